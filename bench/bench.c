@@ -0,0 +1,79 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+
+#ifndef BENCH_PROGRAM
+#define BENCH_PROGRAM "bench" // Set per program by the Makefile
+#endif
+
+static atomic_uint_fast64_t allocation_count;
+static atomic_uint_fast64_t allocation_bytes;
+
+// Linker wrappers (--wrap), so only calls made directly from the objects this build links are counted: the tester
+// and bench code on every thread, not what libc allocates internally (fopen, strdup, pthread). Frees aren't counted.
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+
+static void CountAllocation(size_t size) {
+    atomic_fetch_add_explicit(&allocation_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&allocation_bytes, size, memory_order_relaxed);
+}
+
+void* __wrap_malloc(size_t size) {
+    CountAllocation(size);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    CountAllocation(count * size);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* pointer, size_t size) {
+    CountAllocation(size);
+    return __real_realloc(pointer, size);
+}
+
+void StartBench(BenchTimer* timer, const char* name) {
+    timer->name = name;
+    timer->elapsed = 0;
+    timer->allocations = 0;
+    timer->bytes = 0;
+    ResumeBench(timer);
+}
+
+void PauseBench(BenchTimer* timer) {
+    timer->elapsed += ClockNow() - timer->start_tick;
+    timer->allocations += atomic_load_explicit(&allocation_count, memory_order_relaxed) - timer->start_allocations;
+    timer->bytes += atomic_load_explicit(&allocation_bytes, memory_order_relaxed) - timer->start_bytes;
+}
+
+void ResumeBench(BenchTimer* timer) {
+    timer->start_allocations = atomic_load_explicit(&allocation_count, memory_order_relaxed);
+    timer->start_bytes = atomic_load_explicit(&allocation_bytes, memory_order_relaxed);
+    timer->start_tick = ClockNow();
+}
+
+void StopBench(BenchTimer* timer, uint64_t operations) {
+    PauseBench(timer);
+    double seconds = (double)timer->elapsed / ClockFrequency();
+    double ns_per_op = seconds * 1e9 / operations;
+    double allocations_per_op = (double)timer->allocations / operations;
+    double bytes_per_op = (double)timer->bytes / operations;
+    printf("%-32s %12llu ops %10.2f ns/op %14.0f ops/s %8.3f allocs/op\n", timer->name, (unsigned long long)operations,
+        ns_per_op, operations / seconds, allocations_per_op);
+
+    const char* path = getenv("BENCH_OUTPUT");
+    FILE* output = path && *path ? fopen(path, "a") : NULL;
+    if (output) { // One object per line, names are plain identifiers so there's nothing to escape
+        fprintf(output, "{\"program\": \"%s\", \"name\": \"%s\", \"ops\": %llu, \"ns_per_op\": %.3f, \"allocs_per_op\": %.6f, \"bytes_per_op\": %.3f}\n",
+            BENCH_PROGRAM, timer->name, (unsigned long long)operations, ns_per_op, allocations_per_op, bytes_per_op);
+        fclose(output);
+    }
+}
+
+uint64_t BenchAllocations(const BenchTimer* timer) {
+    return timer->allocations;
+}
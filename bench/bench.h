@@ -0,0 +1,23 @@
+// Minimal benchmark helpers shared by the programs in bench/
+// Heap allocations made directly by the tester and bench code are counted through the linker (-Wl,--wrap=malloc,...),
+// so every bench reports allocations per operation next to ns/op. Allocations inside libc are not seen. With BENCH_OUTPUT set, each result is also appended to that file as one JSON line
+// (see `make bench` and tools/bench_compare).
+#pragma once
+#include <stdint.h>
+#include "platform.h"
+
+typedef struct {
+    const char* name;
+    int64_t start_tick;
+    int64_t elapsed;            // Ticks of earlier running stretches, see PauseBench
+    uint64_t start_allocations;
+    uint64_t start_bytes;
+    uint64_t allocations;
+    uint64_t bytes;
+} BenchTimer;
+
+void StartBench(BenchTimer* timer, const char* name);
+void PauseBench(BenchTimer* timer);                     // Setup between measured stretches, neither timed nor counted
+void ResumeBench(BenchTimer* timer);
+void StopBench(BenchTimer* timer, uint64_t operations);  // Prints ns/op, ops/s and allocations/op
+uint64_t BenchAllocations(const BenchTimer* timer);     // Counted so far, valid after StopBench
@@ -0,0 +1,60 @@
+// Resampling statistics: bootstrap and permutation test on a session-sized sample, one thread against every
+// processor (at least 4). The per-resample figure is what the pool spreads across cores; the results must match exactly.
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "bootstrap.h"
+#include "platform.h"
+#include "prng.h"
+
+#define BENCH_TRIALS 1000
+#define BENCH_RESAMPLES 20000
+
+static double a[BENCH_TRIALS];
+static double b[BENCH_TRIALS];
+
+static void FillSample(double* values, uint64_t seed, double shift) { // Roughly reaction-time shaped, 180 ms plus a tail
+    RandomState random;
+    SeedRandom(&random, seed);
+    for (int i = 0; i < BENCH_TRIALS; i++) {
+        double u = RandomUnit(&random);
+        values[i] = 180 + shift + 60 * u * u * u + 20 * RandomUnit(&random);
+    }
+}
+
+int main(void) {
+    FillSample(a, 1, 0);
+    FillSample(b, 2, 3);
+    int thread_counts[2] = {1, ProcessorCount() > 4 ? ProcessorCount() : 4}; // At least 4 so stealing runs on small machines
+    BootstrapResult bootstrap[2];
+    PermutationResult permutation[2];
+    char name[64];
+    BenchTimer timer;
+
+    for (int i = 0; i < 2; i++) {
+        ResampleOptions options = {.resamples = BENCH_RESAMPLES, .confidence = 0.95, .seed = 42, .threads = thread_counts[i]};
+        snprintf(name, sizeof(name), "bootstrap_%d_threads", thread_counts[i]);
+        StartBench(&timer, name);
+        if (!BootstrapSummary(a, BENCH_TRIALS, &options, &bootstrap[i])) {
+            return 1;
+        }
+        StopBench(&timer, BENCH_RESAMPLES);
+
+        snprintf(name, sizeof(name), "permutation_%d_threads", thread_counts[i]);
+        StartBench(&timer, name);
+        if (!PermutationCompare(a, BENCH_TRIALS, b, BENCH_TRIALS, &options, &permutation[i])) {
+            return 1;
+        }
+        StopBench(&timer, BENCH_RESAMPLES);
+        printf("%d threads: %llu bootstrap steals, %llu permutation steals\n", bootstrap[i].pool.threads,
+            (unsigned long long)bootstrap[i].pool.steals, (unsigned long long)permutation[i].pool.steals);
+    }
+
+    const ConfidenceInterval* mean = &bootstrap[0].intervals[SUMMARY_MEAN];
+    printf("mean %.3f [%.3f, %.3f], difference %+.3f p = %.5f\n", mean->estimate, mean->lower, mean->upper,
+        permutation[0].difference[SUMMARY_MEAN], permutation[0].p_value[SUMMARY_MEAN]);
+    bool same = !memcmp(bootstrap[0].intervals, bootstrap[1].intervals, sizeof(bootstrap[0].intervals)) &&
+        !memcmp(permutation[0].p_value, permutation[1].p_value, sizeof(permutation[0].p_value));
+    printf("results %s across thread counts\n", same ? "identical" : "DIFFER");
+    return same ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+// Cost of loading config/default.cfg the way LoadConfig does: one read, one parse, every key looked up once
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "config_parser.h"
+
+#define BENCH_LOADS 20000
+#define CONFIG_PATH "config/default.cfg"
+
+static const char* const INT_KEYS[][2] = {
+    {"Resolution", "ResolutionWidth"}, {"Resolution", "ResolutionHeight"},
+    {"Delays", "MinDelay"}, {"Delays", "MaxDelay"}, {"Delays", "EarlyResetDelay"}, {"Delays", "VirtualDebounce"},
+    {"Delays", "StimulusSpinWindow"}, {"Delays", "ForeperiodMean"},
+    {"Trial", "AveragingTrials"}, {"Trial", "TotalTrials"}, {"Trial", "HistogramPrecision"}, {"Trial", "LogFlushInterval"},
+    {"Toggles", "RawKeyboardEnabled"}, {"Toggles", "RawMouseEnabled"}, {"Toggles", "RawInputDebug"},
+    {"Toggles", "InputThreadEnabled"}, {"Toggles", "TrialLoggingEnabled"}, {"Toggles", "DebugLoggingEnabled"},
+    {"Toggles", "HotReloadEnabled"}, {"Toggles", "InputRecordingEnabled"}, {"Toggles", "TraceEnabled"},
+    {"Toggles", "DiagnosticsOverlay"}, {"Toggles", "DiagnosticsLogging"}, {"Trial", "DiagnosticsFlagThreshold"},
+    {"Fonts", "FontSize"}
+};
+static const char* const COLOR_KEYS[][2] = {
+    {"Colors", "ReadyColor"}, {"Colors", "ReactColor"}, {"Colors", "EarlyColor"}, {"Colors", "ResultColor"},
+    {"Fonts", "EarlyFontColor"}, {"Fonts", "ResultsFontColor"}
+};
+static const char* const STRING_KEYS[][2] = {{"Fonts", "FontName"}, {"Fonts", "FontStyle"}, {"Trial", "TrialLogFormat"}, {"Trial", "RandomSeed"},
+    {"Delays", "ForeperiodDistribution"}, {"Delays", "ForeperiodWeights"}, {"Delays", "ForeperiodTable"}};
+
+static int LookupAll(const ConfigFile* config) { // Returns the number of keys that were missing or invalid
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(INT_KEYS) / sizeof(INT_KEYS[0]); i++) {
+        int value;
+        failures += !ConfigInt(config, INT_KEYS[i][0], INT_KEYS[i][1], -1, 0, 1000000, &value) || value < 0;
+    }
+    for (size_t i = 0; i < sizeof(COLOR_KEYS) / sizeof(COLOR_KEYS[0]); i++) {
+        uint8_t color[3];
+        failures += !ConfigColor(config, COLOR_KEYS[i][0], COLOR_KEYS[i][1], color);
+    }
+    for (size_t i = 0; i < sizeof(STRING_KEYS) / sizeof(STRING_KEYS[0]); i++) {
+        const char* value = ConfigString(config, STRING_KEYS[i][0], STRING_KEYS[i][1], NULL);
+        failures += !value || !*value || strchr(value, ';') != NULL;
+    }
+    return failures;
+}
+
+int main(void) {
+    FILE* file = fopen(CONFIG_PATH, "rb");
+    if (!file) {
+        fprintf(stderr, "Run from the repository root, %s not found\n", CONFIG_PATH);
+        return 1;
+    }
+    static char text[64 * 1024];
+    size_t size = fread(text, 1, sizeof(text), file);
+    fclose(file);
+
+    ConfigFile config;
+    if (!ParseConfig(&config, text, size)) {
+        return 1;
+    }
+    int failures = LookupAll(&config);
+    printf("%d entries, FontName=\"%s\", failures: %d\n", config.count, ConfigString(&config, "fonts", "fontname", ""), failures);
+    FreeConfig(&config);
+    if (failures) {
+        return 1;
+    }
+
+    BenchTimer timer;
+    StartBench(&timer, "parse_and_lookup");
+    for (int i = 0; i < BENCH_LOADS; i++) {
+        ParseConfig(&config, text, size);
+        failures += LookupAll(&config);
+        FreeConfig(&config);
+    }
+    StopBench(&timer, BENCH_LOADS);
+
+    StartBench(&timer, "load_from_disk");
+    for (int i = 0; i < BENCH_LOADS; i++) {
+        file = fopen(CONFIG_PATH, "rb");
+        if (!file || !LoadConfigFile(&config, file)) {
+            return 1;
+        }
+        fclose(file);
+        failures += LookupAll(&config);
+        FreeConfig(&config);
+    }
+    StopBench(&timer, BENCH_LOADS);
+    return failures != 0;
+}
@@ -0,0 +1,152 @@
+// The timing path piece by piece: state transitions through HandleInput/StimulusOnset/TimerStateLogic, the rolling
+// average behind the result screen, and trial log appends (game thread push, logger thread format and write).
+// Fails if a transition or an average allocates, nothing on the game thread may touch the heap per trial.
+#include <stdio.h>
+#include "bench.h"
+#include "reaction_engine.h"
+#include "trial_logger.h"
+
+#define BENCH_CYCLES 2000000
+#define BENCH_PUSHES 20000000
+#define LOG_ROUNDS 100
+#define LOG_ROUND_RECORDS 4000  // Fits the logger ring, so no push is ever dropped
+#define LOG_PATH "build/bench_trial.log"
+
+static int64_t fake_clock;
+static int64_t pending_onset;
+static int64_t StubNow(void* context) { (void)context; return fake_clock; }
+static void StubSetTimer(void* context, int timer_id, int delay_ms) { (void)context; (void)timer_id; (void)delay_ms; }
+static void StubKillTimer(void* context, int timer_id) { (void)context; (void)timer_id; }
+static void StubRepaint(void* context) { (void)context; }
+static void StubSchedule(void* context, int64_t deadline_tick) { (void)context; pending_onset = deadline_tick; } // Fired by the loop
+static void StubCancel(void* context) { (void)context; pending_onset = 0; }
+
+static bool CheckAllocations(const BenchTimer* timer) {
+    if (BenchAllocations(timer)) {
+        printf("FAIL: %s allocated %llu times\n", timer->name, (unsigned long long)BenchAllocations(timer));
+        return false;
+    }
+    return true;
+}
+
+static int BenchTransitions(void) {
+    EngineConfig config = {.averaging_trials = 5, .total_trials = 1000, .early_reset_delay = 1500, .virtual_debounce = 0, .histogram_precision = 7};
+    ForeperiodDistribution foreperiods;
+    BuildUniformForeperiods(&foreperiods, 1000, 3000);
+    ReactionEngine engine;
+    EnginePlatform platform = {.context = &engine, .now = StubNow, .set_timer = StubSetTimer, .kill_timer = StubKillTimer,
+        .request_repaint = StubRepaint, .schedule_stimulus = StubSchedule, .cancel_stimulus = StubCancel};
+    if (!InitializeEngine(&engine, &config, &platform, 1000000000, &foreperiods, 1)) {
+        return 1;
+    }
+
+    // Valid trial: (INITIAL|RESULT) -input-> READY -onset-> REACT -input-> RESULT
+    BenchTimer timer;
+    StartBench(&timer, "valid_trial_transitions");
+    for (int i = 0; i < BENCH_CYCLES; i++) {
+        fake_clock += 1000000;
+        HandleInput(&engine, false, fake_clock);
+        StimulusOnset(&engine, pending_onset, pending_onset);
+        fake_clock = pending_onset + 180000000 + (i & 0xFFFF) * 1000;
+        HandleInput(&engine, false, fake_clock);
+    }
+    StopBench(&timer, (uint64_t)BENCH_CYCLES * 3);
+    bool clean = CheckAllocations(&timer);
+
+    // Early press: READY -input-> EARLY -timeout-> READY
+    HandleInput(&engine, false, fake_clock);
+    StartBench(&timer, "early_press_transitions");
+    for (int i = 0; i < BENCH_CYCLES; i++) {
+        fake_clock += 1000000;
+        HandleInput(&engine, false, fake_clock);
+        TimerStateLogic(&engine, TIMER_EARLY);
+    }
+    StopBench(&timer, (uint64_t)BENCH_CYCLES * 2);
+    clean &= CheckAllocations(&timer);
+
+    // Events the current state ignores, e.g. an early reset timer that fires after the state moved on
+    ResetLogic(&engine);
+    StartBench(&timer, "ignored_events");
+    for (int i = 0; i < BENCH_CYCLES; i++) {
+        TimerStateLogic(&engine, TIMER_EARLY);
+    }
+    StopBench(&timer, BENCH_CYCLES);
+    clean &= CheckAllocations(&timer);
+
+    printf("trials completed: %d, state %d\n", engine.state.trial_iteration, engine.state.game_state);
+    FreeEngine(&engine);
+    return clean ? 0 : 1;
+}
+
+static int BenchAveraging(void) { // The rolling window GameResultLogic reads, updated once per valid trial
+    static const int WINDOWS[] = {5, 100};
+    char name[64];
+    BenchTimer timer;
+    bool clean = true;
+    for (size_t w = 0; w < sizeof(WINDOWS) / sizeof(WINDOWS[0]); w++) {
+        RollingStats stats;
+        if (!InitializeRollingStats(&stats, WINDOWS[w])) {
+            return 1;
+        }
+        double checksum = 0;
+        uint64_t state = 0x9E3779B97F4A7C15ull;
+        snprintf(name, sizeof(name), "rolling_average_window_%d", WINDOWS[w]);
+        StartBench(&timer, name);
+        for (int i = 0; i < BENCH_PUSHES; i++) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            PushRollingStats(&stats, 150.0 + (double)(state >> 40) / (1 << 16)); // 150-400 ms
+            checksum += stats.summary.mean + stats.summary.sd + stats.summary.median;
+        }
+        StopBench(&timer, BENCH_PUSHES);
+        clean &= CheckAllocations(&timer);
+        printf("window %d: last mean %.3f (%.0f)\n", WINDOWS[w], stats.summary.mean, checksum); // Keeps the work observable
+        FreeRollingStats(&stats);
+    }
+    return clean ? 0 : 1;
+}
+
+static int BenchTrialLog(void) {
+    TrialRecord record = {.scheduled_onset = 1000, .onset = 1200, .response = 181200, .dispatch = 181500, .stimulus_dispatch = 1250,
+        .presented = 9000, .reaction_time_ms = 180.25, .foreperiod_ms = 2000, .key = 'A', .outcome = TRIAL_VALID};
+    static TrialLogger logger; // Holds its write buffer, too big for the stack
+    FILE* file = fopen(LOG_PATH, "w");
+    if (!file || !StartTrialLogger(&logger, file, NULL, 1000, NULL)) {
+        return 1;
+    }
+    StopTrialLogger(&logger); // Warm-up: the first logger thread allocates its trace ring, which would land in the push window
+
+    BenchTimer push, drain;
+    StartBench(&push, "trial_log_append");
+    PauseBench(&push);
+    StartBench(&drain, "trial_log_format_and_write");
+    PauseBench(&drain);
+
+    for (int round = 0; round < LOG_ROUNDS; round++) {
+        file = fopen(LOG_PATH, "w");
+        if (!file || !StartTrialLogger(&logger, file, NULL, 1000, NULL)) { // The writer sleeps through the pushes
+            return 1;
+        }
+        ResumeBench(&push);
+        for (int i = 0; i < LOG_ROUND_RECORDS; i++) {
+            record.trial = i + 1;
+            LogTrial(&logger, &record);
+        }
+        PauseBench(&push);
+        ResumeBench(&drain);
+        StopTrialLogger(&logger); // Drains, formats and writes every record, then closes the file
+        PauseBench(&drain);
+    }
+    ResumeBench(&push);
+    StopBench(&push, (uint64_t)LOG_ROUNDS * LOG_ROUND_RECORDS);
+    ResumeBench(&drain);
+    StopBench(&drain, (uint64_t)LOG_ROUNDS * LOG_ROUND_RECORDS);
+    printf("records dropped in the last round: %u\n", atomic_load(&logger.dropped));
+    return CheckAllocations(&push) ? 0 : 1;
+}
+
+int main(void) {
+    if (BenchTransitions() || BenchAveraging() || BenchTrialLog()) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Cost of drawing a foreperiod: libc rand() rejection sampling (the old GenerateRandomDelay) against the
+// seeded distributions and the precomputed schedule. Also checks replay and the mean of each distribution.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "foreperiod.h"
+
+#define BENCH_DRAWS 20000000
+#define CHECK_DRAWS 4000000
+#define MIN_DELAY 1000
+#define MAX_DELAY 3000
+
+static int RandDelay(int min, int max) {
+    int range = max - min + 1;
+    int buckets = RAND_MAX / range;
+    int limit = buckets * range;
+    int r;
+    do {
+        r = rand();
+    } while (r >= limit);
+    return min + (r / buckets);
+}
+
+static double SampleMean(const ForeperiodDistribution* distribution, int* out_of_range) {
+    RandomState random;
+    SeedRandom(&random, 7);
+    double sum = 0;
+    for (int i = 0; i < CHECK_DRAWS; i++) {
+        int32_t delay = SampleForeperiod(distribution, &random);
+        *out_of_range += delay < distribution->min_delay || delay > distribution->max_delay;
+        sum += delay;
+    }
+    return sum / CHECK_DRAWS;
+}
+
+static void BenchSample(const char* name, const ForeperiodDistribution* distribution, int64_t* sum) {
+    RandomState random;
+    SeedRandom(&random, 42);
+    BenchTimer timer;
+    StartBench(&timer, name);
+    for (int i = 0; i < BENCH_DRAWS; i++) {
+        *sum += SampleForeperiod(distribution, &random);
+    }
+    StopBench(&timer, BENCH_DRAWS);
+}
+
+int main(void) {
+    // Same seed, same delays, including across a refill
+    ForeperiodDistribution uniform;
+    ForeperiodDistribution copy;
+    ForeperiodSchedule first;
+    ForeperiodSchedule second;
+    BuildUniformForeperiods(&uniform, MIN_DELAY, MAX_DELAY);
+    BuildUniformForeperiods(&copy, MIN_DELAY, MAX_DELAY);
+    if (!InitializeForeperiodSchedule(&first, 42, &uniform, 1000) || !InitializeForeperiodSchedule(&second, 42, &copy, 1000)) {
+        return 1;
+    }
+    int mismatches = 0;
+    int out_of_range = 0;
+    for (int i = 0; i < 5000; i++) {
+        int32_t delay = NextForeperiod(&first);
+        mismatches += delay != NextForeperiod(&second);
+        out_of_range += delay < MIN_DELAY || delay > MAX_DELAY;
+    }
+    FreeForeperiodSchedule(&second);
+
+    // Sample means against the exact ones
+    ForeperiodDistribution exponential;
+    ForeperiodDistribution weighted;
+    if (!BuildUniformForeperiods(&uniform, MIN_DELAY, MAX_DELAY) || !BuildExponentialForeperiods(&exponential, MIN_DELAY, MAX_DELAY, 1000) ||
+        !BuildWeightedForeperiods(&weighted, "1000:1, 2000:2, 3000:1\n4000:0.5 # comment")) {
+        return 1;
+    }
+    double range = MAX_DELAY - MIN_DELAY;
+    double exponential_mean = MIN_DELAY + 1000 - range / expm1(range / 1000); // Truncated exponential
+    double weighted_mean = (1000 * 1 + 2000 * 2 + 3000 * 1 + 4000 * 0.5) / 4.5;
+    double exponential_sample = SampleMean(&exponential, &out_of_range);
+    double weighted_sample = SampleMean(&weighted, &out_of_range);
+    printf("exponential mean %.2lf (exact %.2lf), weighted mean %.2lf (exact %.2lf)\n", exponential_sample, exponential_mean, weighted_sample, weighted_mean);
+    printf("replay mismatches: %d, out of range: %d\n", mismatches, out_of_range);
+    if (mismatches || out_of_range || fabs(exponential_sample - exponential_mean) > 2 || fabs(weighted_sample - weighted_mean) > 2) {
+        return 1;
+    }
+
+    int64_t sum = 0;
+    BenchTimer timer;
+    srand(42);
+    StartBench(&timer, "rand_rejection");
+    for (int i = 0; i < BENCH_DRAWS; i++) {
+        sum += RandDelay(MIN_DELAY, MAX_DELAY);
+    }
+    StopBench(&timer, BENCH_DRAWS);
+
+    BenchSample("uniform_sample", &uniform, &sum);
+    BenchSample("exponential_sample", &exponential, &sum);
+    BenchSample("weighted_alias_sample", &weighted, &sum);
+
+    StartBench(&timer, "schedule_next");
+    for (int i = 0; i < BENCH_DRAWS; i++) {
+        sum += NextForeperiod(&first);
+    }
+    StopBench(&timer, BENCH_DRAWS);
+
+    printf("checksum: %lld\n", (long long)sum); // Keeps the draws observable
+    FreeForeperiodDistribution(&uniform);
+    FreeForeperiodDistribution(&exponential);
+    FreeForeperiodDistribution(&weighted);
+    FreeForeperiodSchedule(&first);
+    return 0;
+}
@@ -0,0 +1,68 @@
+// Record and query cost of the session latency histogram, plus its worst relative error against exact percentiles
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "latency_histogram.h"
+
+#define BENCH_VALUES 5000000
+#define BENCH_QUERIES 100000
+#define FREQUENCY 1000000000 // Nanosecond ticks, like ClockNow on Linux
+
+static int CompareTicks(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+int main(void) {
+    static int64_t values[BENCH_VALUES];
+    uint64_t state = 88172645463325252ull;
+    for (int i = 0; i < BENCH_VALUES; i++) { // 150-400ms reactions with a long tail
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        int64_t base = 150000000 + (int64_t)(state % 250000000);
+        values[i] = (state >> 60) == 0 ? base * 4 : base;
+    }
+
+    LatencyHistogram histogram;
+    LatencyHistogram other;
+    if (!InitializeLatencyHistogram(&histogram, MillisecondsToTicks(60000, FREQUENCY), 7, FREQUENCY) ||
+        !InitializeLatencyHistogram(&other, MillisecondsToTicks(60000, 10000000), 9, 10000000)) { // QPC-like clock, finer buckets
+        return 1;
+    }
+    printf("buckets: %d (%zu bytes)\n", histogram.bucket_count, histogram.bucket_count * sizeof(uint32_t));
+
+    BenchTimer timer;
+    StartBench(&timer, "record");
+    for (int i = 0; i < BENCH_VALUES; i++) {
+        RecordLatency(&histogram, values[i]);
+    }
+    StopBench(&timer, BENCH_VALUES);
+
+    const double percentiles[] = {50, 90, 99, 99.9};
+    volatile int64_t sink = 0;
+    StartBench(&timer, "percentile_query");
+    for (int i = 0; i < BENCH_QUERIES; i++) {
+        sink += LatencyPercentile(&histogram, percentiles[i & 3]);
+    }
+    StopBench(&timer, BENCH_QUERIES);
+
+    for (int i = 0; i < BENCH_VALUES; i++) {
+        RecordLatency(&other, values[i] / 100);
+    }
+    StartBench(&timer, "merge_rescale");
+    MergeLatencyHistogram(&other, &histogram);
+    StopBench(&timer, (uint64_t)histogram.bucket_count);
+
+    qsort(values, BENCH_VALUES, sizeof(int64_t), CompareTicks);
+    for (int i = 0; i < 4; i++) {
+        int64_t exact = values[(size_t)(percentiles[i] / 100.0 * BENCH_VALUES + 0.5) - 1];
+        int64_t approximate = LatencyPercentile(&histogram, percentiles[i]);
+        printf("p%-5g exact %10.4fms  histogram %10.4fms  merged %10.4fms  error %.3f%%\n", percentiles[i],
+            exact / 1e6, approximate / 1e6, LatencyPercentile(&other, percentiles[i]) / 1e4,
+            100.0 * (double)llabs(approximate - exact) / (double)exact);
+    }
+
+    FreeLatencyHistogram(&histogram);
+    FreeLatencyHistogram(&other);
+    return sink == 42; // Keeps the queries observable
+}
@@ -0,0 +1,135 @@
+// Per-device participant lanes: routing cost of DispatchLaneBatch against plain DispatchInputBatch as the
+// number of devices (and lanes) grows. Events come from the synthetic source spread over N device handles.
+// Paint cost is the text behind each pane (result summary and three session percentiles), composed for every
+// pane on each paint against only the pane whose cached frame went stale. The GDI side needs Windows.
+#include <stdio.h>
+#include "bench.h"
+#include "participant_lanes.h"
+
+#define BENCH_BATCHES 200000
+#define BENCH_PAINTS 20000
+#define BENCH_VARIANTS 64       // Distinct batches cycled through, so the device order isn't the same every time
+
+static int64_t fake_clock;
+static int64_t StubNow(void* context) { (void)context; return fake_clock; }
+static void StubSetTimer(void* context, int timer_id, int delay_ms) { (void)context; (void)timer_id; (void)delay_ms; }
+static void StubKillTimer(void* context, int timer_id) { (void)context; (void)timer_id; }
+static void StubRepaint(void* context) { (void)context; }
+static void StubSchedule(void* context, int64_t deadline_tick) { StimulusOnset(context, deadline_tick, fake_clock); } // Stimulus shows immediately
+static void StubCancel(void* context) { (void)context; }
+
+static bool InitializeBenchEngine(ReactionEngine* engine, uint64_t seed) {
+    EngineConfig config = {.averaging_trials = 5, .total_trials = 1000, .early_reset_delay = 1500, .virtual_debounce = 0, .histogram_precision = 7};
+    ForeperiodDistribution foreperiods;
+    BuildUniformForeperiods(&foreperiods, 1000, 3000);
+    EnginePlatform platform = {.context = engine, .now = StubNow, .set_timer = StubSetTimer, .kill_timer = StubKillTimer,
+        .request_repaint = StubRepaint, .schedule_stimulus = StubSchedule, .cancel_stimulus = StubCancel};
+    return InitializeEngine(engine, &config, &platform, 1000000000, &foreperiods, seed);
+}
+
+static int FormatPane(const ParticipantLane* lane, char* buffer, size_t size) { // Same numbers as GameResultLogic
+    const ReactionEngine* engine = &lane->engine;
+    const RollingSummary* summary = &engine->data.rolling.summary;
+    const LatencyHistogram* histogram = &engine->data.session_histogram;
+    return snprintf(buffer, size, "Player %d\nLast: %.2fms\nAverage: %.2fms (SD %.2fms)\nMedian: %.2fms | Best: %.2fms\nTrials so far: %d\nSession p50/p90/p99: %.1f / %.1f / %.1fms",
+        lane->index + 1, engine->data.reaction_time_value, summary->mean, summary->sd, summary->median, summary->min, engine->state.trial_iteration,
+        TicksToMilliseconds(LatencyPercentile(histogram, 50), engine->data.frequency),
+        TicksToMilliseconds(LatencyPercentile(histogram, 90), engine->data.frequency),
+        TicksToMilliseconds(LatencyPercentile(histogram, 99), engine->data.frequency));
+}
+
+static uint64_t BenchPaint(const ParticipantLanes* lanes, uint32_t device_count) { // One paint per pane change, as LaneRequestRepaint asks
+    char name[64], buffer[512];
+    uint64_t length = 0;
+    BenchTimer timer;
+    snprintf(name, sizeof(name), "paint_all_panes_%u_lanes", device_count);
+    StartBench(&timer, name);
+    for (int i = 0; i < BENCH_PAINTS; i++) {
+        for (int j = 0; j < lanes->lane_count; j++) {
+            length += (uint64_t)FormatPane(&lanes->lanes[j], buffer, sizeof(buffer));
+        }
+    }
+    StopBench(&timer, BENCH_PAINTS);
+
+    snprintf(name, sizeof(name), "paint_stale_pane_%u_lanes", device_count);
+    StartBench(&timer, name);
+    for (int i = 0; i < BENCH_PAINTS; i++) { // The other panes blit their cached frames
+        length += (uint64_t)FormatPane(&lanes->lanes[i % lanes->lane_count], buffer, sizeof(buffer));
+    }
+    StopBench(&timer, BENCH_PAINTS);
+    return length;
+}
+
+static int BenchDevices(uint32_t device_count) {
+    static InputEventBatch batches[BENCH_VARIANTS];
+    SyntheticInputSource source;
+    InitializeSyntheticInput(&source, 12345, 125000); // 8 kHz devices
+    SetSyntheticDevices(&source, device_count);
+    for (int i = 0; i < BENCH_VARIANTS; i++) {
+        FillSyntheticBatch(&source, &batches[i], INPUT_BATCH_CAPACITY);
+    }
+
+    ParticipantLanes lanes;
+    if (!InitializeParticipantLanes(&lanes, (int)device_count, NULL)) {
+        return 1;
+    }
+    for (int i = 0; i < lanes.lane_count; i++) {
+        if (!InitializeBenchEngine(&lanes.lanes[i].engine, (uint64_t)i + 1)) {
+            return 1;
+        }
+    }
+    ReactionEngine single;
+    if (!InitializeBenchEngine(&single, 1)) {
+        return 1;
+    }
+
+    char name[64];
+    BenchTimer timer;
+    snprintf(name, sizeof(name), "single_engine_%u_devices", device_count);
+    StartBench(&timer, name);
+    for (int i = 0; i < BENCH_BATCHES; i++) {
+        fake_clock += 1000;
+        DispatchInputBatch(&single, &batches[i % BENCH_VARIANTS], true, true);
+    }
+    StopBench(&timer, (uint64_t)BENCH_BATCHES * INPUT_BATCH_CAPACITY);
+
+    snprintf(name, sizeof(name), "lane_dispatch_%u_devices", device_count);
+    StartBench(&timer, name);
+    for (int i = 0; i < BENCH_BATCHES; i++) {
+        fake_clock += 1000;
+        DispatchLaneBatch(&lanes, &batches[i % BENCH_VARIANTS], true, true);
+    }
+    StopBench(&timer, (uint64_t)BENCH_BATCHES * INPUT_BATCH_CAPACITY);
+
+    snprintf(name, sizeof(name), "find_lane_%u_devices", device_count);
+    uint64_t found = 0;
+    StartBench(&timer, name);
+    for (int i = 0; i < BENCH_BATCHES; i++) {
+        const InputEventBatch* batch = &batches[i % BENCH_VARIANTS];
+        for (uint32_t j = 0; j < batch->count; j++) {
+            found += (uint64_t)FindLane(&lanes, batch->events[j].device);
+        }
+    }
+    StopBench(&timer, (uint64_t)BENCH_BATCHES * INPUT_BATCH_CAPACITY);
+    found += BenchPaint(&lanes, device_count); // After the dispatch runs, so every pane has results to show
+
+    int trials = 0;
+    for (int i = 0; i < lanes.lane_count; i++) {
+        trials += lanes.lanes[i].engine.state.trial_iteration;
+    }
+    printf("%u devices: %d lanes bound, %d trials over all lanes, %d single engine (%llu)\n", device_count, lanes.bound_count, trials,
+        single.state.trial_iteration, (unsigned long long)found); // Keeps the dispatch work observable
+    FreeEngine(&single);
+    FreeParticipantLanes(&lanes);
+    return 0;
+}
+
+int main(void) {
+    static const uint32_t DEVICE_COUNTS[] = {1, 4, 16, MAX_PARTICIPANTS};
+    for (size_t i = 0; i < sizeof(DEVICE_COUNTS) / sizeof(DEVICE_COUNTS[0]); i++) {
+        if (BenchDevices(DEVICE_COUNTS[i])) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Write cost of the binary session file and scan speed of the memory-mapped reader
+#include <stdio.h>
+#include "bench.h"
+#include "session_file.h"
+
+#define BENCH_RECORDS 2000000
+#define BENCH_PATH "build/bench_session.rts"
+#define FREQUENCY 1000000000
+
+int main(void) {
+    FILE* file = fopen(BENCH_PATH, "wb");
+    static SessionWriter session_writer; // Holds a whole block, too big for the stack
+    SessionWriter* writer = &session_writer;
+    if (!file || !OpenSessionWriter(writer, file, 1, FREQUENCY, 0, 1)) {
+        return 1;
+    }
+
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+    int64_t tick = 0;
+    double expected_total = 0;
+    int valid = 0;
+
+    BenchTimer timer;
+    StartBench(&timer, "append_record");
+    for (int i = 0; i < BENCH_RECORDS; i++) {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        int32_t foreperiod = 1000 + (int32_t)(state % 2001);
+        int64_t reaction = 150000000 + (int64_t)((state >> 8) % 250000000);
+        bool early = (state & 15) == 0;
+
+        tick += (int64_t)foreperiod * 1000000;
+        TrialRecord record = {.scheduled_onset = tick, .onset = early ? 0 : tick, .response = early ? tick - 1000 : tick + reaction,
+            .dispatch = tick + reaction + 5000, .trial = valid + !early, .foreperiod_ms = foreperiod, .key = 'A', .outcome = early ? TRIAL_EARLY : TRIAL_VALID};
+        AppendSessionRecord(writer, &record);
+        tick += reaction;
+        if (!early) {
+            valid++;
+            expected_total += (double)reaction;
+        }
+        if ((i & 65535) == 0) {
+            FlushSessionWriter(writer); // Like the logger thread's periodic flush
+        }
+    }
+    if (!CloseSessionWriter(writer)) {
+        return 1;
+    }
+    StopBench(&timer, BENCH_RECORDS);
+
+    SessionFile session;
+    if (!OpenSessionFile(&session, BENCH_PATH) || !session.index) {
+        return 1;
+    }
+
+    double total = 0;
+    int scanned = 0;
+    StartBench(&timer, "mmap_scan_valid_reactions");
+    for (uint32_t b = 0; b < session.block_count; b++) {
+        const SessionBlock* block = SessionFileBlock(&session, b);
+        for (uint32_t i = 0; i < block->count; i++) {
+            if (block->outcome[i] == TRIAL_VALID) {
+                total += (double)(block->response[i] - block->onset[i]);
+                scanned++;
+            }
+        }
+    }
+    StopBench(&timer, BENCH_RECORDS);
+    printf("file: %.1f MB, %u blocks, %d valid trials, mean %.3fms\n", session.mapping.size / 1e6, session.block_count, scanned, total / scanned / 1e6);
+
+    uint32_t middle = FindSessionBlock(&session, tick / 2);
+    const SessionBlock* found = SessionFileBlock(&session, middle);
+    bool ok = scanned == valid && total == expected_total && found && found->first_response <= tick / 2 && found->last_response >= tick / 2;
+    CloseSessionFile(&session);
+    remove(BENCH_PATH);
+    return ok ? 0 : 1;
+}
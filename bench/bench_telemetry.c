@@ -0,0 +1,143 @@
+// Live telemetry publishing, the part that runs on the UI thread after every state change and trial, alone and
+// with readers hammering the same block from other threads. Readers check every snapshot they accept for tearing.
+// Fails if publishing allocates or a reader ever accepts a torn snapshot.
+#include <stdio.h>
+#include <unistd.h>
+#include "bench.h"
+#include "telemetry.h"
+
+#define BENCH_PUBLISHES 5000000
+#define BENCH_RECOMPUTES 500000 // Each redoes the session percentiles
+#define BENCH_READERS 2
+
+typedef struct {
+    TelemetryReader reader;
+    PlatformThread thread;
+    atomic_bool stop;
+    uint64_t snapshots;
+    uint64_t trials;
+    uint64_t lost;
+    uint64_t torn;
+} BenchReader;
+
+static int64_t fake_clock;
+static int64_t StubNow(void* context) { (void)context; return fake_clock; }
+static void StubSetTimer(void* context, int timer_id, int delay_ms) { (void)context; (void)timer_id; (void)delay_ms; }
+static void StubKillTimer(void* context, int timer_id) { (void)context; (void)timer_id; }
+static void StubRepaint(void* context) { (void)context; }
+static void StubSchedule(void* context, int64_t deadline_tick) { (void)context; (void)deadline_tick; }
+static void StubCancel(void* context) { (void)context; }
+
+static void ReaderThread(void* arg) {
+    BenchReader* bench_reader = arg;
+    TelemetryTrial trials[64];
+    while (!atomic_load_explicit(&bench_reader->stop, memory_order_relaxed)) {
+        TelemetryParticipant participant;
+        if (ReadTelemetryParticipant(&bench_reader->reader, 0, &participant)) {
+            bench_reader->snapshots++;
+            bench_reader->torn += participant.updated != participant.trials; // The writer always publishes them equal
+        }
+        uint64_t lost;
+        uint32_t count = ReadTelemetryTrials(&bench_reader->reader, trials, 64, &lost);
+        bench_reader->lost += lost;
+        for (uint32_t i = 0; i < count; i++) {
+            bench_reader->trials++;
+            bench_reader->torn += (uint64_t)trials[i].record.trial != trials[i].index || trials[i].record.onset != (int64_t)trials[i].index * 3;
+        }
+    }
+}
+
+static bool CheckAllocations(const BenchTimer* timer) {
+    if (BenchAllocations(timer)) {
+        printf("FAIL: %s allocated %llu times\n", timer->name, (unsigned long long)BenchAllocations(timer));
+        return false;
+    }
+    return true;
+}
+
+static bool BenchPublish(TelemetryWriter* writer, ReactionEngine* engine, const char* suffix) {
+    char name[64];
+    BenchTimer timer;
+    bool clean = true;
+
+    snprintf(name, sizeof(name), "publish_state_change%s", suffix);
+    StartBench(&timer, name);
+    for (int i = 0; i < BENCH_PUBLISHES; i++) {
+        engine->state.game_state = (GameState)(i & 3);
+        PublishParticipant(writer, 0, engine, engine->state.trial_iteration); // Same trial count, only the copy
+    }
+    StopBench(&timer, BENCH_PUBLISHES);
+    clean &= CheckAllocations(&timer);
+
+    snprintf(name, sizeof(name), "publish_after_trial%s", suffix);
+    StartBench(&timer, name);
+    for (int i = 0; i < BENCH_RECOMPUTES; i++) {
+        engine->state.trial_iteration++;
+        PublishParticipant(writer, 0, engine, engine->state.trial_iteration);
+    }
+    StopBench(&timer, BENCH_RECOMPUTES);
+    clean &= CheckAllocations(&timer);
+
+    TrialRecord record = {.scheduled_onset = 1000, .response = 181200, .reaction_time_ms = 180.25, .foreperiod_ms = 2000, .outcome = TRIAL_VALID};
+    uint64_t written = atomic_load(&writer->block->trials_written);
+    snprintf(name, sizeof(name), "publish_trial%s", suffix);
+    StartBench(&timer, name);
+    for (int i = 0; i < BENCH_PUBLISHES; i++) {
+        uint64_t index = written + (uint64_t)i;
+        record.trial = (int)index;
+        record.onset = (int64_t)index * 3;
+        PublishTrial(writer, 0, &record);
+    }
+    StopBench(&timer, BENCH_PUBLISHES);
+    clean &= CheckAllocations(&timer);
+    return clean;
+}
+
+int main(void) {
+    EngineConfig config = {.averaging_trials = 5, .total_trials = 1000, .early_reset_delay = 1500, .virtual_debounce = 0, .histogram_precision = 7};
+    ForeperiodDistribution foreperiods;
+    BuildUniformForeperiods(&foreperiods, 1000, 3000);
+    ReactionEngine engine;
+    EnginePlatform platform = {.context = &engine, .now = StubNow, .set_timer = StubSetTimer, .kill_timer = StubKillTimer,
+        .request_repaint = StubRepaint, .schedule_stimulus = StubSchedule, .cancel_stimulus = StubCancel};
+    if (!InitializeEngine(&engine, &config, &platform, 1000000000, &foreperiods, 1)) {
+        return 1;
+    }
+    for (int i = 0; i < 1000; i++) { // Something for the session percentiles to walk
+        RecordLatency(&engine.data.session_histogram, 150000000 + (int64_t)i * 97000);
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "bench_telemetry_%d", (int)getpid());
+    static TelemetryWriter writer;
+    DiagnosticsSettings settings = {1000000000, 0};
+    if (!OpenTelemetryWriter(&writer, name, 1, 1, 1, &settings)) {
+        printf("FAIL: cannot create shared memory %s\n", name);
+        return 1;
+    }
+    bool clean = BenchPublish(&writer, &engine, "");
+
+    static BenchReader readers[BENCH_READERS];
+    for (int i = 0; i < BENCH_READERS; i++) {
+        if (!OpenTelemetryReader(&readers[i].reader, name) || !StartThread(&readers[i].thread, ReaderThread, &readers[i])) {
+            printf("FAIL: cannot start reader %d\n", i);
+            return 1;
+        }
+    }
+    clean &= BenchPublish(&writer, &engine, "_2_readers");
+    for (int i = 0; i < BENCH_READERS; i++) {
+        atomic_store(&readers[i].stop, true);
+        JoinThread(&readers[i].thread);
+        CloseTelemetryReader(&readers[i].reader);
+        printf("reader %d: %llu snapshots, %llu trials, %llu lost, %llu torn\n", i, (unsigned long long)readers[i].snapshots,
+            (unsigned long long)readers[i].trials, (unsigned long long)readers[i].lost, (unsigned long long)readers[i].torn);
+        if (readers[i].torn) {
+            printf("FAIL: reader %d accepted torn snapshots\n", i);
+            clean = false;
+        }
+    }
+
+    CloseTelemetryWriter(&writer);
+    FreeEngine(&engine);
+    return clean ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+// Cost of a trace point (enabled, switched off at runtime) against a bare clock read, and a dump taken
+// while another thread keeps tracing. Fails if an enabled trace point costs 50 ns or more in its best round.
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "trace.h"
+
+#define BENCH_EVENTS 20000000
+#define BENCH_ROUNDS 2000       // Shorter than a scheduler slice, the budget is checked against the best one so preemption does not count
+#define BUDGET_NS 50.0
+
+static atomic_bool writer_running;
+
+static void WriterThread(void* arg) {
+    (void)arg;
+    TraceThread("Writer");
+    for (int64_t i = 0; atomic_load_explicit(&writer_running, memory_order_relaxed); i++) {
+        TRACE_BEGIN(TRACE_HANDLE_INPUT, i & 1);
+        TRACE_END(TRACE_HANDLE_INPUT);
+    }
+    TraceThreadExit();
+}
+
+static double TimeEvents(const char* name) { // Returns ns per event of the best round
+    BenchTimer timer;
+    StartBench(&timer, name);
+    double best_ns = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        int64_t start = ClockNow();
+        for (int i = 0; i < BENCH_EVENTS / BENCH_ROUNDS; i++) {
+            TRACE_INSTANT(TRACE_STATE, i, i + 1);
+        }
+        double round_ns = TicksToMilliseconds(ClockNow() - start, ClockFrequency()) * 1e6 / (BENCH_EVENTS / BENCH_ROUNDS);
+        if (!round || round_ns < best_ns) best_ns = round_ns;
+    }
+    StopBench(&timer, BENCH_EVENTS);
+    printf("best round: %.2f ns/event\n", best_ns);
+    return best_ns;
+}
+
+int main(void) {
+#if !TRACE_ENABLED
+    printf("built with TRACE_ENABLED=0, nothing to measure\n");
+    return 0;
+#endif
+    TraceThread("Main");
+
+    int64_t sum = 0;
+    BenchTimer timer;
+    StartBench(&timer, "clock_now");
+    for (int i = 0; i < BENCH_EVENTS; i++) {
+        sum += ClockNow();
+    }
+    StopBench(&timer, BENCH_EVENTS);
+
+    TimeEvents("trace_disabled");
+    SetTraceEnabled(true);
+    double enabled_ns = TimeEvents("trace_enabled");
+
+    // Dump while a second thread overwrites its ring as fast as it can
+    PlatformThread writer;
+    atomic_store(&writer_running, true);
+    if (!StartThread(&writer, WriterThread, NULL)) {
+        return 1;
+    }
+    int64_t settle = ClockNow() + MillisecondsToTicks(50, ClockFrequency()); // Let the writer fill its ring first
+    while (ClockNow() < settle) {
+        CpuRelax();
+    }
+    FILE* file = tmpfile();
+    if (!file) {
+        return 1;
+    }
+    StartBench(&timer, "write_trace");
+    bool written = WriteTrace(file);
+    StopBench(&timer, 1);
+    atomic_store(&writer_running, false);
+    JoinThread(&writer);
+
+    long size = ftell(file);
+    rewind(file);
+    char line[256];
+    long events = 0;
+    bool balanced = true;
+    while (fgets(line, sizeof(line), file)) {
+        events += strstr(line, "\"ph\":") != NULL;
+        balanced = balanced && (line[0] == '{' || line[0] == ']' || line[0] == '\n'); // One event per line, nothing torn
+    }
+    fclose(file);
+    printf("dump: %ld events, %ld bytes, checksum %lld\n", events, size, (long long)(sum & 0xFF));
+    if (!written || !balanced || events <= TRACE_RING_CAPACITY || enabled_ns >= BUDGET_NS) {
+        printf("FAIL (budget %.0f ns per event)\n", BUDGET_NS);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,263 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bootstrap.h"
+#include "platform.h"
+#include "prng.h"
+
+#define PERCENTILE_COUNT (SUMMARY_COUNT - 1) // Everything after the mean, in ascending rank order
+
+const char* const SUMMARY_NAMES[SUMMARY_COUNT] = {"mean", "median", "p90", "p99"};
+static const double PERCENTILES[PERCENTILE_COUNT] = {0.5, 0.9, 0.99};
+
+typedef struct {
+    const double* sorted;
+    uint32_t count;
+    uint32_t resamples;
+    uint64_t seed;
+    uint32_t ranks[PERCENTILE_COUNT];
+    uint32_t* counts;           // count per worker
+    double* statistics;         // resamples per statistic
+} BootstrapJob;
+
+typedef struct {
+    const double* sorted;       // Both groups pooled
+    uint32_t count;
+    uint32_t selected;          // Size of the group drawn each permutation, the smaller one
+    bool selected_is_a;
+    uint64_t seed;
+    uint32_t selected_ranks[PERCENTILE_COUNT];
+    uint32_t other_ranks[PERCENTILE_COUNT];
+    double total;
+    double observed[SUMMARY_COUNT];     // |b - a| of the real grouping
+    uint32_t* order;            // count per worker, partially shuffled
+    uint8_t* mask;              // count per worker, 1 = in the selected group
+    uint64_t* extreme;          // SUMMARY_COUNT per worker
+} PermutationJob;
+
+static int CompareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double* SortedCopy(const double* values, uint32_t count) {
+    double* sorted = malloc((size_t)count * sizeof(double));
+    if (sorted) {
+        memcpy(sorted, values, (size_t)count * sizeof(double));
+        qsort(sorted, count, sizeof(double), CompareDoubles);
+    }
+    return sorted;
+}
+
+static void NearestRanks(uint32_t count, uint32_t* ranks) { // 1-based
+    for (int i = 0; i < PERCENTILE_COUNT; i++) {
+        double rank = ceil(PERCENTILES[i] * count);
+        ranks[i] = rank < 1 ? 1 : (uint32_t)rank;
+    }
+}
+
+static int WorkerCount(const ResampleOptions* options) {
+    int threads = options->threads > 0 ? options->threads : ProcessorCount();
+    return threads < WORK_POOL_MAX_THREADS ? threads : WORK_POOL_MAX_THREADS;
+}
+
+static void SeedChunk(RandomState* random, uint64_t seed, uint64_t begin) {
+    SeedRandom(random, seed + (begin / BOOTSTRAP_CHUNK) * 0x9E3779B97F4A7C15ull);
+}
+
+// Kernels, plain loops over contiguous arrays with independent accumulators so the compiler can keep them in vectors
+static double WeightedSum(const double* values, const uint32_t* weights, uint32_t count) {
+    double sum[4] = {0, 0, 0, 0};
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        sum[0] += values[i] * weights[i];
+        sum[1] += values[i + 1] * weights[i + 1];
+        sum[2] += values[i + 2] * weights[i + 2];
+        sum[3] += values[i + 3] * weights[i + 3];
+    }
+    for (; i < count; i++) sum[0] += values[i] * weights[i];
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+static double MaskedSum(const double* values, const uint8_t* mask, uint32_t count) {
+    double sum[4] = {0, 0, 0, 0};
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        sum[0] += values[i] * mask[i];
+        sum[1] += values[i + 1] * mask[i + 1];
+        sum[2] += values[i + 2] * mask[i + 2];
+        sum[3] += values[i + 3] * mask[i + 3];
+    }
+    for (; i < count; i++) sum[0] += values[i] * mask[i];
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+static void DrawCounts(RandomState* random, uint32_t* counts, uint32_t count) { // count draws with replacement
+    memset(counts, 0, (size_t)count * sizeof(uint32_t));
+    uint32_t i = 0;
+    for (; i + 2 <= count; i += 2) { // Two 32-bit multiply-shift draws per output, bias below count / 2^32
+        uint64_t bits = NextRandom(random);
+        counts[((bits & 0xFFFFFFFF) * count) >> 32]++;
+        counts[((bits >> 32) * count) >> 32]++;
+    }
+    if (i < count) counts[RandomBelow(random, count)]++;
+}
+
+// Resampling
+void SummarizeSorted(const double* sorted, uint32_t count, double* statistics) {
+    uint32_t ranks[PERCENTILE_COUNT];
+    NearestRanks(count, ranks);
+    double sum = 0;
+    for (uint32_t i = 0; i < count; i++) sum += sorted[i];
+    statistics[SUMMARY_MEAN] = count ? sum / count : 0;
+    for (int i = 0; i < PERCENTILE_COUNT; i++) {
+        statistics[SUMMARY_MEDIAN + i] = count ? sorted[ranks[i] - 1] : 0;
+    }
+}
+
+static void BootstrapChunk(void* context, int worker, uint64_t begin, uint64_t end) {
+    BootstrapJob* job = context;
+    uint32_t* counts = job->counts + (size_t)worker * job->count;
+    RandomState random;
+    SeedChunk(&random, job->seed, begin);
+
+    for (uint64_t resample = begin; resample < end; resample++) {
+        DrawCounts(&random, counts, job->count);
+        job->statistics[SUMMARY_MEAN * (size_t)job->resamples + resample] = WeightedSum(job->sorted, counts, job->count) / job->count;
+
+        uint32_t cumulative = 0;
+        int next = 0;
+        for (uint32_t i = 0; next < PERCENTILE_COUNT; i++) { // The last rank is at most count, so this ends inside the array
+            cumulative += counts[i];
+            while (next < PERCENTILE_COUNT && cumulative >= job->ranks[next]) {
+                job->statistics[(SUMMARY_MEDIAN + next++) * (size_t)job->resamples + resample] = job->sorted[i];
+            }
+        }
+    }
+}
+
+bool BootstrapSummary(const double* values, uint32_t count, const ResampleOptions* options, BootstrapResult* result) {
+    if (!count || !options->resamples || !(options->confidence > 0 && options->confidence < 1)) {
+        return false;
+    }
+    int workers = WorkerCount(options);
+    BootstrapJob job = {.count = count, .resamples = options->resamples, .seed = options->seed};
+    job.sorted = SortedCopy(values, count);
+    job.counts = malloc((size_t)workers * count * sizeof(uint32_t));
+    job.statistics = malloc((size_t)SUMMARY_COUNT * options->resamples * sizeof(double));
+    bool ran = job.sorted && job.counts && job.statistics;
+    if (ran) {
+        NearestRanks(count, job.ranks);
+        ran = RunWorkPool(options->resamples, BOOTSTRAP_CHUNK, workers, BootstrapChunk, &job, &result->pool);
+    }
+
+    if (ran) {
+        double estimates[SUMMARY_COUNT];
+        SummarizeSorted(job.sorted, count, estimates);
+        double tail = (1 - options->confidence) / 2;
+        size_t low = (size_t)floor(tail * (options->resamples - 1));
+        size_t high = (size_t)ceil((1 - tail) * (options->resamples - 1));
+        for (int i = 0; i < SUMMARY_COUNT; i++) {
+            double* samples = job.statistics + (size_t)i * options->resamples;
+            qsort(samples, options->resamples, sizeof(double), CompareDoubles);
+            result->intervals[i] = (ConfidenceInterval){estimates[i], samples[low], samples[high]};
+        }
+    }
+    free((void*)job.sorted);
+    free(job.counts);
+    free(job.statistics);
+    return ran;
+}
+
+static void GroupPercentiles(const double* sorted, const uint8_t* mask, uint32_t count, const uint32_t* selected_ranks,
+    const uint32_t* other_ranks, double* selected, double* other) { // One scan for both groups
+    uint32_t in = 0, out = 0;
+    int next_in = 0, next_out = 0;
+    for (uint32_t i = 0; i < count && (next_in < PERCENTILE_COUNT || next_out < PERCENTILE_COUNT); i++) {
+        in += mask[i];
+        out += 1u - mask[i];
+        while (next_in < PERCENTILE_COUNT && in >= selected_ranks[next_in]) selected[next_in++] = sorted[i];
+        while (next_out < PERCENTILE_COUNT && out >= other_ranks[next_out]) other[next_out++] = sorted[i];
+    }
+}
+
+static void PermutationChunk(void* context, int worker, uint64_t begin, uint64_t end) {
+    PermutationJob* job = context;
+    uint32_t* order = job->order + (size_t)worker * job->count;
+    uint8_t* mask = job->mask + (size_t)worker * job->count;
+    uint64_t* extreme = job->extreme + (size_t)worker * SUMMARY_COUNT;
+    uint32_t other_count = job->count - job->selected;
+    RandomState random;
+    SeedChunk(&random, job->seed, begin);
+    for (uint32_t i = 0; i < job->count; i++) order[i] = i; // Same start for every chunk, whoever runs it
+
+    for (uint64_t permutation = begin; permutation < end; permutation++) {
+        memset(mask, 0, job->count);
+        for (uint32_t i = 0; i < job->selected; i++) { // Partial Fisher-Yates, the first entries are a uniform subset
+            uint32_t j = i + RandomBelow(&random, job->count - i);
+            uint32_t swap = order[i];
+            order[i] = order[j];
+            order[j] = swap;
+            mask[order[i]] = 1;
+        }
+
+        double selected[SUMMARY_COUNT], other[SUMMARY_COUNT];
+        double selected_sum = MaskedSum(job->sorted, mask, job->count);
+        selected[SUMMARY_MEAN] = selected_sum / job->selected;
+        other[SUMMARY_MEAN] = (job->total - selected_sum) / other_count;
+        GroupPercentiles(job->sorted, mask, job->count, job->selected_ranks, job->other_ranks, selected + SUMMARY_MEDIAN, other + SUMMARY_MEDIAN);
+        for (int i = 0; i < SUMMARY_COUNT; i++) {
+            extreme[i] += fabs(other[i] - selected[i]) >= job->observed[i] * (1 - 1e-12); // Ties count as extreme
+        }
+    }
+}
+
+bool PermutationCompare(const double* a, uint32_t a_count, const double* b, uint32_t b_count, const ResampleOptions* options, PermutationResult* result) {
+    if (!a_count || !b_count || !options->resamples || (uint64_t)a_count + b_count > UINT32_MAX) {
+        return false;
+    }
+    int workers = WorkerCount(options);
+    uint32_t count = a_count + b_count;
+    PermutationJob job = {.count = count, .seed = options->seed, .selected_is_a = a_count <= b_count};
+    job.selected = job.selected_is_a ? a_count : b_count;
+    double* pooled = malloc((size_t)count * sizeof(double));
+    double* sorted_a = SortedCopy(a, a_count);
+    double* sorted_b = SortedCopy(b, b_count);
+    job.order = malloc((size_t)workers * count * sizeof(uint32_t));
+    job.mask = malloc((size_t)workers * count);
+    job.extreme = calloc((size_t)workers * SUMMARY_COUNT, sizeof(uint64_t));
+    bool ran = pooled && sorted_a && sorted_b && job.order && job.mask && job.extreme;
+    if (ran) {
+        SummarizeSorted(sorted_a, a_count, result->a);
+        SummarizeSorted(sorted_b, b_count, result->b);
+        for (int i = 0; i < SUMMARY_COUNT; i++) {
+            result->difference[i] = result->b[i] - result->a[i];
+            job.observed[i] = fabs(result->difference[i]);
+        }
+
+        memcpy(pooled, a, (size_t)a_count * sizeof(double));
+        memcpy(pooled + a_count, b, (size_t)b_count * sizeof(double));
+        qsort(pooled, count, sizeof(double), CompareDoubles);
+        job.sorted = pooled;
+        for (uint32_t i = 0; i < count; i++) job.total += pooled[i];
+        NearestRanks(job.selected, job.selected_ranks);
+        NearestRanks(count - job.selected, job.other_ranks);
+        ran = RunWorkPool(options->resamples, BOOTSTRAP_CHUNK, workers, PermutationChunk, &job, &result->pool);
+    }
+
+    if (ran) {
+        for (int i = 0; i < SUMMARY_COUNT; i++) {
+            uint64_t extreme = 0;
+            for (int worker = 0; worker < workers; worker++) extreme += job.extreme[(size_t)worker * SUMMARY_COUNT + i];
+            result->p_value[i] = (1.0 + (double)extreme) / (1.0 + options->resamples);
+        }
+    }
+    free(pooled);
+    free(sorted_a);
+    free(sorted_b);
+    free(job.order);
+    free(job.mask);
+    free(job.extreme);
+    return ran;
+}
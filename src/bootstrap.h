@@ -0,0 +1,53 @@
+// Resampling statistics for trial logs: bootstrap confidence intervals of a session's summary statistics, and
+// permutation tests between two sets of trials (before/after, device A vs B).
+// A resample is kept as a count per sorted trial instead of a copy, so every statistic comes out of one linear
+// pass (a weighted sum for the mean, a cumulative scan for the nearest-rank percentiles), no sort per resample.
+// Resamples are spread over a work-stealing pool. Each chunk of BOOTSTRAP_CHUNK resamples seeds its own
+// generator from the seed and the chunk index, so results depend on the seed only, not on the thread count.
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "work_pool.h"
+
+#define BOOTSTRAP_CHUNK 256
+
+typedef enum {
+    SUMMARY_MEAN,
+    SUMMARY_MEDIAN,             // Nearest rank, the lower middle value for an even count
+    SUMMARY_P90,
+    SUMMARY_P99,
+    SUMMARY_COUNT
+} SummaryStatistic;
+
+extern const char* const SUMMARY_NAMES[SUMMARY_COUNT];
+
+typedef struct {
+    uint32_t resamples;
+    double confidence;          // Two-sided, e.g. 0.95
+    uint64_t seed;
+    int threads;                // 0 = every processor
+} ResampleOptions;
+
+typedef struct {
+    double estimate;            // Of the sample itself
+    double lower;               // Percentile bootstrap bounds
+    double upper;
+} ConfidenceInterval;
+
+typedef struct {
+    ConfidenceInterval intervals[SUMMARY_COUNT];
+    WorkPoolStats pool;
+} BootstrapResult;
+
+typedef struct {
+    double a[SUMMARY_COUNT];
+    double b[SUMMARY_COUNT];
+    double difference[SUMMARY_COUNT];   // b - a
+    double p_value[SUMMARY_COUNT];      // Two-sided, (1 + as extreme) / (1 + permutations)
+    WorkPoolStats pool;
+} PermutationResult;
+
+void SummarizeSorted(const double* sorted, uint32_t count, double* statistics); // statistics holds SUMMARY_COUNT
+// False for an empty sample, bad options or no memory
+bool BootstrapSummary(const double* values, uint32_t count, const ResampleOptions* options, BootstrapResult* result);
+bool PermutationCompare(const double* a, uint32_t a_count, const double* b, uint32_t b_count, const ResampleOptions* options, PermutationResult* result);
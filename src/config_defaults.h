@@ -0,0 +1,27 @@
+// Defaults for every user.cfg key, shared by the Windows and Linux frontends
+#pragma once
+#define DEFAULT_MIN_DELAY 1000
+#define DEFAULT_MAX_DELAY 3000
+#define DEFAULT_FOREPERIOD_DISTRIBUTION "Uniform"
+#define DEFAULT_FOREPERIOD_MEAN 1000
+#define DEFAULT_EARLY_RESET_DELAY 3000
+#define DEFAULT_VIRTUAL_DEBOUNCE 50
+#define DEFAULT_STIMULUS_SPIN_WINDOW 2000
+#define DEFAULT_AVG_TRIALS 5
+#define DEFAULT_TOTAL_TRIALS 1000
+#define DEFAULT_LOG_FLUSH_INTERVAL 1000
+#define DEFAULT_HISTOGRAM_PRECISION 7
+#define DEFAULT_TRIAL_LOG_FORMAT "Both"
+#define DEFAULT_RANDOM_SEED "0"
+#define DEFAULT_DIAGNOSTICS_FLAG_THRESHOLD 0
+#define DEFAULT_PARTICIPANTS 1
+#define DEFAULT_TELEMETRY_NAME "ReactionTimeTester"
+#define DEFAULT_RAWKEYBOARDENABLE 1
+#define DEFAULT_RAWMOUSEENABLE 1
+#define DEFAULT_INPUT_THREAD_ENABLE 1
+#define DEFAULT_HOT_RELOAD_ENABLE 1
+#define DEFAULT_FONT_SIZE 32
+#define DEFAULT_FONT_NAME "Arial"
+#define DEFAULT_FONT_STYLE "Regular"
+#define DEFAULT_RESOLUTION_WIDTH 1280
+#define DEFAULT_RESOLUTION_HEIGHT 720
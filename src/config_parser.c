@@ -0,0 +1,230 @@
+#include <stdlib.h>
+#include <string.h>
+#include "config_parser.h"
+
+static char LowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static bool EqualsIgnoreCase(const char* a, const char* b) {
+    while (*a && LowerAscii(*a) == LowerAscii(*b)) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static uint32_t HashKey(const char* section, const char* key) { // FNV-1a over "section\0key", lowercased
+    uint32_t hash = 2166136261u;
+    for (; *section; section++) hash = (hash ^ (uint8_t)LowerAscii(*section)) * 16777619u;
+    hash = (hash ^ 0) * 16777619u;
+    for (; *key; key++) hash = (hash ^ (uint8_t)LowerAscii(*key)) * 16777619u;
+    return hash;
+}
+
+static bool IsBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static char* Trim(char* begin, char* end) { // Terminates at the last non-blank character
+    while (begin < end && IsBlank(*begin)) begin++;
+    while (end > begin && IsBlank(end[-1])) end--;
+    *end = '\0';
+    return begin;
+}
+
+static int32_t FindEntry(const ConfigFile* config, const char* section, const char* key, uint32_t hash) {
+    for (uint32_t slot = hash & config->index_mask;; slot = (slot + 1) & config->index_mask) {
+        int32_t entry = config->index[slot];
+        if (entry < 0) {
+            return -(int32_t)slot - 1; // Not found, encodes the free slot
+        }
+        const ConfigEntry* candidate = &config->entries[entry];
+        if (candidate->hash == hash && EqualsIgnoreCase(candidate->section, section) && EqualsIgnoreCase(candidate->key, key)) {
+            return entry;
+        }
+    }
+}
+
+static void AddEntry(ConfigFile* config, const char* section, const char* key, const char* value) {
+    uint32_t hash = HashKey(section, key);
+    int32_t found = FindEntry(config, section, key, hash);
+    if (found >= 0) {
+        return; // First definition wins
+    }
+    config->index[-found - 1] = config->count;
+    config->entries[config->count++] = (ConfigEntry){.section = section, .key = key, .value = value, .hash = hash};
+}
+
+static bool ParseOwnedText(ConfigFile* config, char* text, size_t size) {
+    text[size] = '\0';
+    config->text = text;
+
+    // One entry per line at most, the index stays at most half full
+    size_t lines = 1;
+    for (size_t i = 0; i < size; i++) {
+        lines += text[i] == '\n';
+    }
+    size_t index_size = 16;
+    while (index_size < lines * 2) index_size *= 2;
+
+    config->entries = malloc(lines * sizeof(ConfigEntry) + index_size * sizeof(int32_t));
+    if (!config->entries) {
+        free(text);
+        config->text = NULL;
+        return false;
+    }
+    config->index = (int32_t*)(config->entries + lines);
+    config->index_mask = (uint32_t)index_size - 1;
+    memset(config->index, 0xFF, index_size * sizeof(int32_t));
+
+    char* p = text;
+    char* end = text + size;
+    if (size >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0) {
+        p += 3; // UTF-8 byte order mark
+    }
+
+    const char* section = "";
+    while (p < end) {
+        char* line_end = memchr(p, '\n', (size_t)(end - p));
+        if (!line_end) line_end = end;
+        char* next = line_end < end ? line_end + 1 : end;
+
+        char* line = Trim(p, line_end);
+        p = next;
+        if (*line == '\0' || *line == ';' || *line == '#') {
+            continue;
+        }
+
+        if (*line == '[') {
+            char* close = strchr(line, ']');
+            if (close) {
+                section = Trim(line + 1, close);
+            }
+            continue;
+        }
+
+        char* equals = strchr(line, '=');
+        if (!equals) {
+            continue; // Not a key, ignored like the Windows profile API does
+        }
+        char* value_start = equals + 1;
+        while (IsBlank(*value_start)) value_start++;
+        char* quote_end = (*value_start == '"' || *value_start == '\'') ? strchr(value_start + 1, *value_start) : NULL;
+        char* value_end = strchr(quote_end ? quote_end : value_start, ';'); // A ';' inside quotes is part of the value
+        if (!value_end) value_end = value_start + strlen(value_start);
+
+        char* key = Trim(line, equals);
+        char* value = Trim(value_start, value_end);
+        size_t value_length = strlen(value);
+        if (value_length >= 2 && (value[0] == '"' || value[0] == '\'') && value[value_length - 1] == value[0]) {
+            value[value_length - 1] = '\0'; // Quoted values keep their inner whitespace
+            value++;
+        }
+        if (*key) {
+            AddEntry(config, section, key, value);
+        }
+    }
+    return true;
+}
+
+bool ParseConfig(ConfigFile* config, const char* text, size_t size) {
+    memset(config, 0, sizeof(*config));
+    char* copy = malloc(size + 1);
+    if (!copy) {
+        return false;
+    }
+    memcpy(copy, text, size);
+    return ParseOwnedText(config, copy, size);
+}
+
+bool LoadConfigFile(ConfigFile* config, FILE* file) { // One read for the whole file
+    memset(config, 0, sizeof(*config));
+    if (fseek(file, 0, SEEK_END) != 0) {
+        return false;
+    }
+    long size = ftell(file);
+    if (size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        return false;
+    }
+
+    char* text = malloc((size_t)size + 1);
+    if (!text) {
+        return false;
+    }
+    if (fread(text, 1, (size_t)size, file) != (size_t)size) {
+        free(text);
+        return false;
+    }
+    return ParseOwnedText(config, text, (size_t)size);
+}
+
+void FreeConfig(ConfigFile* config) {
+    free(config->entries);
+    free(config->text);
+    memset(config, 0, sizeof(*config));
+}
+
+const char* ConfigString(const ConfigFile* config, const char* section, const char* key, const char* fallback) {
+    if (!config->entries) {
+        return fallback;
+    }
+    int32_t entry = FindEntry(config, section, key, HashKey(section, key));
+    return entry >= 0 ? config->entries[entry].value : fallback;
+}
+
+static const char* ParseInt(const char* p, long long* value) { // Decimal with optional sign, NULL if there are no digits
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+') p++;
+    if (*p < '0' || *p > '9') {
+        return NULL;
+    }
+
+    long long result = 0;
+    while (*p >= '0' && *p <= '9') {
+        if (result < 1000000000000LL) result = result * 10 + (*p - '0'); // Saturates far outside any int range
+        p++;
+    }
+    *value = negative ? -result : result;
+    return p;
+}
+
+bool ConfigInt(const ConfigFile* config, const char* section, const char* key, int fallback, int min, int max, int* value) {
+    const char* text = ConfigString(config, section, key, NULL);
+    if (!text) {
+        *value = fallback;
+        return true;
+    }
+
+    long long parsed;
+    const char* end = ParseInt(text, &parsed);
+    if (!end || *end != '\0' || parsed < min || parsed > max) {
+        *value = fallback;
+        return false;
+    }
+    *value = (int)parsed;
+    return true;
+}
+
+bool ConfigColor(const ConfigFile* config, const char* section, const char* key, uint8_t color[3]) {
+    const char* p = ConfigString(config, section, key, NULL);
+    if (!p) {
+        return false;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        long long component;
+        while (IsBlank(*p)) p++;
+        p = ParseInt(p, &component);
+        if (!p || component < 0 || component > 255) {
+            return false;
+        }
+        color[i] = (uint8_t)component;
+
+        while (IsBlank(*p)) p++;
+        if (i < 2 && *p++ != ',') {
+            return false;
+        }
+    }
+    return *p == '\0';
+}
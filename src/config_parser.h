@@ -0,0 +1,32 @@
+// Single-pass INI parser: the file is read into one buffer and split in place, keys are found through a hash index.
+// Section and key lookups are case-insensitive, ';' starts a comment anywhere on a line, '#' at the start of one.
+// Duplicate keys keep the first value, like GetPrivateProfileString.
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+    const char* section;
+    const char* key;
+    const char* value;
+    uint32_t hash;
+} ConfigEntry;
+
+typedef struct {
+    char* text;                 // File contents, NUL-terminated in place
+    ConfigEntry* entries;       // Shares one allocation with the index
+    int32_t* index;             // Open addressing, -1 = empty
+    uint32_t index_mask;
+    int count;
+} ConfigFile;
+
+bool ParseConfig(ConfigFile* config, const char* text, size_t size);
+bool LoadConfigFile(ConfigFile* config, FILE* file);
+void FreeConfig(ConfigFile* config);
+
+// Typed lookups. Missing keys return the fallback, present but invalid values return false.
+const char* ConfigString(const ConfigFile* config, const char* section, const char* key, const char* fallback);
+bool ConfigInt(const ConfigFile* config, const char* section, const char* key, int fallback, int min, int max, int* value);
+bool ConfigColor(const ConfigFile* config, const char* section, const char* key, uint8_t color[3]); // "r,g,b", required
@@ -0,0 +1,183 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+#include <string.h>
+#include "config_watcher.h"
+
+#ifdef _WIN32
+static bool IsWatchedFile(const ConfigWatcher* watcher, const FILE_NOTIFY_INFORMATION* info) {
+    size_t length = info->FileNameLength / sizeof(WCHAR);
+    return length == wcslen(watcher->file_name) && _wcsnicmp(info->FileName, watcher->file_name, length) == 0;
+}
+
+static void WatcherThread(void* arg) {
+    ConfigWatcher* watcher = arg;
+    _Alignas(DWORD) BYTE buffer[4096];
+    OVERLAPPED overlapped = {0};
+    overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!overlapped.hEvent) {
+        return;
+    }
+
+    HANDLE handles[2] = {overlapped.hEvent, watcher->stop_event};
+    bool reading = false;
+    bool pending = false;
+    while (atomic_load(&watcher->running)) {
+        if (!reading) {
+            reading = ReadDirectoryChangesW(watcher->directory, buffer, sizeof(buffer), FALSE,
+                FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE, NULL, &overlapped, NULL);
+            if (!reading) {
+                break;
+            }
+        }
+
+        DWORD result = WaitForMultipleObjects(2, handles, FALSE, pending ? CONFIG_WATCH_SETTLE_MS : INFINITE);
+        if (result == WAIT_OBJECT_0 + 1) {
+            break;
+        }
+        if (result == WAIT_TIMEOUT) { // Quiet long enough, the write is done
+            pending = false;
+            watcher->on_change(watcher->context);
+            continue;
+        }
+        if (result != WAIT_OBJECT_0) {
+            break;
+        }
+
+        DWORD bytes = 0;
+        reading = false;
+        if (!GetOverlappedResult(watcher->directory, &overlapped, &bytes, FALSE)) {
+            continue;
+        }
+        if (bytes == 0) {
+            pending = true; // Notification buffer overflowed, assume our file was part of it
+            continue;
+        }
+        for (BYTE* entry = buffer;; ) {
+            const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)entry;
+            pending |= IsWatchedFile(watcher, info);
+            if (!info->NextEntryOffset) break;
+            entry += info->NextEntryOffset;
+        }
+    }
+
+    if (reading) {
+        CancelIo(watcher->directory);
+        DWORD bytes;
+        GetOverlappedResult(watcher->directory, &overlapped, &bytes, TRUE);
+    }
+    CloseHandle(overlapped.hEvent);
+}
+#else
+static void WatcherThread(void* arg) {
+    ConfigWatcher* watcher = arg;
+    _Alignas(struct inotify_event) char buffer[4096];
+    struct pollfd fds[2] = {{.fd = watcher->inotify_fd, .events = POLLIN}, {.fd = watcher->stop_pipe[0], .events = POLLIN}};
+
+    bool pending = false;
+    while (atomic_load(&watcher->running)) {
+        int result = poll(fds, 2, pending ? CONFIG_WATCH_SETTLE_MS : -1);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) {
+            break;
+        }
+        if (result == 0) { // Quiet long enough, the write is done
+            pending = false;
+            watcher->on_change(watcher->context);
+            continue;
+        }
+
+        ssize_t length;
+        while ((length = read(watcher->inotify_fd, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + length; ) {
+                const struct inotify_event* event = (const struct inotify_event*)p;
+                pending |= (event->mask & IN_Q_OVERFLOW) || (event->len && strcmp(event->name, watcher->file_name) == 0);
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+}
+#endif
+
+bool StartConfigWatcher(ConfigWatcher* watcher, const char* directory, const char* file_name, ConfigChangeCallback on_change, void* context) {
+    watcher->on_change = on_change;
+    watcher->context = context;
+    atomic_init(&watcher->running, false);
+
+#ifdef _WIN32
+    if (!MultiByteToWideChar(CP_ACP, 0, file_name, -1, watcher->file_name, CONFIG_WATCH_NAME_SIZE)) {
+        return false;
+    }
+    watcher->directory = CreateFileA(directory, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (watcher->directory == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    watcher->stop_event = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!watcher->stop_event) {
+        CloseHandle(watcher->directory);
+        return false;
+    }
+#else
+    if (strlen(file_name) >= CONFIG_WATCH_NAME_SIZE) {
+        return false;
+    }
+    strcpy(watcher->file_name, file_name);
+    watcher->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher->inotify_fd < 0) {
+        return false;
+    }
+    // Editors either rewrite in place or write a temporary file and rename it over the original
+    if (inotify_add_watch(watcher->inotify_fd, directory, IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE) < 0 ||
+        pipe2(watcher->stop_pipe, O_CLOEXEC) != 0) {
+        close(watcher->inotify_fd);
+        return false;
+    }
+#endif
+
+    atomic_store(&watcher->running, true);
+    if (!StartThread(&watcher->thread, WatcherThread, watcher)) {
+        atomic_store(&watcher->running, false);
+#ifdef _WIN32
+        CloseHandle(watcher->stop_event);
+        CloseHandle(watcher->directory);
+#else
+        close(watcher->stop_pipe[0]);
+        close(watcher->stop_pipe[1]);
+        close(watcher->inotify_fd);
+#endif
+        return false;
+    }
+    return true;
+}
+
+void StopConfigWatcher(ConfigWatcher* watcher) {
+    if (!atomic_exchange(&watcher->running, false)) {
+        return;
+    }
+
+#ifdef _WIN32
+    SetEvent(watcher->stop_event);
+    JoinThread(&watcher->thread);
+    CloseHandle(watcher->stop_event);
+    CloseHandle(watcher->directory);
+#else
+    char stop = 1;
+    ssize_t written = write(watcher->stop_pipe[1], &stop, 1); // Cannot fail short of a closed pipe
+    (void)written;
+    JoinThread(&watcher->thread);
+    close(watcher->stop_pipe[0]);
+    close(watcher->stop_pipe[1]);
+    close(watcher->inotify_fd);
+#endif
+}
@@ -0,0 +1,32 @@
+// Watches one file in a directory and reports changes from a background thread
+// (ReadDirectoryChangesW on Windows, inotify elsewhere). Bursts of events, e.g. an editor's
+// truncate + write + rename, are coalesced into one callback once the file has been quiet for a moment.
+#pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "platform.h"
+
+#define CONFIG_WATCH_SETTLE_MS 100
+#define CONFIG_WATCH_NAME_SIZE 260
+
+typedef void (*ConfigChangeCallback)(void* context); // Called on the watcher thread
+
+typedef struct {
+    PlatformThread thread;
+    ConfigChangeCallback on_change;
+    void* context;
+    atomic_bool running;
+#ifdef _WIN32
+    void* directory;
+    void* stop_event;
+    wchar_t file_name[CONFIG_WATCH_NAME_SIZE];
+#else
+    int inotify_fd;
+    int stop_pipe[2];
+    char file_name[CONFIG_WATCH_NAME_SIZE];
+#endif
+} ConfigWatcher;
+
+bool StartConfigWatcher(ConfigWatcher* watcher, const char* directory, const char* file_name, ConfigChangeCallback on_change, void* context);
+void StopConfigWatcher(ConfigWatcher* watcher);   // Safe to call if the watcher never started
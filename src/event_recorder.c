@@ -0,0 +1,641 @@
+#include <stdlib.h>
+#include <string.h>
+#include "event_recorder.h"
+#include "platform.h"
+
+#define QUANTILE_COUNT ((1u << FOREPERIOD_QUANTILE_BITS) + 1)
+#define FNV_OFFSET 0xCBF29CE484222325ull
+#define FNV_PRIME 0x100000001B3ull
+
+_Static_assert(sizeof(TrialRecord) == 72, "TrialRecord has padding, the digest would hash garbage");
+
+static uint64_t DigestTrial(uint64_t digest, const TrialRecord* record) { // FNV-1a over the raw record, so any field changing shows up
+    const uint8_t* bytes = (const uint8_t*)record;
+    for (size_t i = 0; i < sizeof(*record); i++) {
+        digest = (digest ^ bytes[i]) * FNV_PRIME;
+    }
+    return digest;
+}
+
+// Writing
+static bool Recording(const EventRecorder* recorder) {
+    return recorder->file && !recorder->failed;
+}
+
+static void FlushRecorder(EventRecorder* recorder) {
+    if (recorder->buffer_used && fwrite(recorder->buffer, 1, recorder->buffer_used, recorder->file) != recorder->buffer_used) {
+        recorder->failed = true;
+    }
+    recorder->buffer_used = 0;
+}
+
+static uint8_t* Reserve(EventRecorder* recorder, size_t bytes) { // Room for one small record, committed with Commit
+    if (EVENT_RECORDER_BUFFER_SIZE - recorder->buffer_used < bytes) {
+        FlushRecorder(recorder);
+    }
+    return recorder->buffer + recorder->buffer_used;
+}
+
+static void Commit(EventRecorder* recorder, const uint8_t* end) {
+    recorder->buffer_used = (size_t)(end - recorder->buffer);
+}
+
+static uint8_t* PutVarint(uint8_t* p, uint64_t value) {
+    while (value >= 0x80) {
+        *p++ = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+static uint8_t* PutSigned(uint8_t* p, int64_t value) { // Zigzag, small negatives stay small
+    return PutVarint(p, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+static uint8_t* PutTick(EventRecorder* recorder, uint8_t* p, int64_t tick) {
+    p = PutSigned(p, (int64_t)((uint64_t)tick - (uint64_t)recorder->last_tick));
+    recorder->last_tick = tick;
+    return p;
+}
+
+// Platform forwarding, every callback goes to the frontend unchanged
+static int64_t RecorderNow(void* context) {
+    EventRecorder* recorder = context;
+    int64_t tick = recorder->inner.now(recorder->inner.context);
+    if (Recording(recorder)) {
+        uint8_t* p = Reserve(recorder, 16);
+        *p++ = RECORD_CLOCK;
+        Commit(recorder, PutTick(recorder, p, tick));
+    }
+    return tick;
+}
+
+static void RecorderSetTimer(void* context, int timer_id, int delay_ms) {
+    EventRecorder* recorder = context;
+    recorder->inner.set_timer(recorder->inner.context, timer_id, delay_ms);
+}
+
+static void RecorderKillTimer(void* context, int timer_id) {
+    EventRecorder* recorder = context;
+    recorder->inner.kill_timer(recorder->inner.context, timer_id);
+}
+
+static void RecorderRepaint(void* context) {
+    EventRecorder* recorder = context;
+    recorder->inner.request_repaint(recorder->inner.context);
+}
+
+static void RecorderScheduleStimulus(void* context, int64_t deadline_tick) {
+    EventRecorder* recorder = context;
+    recorder->inner.schedule_stimulus(recorder->inner.context, deadline_tick);
+}
+
+static void RecorderCancelStimulus(void* context) {
+    EventRecorder* recorder = context;
+    recorder->inner.cancel_stimulus(recorder->inner.context);
+}
+
+static void RecorderTrialComplete(void* context, const TrialRecord* record) {
+    EventRecorder* recorder = context;
+    recorder->trials++;
+    recorder->digest = DigestTrial(recorder->digest, record);
+    if (recorder->inner.trial_complete) {
+        recorder->inner.trial_complete(recorder->inner.context, record);
+    }
+}
+
+// Recorder
+bool StartEventRecorder(EventRecorder* recorder, FILE* file, ReactionEngine* engine, uint64_t session_id, int64_t start_time) {
+    recorder->file = NULL;
+    if (!file) {
+        return false;
+    }
+    if (engine->data.foreperiods.drawn != 0) { // Replay starts from a fresh engine, so must the recording
+        fclose(file);
+        return false;
+    }
+
+    EventRecordingHeader header = {
+        .magic = EVENT_RECORDING_MAGIC,
+        .version = EVENT_RECORDING_VERSION,
+        .session_id = session_id,
+        .frequency = engine->data.frequency,
+        .start_time = start_time,
+        .seed = engine->data.foreperiods.seed,
+        .first_tick = engine->platform.now(engine->platform.context)
+    };
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        fclose(file);
+        return false;
+    }
+
+    recorder->file = file;
+    recorder->engine = engine;
+    recorder->inner = engine->platform;
+    recorder->last_tick = header.first_tick;
+    recorder->trials = 0;
+    recorder->digest = FNV_OFFSET;
+    recorder->failed = false;
+    recorder->buffer_used = 0;
+
+    // What the replayer builds its engine from
+    RecordEngineConfig(recorder);
+    RecordForeperiods(recorder);
+    recorder->mouse_active = !engine->state.mouse_active;
+    RecordMouseActive(recorder, engine->state.mouse_active);
+
+    engine->platform = (EnginePlatform){
+        .context = recorder,
+        .now = RecorderNow,
+        .set_timer = RecorderSetTimer,
+        .kill_timer = RecorderKillTimer,
+        .request_repaint = RecorderRepaint,
+        .schedule_stimulus = RecorderScheduleStimulus,
+        .cancel_stimulus = RecorderCancelStimulus,
+        .trial_complete = RecorderTrialComplete
+    };
+    return true;
+}
+
+bool StopEventRecorder(EventRecorder* recorder) {
+    if (!recorder->file) {
+        return false;
+    }
+    recorder->engine->platform = recorder->inner;
+
+    uint8_t* p = Reserve(recorder, 24);
+    *p++ = RECORD_END;
+    p = PutVarint(p, recorder->trials);
+    memcpy(p, &recorder->digest, sizeof(recorder->digest));
+    Commit(recorder, p + sizeof(recorder->digest));
+    FlushRecorder(recorder);
+
+    bool written = !recorder->failed;
+    written = fclose(recorder->file) == 0 && written;
+    recorder->file = NULL;
+    return written;
+}
+
+void RecordInputBatch(EventRecorder* recorder, const InputEventBatch* batch, bool keyboard_enabled, bool mouse_enabled) {
+    if (!Recording(recorder) || batch->count == 0) {
+        return;
+    }
+    uint8_t* p = Reserve(recorder, 16);
+    *p++ = RECORD_INPUT_BATCH;
+    *p++ = (uint8_t)(keyboard_enabled | mouse_enabled << 1);
+    Commit(recorder, PutVarint(p, batch->count));
+
+    for (uint32_t i = 0; i < batch->count; i++) {
+        const InputEvent* event = &batch->events[i];
+        p = Reserve(recorder, 32);
+        p = PutTick(recorder, p, event->arrival_tick);
+        p = PutVarint(p, event->message_delay_ms);
+        p = PutVarint(p, event->key);
+        *p++ = (uint8_t)(event->source | event->pressed << 1);
+        Commit(recorder, p);
+    }
+}
+
+void RecordInput(EventRecorder* recorder, bool is_mouse_input, int64_t input_tick) {
+    if (!Recording(recorder)) {
+        return;
+    }
+    uint8_t* p = Reserve(recorder, 24);
+    *p++ = RECORD_INPUT;
+    *p++ = is_mouse_input;
+    p = PutVarint(p, recorder->engine->data.input_key);
+    Commit(recorder, PutTick(recorder, p, input_tick));
+}
+
+void RecordTimer(EventRecorder* recorder, int timer_id) {
+    if (!Recording(recorder)) {
+        return;
+    }
+    int64_t tick = recorder->inner.now(recorder->inner.context); // Only paces real-time replay, the engine never sees it
+    uint8_t* p = Reserve(recorder, 24);
+    *p++ = RECORD_TIMER;
+    p = PutVarint(p, (uint32_t)timer_id);
+    Commit(recorder, PutTick(recorder, p, tick));
+}
+
+void RecordStimulus(EventRecorder* recorder, int64_t scheduled_tick, int64_t onset_tick) {
+    if (!Recording(recorder)) {
+        return;
+    }
+    uint8_t* p = Reserve(recorder, 24);
+    *p++ = RECORD_STIMULUS;
+    p = PutTick(recorder, p, scheduled_tick);
+    Commit(recorder, PutTick(recorder, p, onset_tick));
+}
+
+void RecordPresented(EventRecorder* recorder, int64_t tick) {
+    if (!Recording(recorder)) {
+        return;
+    }
+    uint8_t* p = Reserve(recorder, 16);
+    *p++ = RECORD_PRESENTED;
+    Commit(recorder, PutTick(recorder, p, tick));
+}
+
+void RecordMouseActive(EventRecorder* recorder, bool mouse_active) {
+    if (!Recording(recorder) || recorder->mouse_active == mouse_active) {
+        return;
+    }
+    recorder->mouse_active = mouse_active;
+    uint8_t* p = Reserve(recorder, 2);
+    *p++ = RECORD_MOUSE_ACTIVE;
+    *p++ = mouse_active;
+    Commit(recorder, p);
+}
+
+void RecordEngineConfig(EventRecorder* recorder) {
+    if (!Recording(recorder)) {
+        return;
+    }
+    const EngineConfig* config = &recorder->engine->config;
+    uint8_t* p = Reserve(recorder, 64);
+    *p++ = RECORD_CONFIG;
+    p = PutSigned(p, config->averaging_trials);
+    p = PutSigned(p, config->total_trials);
+    p = PutSigned(p, config->early_reset_delay);
+    p = PutSigned(p, config->virtual_debounce);
+    Commit(recorder, PutSigned(p, config->histogram_precision));
+}
+
+void RecordForeperiods(EventRecorder* recorder) { // The built tables, not the config text, so replay never depends on the parser
+    if (!Recording(recorder)) {
+        return;
+    }
+    const ForeperiodDistribution* distribution = &recorder->engine->data.foreperiods.distribution;
+    uint8_t* p = Reserve(recorder, 64);
+    *p++ = RECORD_FOREPERIODS;
+    *p++ = (uint8_t)distribution->model;
+    p = PutSigned(p, distribution->min_delay);
+    p = PutSigned(p, distribution->max_delay);
+    p = PutVarint(p, distribution->count);
+    Commit(recorder, PutVarint(p, distribution->quantiles ? QUANTILE_COUNT : 0));
+
+    for (uint32_t i = 0; i < distribution->count; i++) {
+        p = Reserve(recorder, 32);
+        p = PutSigned(p, distribution->values[i]);
+        p = PutVarint(p, distribution->thresholds[i]);
+        Commit(recorder, PutVarint(p, distribution->alias[i]));
+    }
+    for (uint32_t i = 0; distribution->quantiles && i < QUANTILE_COUNT; i++) {
+        p = Reserve(recorder, sizeof(double));
+        memcpy(p, &distribution->quantiles[i], sizeof(double));
+        Commit(recorder, p + sizeof(double));
+    }
+}
+
+// Reading
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+    int64_t last_tick;
+    bool truncated;             // Ran off the end (or into a malformed varint)
+} StreamReader;
+
+static uint8_t GetByte(StreamReader* stream) {
+    if (stream->p == stream->end) {
+        stream->truncated = true;
+        return 0;
+    }
+    return *stream->p++;
+}
+
+static uint64_t GetVarint(StreamReader* stream) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = GetByte(stream);
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    stream->truncated = true;
+    return value;
+}
+
+static int64_t GetSigned(StreamReader* stream) {
+    uint64_t value = GetVarint(stream);
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static int64_t GetTick(StreamReader* stream) {
+    stream->last_tick = (int64_t)((uint64_t)stream->last_tick + (uint64_t)GetSigned(stream));
+    return stream->last_tick;
+}
+
+static bool GetForeperiods(StreamReader* stream, ForeperiodDistribution* distribution) { // Leaves a distribution that is safe to free
+    *distribution = (ForeperiodDistribution){.model = GetByte(stream)};
+    distribution->min_delay = (int32_t)GetSigned(stream);
+    distribution->max_delay = (int32_t)GetSigned(stream);
+    uint64_t count = GetVarint(stream);
+    uint64_t quantiles = GetVarint(stream);
+    if (stream->truncated || distribution->model > FOREPERIOD_WEIGHTED || distribution->min_delay > distribution->max_delay ||
+        count > FOREPERIOD_MAX_POINTS || (distribution->model == FOREPERIOD_WEIGHTED) != (count > 0) ||
+        (distribution->model == FOREPERIOD_EXPONENTIAL) != (quantiles == QUANTILE_COUNT) || (quantiles && quantiles != QUANTILE_COUNT)) {
+        return false;
+    }
+
+    if (count) {
+        distribution->count = (uint32_t)count;
+        distribution->values = malloc(count * sizeof(int32_t));
+        distribution->thresholds = malloc(count * sizeof(uint32_t));
+        distribution->alias = malloc(count * sizeof(uint32_t));
+        if (!distribution->values || !distribution->thresholds || !distribution->alias) {
+            return false;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            distribution->values[i] = (int32_t)GetSigned(stream);
+            distribution->thresholds[i] = (uint32_t)GetVarint(stream);
+            distribution->alias[i] = (uint32_t)GetVarint(stream);
+            if (distribution->alias[i] >= count) {
+                return false;
+            }
+        }
+    }
+    if (quantiles) {
+        distribution->quantiles = malloc(QUANTILE_COUNT * sizeof(double));
+        if (!distribution->quantiles || (size_t)(stream->end - stream->p) < QUANTILE_COUNT * sizeof(double)) {
+            stream->truncated = distribution->quantiles != NULL;
+            return false;
+        }
+        memcpy(distribution->quantiles, stream->p, QUANTILE_COUNT * sizeof(double));
+        stream->p += QUANTILE_COUNT * sizeof(double);
+    }
+    return !stream->truncated;
+}
+
+// Replay
+typedef struct {
+    StreamReader stream;
+    const ReplayOptions* options;
+    ReplayResult* result;
+    ReactionEngine engine;
+    InputEventBatch batch;
+    bool initialized;
+    bool diverged;
+    int64_t wall_start;         // Real-time mode only
+    PlatformEvent wait;
+} Replay;
+
+static int64_t ReplayNow(void* context) { // Hands the engine the clock reads it made while recording, in order
+    Replay* replay = context;
+    StreamReader* stream = &replay->stream;
+    if (stream->p == stream->end || *stream->p != RECORD_CLOCK) {
+        replay->diverged = true;
+        return stream->last_tick;
+    }
+    stream->p++;
+    replay->result->events++;
+    return GetTick(stream);
+}
+
+static void ReplaySetTimer(void* context, int timer_id, int delay_ms) { // Expiries are in the stream
+    (void)context;
+    (void)timer_id;
+    (void)delay_ms;
+}
+
+static void ReplayKillTimer(void* context, int timer_id) {
+    (void)context;
+    (void)timer_id;
+}
+
+static void ReplayRepaint(void* context) {
+    (void)context;
+}
+
+static void ReplayScheduleStimulus(void* context, int64_t deadline_tick) { // Onsets are in the stream
+    (void)context;
+    (void)deadline_tick;
+}
+
+static void ReplayCancelStimulus(void* context) {
+    (void)context;
+}
+
+static void ReplayTrialComplete(void* context, const TrialRecord* record) {
+    Replay* replay = context;
+    replay->result->trials++;
+    replay->result->digest = DigestTrial(replay->result->digest, record);
+    if (replay->options->trial_complete) {
+        replay->options->trial_complete(replay->options->context, record);
+    }
+}
+
+static void WaitForTick(Replay* replay, int64_t tick) { // Real-time mode: sleep most of the gap, spin the last 2ms
+    if (!replay->options->real_time) {
+        return;
+    }
+    int64_t frequency = ClockFrequency();
+    double elapsed = (double)(tick - replay->result->header.first_tick) / (double)replay->result->header.frequency;
+    int64_t deadline = replay->wall_start + (int64_t)(elapsed * (double)frequency);
+    for (;;) {
+        int64_t remaining = deadline - ClockNow();
+        if (remaining <= 0) {
+            return;
+        }
+        double remaining_ms = TicksToMilliseconds(remaining, frequency);
+        if (remaining_ms > 2) {
+            WaitEvent(&replay->wait, (int)remaining_ms - 1);
+        } else {
+            CpuRelax();
+        }
+    }
+}
+
+static bool ReplayRecord(Replay* replay, uint8_t type, EngineConfig* config) { // False once the result is decided
+    StreamReader* stream = &replay->stream;
+    ReplayResult* result = replay->result;
+    ReactionEngine* engine = &replay->engine;
+    if (!replay->initialized && type != RECORD_CONFIG && type != RECORD_FOREPERIODS) {
+        result->status = REPLAY_INVALID; // The recorder always starts with both
+        return false;
+    }
+
+    switch (type) {
+    case RECORD_CLOCK:
+        result->status = REPLAY_DIVERGED; // The engine read the clock fewer times than when recorded
+        return false;
+
+    case RECORD_INPUT_BATCH: {
+        InputEventBatch* batch = &replay->batch;
+        uint8_t enabled = GetByte(stream);
+        uint64_t count = GetVarint(stream);
+        if (count > INPUT_BATCH_CAPACITY) {
+            result->status = REPLAY_INVALID;
+            return false;
+        }
+        batch->count = (uint32_t)count;
+        for (uint32_t i = 0; i < batch->count; i++) {
+            InputEvent* event = &batch->events[i];
+            event->arrival_tick = GetTick(stream);
+            event->message_delay_ms = (uint32_t)GetVarint(stream);
+            event->key = (uint16_t)GetVarint(stream);
+            uint8_t flags = GetByte(stream);
+            event->source = flags & 1;
+            event->pressed = flags >> 1 & 1;
+        }
+        if (stream->truncated) break;
+        WaitForTick(replay, stream->last_tick);
+        DispatchInputBatch(engine, batch, enabled & 1, enabled >> 1 & 1);
+        break;
+    }
+
+    case RECORD_INPUT: {
+        bool is_mouse = GetByte(stream);
+        uint16_t key = (uint16_t)GetVarint(stream);
+        int64_t tick = GetTick(stream);
+        if (stream->truncated) break;
+        WaitForTick(replay, tick);
+        engine->data.input_key = key;
+        HandleInput(engine, is_mouse, tick);
+        break;
+    }
+
+    case RECORD_TIMER: {
+        int timer_id = (int)GetVarint(stream);
+        int64_t tick = GetTick(stream);
+        if (stream->truncated) break;
+        WaitForTick(replay, tick);
+        TimerStateLogic(engine, timer_id);
+        break;
+    }
+
+    case RECORD_STIMULUS: {
+        int64_t scheduled = GetTick(stream);
+        int64_t onset = GetTick(stream);
+        if (stream->truncated) break;
+        WaitForTick(replay, onset);
+        StimulusOnset(engine, scheduled, onset);
+        break;
+    }
+
+    case RECORD_PRESENTED: {
+        int64_t tick = GetTick(stream);
+        if (stream->truncated) break;
+        WaitForTick(replay, tick);
+        StimulusPresented(engine, tick);
+        break;
+    }
+
+    case RECORD_MOUSE_ACTIVE:
+        engine->state.mouse_active = GetByte(stream) != 0;
+        break;
+
+    case RECORD_CONFIG:
+        config->averaging_trials = (int)GetSigned(stream);
+        config->total_trials = (int)GetSigned(stream);
+        config->early_reset_delay = (int)GetSigned(stream);
+        config->virtual_debounce = (int)GetSigned(stream);
+        config->histogram_precision = (int)GetSigned(stream);
+        if (!stream->truncated && replay->initialized && !UpdateEngineConfig(engine, config)) {
+            result->status = REPLAY_INVALID;
+            return false;
+        }
+        break;
+
+    case RECORD_FOREPERIODS: {
+        ForeperiodDistribution foreperiods;
+        if (!GetForeperiods(stream, &foreperiods)) {
+            FreeForeperiodDistribution(&foreperiods);
+            if (!stream->truncated) result->status = REPLAY_INVALID;
+            break;
+        }
+        if (replay->initialized) {
+            SetEngineForeperiods(engine, &foreperiods);
+            break;
+        }
+        EnginePlatform platform = {
+            .context = replay,
+            .now = ReplayNow,
+            .set_timer = ReplaySetTimer,
+            .kill_timer = ReplayKillTimer,
+            .request_repaint = ReplayRepaint,
+            .schedule_stimulus = ReplayScheduleStimulus,
+            .cancel_stimulus = ReplayCancelStimulus,
+            .trial_complete = ReplayTrialComplete
+        };
+        if (!InitializeEngine(engine, config, &platform, result->header.frequency, &foreperiods, result->header.seed)) {
+            result->status = REPLAY_INVALID;
+            return false;
+        }
+        replay->initialized = true;
+        break;
+    }
+
+    case RECORD_END: {
+        result->recorded_trials = (uint32_t)GetVarint(stream);
+        if ((size_t)(stream->end - stream->p) < sizeof(result->recorded_digest)) {
+            stream->truncated = true;
+            break;
+        }
+        memcpy(&result->recorded_digest, stream->p, sizeof(result->recorded_digest));
+        stream->p += sizeof(result->recorded_digest);
+        bool same = result->trials == result->recorded_trials && result->digest == result->recorded_digest;
+        result->status = same ? REPLAY_MATCH : REPLAY_MISMATCH;
+        return false;
+    }
+
+    default:
+        result->status = REPLAY_INVALID;
+        return false;
+    }
+
+    if (stream->truncated) {
+        result->status = result->status == REPLAY_INVALID ? REPLAY_INVALID : REPLAY_TRUNCATED;
+        return false;
+    }
+    if (replay->diverged) {
+        result->status = REPLAY_DIVERGED;
+        return false;
+    }
+    return result->status != REPLAY_INVALID;
+}
+
+bool ReplayEventRecording(const void* data, size_t size, const ReplayOptions* options, ReplayResult* result) {
+    memset(result, 0, sizeof(*result));
+    result->status = REPLAY_INVALID;
+    result->digest = FNV_OFFSET;
+    if (size < sizeof(EventRecordingHeader)) {
+        return false;
+    }
+    memcpy(&result->header, data, sizeof(result->header));
+    if (result->header.magic != EVENT_RECORDING_MAGIC || result->header.version != EVENT_RECORDING_VERSION || result->header.frequency <= 0) {
+        return false;
+    }
+
+    Replay* replay = calloc(1, sizeof(Replay));
+    if (!replay || (options->real_time && !InitializeEvent(&replay->wait))) {
+        free(replay);
+        return false;
+    }
+    replay->options = options;
+    replay->result = result;
+    replay->stream = (StreamReader){
+        .p = (const uint8_t*)data + sizeof(EventRecordingHeader),
+        .end = (const uint8_t*)data + size,
+        .last_tick = result->header.first_tick
+    };
+    replay->wall_start = ClockNow();
+
+    EngineConfig config = {0};
+    result->status = REPLAY_TRUNCATED; // Until an END record says otherwise
+    while (replay->stream.p < replay->stream.end) {
+        uint8_t type = *replay->stream.p++;
+        result->events++;
+        if (!ReplayRecord(replay, type, &config)) {
+            break;
+        }
+    }
+    result->last_tick = replay->stream.last_tick;
+
+    if (replay->initialized) FreeEngine(&replay->engine);
+    if (options->real_time) DestroyEvent(&replay->wait);
+    free(replay);
+    return result->status == REPLAY_MATCH;
+}
@@ -0,0 +1,97 @@
+// Input event recording (.rec) and deterministic replay.
+//
+// The recorder sits between the engine and its platform: every event the frontend feeds the engine (input,
+// timers, stimulus onsets, config changes) and every clock read the engine makes is written with its tick.
+// Feeding the same stream back into a fresh engine reproduces every trial record bit for bit, so a recording
+// doubles as a regression case. The replayer never sleeps unless asked to, a day of trials replays in seconds.
+//
+// Layout: EventRecordingHeader | records. A record is one type byte followed by LEB128 varints, ticks are
+// zigzag deltas from the previous tick in the stream. The stream ends with an END record holding the trial
+// count and a digest of every TrialRecord; a file without one (crashed session) replays up to where it stops.
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "input_events.h"
+#include "reaction_engine.h"
+
+#define EVENT_RECORDING_MAGIC 0x52455452u      // "RTER"
+#define EVENT_RECORDING_VERSION 2              // 2: PRESENTED records, 72-byte TrialRecord in the digest
+#define EVENT_RECORDER_BUFFER_SIZE 65536
+
+typedef enum {
+    RECORD_CLOCK = 1,           // The engine read the clock: tick
+    RECORD_INPUT_BATCH,         // DispatchInputBatch: enabled sources, count, then tick, delay, key, source | pressed << 1 per event
+    RECORD_INPUT,               // Direct HandleInput call: is_mouse, key, tick
+    RECORD_TIMER,               // TimerStateLogic: timer id, tick
+    RECORD_STIMULUS,            // StimulusOnset: scheduled tick, onset tick
+    RECORD_MOUSE_ACTIVE,        // Cursor entered or left the click area: 0 or 1
+    RECORD_CONFIG,              // EngineConfig, one varint per field
+    RECORD_FOREPERIODS,         // ForeperiodDistribution with its lookup tables
+    RECORD_END,                 // Trial count, digest (8 bytes)
+    RECORD_PRESENTED            // StimulusPresented: tick
+} RecordType;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t session_id;
+    int64_t frequency;          // Ticks per second of every tick in the stream
+    int64_t start_time;         // Unix time the session started
+    uint64_t seed;              // Foreperiod generator seed
+    int64_t first_tick;         // The first delta is taken from here
+} EventRecordingHeader;
+
+typedef struct {
+    FILE* file;
+    ReactionEngine* engine;
+    EnginePlatform inner;       // The frontend's platform, every callback is forwarded to it
+    int64_t last_tick;
+    uint32_t trials;
+    uint64_t digest;            // FNV-1a over every TrialRecord emitted
+    bool mouse_active;          // Last value written
+    bool failed;                // A write failed, the rest of the session is not recorded
+    size_t buffer_used;
+    uint8_t buffer[EVENT_RECORDER_BUFFER_SIZE];
+} EventRecorder;
+
+typedef enum {
+    REPLAY_MATCH,               // Same trials, same digest
+    REPLAY_MISMATCH,            // Stream replayed, trial records differ
+    REPLAY_DIVERGED,            // The engine read the clock at a different point than when recorded
+    REPLAY_TRUNCATED,           // No END record, everything up to the cut was replayed
+    REPLAY_INVALID              // Not a recording, or a version this build can't read
+} ReplayStatus;
+
+typedef struct {
+    bool real_time;             // Wait for each event's recorded time instead of running flat out
+    void (*trial_complete)(void* context, const TrialRecord* record); // Optional
+    void* context;
+} ReplayOptions;
+
+typedef struct {
+    ReplayStatus status;
+    EventRecordingHeader header;
+    uint64_t events;            // Records replayed, clock reads included
+    uint32_t trials;
+    uint64_t digest;
+    uint32_t recorded_trials;   // From the END record
+    uint64_t recorded_digest;
+    int64_t last_tick;          // Recorded time covered, last_tick - header.first_tick
+} ReplayResult;
+
+// Recorder, used from the thread that drives the engine. Every Record* call is a no-op while no file is open.
+// Start it right after InitializeEngine, it wraps the engine's platform until StopEventRecorder.
+bool StartEventRecorder(EventRecorder* recorder, FILE* file, ReactionEngine* engine, uint64_t session_id, int64_t start_time); // Takes ownership of file
+bool StopEventRecorder(EventRecorder* recorder);   // Writes the END record, restores the platform and closes the file
+void RecordInputBatch(EventRecorder* recorder, const InputEventBatch* batch, bool keyboard_enabled, bool mouse_enabled); // Call right before dispatching it
+void RecordInput(EventRecorder* recorder, bool is_mouse_input, int64_t input_tick);     // Before HandleInput, key from engine->data.input_key
+void RecordTimer(EventRecorder* recorder, int timer_id);                                // Before TimerStateLogic
+void RecordStimulus(EventRecorder* recorder, int64_t scheduled_tick, int64_t onset_tick); // Before StimulusOnset
+void RecordPresented(EventRecorder* recorder, int64_t tick);                            // Before StimulusPresented
+void RecordMouseActive(EventRecorder* recorder, bool mouse_active);                     // Only writes changes
+void RecordEngineConfig(EventRecorder* recorder);   // After UpdateEngineConfig or SetEngineForeperiods succeeded
+void RecordForeperiods(EventRecorder* recorder);
+
+// Replayer, data is a whole recording (e.g. a MapFile view)
+bool ReplayEventRecording(const void* data, size_t size, const ReplayOptions* options, ReplayResult* result); // True for REPLAY_MATCH
@@ -0,0 +1,251 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "foreperiod.h"
+
+#define QUANTILE_SLICES (1u << FOREPERIOD_QUANTILE_BITS)
+
+// Building
+bool BuildUniformForeperiods(ForeperiodDistribution* distribution, int min_delay, int max_delay) {
+    *distribution = (ForeperiodDistribution){.model = FOREPERIOD_UNIFORM, .min_delay = min_delay, .max_delay = max_delay};
+    return min_delay <= max_delay;
+}
+
+bool BuildExponentialForeperiods(ForeperiodDistribution* distribution, int min_delay, int max_delay, double mean_ms) {
+    *distribution = (ForeperiodDistribution){.model = FOREPERIOD_EXPONENTIAL, .min_delay = min_delay, .max_delay = max_delay};
+    if (min_delay > max_delay || !(mean_ms > 0)) {
+        return false;
+    }
+    distribution->quantiles = malloc((QUANTILE_SLICES + 1) * sizeof(double));
+    if (!distribution->quantiles) {
+        return false;
+    }
+
+    // Truncated at max: F(x) = (1 - e^(-x/mean)) / (1 - e^(-range/mean)), inverted at every slice boundary
+    double range = (double)max_delay - min_delay;
+    double mass = -expm1(-range / mean_ms);
+    for (uint32_t i = 0; i < QUANTILE_SLICES; i++) {
+        double p = (double)i / QUANTILE_SLICES;
+        distribution->quantiles[i] = min_delay - mean_ms * log1p(-p * mass);
+    }
+    distribution->quantiles[QUANTILE_SLICES] = max_delay;
+    return true;
+}
+
+static const char* SkipSeparators(const char* p) { // Blanks, commas, line breaks and '#' comments
+    for (;;) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ',') p++;
+        if (*p != '#') return p;
+        while (*p && *p != '\n') p++;
+    }
+}
+
+static bool BuildAliasTable(ForeperiodDistribution* distribution, double* weights) { // Vose's method, weights are overwritten
+    uint32_t count = distribution->count;
+    distribution->thresholds = malloc(count * sizeof(uint32_t));
+    distribution->alias = malloc(count * sizeof(uint32_t));
+    uint32_t* worklist = malloc(count * sizeof(uint32_t)); // Small columns grow from the front, large ones from the back
+    if (!distribution->thresholds || !distribution->alias || !worklist) {
+        free(worklist);
+        return false;
+    }
+
+    double total = 0;
+    for (uint32_t i = 0; i < count; i++) total += weights[i];
+    uint32_t small = 0;
+    uint32_t large = count;
+    for (uint32_t i = 0; i < count; i++) {
+        weights[i] *= count / total; // Average column is now exactly 1
+        if (weights[i] < 1) worklist[small++] = i;
+        else worklist[--large] = i;
+    }
+
+    while (small > 0 && large < count) {
+        uint32_t column = worklist[--small];
+        uint32_t donor = worklist[large++];
+        distribution->thresholds[column] = (uint32_t)(weights[column] * 4294967296.0);
+        distribution->alias[column] = donor;
+
+        weights[donor] -= 1 - weights[column];
+        if (weights[donor] < 1) worklist[small++] = donor;
+        else worklist[--large] = donor;
+    }
+    while (small > 0) { // Only rounding error left, these columns are full
+        uint32_t column = worklist[--small];
+        distribution->thresholds[column] = UINT32_MAX;
+        distribution->alias[column] = column;
+    }
+    while (large < count) {
+        uint32_t column = worklist[large++];
+        distribution->thresholds[column] = UINT32_MAX;
+        distribution->alias[column] = column;
+    }
+    free(worklist);
+    return true;
+}
+
+bool BuildWeightedForeperiods(ForeperiodDistribution* distribution, const char* text) {
+    *distribution = (ForeperiodDistribution){.model = FOREPERIOD_WEIGHTED};
+
+    size_t capacity = 1; // Upper bound, one entry per separator
+    for (const char* p = text; *p; p++) capacity += *p == ',' || *p == '\n';
+    if (capacity > FOREPERIOD_MAX_POINTS) {
+        return false;
+    }
+    distribution->values = malloc(capacity * sizeof(int32_t));
+    double* weights = malloc(capacity * sizeof(double));
+    if (!distribution->values || !weights) {
+        free(weights);
+        return false;
+    }
+
+    bool valid = true;
+    for (const char* p = SkipSeparators(text); *p && valid; p = SkipSeparators(p)) {
+        char* end;
+        long delay = strtol(p, &end, 10);
+        double weight = 1;
+        valid = end != p && delay >= 0 && delay <= INT32_MAX;
+        p = end;
+        while (*p == ' ' || *p == '\t') p++;
+        if (valid && *p == ':') {
+            weight = strtod(p + 1, &end);
+            valid = end != p + 1 && weight > 0 && isfinite(weight);
+            p = end;
+        }
+        while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+        valid = valid && (*p == '\0' || *p == ',' || *p == '\n' || *p == '#');
+        if (valid) {
+            uint32_t index = distribution->count++;
+            distribution->values[index] = (int32_t)delay;
+            weights[index] = weight;
+            if (index == 0 || delay < distribution->min_delay) distribution->min_delay = (int32_t)delay;
+            if (index == 0 || delay > distribution->max_delay) distribution->max_delay = (int32_t)delay;
+        }
+    }
+
+    valid = valid && distribution->count > 0 && BuildAliasTable(distribution, weights);
+    free(weights);
+    return valid;
+}
+
+bool LoadForeperiodTable(ForeperiodDistribution* distribution, FILE* file) {
+    *distribution = (ForeperiodDistribution){.model = FOREPERIOD_WEIGHTED};
+    if (fseek(file, 0, SEEK_END) != 0) {
+        return false;
+    }
+    long size = ftell(file);
+    if (size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        return false;
+    }
+
+    char* text = malloc((size_t)size + 1);
+    if (!text) {
+        return false;
+    }
+    bool loaded = fread(text, 1, (size_t)size, file) == (size_t)size;
+    text[size] = '\0';
+    loaded = loaded && BuildWeightedForeperiods(distribution, text);
+    free(text);
+    return loaded;
+}
+
+void FreeForeperiodDistribution(ForeperiodDistribution* distribution) {
+    free(distribution->values);
+    free(distribution->thresholds);
+    free(distribution->alias);
+    free(distribution->quantiles);
+    memset(distribution, 0, sizeof(*distribution));
+}
+
+static void* CopyTable(const void* table, size_t size, bool* ok) {
+    if (!table) {
+        return NULL;
+    }
+    void* copy = malloc(size);
+    if (copy) memcpy(copy, table, size);
+    else *ok = false;
+    return copy;
+}
+
+bool CopyForeperiodDistribution(ForeperiodDistribution* target, const ForeperiodDistribution* source) {
+    bool ok = true;
+    *target = *source;
+    target->values = CopyTable(source->values, source->count * sizeof(int32_t), &ok);
+    target->thresholds = CopyTable(source->thresholds, source->count * sizeof(uint32_t), &ok);
+    target->alias = CopyTable(source->alias, source->count * sizeof(uint32_t), &ok);
+    target->quantiles = CopyTable(source->quantiles, (QUANTILE_SLICES + 1) * sizeof(double), &ok);
+    if (!ok) {
+        FreeForeperiodDistribution(target);
+    }
+    return ok;
+}
+
+int32_t SampleForeperiod(const ForeperiodDistribution* distribution, RandomState* random) {
+    switch (distribution->model) {
+    case FOREPERIOD_EXPONENTIAL: {
+        uint64_t r = NextRandom(random); // Top bits pick the slice, the next 53 - bits place the delay inside it
+        uint32_t slice = (uint32_t)(r >> (64 - FOREPERIOD_QUANTILE_BITS));
+        double fraction = (double)((r >> 11) & ((1ull << (53 - FOREPERIOD_QUANTILE_BITS)) - 1)) * (1.0 / (1ull << (53 - FOREPERIOD_QUANTILE_BITS)));
+        const double* q = distribution->quantiles + slice;
+        return (int32_t)(q[0] + (q[1] - q[0]) * fraction + 0.5);
+    }
+
+    case FOREPERIOD_WEIGHTED: {
+        uint64_t r = NextRandom(random); // High half picks the column, low half decides between it and its alias
+        uint32_t column = (uint32_t)(((r >> 32) * distribution->count) >> 32);
+        return (uint32_t)r < distribution->thresholds[column] ? distribution->values[column] : distribution->values[distribution->alias[column]];
+    }
+
+    default:
+        return RandomInRange(random, distribution->min_delay, distribution->max_delay);
+    }
+}
+
+// Schedule
+static void DrawForeperiods(ForeperiodSchedule* schedule, uint32_t first) { // Fills delays[first..capacity)
+    for (uint32_t i = first; i < schedule->capacity; i++) {
+        schedule->delays[i] = SampleForeperiod(&schedule->distribution, &schedule->random);
+    }
+}
+
+bool InitializeForeperiodSchedule(ForeperiodSchedule* schedule, uint64_t seed, ForeperiodDistribution* distribution, uint32_t capacity) {
+    if (capacity == 0) capacity = 1;
+    if (capacity > FOREPERIOD_SCHEDULE_MAX) capacity = FOREPERIOD_SCHEDULE_MAX;
+
+    schedule->distribution = *distribution;
+    memset(distribution, 0, sizeof(*distribution));
+    schedule->delays = malloc(capacity * sizeof(int32_t));
+    if (!schedule->delays) {
+        FreeForeperiodDistribution(&schedule->distribution);
+        return false;
+    }
+    SeedRandom(&schedule->random, seed);
+    schedule->seed = seed;
+    schedule->capacity = capacity;
+    schedule->next = 0;
+    schedule->drawn = 0;
+    DrawForeperiods(schedule, 0);
+    return true;
+}
+
+void FreeForeperiodSchedule(ForeperiodSchedule* schedule) {
+    free(schedule->delays);
+    schedule->delays = NULL;
+    FreeForeperiodDistribution(&schedule->distribution);
+}
+
+int32_t NextForeperiod(ForeperiodSchedule* schedule) {
+    if (schedule->next == schedule->capacity) { // Only after capacity trials (early presses included)
+        DrawForeperiods(schedule, 0);
+        schedule->next = 0;
+    }
+    schedule->drawn++;
+    return schedule->delays[schedule->next++];
+}
+
+void SetForeperiodDistribution(ForeperiodSchedule* schedule, ForeperiodDistribution* distribution) {
+    FreeForeperiodDistribution(&schedule->distribution);
+    schedule->distribution = *distribution;
+    memset(distribution, 0, sizeof(*distribution));
+    DrawForeperiods(schedule, schedule->next);
+}
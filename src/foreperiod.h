@@ -0,0 +1,61 @@
+// Foreperiods: the random delays before each stimulus.
+//
+// A ForeperiodDistribution is built once from the config (Walker alias table for discrete delays,
+// inverse-CDF table for the exponential), after that every draw is a table lookup with no logarithms.
+// A ForeperiodSchedule draws ahead of time from a seeded generator, so arming a trial is one array load.
+// The sequence only depends on the seed and the distribution, logging the seed is enough to replay a session exactly.
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "prng.h"
+
+#define FOREPERIOD_SCHEDULE_MAX 65536   // Entries drawn at once, longer sessions refill from the same generator
+#define FOREPERIOD_QUANTILE_BITS 10     // Inverse-CDF table resolution, 2^bits slices of equal probability
+#define FOREPERIOD_MAX_POINTS (1 << 20) // Entries in a weighted list or table file
+
+typedef enum {
+    FOREPERIOD_UNIFORM,         // Every millisecond in [min, max] equally likely ("aging", late stimuli become predictable)
+    FOREPERIOD_EXPONENTIAL,     // Constant hazard ("non-aging"), truncated at max
+    FOREPERIOD_WEIGHTED         // Discrete delays with weights, from the config or a table file
+} ForeperiodModel;
+
+typedef struct {
+    ForeperiodModel model;
+    int32_t min_delay;
+    int32_t max_delay;
+
+    // Walker alias table: column i keeps values[i] if the low 32 bits of the draw are below thresholds[i], else values[alias[i]]
+    int32_t* values;
+    uint32_t* thresholds;
+    uint32_t* alias;
+    uint32_t count;
+
+    // Inverse CDF: delay at each of 2^FOREPERIOD_QUANTILE_BITS + 1 evenly spaced probabilities, linear in between
+    double* quantiles;
+} ForeperiodDistribution;
+
+typedef struct {
+    RandomState random;
+    uint64_t seed;
+    ForeperiodDistribution distribution;
+    int32_t* delays;
+    uint32_t capacity;
+    uint32_t next;              // Index of the next foreperiod handed out
+    uint64_t drawn;             // Foreperiods handed out so far
+} ForeperiodSchedule;
+
+// Building (at load time). Every builder leaves a distribution that is safe to free, even on failure.
+bool BuildUniformForeperiods(ForeperiodDistribution* distribution, int min_delay, int max_delay);
+bool BuildExponentialForeperiods(ForeperiodDistribution* distribution, int min_delay, int max_delay, double mean_ms); // mean of the part above min_delay, before truncation
+bool BuildWeightedForeperiods(ForeperiodDistribution* distribution, const char* text); // "delay[:weight]" separated by commas or newlines, '#' comments
+bool LoadForeperiodTable(ForeperiodDistribution* distribution, FILE* file);           // Same format as BuildWeightedForeperiods, one read
+void FreeForeperiodDistribution(ForeperiodDistribution* distribution);
+bool CopyForeperiodDistribution(ForeperiodDistribution* target, const ForeperiodDistribution* source); // Deep copy, e.g. one per engine
+int32_t SampleForeperiod(const ForeperiodDistribution* distribution, RandomState* random); // Constant time
+
+// Schedule. Both functions take ownership of the distribution and leave the caller's copy empty.
+bool InitializeForeperiodSchedule(ForeperiodSchedule* schedule, uint64_t seed, ForeperiodDistribution* distribution, uint32_t capacity);
+void FreeForeperiodSchedule(ForeperiodSchedule* schedule);
+int32_t NextForeperiod(ForeperiodSchedule* schedule);
+void SetForeperiodDistribution(ForeperiodSchedule* schedule, ForeperiodDistribution* distribution); // Redraws the part not handed out yet
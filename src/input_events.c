@@ -0,0 +1,93 @@
+#include "input_events.h"
+
+static void SubmitInput(ReactionEngine* engine, const InputEvent* event, bool is_mouse_input) {
+    engine->data.message_delay_ms = event->message_delay_ms; // Picked up by the trial record if this event finishes a trial
+    engine->data.input_key = event->key;
+    HandleInput(engine, is_mouse_input, event->arrival_tick);
+}
+
+// Input Functions
+void HandleRawKeyboardInput(ReactionEngine* engine, const InputEvent* event) {
+    int vkey = event->key & 0xFF;
+    ProgramState* state = &engine->state;
+
+    if (event->pressed && IsAlphanumeric(vkey) && !state->key_states[vkey]) {
+        SubmitInput(engine, event, false);
+        state->key_states[vkey] = true;
+    }
+    else if (!event->pressed) {
+        state->key_states[vkey] = false;
+    }
+}
+
+void HandleRawMouseInput(ReactionEngine* engine, const InputEvent* event) {
+    ProgramState* state = &engine->state;
+
+    if (event->pressed && !state->mouse_button_down) {
+        SubmitInput(engine, event, true);
+        state->mouse_button_down = true;
+    }
+    else if (!event->pressed && state->mouse_button_down) {
+        state->mouse_button_down = false;
+    }
+}
+
+void DispatchInputBatch(ReactionEngine* engine, const InputEventBatch* batch, bool keyboard_enabled, bool mouse_enabled) {
+    for (uint32_t i = 0; i < batch->count; i++) {
+        const InputEvent* event = &batch->events[i];
+        if (event->source == INPUT_SOURCE_KEYBOARD && keyboard_enabled) {
+            HandleRawKeyboardInput(engine, event);
+        }
+        else if (event->source == INPUT_SOURCE_MOUSE && mouse_enabled) {
+            HandleRawMouseInput(engine, event);
+        }
+    }
+}
+
+bool IsAlphanumeric(int vkey) {
+    return (vkey >= '0' && vkey <= '9') || (vkey >= 'A' && vkey <= 'Z');
+}
+
+// Synthetic Input Functions
+void InitializeSyntheticInput(SyntheticInputSource* source, uint64_t seed, int64_t tick_step) {
+    source->state = seed ? seed : 0x9E3779B97F4A7C15ull;
+    source->tick = 0;
+    source->tick_step = tick_step;
+    source->device_count = 1;
+}
+
+void SetSyntheticDevices(SyntheticInputSource* source, uint32_t device_count) {
+    source->device_count = device_count ? device_count : 1;
+}
+
+uint64_t SyntheticDeviceHandle(uint32_t index) {
+    return 0x10041 + 0x40 * (uint64_t)index;
+}
+
+void FillSyntheticBatch(SyntheticInputSource* source, InputEventBatch* batch, uint32_t count) {
+    if (count > INPUT_BATCH_CAPACITY) {
+        count = INPUT_BATCH_CAPACITY;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        // xorshift64, the stream only needs to be cheap and repeatable
+        source->state ^= source->state << 13;
+        source->state ^= source->state >> 7;
+        source->state ^= source->state << 17;
+
+        InputEvent* event = &batch->events[i];
+        source->tick += source->tick_step;
+        event->arrival_tick = source->tick;
+        event->message_delay_ms = 0;
+        event->device = SyntheticDeviceHandle((uint32_t)((source->state >> 32) % source->device_count));
+        event->pressed = (uint8_t)(i & 1); // Alternate release/press so the edge detection does real work
+        if (source->state & 1) {
+            event->source = INPUT_SOURCE_MOUSE;
+            event->key = 0;
+        } else {
+            event->source = INPUT_SOURCE_KEYBOARD;
+            event->key = (uint16_t)('A' + (source->state >> 8) % 26);
+        }
+    }
+    batch->count = count;
+}
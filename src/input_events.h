@@ -0,0 +1,47 @@
+// Portable input event representation shared by the capture thread and the game logic
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "reaction_engine.h"
+
+#define INPUT_BATCH_CAPACITY 256
+
+typedef enum {
+    INPUT_SOURCE_KEYBOARD,
+    INPUT_SOURCE_MOUSE
+} InputSource;
+
+typedef struct {
+    int64_t arrival_tick;       // Stamped as soon as the event is read from the OS
+    uint64_t device;            // Raw input hDevice on Windows, evdev device number + 1 on Linux, 0 = unknown (legacy paths)
+    uint32_t message_delay_ms;  // OS message queue delay before the event was read (GetMessageTime based on Windows)
+    uint16_t key;               // Virtual key for keyboards, button index for mice (0 = left)
+    uint8_t source;             // InputSource
+    uint8_t pressed;            // 1 = down, 0 = up
+} InputEvent;
+
+// Fixed-size batch, filled by a raw input drain (or a synthetic source) and dispatched in one go
+typedef struct {
+    uint32_t count;
+    InputEvent events[INPUT_BATCH_CAPACITY];
+} InputEventBatch;
+
+// Deterministic generator of press/release pairs for benchmarking the dispatch path
+typedef struct {
+    uint64_t state;
+    int64_t tick;
+    int64_t tick_step;
+    uint32_t device_count;      // Events are spread over this many devices, 1 after InitializeSyntheticInput
+} SyntheticInputSource;
+
+// Input Functions
+void HandleRawKeyboardInput(ReactionEngine* engine, const InputEvent* event);
+void HandleRawMouseInput(ReactionEngine* engine, const InputEvent* event);
+void DispatchInputBatch(ReactionEngine* engine, const InputEventBatch* batch, bool keyboard_enabled, bool mouse_enabled);
+bool IsAlphanumeric(int vkey);
+
+// Synthetic Input Functions
+void InitializeSyntheticInput(SyntheticInputSource* source, uint64_t seed, int64_t tick_step);
+void FillSyntheticBatch(SyntheticInputSource* source, InputEventBatch* batch, uint32_t count);
+void SetSyntheticDevices(SyntheticInputSource* source, uint32_t device_count);
+uint64_t SyntheticDeviceHandle(uint32_t index);    // Spaced like Win32 raw input handles
@@ -0,0 +1,76 @@
+#include "latency_diagnostics.h"
+#include "platform.h"
+
+const char* const PIPELINE_MEASURE_NAMES[MEASURE_COUNT] = {
+    [MEASURE_INPUT_QUEUE] = "input",
+    [MEASURE_ONSET_LATENESS] = "onset",
+    [MEASURE_STIMULUS_HANDOFF] = "handoff",
+    [MEASURE_REACT_PAINT] = "paint",
+    [MEASURE_TIMER_LATENESS] = "timer"
+};
+
+bool MeasureTrial(const TrialRecord* record, const DiagnosticsSettings* settings, int64_t measures[TRIAL_MEASURE_COUNT]) {
+    for (int i = 0; i < TRIAL_MEASURE_COUNT; i++) measures[i] = -1;
+    if (record->outcome != TRIAL_VALID) {
+        return false;
+    }
+
+    measures[MEASURE_INPUT_QUEUE] = MillisecondsToTicks(record->message_delay_ms, settings->frequency) + (record->dispatch - record->response);
+    measures[MEASURE_ONSET_LATENESS] = record->onset - record->scheduled_onset;
+    if (record->stimulus_dispatch) {
+        measures[MEASURE_STIMULUS_HANDOFF] = record->stimulus_dispatch - record->onset;
+    }
+    if (record->stimulus_dispatch && record->presented) {
+        measures[MEASURE_REACT_PAINT] = record->presented - record->stimulus_dispatch;
+    }
+
+    bool flagged = false;
+    for (int i = 0; i < TRIAL_MEASURE_COUNT && settings->flag_ticks > 0; i++) {
+        flagged |= measures[i] > settings->flag_ticks;
+    }
+    return flagged;
+}
+
+bool InitializeLatencyDiagnostics(LatencyDiagnostics* diagnostics, const DiagnosticsSettings* settings) {
+    diagnostics->settings = *settings;
+    diagnostics->trials = 0;
+    diagnostics->flagged = 0;
+    int64_t highest = MillisecondsToTicks(DIAGNOSTICS_HIGHEST_MS, settings->frequency);
+    for (int i = 0; i < MEASURE_COUNT; i++) {
+        diagnostics->last[i] = -1;
+        if (!InitializeLatencyHistogram(&diagnostics->histograms[i], highest, DIAGNOSTICS_PRECISION, settings->frequency)) {
+            while (i-- > 0) FreeLatencyHistogram(&diagnostics->histograms[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+void FreeLatencyDiagnostics(LatencyDiagnostics* diagnostics) {
+    for (int i = 0; i < MEASURE_COUNT; i++) {
+        FreeLatencyHistogram(&diagnostics->histograms[i]);
+    }
+}
+
+void AddTrialDiagnostics(LatencyDiagnostics* diagnostics, const TrialRecord* record) {
+    if (record->outcome != TRIAL_VALID) {
+        return;
+    }
+    int64_t measures[TRIAL_MEASURE_COUNT];
+    bool flagged = MeasureTrial(record, &diagnostics->settings, measures);
+
+    diagnostics->trials++;
+    diagnostics->flagged += flagged;
+    for (int i = 0; i < TRIAL_MEASURE_COUNT; i++) {
+        diagnostics->last[i] = measures[i];
+        if (measures[i] >= 0) { // Negative only if the clock went backwards, nothing to learn from it
+            RecordLatency(&diagnostics->histograms[i], measures[i]);
+        }
+    }
+}
+
+void AddTimerLateness(LatencyDiagnostics* diagnostics, int64_t lateness_ticks) {
+    if (lateness_ticks < 0) lateness_ticks = 0; // Windows may fire a timer a little early
+    diagnostics->last[MEASURE_TIMER_LATENESS] = lateness_ticks;
+    RecordLatency(&diagnostics->histograms[MEASURE_TIMER_LATENESS], lateness_ticks);
+}
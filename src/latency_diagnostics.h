@@ -0,0 +1,48 @@
+// Measurement pipeline diagnostics: how much system latency surrounds each reported reaction time.
+//
+// Every measure comes from the ticks already in a TrialRecord, so the same numbers can be derived from the
+// session file or a replay. Trials where any measure goes over a threshold are flagged, e.g. to drop trials
+// collected while the machine was busy or to qualify a lab machine before a study.
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "latency_histogram.h"
+#include "reaction_engine.h"
+
+#define DIAGNOSTICS_HIGHEST_MS 10000    // Longer delays share the last histogram bucket
+#define DIAGNOSTICS_PRECISION 7         // Significant bits, under 1% error
+
+typedef enum {
+    MEASURE_INPUT_QUEUE,        // OS message queue (GetMessageTime) plus the handoff from arrival to HandleInput
+    MEASURE_ONSET_LATENESS,     // Scheduler: actual onset against the end of the foreperiod
+    MEASURE_STIMULUS_HANDOFF,   // Onset to the UI thread handling it and invalidating the window
+    MEASURE_REACT_PAINT,        // Invalidation to EndPaint of the react frame
+    MEASURE_TIMER_LATENESS,     // WM_TIMER against its due time, not tied to a trial
+    MEASURE_COUNT
+} PipelineMeasure;
+
+#define TRIAL_MEASURE_COUNT MEASURE_TIMER_LATENESS // The measures taken from every valid trial
+
+typedef struct {
+    int64_t frequency;
+    int64_t flag_ticks;         // A trial is flagged when any of its measures is above this, 0 = never
+} DiagnosticsSettings;
+
+typedef struct {
+    DiagnosticsSettings settings;
+    LatencyHistogram histograms[MEASURE_COUNT]; // Ticks
+    int64_t last[MEASURE_COUNT];                // Latest value, -1 = not measured yet
+    uint64_t trials;
+    uint64_t flagged;
+} LatencyDiagnostics;
+
+extern const char* const PIPELINE_MEASURE_NAMES[MEASURE_COUNT];
+
+// Per trial, no state. measures[i] = -1 where the record has no value (early press, frame never painted).
+bool MeasureTrial(const TrialRecord* record, const DiagnosticsSettings* settings, int64_t measures[TRIAL_MEASURE_COUNT]); // True if flagged
+
+// Session aggregates
+bool InitializeLatencyDiagnostics(LatencyDiagnostics* diagnostics, const DiagnosticsSettings* settings);
+void FreeLatencyDiagnostics(LatencyDiagnostics* diagnostics);
+void AddTrialDiagnostics(LatencyDiagnostics* diagnostics, const TrialRecord* record); // Valid trials only, others are ignored
+void AddTimerLateness(LatencyDiagnostics* diagnostics, int64_t lateness_ticks);
@@ -0,0 +1,196 @@
+#include <stdlib.h>
+#include <string.h>
+#include "latency_histogram.h"
+
+#define HISTOGRAM_MAGIC 0x47485452u // "RTHG"
+#define HISTOGRAM_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t significant_bits;
+    int32_t bucket_count;
+    int64_t highest_trackable;
+    int64_t frequency;
+    uint64_t total;
+    int64_t min;
+    int64_t max;
+} HistogramFileHeader;
+
+static int BucketIndex(const LatencyHistogram* histogram, int64_t value) {
+    uint64_t v = (uint64_t)value;
+    if (v < (uint64_t)histogram->sub_bucket_half * 2) {
+        return (int)v; // First power of two range is exact
+    }
+    int msb = 63 - __builtin_clzll(v);
+    int shift = msb - histogram->significant_bits + 1;
+    return shift * histogram->sub_bucket_half + (int)(v >> shift);
+}
+
+static int64_t BucketLow(const LatencyHistogram* histogram, int index) {
+    int shift = index / histogram->sub_bucket_half - 1;
+    if (shift <= 0) {
+        return index;
+    }
+    return (int64_t)(index - shift * histogram->sub_bucket_half) << shift;
+}
+
+static int64_t BucketMidpoint(const LatencyHistogram* histogram, int index) {
+    int shift = index / histogram->sub_bucket_half - 1;
+    if (shift <= 0) {
+        return index;
+    }
+    return BucketLow(histogram, index) + ((int64_t)1 << (shift - 1));
+}
+
+static uint32_t SaturatingAdd(uint32_t a, uint32_t b) {
+    return a > UINT32_MAX - b ? UINT32_MAX : a + b;
+}
+
+bool InitializeLatencyHistogram(LatencyHistogram* histogram, int64_t highest_trackable, int significant_bits, int64_t frequency) {
+    memset(histogram, 0, sizeof(*histogram));
+    if (significant_bits < HISTOGRAM_MIN_SIGNIFICANT_BITS || significant_bits > HISTOGRAM_MAX_SIGNIFICANT_BITS || frequency <= 0) {
+        return false;
+    }
+
+    histogram->significant_bits = significant_bits;
+    histogram->sub_bucket_half = 1 << (significant_bits - 1);
+    histogram->highest_trackable = highest_trackable < (int64_t)histogram->sub_bucket_half * 2 ? (int64_t)histogram->sub_bucket_half * 2 : highest_trackable;
+    histogram->frequency = frequency;
+    histogram->bucket_count = BucketIndex(histogram, histogram->highest_trackable) + 1;
+
+    histogram->counts = calloc((size_t)histogram->bucket_count, sizeof(uint32_t));
+    if (!histogram->counts) {
+        return false;
+    }
+    ResetLatencyHistogram(histogram);
+    return true;
+}
+
+void FreeLatencyHistogram(LatencyHistogram* histogram) {
+    free(histogram->counts);
+    histogram->counts = NULL;
+    histogram->bucket_count = 0;
+}
+
+void ResetLatencyHistogram(LatencyHistogram* histogram) {
+    memset(histogram->counts, 0, (size_t)histogram->bucket_count * sizeof(uint32_t));
+    histogram->total = 0;
+    histogram->min = INT64_MAX;
+    histogram->max = 0;
+}
+
+void RecordLatencyCount(LatencyHistogram* histogram, int64_t value, uint32_t count) {
+    if (count == 0) {
+        return;
+    }
+    if (value < 0) {
+        value = 0;
+    }
+
+    int64_t bucket_value = value > histogram->highest_trackable ? histogram->highest_trackable : value;
+    int index = BucketIndex(histogram, bucket_value);
+    histogram->counts[index] = SaturatingAdd(histogram->counts[index], count);
+    histogram->total += count;
+    if (value < histogram->min) histogram->min = value;
+    if (value > histogram->max) histogram->max = value; // Keeps the real maximum even when it was clamped
+}
+
+void RecordLatency(LatencyHistogram* histogram, int64_t value) {
+    RecordLatencyCount(histogram, value, 1);
+}
+
+int64_t LatencyPercentile(const LatencyHistogram* histogram, double percentile) {
+    if (histogram->total == 0) {
+        return 0;
+    }
+    if (percentile <= 0) {
+        return histogram->min;
+    }
+    if (percentile >= 100) {
+        return histogram->max;
+    }
+
+    uint64_t target = (uint64_t)(percentile / 100.0 * (double)histogram->total + 0.5);
+    if (target == 0) {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < histogram->bucket_count; i++) {
+        seen += histogram->counts[i];
+        if (seen >= target) {
+            int64_t value = BucketMidpoint(histogram, i);
+            if (value < histogram->min) return histogram->min;
+            if (value > histogram->max) return histogram->max;
+            return value;
+        }
+    }
+    return histogram->max;
+}
+
+void MergeLatencyHistogram(LatencyHistogram* destination, const LatencyHistogram* source) {
+    if (source->total == 0) {
+        return;
+    }
+
+    bool same_layout = destination->significant_bits == source->significant_bits &&
+                       destination->bucket_count == source->bucket_count &&
+                       destination->frequency == source->frequency;
+    if (same_layout) {
+        for (int i = 0; i < source->bucket_count; i++) {
+            destination->counts[i] = SaturatingAdd(destination->counts[i], source->counts[i]);
+        }
+        destination->total += source->total;
+        if (source->min < destination->min) destination->min = source->min;
+        if (source->max > destination->max) destination->max = source->max;
+        return;
+    }
+
+    // Different precision or clock, re-record every bucket at its midpoint converted to destination ticks
+    double scale = (double)destination->frequency / (double)source->frequency;
+    for (int i = 0; i < source->bucket_count; i++) {
+        if (source->counts[i]) {
+            int64_t value = BucketMidpoint(source, i);
+            if (value < source->min) value = source->min;
+            if (value > source->max) value = source->max;
+            RecordLatencyCount(destination, (int64_t)((double)value * scale + 0.5), source->counts[i]);
+        }
+    }
+}
+
+bool SaveLatencyHistogram(const LatencyHistogram* histogram, FILE* file) {
+    HistogramFileHeader header = {
+        .magic = HISTOGRAM_MAGIC,
+        .version = HISTOGRAM_VERSION,
+        .significant_bits = histogram->significant_bits,
+        .bucket_count = histogram->bucket_count,
+        .highest_trackable = histogram->highest_trackable,
+        .frequency = histogram->frequency,
+        .total = histogram->total,
+        .min = histogram->min,
+        .max = histogram->max
+    };
+    return fwrite(&header, sizeof(header), 1, file) == 1 &&
+           fwrite(histogram->counts, sizeof(uint32_t), (size_t)histogram->bucket_count, file) == (size_t)histogram->bucket_count;
+}
+
+bool LoadLatencyHistogram(LatencyHistogram* histogram, FILE* file) {
+    HistogramFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != HISTOGRAM_MAGIC || header.version != HISTOGRAM_VERSION) {
+        return false;
+    }
+    if (!InitializeLatencyHistogram(histogram, header.highest_trackable, header.significant_bits, header.frequency)) {
+        return false;
+    }
+    if (histogram->bucket_count != header.bucket_count ||
+        fread(histogram->counts, sizeof(uint32_t), (size_t)histogram->bucket_count, file) != (size_t)histogram->bucket_count) {
+        FreeLatencyHistogram(histogram);
+        return false;
+    }
+
+    histogram->total = header.total;
+    histogram->min = header.min;
+    histogram->max = header.max;
+    return true;
+}
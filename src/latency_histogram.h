@@ -0,0 +1,35 @@
+// Whole-session latency distribution in constant memory (HdrHistogram-style log-linear buckets).
+// Values are platform ticks. Every power of two is split into 2^(significant_bits - 1) linear sub-buckets,
+// so the relative error of any reported value is below 2^-(significant_bits - 1).
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define HISTOGRAM_MIN_SIGNIFICANT_BITS 2
+#define HISTOGRAM_MAX_SIGNIFICANT_BITS 16
+
+typedef struct {
+    int significant_bits;
+    int sub_bucket_half;        // Linear sub-buckets per power of two
+    int bucket_count;
+    int64_t highest_trackable;  // Larger values are counted in the last bucket
+    int64_t frequency;          // Ticks per second, lets sessions from other machines be merged
+    uint64_t total;
+    int64_t min;
+    int64_t max;
+    uint32_t* counts;
+} LatencyHistogram;
+
+bool InitializeLatencyHistogram(LatencyHistogram* histogram, int64_t highest_trackable, int significant_bits, int64_t frequency);
+void FreeLatencyHistogram(LatencyHistogram* histogram);
+void ResetLatencyHistogram(LatencyHistogram* histogram);
+
+void RecordLatency(LatencyHistogram* histogram, int64_t value);
+void RecordLatencyCount(LatencyHistogram* histogram, int64_t value, uint32_t count);
+int64_t LatencyPercentile(const LatencyHistogram* histogram, double percentile); // percentile in [0, 100], 0 when empty
+void MergeLatencyHistogram(LatencyHistogram* destination, const LatencyHistogram* source); // Layouts and frequencies may differ
+
+// Binary snapshot, histogram must be uninitialized (or freed) before loading
+bool SaveLatencyHistogram(const LatencyHistogram* histogram, FILE* file);
+bool LoadLatencyHistogram(LatencyHistogram* histogram, FILE* file);
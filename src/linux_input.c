@@ -0,0 +1,277 @@
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "linux_input.h"
+#include "trace.h"
+
+#define INPUT_RING_CAPACITY 4096
+#define BITS_PER_LONG (8 * sizeof(unsigned long))
+#define TEST_BIT(bits, bit) (((bits)[(bit) / BITS_PER_LONG] >> ((bit) % BITS_PER_LONG)) & 1)
+
+uint16_t EvdevKeyToVirtualKey(uint16_t code) { // Only the keys IsAlphanumeric accepts, in VK terms
+    static const uint8_t LETTERS[] = {
+        [KEY_A] = 'A', [KEY_B] = 'B', [KEY_C] = 'C', [KEY_D] = 'D', [KEY_E] = 'E', [KEY_F] = 'F', [KEY_G] = 'G',
+        [KEY_H] = 'H', [KEY_I] = 'I', [KEY_J] = 'J', [KEY_K] = 'K', [KEY_L] = 'L', [KEY_M] = 'M', [KEY_N] = 'N',
+        [KEY_O] = 'O', [KEY_P] = 'P', [KEY_Q] = 'Q', [KEY_R] = 'R', [KEY_S] = 'S', [KEY_T] = 'T', [KEY_U] = 'U',
+        [KEY_V] = 'V', [KEY_W] = 'W', [KEY_X] = 'X', [KEY_Y] = 'Y', [KEY_Z] = 'Z'
+    };
+    if (code >= KEY_1 && code <= KEY_9) return (uint16_t)('1' + code - KEY_1);
+    if (code == KEY_0) return '0';
+    return code < sizeof(LETTERS) ? LETTERS[code] : 0;
+}
+
+static int64_t EventTick(const EvdevDevice* device, const struct input_event* event, int64_t read_tick) {
+    if (!device->kernel_clock) {
+        return read_tick;
+    }
+    return (int64_t)event->input_event_sec * 1000000000 + (int64_t)event->input_event_usec * 1000; // ClockNow is CLOCK_MONOTONIC in ns
+}
+
+static bool AddDevice(EvdevInput* input, const char* path, bool required) {
+    if (input->device_count == EVDEV_MAX_DEVICES) {
+        return false;
+    }
+    int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        if (required) fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    EvdevDevice* device = &input->devices[input->device_count];
+    struct stat info;
+    if (fstat(fd, &info) == 0 && !S_ISCHR(info.st_mode)) { // Canned stream, already stamped on CLOCK_MONOTONIC
+        device->fd = fd;
+        device->kernel_clock = true;
+        snprintf(device->name, sizeof(device->name), "%s", path);
+        input->device_count++;
+        return true;
+    }
+
+    unsigned long keys[KEY_MAX / BITS_PER_LONG + 1] = {0};
+    if (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keys)), keys) < 0) {
+        if (required) fprintf(stderr, "%s: not an evdev device\n", path);
+        close(fd);
+        return false;
+    }
+    bool is_keyboard = TEST_BIT(keys, KEY_A) && TEST_BIT(keys, KEY_Z);
+    bool is_mouse = TEST_BIT(keys, BTN_LEFT);
+    if (!required && !((is_keyboard && input->keyboard) || (is_mouse && input->mouse))) {
+        close(fd); // Power buttons, lid switches, ...
+        return false;
+    }
+
+    int clock = CLOCK_MONOTONIC;
+    device->fd = fd;
+    device->kernel_clock = ioctl(fd, EVIOCSCLOCKID, &clock) == 0; // Linux 3.4+, the default is CLOCK_REALTIME
+    if (ioctl(fd, EVIOCGNAME(sizeof(device->name)), device->name) < 0) {
+        snprintf(device->name, sizeof(device->name), "%s", path);
+    }
+    input->device_count++;
+    return true;
+}
+
+static int CompareNames(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+static void CloseDevices(EvdevInput* input) {
+    for (int i = 0; i < input->device_count; i++) {
+        if (input->devices[i].fd >= 0) close(input->devices[i].fd);
+    }
+    input->device_count = 0;
+}
+
+bool OpenEvdevDevices(EvdevInput* input, const char* const* paths, int path_count, bool keyboard, bool mouse) {
+    input->device_count = 0;
+    input->keyboard = keyboard;
+    input->mouse = mouse;
+    for (int i = 0; i < path_count; i++) {
+        if (!AddDevice(input, paths[i], true)) {
+            CloseDevices(input); // Nobody stops an input that never started
+            return false;
+        }
+    }
+    if (path_count) {
+        return true;
+    }
+
+    DIR* directory = opendir("/dev/input");
+    if (!directory) {
+        return false;
+    }
+    char names[EVDEV_MAX_DEVICES * 2][32];
+    const char* sorted[EVDEV_MAX_DEVICES * 2];
+    int count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(directory)) && count < EVDEV_MAX_DEVICES * 2) {
+        if (!strncmp(entry->d_name, "event", 5) && snprintf(names[count], sizeof(names[count]), "/dev/input/%s", entry->d_name) < (int)sizeof(names[count])) {
+            sorted[count] = names[count];
+            count++;
+        }
+    }
+    closedir(directory);
+    qsort(sorted, (size_t)count, sizeof(sorted[0]), CompareNames);
+    for (int i = 0; i < count; i++) {
+        AddDevice(input, sorted[i], false); // Unreadable devices are skipped, usually a missing "input" group
+    }
+    return input->device_count > 0;
+}
+
+static void PublishBatch(EvdevInput* input) {
+    InputEventBatch* batch = &input->batch;
+    if (!batch->count) {
+        return;
+    }
+
+    size_t pushed = SpscPushBatch(&input->ring, batch->events, batch->count);
+    if (pushed < batch->count) {
+        atomic_fetch_add(&input->dropped, (unsigned)(batch->count - pushed));
+    }
+    batch->count = 0;
+    if (pushed && !atomic_exchange(&input->notify_pending, true)) { // Only wake the UI thread once per drain
+        uint64_t one = 1;
+        if (write(input->notify_fd, &one, sizeof(one)) < 0) {
+            atomic_store(&input->notify_pending, false);
+        }
+    }
+}
+
+static void AddEvent(EvdevInput* input, const EvdevDevice* device, const struct input_event* raw, int64_t read_tick) {
+    if (raw->type != EV_KEY || raw->value == 2) {
+        return; // Only presses and releases, not autorepeat
+    }
+    InputEvent event = {.arrival_tick = EventTick(device, raw, read_tick), .pressed = raw->value != 0,
+        .device = (uint64_t)(device - input->devices) + 1};
+    // message_delay_ms stays 0: the kernel stamp already covers the wait for this thread, it shows up in the handoff
+    if (raw->code == BTN_LEFT) {
+        if (!input->mouse) return;
+        event.source = INPUT_SOURCE_MOUSE;
+        event.key = 0;
+    } else {
+        event.key = EvdevKeyToVirtualKey(raw->code);
+        if (!event.key || !input->keyboard) return;
+        event.source = INPUT_SOURCE_KEYBOARD;
+    }
+
+    if (input->batch.count == INPUT_BATCH_CAPACITY) {
+        PublishBatch(input);
+    }
+    input->batch.events[input->batch.count++] = event;
+}
+
+static bool ReadDevice(EvdevInput* input, EvdevDevice* device) { // False once the device is gone
+    struct input_event events[EVDEV_READ_EVENTS];
+    uint32_t captured = 0;
+    for (;;) {
+        ssize_t size = read(device->fd, events, sizeof(events));
+        if (size < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) break;
+            return false; // ENODEV after an unplug
+        }
+        if (size == 0) {
+            return false; // Writer of a canned stream is done
+        }
+        int64_t read_tick = ClockNow();
+        size_t count = (size_t)size / sizeof(struct input_event);
+        for (size_t i = 0; i < count; i++) {
+            AddEvent(input, device, &events[i], read_tick);
+        }
+        captured += (uint32_t)count;
+        if ((size_t)size < sizeof(events)) break;
+    }
+    if (captured) TRACE_INSTANT(TRACE_INPUT_CAPTURED, captured, 0);
+    PublishBatch(input);
+    return true;
+}
+
+static void EvdevThreadMain(void* arg) {
+    EvdevInput* input = arg;
+    RaiseThreadPriority();
+    TraceThread("Input capture");
+
+    struct pollfd fds[EVDEV_MAX_DEVICES + 1];
+    int open_devices = input->device_count;
+    for (;;) {
+        for (int i = 0; i < input->device_count; i++) {
+            fds[i] = (struct pollfd){.fd = input->devices[i].fd, .events = POLLIN}; // Closed devices are -1, poll skips them
+        }
+        fds[input->device_count] = (struct pollfd){.fd = input->stop_fd, .events = POLLIN};
+        if (poll(fds, (nfds_t)input->device_count + 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[input->device_count].revents) {
+            break;
+        }
+        for (int i = 0; i < input->device_count; i++) {
+            if (fds[i].revents && !ReadDevice(input, &input->devices[i])) {
+                close(input->devices[i].fd);
+                input->devices[i].fd = -1;
+                open_devices--;
+            }
+        }
+        if (!open_devices) {
+            break; // Nothing left to read, the UI keeps running on the X11 events
+        }
+    }
+    TraceThreadExit();
+}
+
+bool StartEvdevInput(EvdevInput* input) {
+    if (!input->device_count) {
+        return false;
+    }
+    if (!InitializeSpscRing(&input->ring, sizeof(InputEvent), INPUT_RING_CAPACITY)) {
+        CloseDevices(input);
+        return false;
+    }
+    input->batch.count = 0;
+    atomic_init(&input->notify_pending, false);
+    atomic_init(&input->dropped, 0);
+    input->notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    input->stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (input->notify_fd < 0 || input->stop_fd < 0 || !StartThread(&input->thread, EvdevThreadMain, input)) {
+        if (input->notify_fd >= 0) close(input->notify_fd); // The caller falls back to X11 input and never stops us
+        if (input->stop_fd >= 0) close(input->stop_fd);
+        FreeSpscRing(&input->ring);
+        CloseDevices(input);
+        return false;
+    }
+    return true;
+}
+
+void StopEvdevInput(EvdevInput* input) {
+    uint64_t one = 1;
+    if (write(input->stop_fd, &one, sizeof(one)) == sizeof(one)) {
+        JoinThread(&input->thread);
+    }
+    CloseDevices(input);
+    close(input->notify_fd);
+    close(input->stop_fd);
+    FreeSpscRing(&input->ring);
+}
+
+uint32_t PopEvdevBatch(EvdevInput* input, InputEventBatch* batch) {
+    batch->count = (uint32_t)SpscPopBatch(&input->ring, batch->events, INPUT_BATCH_CAPACITY);
+    return batch->count;
+}
+
+void AcknowledgeEvdevNotification(EvdevInput* input) {
+    uint64_t count;
+    if (read(input->notify_fd, &count, sizeof(count)) < 0) {
+        // EAGAIN, nothing was pending
+    }
+    atomic_store(&input->notify_pending, false);
+}
@@ -0,0 +1,41 @@
+// evdev capture thread: reads keyboards and mice straight from /dev/input and hands the events to the UI thread
+// through an SPSC ring. Events keep the kernel's own timestamp (switched to CLOCK_MONOTONIC, the ClockNow clock),
+// so the time an input arrived no longer depends on when a user-space thread got to read it.
+#pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "input_events.h"
+#include "platform.h"
+#include "spsc_ring.h"
+
+#define EVDEV_MAX_DEVICES 32
+#define EVDEV_READ_EVENTS 64    // input_event structs per read()
+
+typedef struct {
+    int fd;
+    bool kernel_clock;          // Timestamps are CLOCK_MONOTONIC, false = stamped on read (a device that refused the clock switch)
+    char name[64];
+} EvdevDevice;
+
+typedef struct {
+    EvdevDevice devices[EVDEV_MAX_DEVICES];
+    int device_count;
+    InputEventBatch batch;
+    PlatformThread thread;
+    SpscRing ring;
+    int notify_fd;              // eventfd, becomes readable when the ring goes from drained to non-empty
+    int stop_fd;                // eventfd, wakes the capture thread to exit
+    bool keyboard;
+    bool mouse;
+    atomic_bool notify_pending;
+    atomic_uint dropped;        // Events lost because the ring was full
+} EvdevInput;
+
+// Opens the given device paths, or every readable keyboard and mouse under /dev/input when there are none.
+// Regular files and FIFOs are accepted too and their timestamps trusted as CLOCK_MONOTONIC, for canned event streams.
+bool OpenEvdevDevices(EvdevInput* input, const char* const* paths, int path_count, bool keyboard, bool mouse);
+bool StartEvdevInput(EvdevInput* input);    // Needs at least one device, closes them again on failure
+void StopEvdevInput(EvdevInput* input);     // Also closes the devices
+uint32_t PopEvdevBatch(EvdevInput* input, InputEventBatch* batch);  // UI thread only
+void AcknowledgeEvdevNotification(EvdevInput* input);               // Call before draining once notify_fd is readable
+uint16_t EvdevKeyToVirtualKey(uint16_t code);                       // Windows VK code the engine expects, 0 if not a test key
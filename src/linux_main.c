@@ -0,0 +1,878 @@
+// Native Linux frontend: an X11 window, evdev input with kernel timestamps and the same engine, user.cfg and logs
+// as the Windows build. Without readable evdev devices (not in the "input" group) it falls back to X11 key and button
+// events, stamped when the UI thread reads them, like the legacy WM_KEYDOWN path.
+// Usage: ReactionTimeTester [--config FILE] [--device PATH]... [--trials N]
+// --trials quits after N valid trials, e.g. for a scripted run under Xvfb with a uinput responder.
+#define _GNU_SOURCE
+#include <X11/XKBlib.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "config_defaults.h"
+#include "config_parser.h"
+#include "event_recorder.h"
+#include "foreperiod.h"
+#include "latency_diagnostics.h"
+#include "linux_input.h"
+#include "stimulus_scheduler.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "trial_logger.h"
+
+#define FRAME_COUNT STATE_COUNT
+#define DISPLAY_BUFFER_SIZE 512
+#define HISTORY_FILE_NAME "history.hist"
+#define MAX_DEVICE_PATHS EVDEV_MAX_DEVICES
+
+// Configuration, the subset of user.cfg that means something here (no raw input thread or hot reload switches)
+typedef struct {
+    uint8_t ready_color[3];
+    uint8_t react_color[3];
+    uint8_t early_color[3];
+    uint8_t result_color[3];
+    uint8_t early_font[3];
+    uint8_t results_font[3];
+    char font_name[64];
+    int font_size;
+    bool bold;
+    int resolution_width;
+    int resolution_height;
+
+    int stimulus_spin_window;
+    uint64_t random_seed;
+    ForeperiodDistribution foreperiods;
+
+    bool keyboard;
+    bool mouse;
+    bool raw_input_debug;
+    bool trial_logging;
+    bool text_log;
+    bool session_file;
+    bool input_recording;
+    bool trace;
+    bool diagnostics_overlay;
+    bool diagnostics_logging;
+    int diagnostics_flag_threshold;
+    int log_flush_interval;
+    bool telemetry;
+    char telemetry_name[TELEMETRY_MAX_NAME + 1];
+
+    EngineConfig game;
+} Configuration;
+
+typedef struct {
+    char directory[PATH_MAX];   // Next to the executable, holds config/ and log/
+    char config_path[PATH_MAX];
+    char log_directory[PATH_MAX];
+    char timestamp[20];
+    time_t session_start;
+    uint64_t session_id;
+    uint64_t seed;
+    const char* device_paths[MAX_DEVICE_PATHS];
+    int device_count;
+    int64_t trial_limit;        // 0 = run until the window is closed
+    int64_t valid_trials;
+} ProgramData;
+
+typedef struct {
+    Display* display;
+    Window window;
+    GC gc;
+    Atom delete_window;
+    XFontStruct* font;
+    XFontStruct* overlay_font;
+    unsigned long pixels[STATE_COLOR_COUNT]; // Backgrounds, indexed by StateView.background
+    unsigned long early_text_pixel;
+    unsigned long results_text_pixel;
+    Pixmap frames[FRAME_COUNT]; // Pre-rendered per state, a repaint is one XCopyArea
+    bool stale[FRAME_COUNT];
+    int width;
+    int height;
+    bool repaint;
+    bool focused;
+} UI;
+
+// Everything one running test owns, passed to every function below and to the engine as its platform context
+typedef struct {
+    Configuration config;
+    ReactionEngine engine;
+    ProgramData data;
+    UI ui;
+    StimulusScheduler scheduler;
+    EvdevInput evdev;
+    bool evdev_running;
+    TrialLogger trial_logger;
+    SessionWriter session_writer;
+    EventRecorder recorder;
+    LatencyDiagnostics diagnostics;
+    TelemetryWriter telemetry;              // Idle unless TelemetryEnabled=1
+    int64_t timer_due[TIMER_DEBOUNCE + 1];  // 0 = not armed
+    int stimulus_pipe[2];                   // Scheduler thread -> UI thread, one StimulusMessage per onset
+    InputEventBatch input_batch;            // Drain buffer, too big for the stack
+} Session;
+
+typedef struct {
+    int64_t scheduled_tick;
+    int64_t onset_tick;
+} StimulusMessage;
+
+static void Fail(Session* session, const char* message) {
+    fprintf(stderr, "Error: %s\n", message);
+    StopTrialLogger(&session->trial_logger); // Keep the trials recorded so far
+    exit(1);
+}
+
+static void MakePath(Session* session, char path[PATH_MAX], const char* format, ...) { // Every file name is built from session->data.directory, too long is fatal
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(path, PATH_MAX, format, args);
+    va_end(args);
+    if (length < 0 || length >= PATH_MAX) {
+        Fail(session, "Path too long");
+    }
+}
+
+// Configuration
+static int ReadConfigInt(Session* session, const ConfigFile* cfg, const char* section, const char* key, int fallback, int min, int max) {
+    int value;
+    if (!ConfigInt(cfg, section, key, fallback, min, max, &value)) {
+        fprintf(stderr, "Error: invalid value for %s in %s\n", key, session->data.config_path);
+        exit(1);
+    }
+    return value;
+}
+
+static void ReadConfigColor(Session* session, const ConfigFile* cfg, const char* section, const char* key, uint8_t color[3]) {
+    if (!ConfigColor(cfg, section, key, color)) {
+        fprintf(stderr, "Error: invalid color for %s in %s\n", key, session->data.config_path);
+        exit(1);
+    }
+}
+
+static bool CopyFile(const char* from, const char* to) {
+    FILE* source = fopen(from, "rb");
+    if (!source) {
+        return false;
+    }
+    FILE* target = fopen(to, "wb");
+    bool copied = target != NULL;
+    char buffer[1024];
+    size_t size;
+    while (copied && (size = fread(buffer, 1, sizeof(buffer), source)) > 0) {
+        copied = fwrite(buffer, 1, size, target) == size;
+    }
+    fclose(source);
+    if (target && fclose(target) != 0) copied = false;
+    return copied;
+}
+
+static void LoadForeperiods(Session* session, const ConfigFile* cfg) {
+    int min_delay = ReadConfigInt(session, cfg, "Delays", "MinDelay", DEFAULT_MIN_DELAY, 0, INT_MAX);
+    int max_delay = ReadConfigInt(session, cfg, "Delays", "MaxDelay", DEFAULT_MAX_DELAY, 0, INT_MAX);
+    if (max_delay < min_delay) {
+        Fail(session, "MaxDelay cannot be less than MinDelay");
+    }
+
+    const char* model = ConfigString(cfg, "Delays", "ForeperiodDistribution", DEFAULT_FOREPERIOD_DISTRIBUTION);
+    bool built = false;
+    if (!strcmp(model, "Uniform")) {
+        built = BuildUniformForeperiods(&session->config.foreperiods, min_delay, max_delay);
+    } else if (!strcmp(model, "Exponential")) {
+        int mean = ReadConfigInt(session, cfg, "Delays", "ForeperiodMean", DEFAULT_FOREPERIOD_MEAN, 1, INT_MAX);
+        built = BuildExponentialForeperiods(&session->config.foreperiods, min_delay, max_delay, mean);
+    } else if (!strcmp(model, "Weighted")) {
+        built = BuildWeightedForeperiods(&session->config.foreperiods, ConfigString(cfg, "Delays", "ForeperiodWeights", ""));
+    } else if (!strcmp(model, "Table")) {
+        char path[PATH_MAX];
+        MakePath(session, path, "%s/config/%s", session->data.directory, ConfigString(cfg, "Delays", "ForeperiodTable", ""));
+        FILE* file = fopen(path, "rb");
+        if (file) {
+            built = LoadForeperiodTable(&session->config.foreperiods, file);
+            fclose(file);
+        }
+    }
+    if (!built) {
+        Fail(session, "Invalid foreperiod configuration");
+    }
+}
+
+static void LoadConfig(Session* session) {
+    char default_path[PATH_MAX];
+    MakePath(session, default_path, "%s/config/default.cfg", session->data.directory);
+    if (!session->data.config_path[0]) {
+        MakePath(session, session->data.config_path, "%s/config/user.cfg", session->data.directory);
+        if (access(session->data.config_path, F_OK) != 0 && !CopyFile(default_path, session->data.config_path)) { // First launch, same as Windows
+            Fail(session, "Failed to create user.cfg from default.cfg");
+        }
+    }
+
+    ConfigFile cfg;
+    FILE* file = fopen(session->data.config_path, "rb");
+    if (!file || !LoadConfigFile(&cfg, file)) {
+        Fail(session, "Failed to read the config file");
+    }
+    fclose(file);
+
+    session->config.resolution_width = ReadConfigInt(session, &cfg, "Resolution", "ResolutionWidth", DEFAULT_RESOLUTION_WIDTH, 1, 65535);
+    session->config.resolution_height = ReadConfigInt(session, &cfg, "Resolution", "ResolutionHeight", DEFAULT_RESOLUTION_HEIGHT, 1, 65535);
+    ReadConfigColor(session, &cfg, "Colors", "ReadyColor", session->config.ready_color);
+    ReadConfigColor(session, &cfg, "Colors", "ReactColor", session->config.react_color);
+    ReadConfigColor(session, &cfg, "Colors", "EarlyColor", session->config.early_color);
+    ReadConfigColor(session, &cfg, "Colors", "ResultColor", session->config.result_color);
+    ReadConfigColor(session, &cfg, "Fonts", "EarlyFontColor", session->config.early_font);
+    ReadConfigColor(session, &cfg, "Fonts", "ResultsFontColor", session->config.results_font);
+    snprintf(session->config.font_name, sizeof(session->config.font_name), "%s", ConfigString(&cfg, "Fonts", "FontName", DEFAULT_FONT_NAME));
+    session->config.font_size = ReadConfigInt(session, &cfg, "Fonts", "FontSize", DEFAULT_FONT_SIZE, 1, 1000);
+    session->config.bold = strstr(ConfigString(&cfg, "Fonts", "FontStyle", DEFAULT_FONT_STYLE), "Bold") != NULL;
+
+    LoadForeperiods(session, &cfg);
+    session->config.stimulus_spin_window = ReadConfigInt(session, &cfg, "Delays", "StimulusSpinWindow", DEFAULT_STIMULUS_SPIN_WINDOW, 0, INT_MAX);
+    session->config.game.early_reset_delay = ReadConfigInt(session, &cfg, "Delays", "EarlyResetDelay", DEFAULT_EARLY_RESET_DELAY, 0, INT_MAX);
+    session->config.game.virtual_debounce = ReadConfigInt(session, &cfg, "Delays", "VirtualDebounce", DEFAULT_VIRTUAL_DEBOUNCE, 0, INT_MAX);
+    session->config.game.averaging_trials = ReadConfigInt(session, &cfg, "Trial", "AveragingTrials", DEFAULT_AVG_TRIALS, 1, INT_MAX);
+    session->config.game.total_trials = ReadConfigInt(session, &cfg, "Trial", "TotalTrials", DEFAULT_TOTAL_TRIALS, 1, INT_MAX);
+    session->config.game.histogram_precision = ReadConfigInt(session, &cfg, "Trial", "HistogramPrecision", DEFAULT_HISTOGRAM_PRECISION,
+        HISTOGRAM_MIN_SIGNIFICANT_BITS, HISTOGRAM_MAX_SIGNIFICANT_BITS);
+    session->config.log_flush_interval = ReadConfigInt(session, &cfg, "Trial", "LogFlushInterval", DEFAULT_LOG_FLUSH_INTERVAL, 1, INT_MAX);
+    session->config.diagnostics_flag_threshold = ReadConfigInt(session, &cfg, "Trial", "DiagnosticsFlagThreshold", DEFAULT_DIAGNOSTICS_FLAG_THRESHOLD, 0, DIAGNOSTICS_HIGHEST_MS);
+
+    const char* log_format = ConfigString(&cfg, "Trial", "TrialLogFormat", DEFAULT_TRIAL_LOG_FORMAT);
+    session->config.text_log = !strcmp(log_format, "Text") || !strcmp(log_format, "Both");
+    session->config.session_file = !strcmp(log_format, "Binary") || !strcmp(log_format, "Both");
+    if (!session->config.text_log && !session->config.session_file) {
+        Fail(session, "Invalid trial log format");
+    }
+    const char* seed = ConfigString(&cfg, "Trial", "RandomSeed", DEFAULT_RANDOM_SEED);
+    char* seed_end;
+    errno = 0;
+    session->config.random_seed = strtoull(seed, &seed_end, 0);
+    if (!*seed || *seed == '-' || *seed_end || errno == ERANGE) {
+        Fail(session, "Invalid value for RandomSeed");
+    }
+
+    // RawKeyboardEnabled/RawMouseEnabled pick the sources here, evdev or the X11 fallback both count as raw
+    session->config.keyboard = ReadConfigInt(session, &cfg, "Toggles", "RawKeyboardEnabled", DEFAULT_RAWKEYBOARDENABLE, 0, 1);
+    session->config.mouse = ReadConfigInt(session, &cfg, "Toggles", "RawMouseEnabled", DEFAULT_RAWMOUSEENABLE, 0, 1);
+    session->config.raw_input_debug = ReadConfigInt(session, &cfg, "Toggles", "RawInputDebug", 0, 0, 1);
+    session->config.trial_logging = ReadConfigInt(session, &cfg, "Toggles", "TrialLoggingEnabled", 0, 0, 1);
+    session->config.input_recording = ReadConfigInt(session, &cfg, "Toggles", "InputRecordingEnabled", 0, 0, 1);
+    session->config.trace = ReadConfigInt(session, &cfg, "Toggles", "TraceEnabled", 0, 0, 1);
+    session->config.diagnostics_overlay = ReadConfigInt(session, &cfg, "Toggles", "DiagnosticsOverlay", 0, 0, 1);
+    session->config.diagnostics_logging = ReadConfigInt(session, &cfg, "Toggles", "DiagnosticsLogging", 0, 0, 1);
+    session->config.telemetry = ReadConfigInt(session, &cfg, "Toggles", "TelemetryEnabled", 0, 0, 1);
+    const char* telemetry_name = ConfigString(&cfg, "Toggles", "TelemetryName", DEFAULT_TELEMETRY_NAME);
+    if (!ValidTelemetryName(telemetry_name)) {
+        Fail(session, "Invalid value for TelemetryName");
+    }
+    snprintf(session->config.telemetry_name, sizeof(session->config.telemetry_name), "%s", telemetry_name);
+    FreeConfig(&cfg);
+}
+
+// Engine platform callbacks
+static int64_t PlatformNow(void* context) {
+    (void)context;
+    return ClockNow();
+}
+
+static void PlatformSetTimer(void* context, int timer_id, int delay_ms) {
+    Session* session = context;
+    if (timer_id >= 0 && timer_id <= TIMER_DEBOUNCE) session->timer_due[timer_id] = ClockNow() + MillisecondsToTicks(delay_ms, ClockFrequency());
+}
+
+static void PlatformKillTimer(void* context, int timer_id) {
+    Session* session = context;
+    if (timer_id >= 0 && timer_id <= TIMER_DEBOUNCE) session->timer_due[timer_id] = 0;
+}
+
+static void PlatformRequestRepaint(void* context) {
+    Session* session = context;
+    GameState state = session->engine.state.game_state;
+    if (STATE_VIEWS[state].text != STATE_TEXT_NONE) {
+        session->ui.stale[state] = true; // New text, rendered once by the next paint
+    }
+    session->ui.repaint = true;
+    PublishParticipant(&session->telemetry, 0, &session->engine, ClockNow());
+}
+
+static void PlatformScheduleStimulus(void* context, int64_t deadline_tick) {
+    Session* session = context;
+    ArmStimulus(&session->scheduler, deadline_tick);
+}
+
+static void PlatformCancelStimulus(void* context) {
+    Session* session = context;
+    CancelStimulus(&session->scheduler);
+}
+
+static void PlatformTrialComplete(void* context, const TrialRecord* record) {
+    Session* session = context;
+    AddTrialDiagnostics(&session->diagnostics, record);
+    if (session->config.trial_logging) {
+        LogTrial(&session->trial_logger, record);
+    }
+    session->data.valid_trials += record->outcome == TRIAL_VALID;
+    PublishTrial(&session->telemetry, 0, record);
+    PublishDiagnostics(&session->telemetry, &session->diagnostics);
+}
+
+static void PlatformStimulusOnset(void* context, int64_t scheduled_tick, int64_t onset_tick) { // Runs on the scheduler thread
+    Session* session = context;
+    StimulusMessage message = {scheduled_tick, onset_tick};
+    if (write(session->stimulus_pipe[1], &message, sizeof(message)) != sizeof(message)) { // Below PIPE_BUF, never torn
+        fprintf(stderr, "Error: lost a stimulus onset\n");
+    }
+}
+
+// Rendering
+static unsigned long ColorPixel(Session* session, const uint8_t color[3]) {
+    XColor xcolor = {.red = (unsigned short)(color[0] * 257), .green = (unsigned short)(color[1] * 257), .blue = (unsigned short)(color[2] * 257),
+        .flags = DoRed | DoGreen | DoBlue};
+    XAllocColor(session->ui.display, DefaultColormap(session->ui.display, DefaultScreen(session->ui.display)), &xcolor);
+    return xcolor.pixel;
+}
+
+static XFontStruct* LoadFont(Session* session) { // Core fonts: the configured family first, then any scalable sans, then "fixed"
+    char family[sizeof(session->config.font_name)];
+    char pattern[160];
+    for (size_t i = 0; i < sizeof(family); i++) { // XLFD family names are lower case
+        char c = session->config.font_name[i];
+        family[i] = c >= 'A' && c <= 'Z' ? (char)(c + 32) : c;
+    }
+
+    const char* families[] = {family, "helvetica", "*"};
+    for (size_t i = 0; i < sizeof(families) / sizeof(families[0]); i++) {
+        snprintf(pattern, sizeof(pattern), "-*-%s-%s-r-normal--%d-*-*-*-*-*-iso8859-1", families[i], session->config.bold ? "bold" : "medium", session->config.font_size);
+        XFontStruct* font = XLoadQueryFont(session->ui.display, pattern);
+        if (font) return font;
+    }
+    return XLoadQueryFont(session->ui.display, "fixed");
+}
+
+static void ResultText(Session* session, char* buffer) {
+    int length;
+    if (!AverageAvailable(&session->engine)) {
+        length = snprintf(buffer, DISPLAY_BUFFER_SIZE, "Last: %.2fms\nComplete %d trials for average.\nTrials so far: %d",
+            session->engine.data.reaction_time_value, session->config.game.averaging_trials, session->engine.state.trial_iteration);
+    } else {
+        const RollingSummary* summary = &session->engine.data.rolling.summary;
+        length = snprintf(buffer, DISPLAY_BUFFER_SIZE, "Last: %.2fms\nAverage (last %d): %.2fms (SD %.2fms)\nMedian: %.2fms | Best: %.2fms\nTrials so far: %d",
+            session->engine.data.reaction_time_value, session->config.game.averaging_trials, summary->mean, summary->sd, summary->median, summary->min, session->engine.state.trial_iteration);
+    }
+    if (length > 0) {
+        const LatencyHistogram* histogram = &session->engine.data.session_histogram;
+        length += snprintf(buffer + length, DISPLAY_BUFFER_SIZE - length, "\nSession p50/p90/p99: %.1f / %.1f / %.1fms",
+            TicksToMilliseconds(LatencyPercentile(histogram, 50), session->engine.data.frequency),
+            TicksToMilliseconds(LatencyPercentile(histogram, 90), session->engine.data.frequency),
+            TicksToMilliseconds(LatencyPercentile(histogram, 99), session->engine.data.frequency));
+    }
+    if (session->config.raw_input_debug && length > 0) {
+        snprintf(buffer + length, DISPLAY_BUFFER_SIZE - length, "\nHandoff: %.3fms (%s)",
+            TicksToMilliseconds(session->engine.data.last_trial.dispatch - session->engine.data.last_trial.response, session->engine.data.frequency),
+            session->evdev_running ? "evdev" : "X11");
+    }
+}
+
+static void DrawLines(Session* session, Drawable target, XFontStruct* font, const char* text, bool centered) {
+    int line_height = font->ascent + font->descent;
+    int lines = 1;
+    for (const char* p = text; *p; p++) lines += *p == '\n';
+    int y = centered ? (session->ui.height - lines * line_height) / 2 + font->ascent : 8 + font->ascent;
+
+    XSetFont(session->ui.display, session->ui.gc, font->fid);
+    for (const char* line = text; line; y += line_height) {
+        const char* end = strchr(line, '\n');
+        int length = end ? (int)(end - line) : (int)strlen(line);
+        int x = centered ? (session->ui.width - XTextWidth(font, line, length)) / 2 : 8;
+        XDrawString(session->ui.display, target, session->ui.gc, x, y, line, length);
+        line = end ? end + 1 : NULL;
+    }
+}
+
+static void DiagnosticsOverlay(Session* session, Drawable target) {
+    char buffer[DISPLAY_BUFFER_SIZE];
+    int length = snprintf(buffer, sizeof(buffer), "Pipeline (ms)   last     p50     p99     max");
+    for (int i = 0; i < MEASURE_COUNT && length > 0; i++) {
+        const LatencyHistogram* histogram = &session->diagnostics.histograms[i];
+        double last = session->diagnostics.last[i] < 0 ? 0.0 : TicksToMilliseconds(session->diagnostics.last[i], session->engine.data.frequency);
+        length += snprintf(buffer + length, sizeof(buffer) - length, "\n%-10s %8.3f %7.3f %7.3f %7.3f", PIPELINE_MEASURE_NAMES[i], last,
+            TicksToMilliseconds(LatencyPercentile(histogram, 50), session->engine.data.frequency),
+            TicksToMilliseconds(LatencyPercentile(histogram, 99), session->engine.data.frequency),
+            TicksToMilliseconds(histogram->max, session->engine.data.frequency));
+    }
+    if (length > 0) {
+        snprintf(buffer + length, sizeof(buffer) - length, "\nFlagged: %llu of %llu trials",
+            (unsigned long long)session->diagnostics.flagged, (unsigned long long)session->diagnostics.trials);
+    }
+    XSetForeground(session->ui.display, session->ui.gc, session->ui.results_text_pixel);
+    DrawLines(session, target, session->ui.overlay_font, buffer, false);
+}
+
+static void RenderFrame(Session* session, GameState state) {
+    const StateView* view = &STATE_VIEWS[state];
+    Pixmap frame = session->ui.frames[state];
+    XSetForeground(session->ui.display, session->ui.gc, session->ui.pixels[view->background]);
+    XFillRectangle(session->ui.display, frame, session->ui.gc, 0, 0, (unsigned)session->ui.width, (unsigned)session->ui.height);
+    session->ui.stale[state] = false;
+    if (view->text == STATE_TEXT_NONE) {
+        return; // Plain color, the stimulus is the change between these two
+    }
+
+    char buffer[DISPLAY_BUFFER_SIZE] = {0};
+    XSetForeground(session->ui.display, session->ui.gc, view->early_font ? session->ui.early_text_pixel : session->ui.results_text_pixel);
+    switch (view->text) {
+    case STATE_TEXT_BEGIN:
+        snprintf(buffer, sizeof(buffer), "Click to Begin");
+        break;
+    case STATE_TEXT_RESULT:
+        ResultText(session, buffer);
+        break;
+    case STATE_TEXT_EARLY:
+        snprintf(buffer, sizeof(buffer), "Too early!\nTrials so far: %d", session->engine.state.trial_iteration);
+        break;
+    default:
+        break;
+    }
+    DrawLines(session, frame, session->ui.font, buffer, true);
+    if (session->config.diagnostics_overlay) {
+        DiagnosticsOverlay(session, frame);
+    }
+}
+
+static void ResizeFrames(Session* session, int width, int height) {
+    if (width < 1) width = 1;
+    if (height < 1) height = 1;
+    if (width == session->ui.width && height == session->ui.height && session->ui.frames[0]) {
+        return;
+    }
+    int depth = DefaultDepth(session->ui.display, DefaultScreen(session->ui.display));
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        if (session->ui.frames[i]) XFreePixmap(session->ui.display, session->ui.frames[i]);
+        session->ui.frames[i] = XCreatePixmap(session->ui.display, session->ui.window, (unsigned)width, (unsigned)height, (unsigned)depth);
+        session->ui.stale[i] = true;
+    }
+    session->ui.width = width;
+    session->ui.height = height;
+    RenderFrame(session, STATE_REACT); // Never rendered on demand, the stimulus only copies
+    session->ui.repaint = true;
+}
+
+static void Present(Session* session) {
+    GameState state = session->engine.state.game_state;
+    TRACE_BEGIN(TRACE_PAINT, state);
+    if (session->ui.stale[state]) RenderFrame(session, state);
+    XCopyArea(session->ui.display, session->ui.frames[state], session->ui.window, session->ui.gc, 0, 0, (unsigned)session->ui.width, (unsigned)session->ui.height, 0, 0);
+    if (state == STATE_REACT && !session->engine.data.presented) {
+        XSync(session->ui.display, False); // Round trip, the server has executed the copy (the EndPaint equivalent)
+        int64_t presented = ClockNow();
+        RecordPresented(&session->recorder, presented);
+        StimulusPresented(&session->engine, presented);
+    } else {
+        XFlush(session->ui.display);
+    }
+    if (state == STATE_READY && session->ui.stale[STATE_REACT]) {
+        RenderFrame(session, STATE_REACT);
+    }
+    session->ui.repaint = false;
+    TRACE_END(TRACE_PAINT);
+}
+
+static void CreateMainWindow(Session* session) {
+    session->ui.display = XOpenDisplay(NULL);
+    if (!session->ui.display) {
+        Fail(session, "Cannot open the X display (is DISPLAY set?)");
+    }
+    int screen = DefaultScreen(session->ui.display);
+    int x = (DisplayWidth(session->ui.display, screen) - session->config.resolution_width) / 2;
+    int y = (DisplayHeight(session->ui.display, screen) - session->config.resolution_height) / 2;
+    XSetWindowAttributes attributes = {
+        .background_pixmap = None, // No server-side background fill before each copy
+        .bit_gravity = NorthWestGravity,
+        .event_mask = ExposureMask | StructureNotifyMask | KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask |
+            EnterWindowMask | LeaveWindowMask | FocusChangeMask
+    };
+    session->ui.window = XCreateWindow(session->ui.display, RootWindow(session->ui.display, screen), x < 0 ? 0 : x, y < 0 ? 0 : y,
+        (unsigned)session->config.resolution_width, (unsigned)session->config.resolution_height, 0, CopyFromParent, InputOutput, CopyFromParent,
+        CWBackPixmap | CWBitGravity | CWEventMask, &attributes);
+    XStoreName(session->ui.display, session->ui.window, "Reaction Time Tester");
+    session->ui.delete_window = XInternAtom(session->ui.display, "WM_DELETE_WINDOW", False);
+    XSetWMProtocols(session->ui.display, session->ui.window, &session->ui.delete_window, 1);
+    XkbSetDetectableAutoRepeat(session->ui.display, True, NULL); // Held keys repeat presses only, no fake release edges
+    session->ui.gc = XCreateGC(session->ui.display, session->ui.window, 0, NULL);
+
+    session->ui.pixels[STATE_COLOR_READY] = ColorPixel(session, session->config.ready_color);
+    session->ui.pixels[STATE_COLOR_REACT] = ColorPixel(session, session->config.react_color);
+    session->ui.pixels[STATE_COLOR_EARLY] = ColorPixel(session, session->config.early_color);
+    session->ui.pixels[STATE_COLOR_RESULT] = ColorPixel(session, session->config.result_color);
+    session->ui.early_text_pixel = ColorPixel(session, session->config.early_font);
+    session->ui.results_text_pixel = ColorPixel(session, session->config.results_font);
+    session->ui.font = LoadFont(session);
+    session->ui.overlay_font = XLoadQueryFont(session->ui.display, "fixed");
+    if (!session->ui.font || !session->ui.overlay_font) {
+        Fail(session, "No usable X11 core font");
+    }
+    ResizeFrames(session, session->config.resolution_width, session->config.resolution_height);
+    XMapWindow(session->ui.display, session->ui.window);
+}
+
+// Logging
+static FILE* OpenLogFile(Session* session, const char* prefix, const char* extension, const char* mode) {
+    char path[PATH_MAX];
+    MakePath(session, path, "%s/%s_%s.%s", session->data.log_directory, prefix, session->data.timestamp, extension);
+    FILE* file = fopen(path, mode);
+    if (!file) {
+        fprintf(stderr, "Error: %s: %s\n", path, strerror(errno));
+        exit(1);
+    }
+    return file;
+}
+
+static void InitializeLogging(Session* session) {
+    MakePath(session, session->data.log_directory, "%s/log", session->data.directory);
+    if ((session->config.trial_logging || session->config.input_recording || session->config.trace) && mkdir(session->data.log_directory, 0755) != 0 && errno != EEXIST) {
+        Fail(session, "Failed to create log directory");
+    }
+    session->data.session_start = time(NULL);
+    struct tm local_time;
+    localtime_r(&session->data.session_start, &local_time);
+    strftime(session->data.timestamp, sizeof(session->data.timestamp), "%Y%m%d%H%M%S", &local_time);
+    session->data.session_id = ((uint64_t)session->data.session_start << 20) | ((uint64_t)getpid() & 0xFFFFF);
+
+    if (session->config.trial_logging) {
+        FILE* log_file = session->config.text_log ? OpenLogFile(session, "Log", "log", "a") : NULL;
+        if (log_file) {
+            fprintf(log_file, "Seed: %llu\n", (unsigned long long)session->data.seed);
+        }
+        SessionWriter* writer = NULL;
+        if (session->config.session_file) {
+            if (!OpenSessionWriter(&session->session_writer, OpenLogFile(session, "Session", "rts", "wb"), session->data.session_id, session->engine.data.frequency, (int64_t)session->data.session_start, session->data.seed)) {
+                Fail(session, "Failed to write session file header");
+            }
+            writer = &session->session_writer;
+        }
+        if (!StartTrialLogger(&session->trial_logger, log_file, writer, session->config.log_flush_interval, session->config.diagnostics_logging ? &session->diagnostics.settings : NULL)) {
+            Fail(session, "Failed to start trial logger");
+        }
+    }
+    if (session->config.input_recording && !StartEventRecorder(&session->recorder, OpenLogFile(session, "Input", "rec", "wb"), &session->engine, session->data.session_id, (int64_t)session->data.session_start)) {
+        Fail(session, "Failed to write input recording header");
+    }
+}
+
+static void DumpTrace(Session* session) {
+    char timestamp[20];
+    time_t t = time(NULL);
+    struct tm local_time;
+    localtime_r(&t, &local_time);
+    strftime(timestamp, sizeof(timestamp), "%Y%m%d%H%M%S", &local_time);
+    char path[PATH_MAX];
+    MakePath(session, path, "%s/Trace_%s.json", session->data.log_directory, timestamp);
+    FILE* file = fopen(path, "w");
+    if (file) {
+        WriteTrace(file);
+        fclose(file);
+    }
+}
+
+static void SaveDiagnosticsSummary(Session* session) { // Appended to the text log once the logger thread has closed it
+    FILE* file = OpenLogFile(session, "Log", "log", "a");
+    fprintf(file, "Diagnostics: %llu trials, %llu flagged\n", (unsigned long long)session->diagnostics.trials, (unsigned long long)session->diagnostics.flagged);
+    for (int i = 0; i < MEASURE_COUNT; i++) {
+        const LatencyHistogram* histogram = &session->diagnostics.histograms[i];
+        fprintf(file, "Diagnostics %s: p50 %.3f p90 %.3f p99 %.3f max %.3f ms (%llu samples)\n", PIPELINE_MEASURE_NAMES[i],
+            TicksToMilliseconds(LatencyPercentile(histogram, 50), session->engine.data.frequency),
+            TicksToMilliseconds(LatencyPercentile(histogram, 90), session->engine.data.frequency),
+            TicksToMilliseconds(LatencyPercentile(histogram, 99), session->engine.data.frequency),
+            TicksToMilliseconds(histogram->max, session->engine.data.frequency), (unsigned long long)histogram->total);
+    }
+    fclose(file);
+}
+
+static void SaveSessionHistory(Session* session) { // Same log/history.hist as the Windows build, histograms carry their own frequency
+    char path[PATH_MAX];
+    MakePath(session, path, "%s/%s", session->data.log_directory, HISTORY_FILE_NAME);
+    LatencyHistogram history;
+    bool loaded = false;
+    FILE* file = fopen(path, "rb");
+    if (file) {
+        loaded = LoadLatencyHistogram(&history, file);
+        fclose(file);
+    }
+    if (!loaded && !InitializeLatencyHistogram(&history, session->engine.data.session_histogram.highest_trackable, session->engine.data.session_histogram.significant_bits, session->engine.data.frequency)) {
+        return;
+    }
+    MergeLatencyHistogram(&history, &session->engine.data.session_histogram);
+    if ((file = fopen(path, "wb"))) {
+        SaveLatencyHistogram(&history, file);
+        fclose(file);
+    }
+    FreeLatencyHistogram(&history);
+}
+
+// Input
+static void DrainEvdevInput(Session* session) {
+    AcknowledgeEvdevNotification(&session->evdev);
+    TRACE_BEGIN(TRACE_INPUT_DRAIN, 0);
+    InputEventBatch* batch = &session->input_batch;
+    while (PopEvdevBatch(&session->evdev, batch)) {
+        if (!session->ui.focused) { // evdev sees input for every window, only ours counts. Keep releases so key states can't get stuck
+            uint32_t kept = 0;
+            for (uint32_t i = 0; i < batch->count; i++) {
+                if (!batch->events[i].pressed) batch->events[kept++] = batch->events[i];
+            }
+            batch->count = kept;
+        }
+        RecordInputBatch(&session->recorder, batch, session->config.keyboard, session->config.mouse);
+        DispatchInputBatch(&session->engine, batch, session->config.keyboard, session->config.mouse);
+    }
+    TRACE_END(TRACE_INPUT_DRAIN);
+}
+
+static void HandleX11Input(Session* session, const XEvent* event) { // Fallback when evdev is not available, stamped on read
+    InputEventBatch* batch = &session->input_batch;
+    InputEvent* input = &batch->events[0];
+    *input = (InputEvent){.arrival_tick = ClockNow()};
+    if (event->type == KeyPress || event->type == KeyRelease) {
+        KeySym symbol = XLookupKeysym((XKeyEvent*)&event->xkey, 0);
+        if (symbol >= XK_a && symbol <= XK_z) input->key = (uint16_t)('A' + symbol - XK_a);
+        else if (symbol >= XK_0 && symbol <= XK_9) input->key = (uint16_t)('0' + symbol - XK_0);
+        else return;
+        input->source = INPUT_SOURCE_KEYBOARD;
+        input->pressed = event->type == KeyPress;
+    } else {
+        if (event->xbutton.button != Button1) return;
+        input->source = INPUT_SOURCE_MOUSE;
+        input->pressed = event->type == ButtonPress;
+    }
+    batch->count = 1;
+    RecordInputBatch(&session->recorder, batch, session->config.keyboard, session->config.mouse);
+    DispatchInputBatch(&session->engine, batch, session->config.keyboard, session->config.mouse);
+}
+
+static bool HandleX11Event(Session* session, XEvent* event) { // False once the window was closed
+    switch (event->type) {
+    case Expose:
+        if (event->xexpose.count == 0) session->ui.repaint = true;
+        break;
+    case ConfigureNotify:
+        ResizeFrames(session, event->xconfigure.width, event->xconfigure.height);
+        break;
+    case FocusIn:
+    case FocusOut:
+        session->ui.focused = event->type == FocusIn;
+        break;
+    case EnterNotify:
+    case LeaveNotify:
+        session->engine.state.mouse_active = event->type == EnterNotify;
+        RecordMouseActive(&session->recorder, session->engine.state.mouse_active);
+        break;
+    case KeyPress:
+        if (XLookupKeysym(&event->xkey, 0) == XK_F9 && session->config.trace) {
+            DumpTrace(session);
+            break;
+        }
+        // Fall through
+    case KeyRelease:
+        if (!session->evdev_running) HandleX11Input(session, event);
+        break;
+    case ButtonPress:
+    case ButtonRelease:
+        if (!session->evdev_running) HandleX11Input(session, event);
+        break;
+    case ClientMessage:
+        if ((Atom)event->xclient.data.l[0] == session->ui.delete_window) return false;
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+static int PollTimeout(Session* session) { // Until the next engine timer, in ms rounded up, -1 = none
+    int64_t next = 0;
+    for (int i = 0; i <= TIMER_DEBOUNCE; i++) {
+        if (session->timer_due[i] && (!next || session->timer_due[i] < next)) next = session->timer_due[i];
+    }
+    if (!next) {
+        return -1;
+    }
+    int64_t remaining = next - ClockNow();
+    return remaining <= 0 ? 0 : (int)((remaining + 999999) / 1000000);
+}
+
+static void FireTimers(Session* session) {
+    int64_t now = ClockNow();
+    for (int i = 0; i <= TIMER_DEBOUNCE; i++) {
+        if (session->timer_due[i] && session->timer_due[i] <= now) {
+            AddTimerLateness(&session->diagnostics, now - session->timer_due[i]);
+            session->timer_due[i] = 0; // One-shot, TimerStateLogic may re-arm it
+            TRACE_INSTANT(TRACE_TIMER_FIRE, i, 0);
+            RecordTimer(&session->recorder, i);
+            TimerStateLogic(&session->engine, i);
+        }
+    }
+}
+
+static void RunEventLoop(Session* session) {
+    int x11_fd = ConnectionNumber(session->ui.display);
+    for (;;) {
+        if (session->ui.repaint) Present(session);
+        XFlush(session->ui.display);
+        if (session->data.trial_limit && session->data.valid_trials >= session->data.trial_limit && session->engine.state.game_state == STATE_RESULT) {
+            return;
+        }
+
+        struct pollfd fds[3] = {
+            {.fd = session->stimulus_pipe[0], .events = POLLIN},
+            {.fd = session->evdev_running ? session->evdev.notify_fd : -1, .events = POLLIN},
+            {.fd = x11_fd, .events = POLLIN}
+        };
+        if (!XPending(session->ui.display) && poll(fds, 3, PollTimeout(session)) < 0 && errno != EINTR) {
+            Fail(session, "poll failed");
+        }
+
+        StimulusMessage message; // First, it is the one event whose handling time adds to the measurement
+        while (read(session->stimulus_pipe[0], &message, sizeof(message)) == sizeof(message)) {
+            RecordStimulus(&session->recorder, message.scheduled_tick, message.onset_tick);
+            StimulusOnset(&session->engine, message.scheduled_tick, message.onset_tick);
+            Present(session);
+        }
+        if (session->evdev_running && (fds[1].revents & POLLIN)) DrainEvdevInput(session);
+        while (XPending(session->ui.display)) {
+            XEvent event;
+            XNextEvent(session->ui.display, &event);
+            if (!HandleX11Event(session, &event)) return;
+        }
+        FireTimers(session);
+    }
+}
+
+static bool ParseTrialLimit(const char* text, int64_t* trial_limit) { // Same checks as RandomSeed, and at least one trial
+    char* end;
+    errno = 0;
+    long long value = strtoll(text, &end, 10);
+    if (!*text || *end || errno == ERANGE || value <= 0) {
+        return false;
+    }
+    *trial_limit = value;
+    return true;
+}
+
+static void ParseArguments(Session* session, int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--config") && i + 1 < argc) {
+            MakePath(session, session->data.config_path, "%s", argv[++i]);
+        } else if (!strcmp(argv[i], "--device") && i + 1 < argc && session->data.device_count < MAX_DEVICE_PATHS) {
+            session->data.device_paths[session->data.device_count++] = argv[++i];
+        } else if (!strcmp(argv[i], "--trials") && i + 1 < argc && ParseTrialLimit(argv[i + 1], &session->data.trial_limit)) {
+            i++;
+        } else {
+            fprintf(stderr, "Usage: %s [--config FILE] [--device PATH]... [--trials N]\n", argv[0]);
+            exit(2);
+        }
+    }
+}
+
+static void ResolveDirectory(Session* session) {
+    ssize_t length = readlink("/proc/self/exe", session->data.directory, sizeof(session->data.directory) - 1);
+    if (length <= 0) {
+        snprintf(session->data.directory, sizeof(session->data.directory), ".");
+        return;
+    }
+    session->data.directory[length] = '\0';
+    char* slash = strrchr(session->data.directory, '/');
+    if (slash) *slash = '\0';
+}
+
+static uint64_t NewSessionSeed(void) { // Only has to differ between sessions, SeedRandom does the mixing
+    uint64_t seed = ((uint64_t)time(NULL) << 32) ^ (uint64_t)ClockNow() ^ ((uint64_t)getpid() << 16);
+    return seed ? seed : 1;
+}
+
+static int RunSession(Session* session) { // One test from config to shutdown, on the calling thread
+    LoadConfig(session);
+    if (pipe(session->stimulus_pipe) != 0) {
+        Fail(session, "Failed to create the stimulus pipe");
+    }
+    fcntl(session->stimulus_pipe[0], F_SETFL, O_NONBLOCK);
+
+    EnginePlatform platform = {
+        .context = session,
+        .now = PlatformNow,
+        .set_timer = PlatformSetTimer,
+        .kill_timer = PlatformKillTimer,
+        .request_repaint = PlatformRequestRepaint,
+        .schedule_stimulus = PlatformScheduleStimulus,
+        .cancel_stimulus = PlatformCancelStimulus,
+        .trial_complete = PlatformTrialComplete
+    };
+    TraceThread("UI");
+    SetTraceEnabled(session->config.trace);
+    session->data.seed = session->config.random_seed ? session->config.random_seed : NewSessionSeed();
+    if (!InitializeEngine(&session->engine, &session->config.game, &platform, ClockFrequency(), &session->config.foreperiods, session->data.seed)) {
+        Fail(session, "Failed to allocate trial statistics");
+    }
+    if (!InitializeLatencyDiagnostics(&session->diagnostics, &(DiagnosticsSettings){ClockFrequency(), MillisecondsToTicks(session->config.diagnostics_flag_threshold, ClockFrequency())})) {
+        Fail(session, "Failed to allocate latency diagnostics");
+    }
+    if (!StartStimulusScheduler(&session->scheduler, session->config.stimulus_spin_window, PlatformStimulusOnset, session)) {
+        Fail(session, "Failed to start stimulus scheduler");
+    }
+    InitializeLogging(session);
+    if (session->config.telemetry) {
+        if (!OpenTelemetryWriter(&session->telemetry, session->config.telemetry_name, 1, session->data.session_id, session->data.seed, &session->diagnostics.settings)) {
+            Fail(session, "Failed to publish telemetry, another running tester uses the same TelemetryName");
+        }
+        PublishParticipant(&session->telemetry, 0, &session->engine, ClockNow());
+    }
+
+    session->evdev_running = OpenEvdevDevices(&session->evdev, session->data.device_paths, session->data.device_count, session->config.keyboard, session->config.mouse) && StartEvdevInput(&session->evdev);
+    if (!session->evdev_running && session->data.device_count) {
+        Fail(session, "Failed to open the input devices");
+    }
+    if (!session->evdev_running) {
+        fprintf(stderr, "No readable evdev devices (is the user in the \"input\" group?), using X11 input stamped on read\n");
+    }
+    CreateMainWindow(session);
+    RunEventLoop(session);
+
+    StopEventRecorder(&session->recorder);
+    if (session->config.trace) DumpTrace(session);
+    if (session->evdev_running) StopEvdevInput(&session->evdev);
+    StopStimulusScheduler(&session->scheduler);
+    StopTrialLogger(&session->trial_logger);
+    CloseTelemetryWriter(&session->telemetry);
+    if (session->config.trial_logging) SaveSessionHistory(session);
+    if (session->config.trial_logging && session->config.text_log) SaveDiagnosticsSummary(session);
+    XCloseDisplay(session->ui.display);
+    close(session->stimulus_pipe[0]);
+    close(session->stimulus_pipe[1]);
+    FreeLatencyDiagnostics(&session->diagnostics);
+    FreeEngine(&session->engine);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Session* session = calloc(1, sizeof(Session));
+    if (!session) {
+        fprintf(stderr, "Error: failed to allocate the session\n");
+        return 1;
+    }
+    session->config.game.virtual_debounce = DEFAULT_VIRTUAL_DEBOUNCE;
+    session->engine.state.game_state = STATE_INITIAL;
+    ParseArguments(session, argc, argv);
+    ResolveDirectory(session);
+    int result = RunSession(session);
+    free(session);
+    return result;
+}
@@ -5,87 +5,128 @@
 #include <stdlib.h>
 #include <time.h>
 #include <stdio.h>
+#include <limits.h>
+#include <errno.h>
+#include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <uchar.h>
 #include "main_definitions.h"
+#include "stimulus_scheduler.h"
+#include "win32_input.h"
+#include "win32_frames.h"
+#include "trial_logger.h"
+#include "config_watcher.h"
+#include "event_recorder.h"
+#include "trace.h"
+#include "latency_diagnostics.h"
+#include "telemetry.h"
+
+_Static_assert(TELEMETRY_MAX_PARTICIPANTS >= MAX_PARTICIPANTS, "Every lane needs a telemetry slot");
+_Static_assert(sizeof(WPARAM) == 8 && MAX_PARTICIPANTS <= (1 << (64 - LANE_STIMULUS_TICK_BITS)), "WM_APP_LANE_STIMULUS packs the lane above the tick");
 
 // Configuration
 typedef struct {
     // Appearance
-    COLORREF early_font[3];
-    COLORREF results_font[3];
+    uint8_t ready_color[3];
+    uint8_t react_color[3];
+    uint8_t early_color[3];
+    uint8_t result_color[3];
+    uint8_t early_font[3];
+    uint8_t results_font[3];
     wchar_t font_name[MAX_PATH];
     wchar_t font_style[MAX_PATH];
     int font_size;
     int resolution_width;
     int resolution_height;
 
+    // Timing
+    int stimulus_spin_window;
+    uint64_t random_seed;       // 0 = new seed every session
+    ForeperiodDistribution foreperiods; // Built while loading, the engine takes it over
+
     // Toggles
     bool raw_keyboard;
     bool raw_mouse;
     bool raw_input_debug;
+    bool input_thread;
     bool trial_logging;
+    bool text_log;
+    bool session_file;
     bool debug_logging;
+    bool hot_reload;
+    bool input_recording;
+    bool trace;
+    bool diagnostics_overlay;
+    bool diagnostics_logging;
+    int diagnostics_flag_threshold; // ms, 0 = never flag
+    int log_flush_interval;
+    int participants;           // 1 = one player on every device, more = one lane per keyboard or mouse
+    bool telemetry;
+    char telemetry_name[TELEMETRY_MAX_NAME + 1];
 
     // Game Options
-    int averaging_trials;
-    int total_trials;
-    int min_delay;
-    int max_delay;
-    int early_reset_delay;
-    int virtual_debounce;
+    EngineConfig game;
 } Configuration;
 
-// Program State and Data
-typedef struct { // ##REVIEW## Should I split this up a bit? Have a ProgramState and ProgramData?
-    // Game State
-    enum {
-        STATE_INITIAL,
-        STATE_READY,
-        STATE_REACT,
-        STATE_EARLY,
-        STATE_RESULT
-    } game_state;
-    int current_attempt;
-    int trial_iteration;
-
-    // Input State
-    bool mouse_active;
-    bool debounce_active;
-    int key_states[256];
-} ProgramState;
-
+// Program Data (game state and timing live in the engine)
 typedef struct {
-    // Logging and Data
-    double reaction_time_value;
-    double reaction_time_array[1024]; // ##REVIEW## Hardcoded size for now. Make user configurable later? Maybe rolling array would be a better
+    // Configuration
+    wchar_t config_directory[MAX_PATH];
+    wchar_t config_path[MAX_PATH];
+
+    // Input (what is currently set up, the config may already ask for something else)
+    bool input_thread_running;
+    bool raw_keyboard_registered;
+    bool raw_mouse_registered;
+
+    // Logging
+    wchar_t log_directory[MAX_PATH];
     wchar_t trial_log_path[MAX_PATH];
+    wchar_t session_file_path[MAX_PATH];
+    wchar_t recording_path[MAX_PATH];
+    time_t session_start;
+    uint64_t session_id;
     wchar_t debug_log_path[MAX_PATH];
-
-    // Timing
-    LARGE_INTEGER start_time;
-    LARGE_INTEGER end_time;
-    LARGE_INTEGER frequency;
+    uint64_t seed;              // Foreperiod seed actually used, logged with the session
 } ProgramData;
 
 
 // UI and Rendering
 typedef struct {
-    HBRUSH ready_brush;
-    HBRUSH react_brush;
-    HBRUSH early_brush;
-    HBRUSH result_brush;
+    HBRUSH brushes[STATE_COLOR_COUNT]; // Indexed by StateView.background
     HFONT font;
     int font_weight;
     BOOL italics_enabled;
 } UI;
 
-// Declare global structs
-Configuration config = {.virtual_debounce = DEFAULT_VIRTUAL_DEBOUNCE};
-ProgramState state = {.game_state = STATE_INITIAL};
-ProgramData data = {.reaction_time_array = {0}};
-UI ui;
+// Everything one running test owns. WindowProc finds it through GWLP_USERDATA and every function below gets it
+// passed in, so nothing is shared between windows (or threads) except the trace registry, which is thread-safe.
+typedef struct Session {
+    HWND hwnd;
+    Configuration config;
+    ReactionEngine engine;
+    ProgramData data;
+    UI ui;
+    StimulusScheduler scheduler;
+    InputThread input_thread;
+    TrialLogger trial_logger;
+    SessionWriter session_writer;
+    ConfigWatcher config_watcher;
+    EventRecorder recorder;     // Idle unless InputRecordingEnabled=1
+    ConfigFile active_config;   // Last user.cfg that was applied, reloads are diffed against it
+    FrameCache frames;          // One pre-rendered frame per game state
+    LatencyDiagnostics diagnostics; // Always collected, shown with DiagnosticsOverlay=1
+    int64_t timer_due[TIMER_DEBOUNCE + 1]; // Tick each engine timer should fire at, for its lateness
+    InputEventBatch input_batch; // Drain buffer for the input thread's ring, too big for the stack
+    ParticipantLanes lanes;     // Participants > 1 only, the session engine then sits idle
+    FrameCache lane_frames[MAX_PARTICIPANTS]; // The same for each lane's pane, placed at the pane
+    TelemetryWriter telemetry;  // Idle unless TelemetryEnabled=1
+
+    // While reloading, errors are collected instead of exiting so a half-typed value can't close the tester
+    bool config_reloading;
+    wchar_t config_error[256];
+} Session;
 
 int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nCmdShow) {
     
@@ -104,32 +145,37 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 
     // Register the window class.
     if (!RegisterClass(&wc)) {
-        HandleError(L"Failed to register window class");
+        MessageBoxW(NULL, L"Failed to register window class", L"Error", MB_OK);
+        return 0;
     }
 
-    LoadConfig();
-
-    // Get the dimensions of the main display, then calculate the position to center the window
-    int position_x = (GetSystemMetrics(SM_CXSCREEN) - config.resolution_width) / 2;
-    int position_y = (GetSystemMetrics(SM_CYSCREEN) - config.resolution_height) / 2;
-
-    // Create main window centered on the main display
-    HWND hwnd = CreateWindowExW(0, CLASS_NAME, L"Reaction Time Tester", WS_OVERLAPPEDWINDOW, position_x, position_y, config.resolution_width, config.resolution_height, NULL, NULL, hInstance, NULL);
+    Session* session = calloc(1, sizeof(Session)); // Lives as long as its window, several can run side by side on their own threads
+    if (!session) {
+        MessageBoxW(NULL, L"Failed to allocate session", L"Error", MB_OK);
+        return 0;
+    }
+    session->config.game.virtual_debounce = DEFAULT_VIRTUAL_DEBOUNCE;
+    session->engine.state.game_state = STATE_INITIAL;
+    session->frames = (FrameCache){.render = DisplayLogic, .context = session};
 
-    InitializeSettings(&hwnd);
+    LoadConfig(session);
 
-    // Display the window.
-    ShowWindow(hwnd, nCmdShow);
-    UpdateWindow(hwnd);
+    // Get the dimensions of the main display, then calculate the position to center the window
+    int position_x = (GetSystemMetrics(SM_CXSCREEN) - session->config.resolution_width) / 2;
+    int position_y = (GetSystemMetrics(SM_CYSCREEN) - session->config.resolution_height) / 2;
 
+    // Create main window centered on the main display, WM_NCCREATE hands the session to WindowProc
+    HWND hwnd = CreateWindowExW(0, CLASS_NAME, L"Reaction Time Tester", WS_OVERLAPPEDWINDOW, position_x, position_y, session->config.resolution_width, session->config.resolution_height, NULL, NULL, hInstance, session);
     if (hwnd == NULL) {
         MessageBoxW(NULL, L"Failed to create window", L"Error", MB_OK);
         return 0;
     }
 
-    // Seed RNG and set initial timer
-    srand((unsigned)time(NULL));
-    // SetTimer(hwnd, TIMER_READY, GenerateRandomDelay(config.min_delay, config.max_delay), NULL);
+    InitializeSettings(session);
+
+    // Display the window.
+    ShowWindow(hwnd, nCmdShow);
+    UpdateWindow(hwnd);
 
     // Enter Windows message loop.
     MSG msg = {0};
@@ -138,10 +184,21 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
         DispatchMessage(&msg);
     }
 
+    free(session);
     return 0;
 }
 
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
+    if (uMsg == WM_NCCREATE) {
+        Session* created = ((CREATESTRUCTW*)lParam)->lpCreateParams;
+        created->hwnd = hwnd;
+        SetWindowLongPtrW(hwnd, GWLP_USERDATA, (LONG_PTR)created);
+    }
+    Session* session = (Session*)GetWindowLongPtrW(hwnd, GWLP_USERDATA);
+    if (!session) {
+        return DefWindowProc(hwnd, uMsg, wParam, lParam); // WM_GETMINMAXINFO comes before WM_NCCREATE
+    }
+
     switch (uMsg) {
     case WM_CREATE:
         LoadAndSetIcon(hwnd);
@@ -150,95 +207,178 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     case WM_SETCURSOR:
         switch (LOWORD(lParam)) {
         case HTCAPTION:
-            state.mouse_active = false;
+            session->engine.state.mouse_active = false;
             SetCursor(LoadCursor(NULL, IDC_ARROW)); // Hand cursor
             break;
         case HTCLIENT:
-            state.mouse_active = true;
+            session->engine.state.mouse_active = true;
             SetCursor(LoadCursor(NULL, IDC_HAND)); // Hand cursor
             break;
         case HTLEFT:
         case HTRIGHT:
-            state.mouse_active = false;
+            session->engine.state.mouse_active = false;
             SetCursor(LoadCursor(NULL, IDC_SIZEWE)); // Left or right border cursor
             break;
         case HTTOP:
         case HTBOTTOM:
-            state.mouse_active = false;
+            session->engine.state.mouse_active = false;
             SetCursor(LoadCursor(NULL, IDC_SIZENS)); // Top or bottom border cursor
             break;
         case HTTOPLEFT:
         case HTBOTTOMRIGHT:
-            state.mouse_active = false;
+            session->engine.state.mouse_active = false;
             SetCursor(LoadCursor(NULL, IDC_SIZENWSE)); // Top-left or bottom-right corner cursor
             break;
         case HTTOPRIGHT:
         case HTBOTTOMLEFT:
-            state.mouse_active = false;
+            session->engine.state.mouse_active = false;
             SetCursor(LoadCursor(NULL, IDC_SIZENESW)); // Top-right or bottom-left corner cursor
             break;
         default:
-            state.mouse_active = false;
+            session->engine.state.mouse_active = false;
             SetCursor(LoadCursor(NULL, IDC_ARROW)); // Default cursor
             break;
         }
+        RecordMouseActive(&session->recorder, session->engine.state.mouse_active);
         return TRUE;
 
-    case WM_SIZE:
-        InvalidateRect(hwnd,NULL,TRUE);
-        break;  
+    case WM_SIZE: {
+        HDC window_dc = GetDC(hwnd);
+        if (!ResizeFrameCache(&session->frames, window_dc, LOWORD(lParam), HIWORD(lParam))) {
+            HandleError(session, L"Failed to allocate frame buffers");
+        }
+        if (session->lanes.lane_count) ResizeLaneFrames(session, window_dc);
+        ReleaseDC(hwnd, window_dc);
+        PrepareFrame(&session->frames, STATE_REACT); // Never rendered on demand, the stimulus only blits
+        InvalidateRect(hwnd, NULL, FALSE);
+        break;
+    }
+
+    case WM_ERASEBKGND:
+        return 1; // Every frame covers the whole client area, an erase would only add a fill before the blit
 
     case WM_PAINT: 
         PAINTSTRUCT ps;
         HDC hdc = BeginPaint(hwnd, &ps);
-        HBRUSH hBrush;
 
-        SetBrush(&hBrush);
-        DisplayLogic(&hdc, &hwnd, &hBrush);
+        TRACE_BEGIN(TRACE_PAINT, session->engine.state.game_state);
+        if (session->lanes.lane_count) { // Stimulus panes first and stamped right away, the others can't delay them
+            PaintLanes(session, hdc, &ps.rcPaint, true);
+            GdiFlush();
+            int64_t presented = PlatformNow(NULL);
+            for (int i = 0; i < session->lanes.lane_count; i++) { // Every pane that just showed its stimulus
+                ReactionEngine* engine = &session->lanes.lanes[i].engine;
+                RECT pane;
+                LaneRect(session, i, &pane);
+                if (engine->state.game_state == STATE_REACT && !engine->data.presented && RectVisible(hdc, &pane)) {
+                    StimulusPresented(engine, presented);
+                }
+            }
+            PaintLanes(session, hdc, &ps.rcPaint, false);
+            EndPaint(hwnd, &ps);
+            TRACE_END(TRACE_PAINT);
+            break;
+        }
+        PresentFrame(&session->frames, session->engine.state.game_state, hdc, &ps.rcPaint);
         EndPaint(hwnd, &ps);
+        if (session->engine.state.game_state == STATE_REACT && !session->engine.data.presented) { // GDI has the frame, the compositor still has to show it
+            int64_t presented = PlatformNow(NULL);
+            RecordPresented(&session->recorder, presented);
+            StimulusPresented(&session->engine, presented);
+        }
+        TRACE_END(TRACE_PAINT);
         break;
 
     case WM_TIMER:
-        TimerStateLogic(&wParam, &hwnd);
+        KillTimer(hwnd, wParam); // Engine timers are one-shot
+        TRACE_INSTANT(TRACE_TIMER_FIRE, (int64_t)wParam, 0);
+        if (wParam >= LANE_TIMER_BASE) {
+            int lane = (int)(wParam - LANE_TIMER_BASE) / LANE_TIMER_STRIDE;
+            if (lane < session->lanes.lane_count) {
+                TimerStateLogic(&session->lanes.lanes[lane].engine, (int)(wParam - LANE_TIMER_BASE) % LANE_TIMER_STRIDE);
+            }
+            break;
+        }
+        if (wParam <= TIMER_DEBOUNCE && session->timer_due[wParam]) {
+            AddTimerLateness(&session->diagnostics, PlatformNow(NULL) - session->timer_due[wParam]);
+            session->timer_due[wParam] = 0;
+        }
+        RecordTimer(&session->recorder, (int)wParam);
+        TimerStateLogic(&session->engine, (int)wParam);
+        break;
+
+    case WM_APP_STIMULUS: // Posted by the scheduler thread, wParam = scheduled tick, lParam = actual onset tick
+        RecordStimulus(&session->recorder, (int64_t)wParam, (int64_t)lParam);
+        StimulusOnset(&session->engine, (int64_t)wParam, (int64_t)lParam);
+        break;
+
+    case WM_APP_LANE_STIMULUS: { // Posted by a lane's scheduler thread
+        int lane = (int)(wParam >> LANE_STIMULUS_TICK_BITS);
+        if (lane < session->lanes.lane_count) { // The engine drops the onset of a foreperiod it has since cancelled
+            StimulusOnset(&session->lanes.lanes[lane].engine, (int64_t)(wParam & LANE_STIMULUS_TICK_MASK), (int64_t)lParam);
+        }
+        break;
+    }
+
+    case WM_APP_INPUT: // Events queued by the input capture thread
+        DrainInputEvents(session);
+        break;
+
+    case WM_APP_CONFIG: // user.cfg was saved, posted by the config watcher thread
+        ReloadConfig(session);
         break;
 
     case WM_INPUT:
-        HandleRawInput(&hwnd, &lParam);
+        HandleRawInput(session, &lParam);
         break;
 
     // Handle generic keyboard input
     case WM_KEYDOWN:
     case WM_KEYUP:
-        if (config.raw_keyboard) {
+        if (uMsg == WM_KEYDOWN && wParam == TRACE_DUMP_KEY && session->config.trace) {
+            DumpTrace(session);
             break;
         }
-
-        for (int vkey = 0; vkey <= 255; vkey++) {
-            if (IsAlphanumeric(vkey)) {
-                bool is_key_pressed = GetAsyncKeyState(vkey) & 0x8000;
-                if (is_key_pressed && !state.key_states[vkey]) {
-                    HandleInput(hwnd, false);
-                    state.key_states[vkey] = 1;
-                }
-                else if (!is_key_pressed && state.key_states[vkey]) {
-                    state.key_states[vkey] = 0;
-                }
-            }
+        if (session->config.raw_keyboard || session->lanes.lane_count) {
+            break;
         }
+
+        HandleLegacyKeyboard(session);
         break;
 
     // Handle generic mouse input
     case WM_LBUTTONDOWN:
     case WM_LBUTTONUP:
-        if (config.raw_mouse) { 
+        if (session->config.raw_mouse || session->lanes.lane_count) { // Lanes need the device handle only raw input has
             break;
         }
         if (GetAsyncKeyState(VK_LBUTTON) & 0x8000) {
-            HandleInput(hwnd, true);
+            int64_t input_tick = PlatformNow(NULL);
+            session->engine.data.input_key = 0; // Left button
+            RecordInput(&session->recorder, true, input_tick);
+            HandleInput(&session->engine, true, input_tick);
         }
         break;
 
     case WM_DESTROY:
+        StopConfigWatcher(&session->config_watcher);
+        StopEventRecorder(&session->recorder); // Before the engine goes away, it still points at the recorder
+        if (session->config.trace) DumpTrace(session);
+        if (session->data.input_thread_running) StopInputThread(&session->input_thread);
+        StopStimulusScheduler(&session->scheduler);
+        StopTrialLogger(&session->trial_logger);
+        StopLanes(session);
+        CloseTelemetryWriter(&session->telemetry);
+        if (session->config.trial_logging) SaveSessionHistory(session);
+        if (session->config.trial_logging && session->config.text_log && !session->lanes.lane_count) SaveDiagnosticsSummary(session);
+        FreeLatencyDiagnostics(&session->diagnostics);
+        FreeFrameCache(&session->frames);
+        for (int i = 0; i < session->lanes.lane_count; i++) {
+            FreeFrameCache(&session->lane_frames[i]);
+        }
+        FreeParticipantLanes(&session->lanes);
+        FreeEngine(&session->engine);
+        FreeConfig(&session->active_config);
         PostQuitMessage(0);
         return 0;
 
@@ -250,249 +390,394 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 }
 
 // Game Logic Functions
-void DisplayLogic(HDC* hdc, HWND* hwnd, HBRUSH* brush) {
-    // Paint the entire window
-    RECT rect;
-    GetClientRect(*hwnd, &rect);
-    FillRect(*hdc, &rect, *brush);
+void DisplayLogic(HDC hdc, const RECT* rect, GameState state, void* context) { // Renders into the state's cached frame, not the window
+    Session* session = context;
+    HBRUSH brush;
+    SetBrush(session, &brush, state);
+    FillRect(hdc, rect, brush);
+    if (STATE_VIEWS[state].text == STATE_TEXT_NONE) {
+        return; // Plain color, the stimulus is the change between these two
+    }
 
     // Display text
-    SetBkMode(*hdc, TRANSPARENT);
-    SetTextColor(*hdc, RGB(255, 255, 255));
-    SelectObject(*hdc, ui.font);
-
-    wchar_t buffer[100] = {0};
-
-    switch (state.game_state){
-    case STATE_INITIAL:
-        SetTextColor(*hdc, RGB(config.results_font[0], config.results_font[1], config.results_font[2]));
-        swprintf_s(buffer, 100, L"Click to Begin");
-        break;
-
-    case STATE_RESULT:
-        SetTextColor(*hdc, RGB(config.results_font[0], config.results_font[1], config.results_font[2]));
-        GameResultLogic(buffer);
-        break;
-        
-    case STATE_EARLY:
-        SetTextColor(*hdc, RGB(config.early_font[0], config.early_font[1], config.early_font[2]));
-        swprintf_s(buffer, 100, L"Too early!\nTrials so far: %d", state.trial_iteration);
-        break;
+    SetBkMode(hdc, TRANSPARENT);
+    HGDIOBJ previous_font = SelectObject(hdc, session->ui.font); // Put back before returning, the frame DCs outlive a font rebuild
 
-    default:
-        break;
-    }
-    
+    wchar_t buffer[DISPLAY_BUFFER_SIZE] = {0};
+    StateTextLogic(session, &session->engine, state, buffer, L"Click to Begin");
+    const uint8_t* color = STATE_VIEWS[state].early_font ? session->config.early_font : session->config.results_font;
+    SetTextColor(hdc, RGB(color[0], color[1], color[2]));
 
     // Calculate rectangle for the text and display it.
     RECT text_rectangle;
     SetRectEmpty(&text_rectangle);
-    DrawTextW(*hdc, buffer, -1, &text_rectangle, DT_CALCRECT | DT_WORDBREAK);
+    DrawTextW(hdc, buffer, -1, &text_rectangle, DT_CALCRECT | DT_WORDBREAK);
 
     // ##REVIEW##LOW## Text doesn't center vertically (Pretty sure GPT mangled this at some point)
-    RECT centered_rectangle = rect;
-    centered_rectangle.top += (rect.bottom - rect.top - (text_rectangle.bottom - text_rectangle.top)) / 2; 
-    DrawTextW(*hdc, buffer, -1, &centered_rectangle, DT_CENTER | DT_WORDBREAK);
+    RECT centered_rectangle = *rect;
+    centered_rectangle.top += (rect->bottom - rect->top - (text_rectangle.bottom - text_rectangle.top)) / 2; 
+    DrawTextW(hdc, buffer, -1, &centered_rectangle, DT_CENTER | DT_WORDBREAK);
+
+    if (session->config.diagnostics_overlay) {
+        DiagnosticsOverlay(session, hdc, rect);
+    }
+    SelectObject(hdc, previous_font);
 };
 
-void TimerStateLogic(WPARAM* wParam, HWND* hwnd) {
-    switch (*wParam) {
-    case TIMER_READY:
-        state.game_state = STATE_READY;
-        KillTimer(*hwnd, TIMER_READY);
-        SetTimer(*hwnd, TIMER_REACT, GenerateRandomDelay(config.min_delay, config.max_delay), NULL);
-        break;
+void DiagnosticsOverlay(Session* session, HDC hdc, const RECT* rect) { // Top left, small fixed font: last, p50, p99 and max of every pipeline measure
+    wchar_t buffer[DISPLAY_BUFFER_SIZE];
+    int length = swprintf_s(buffer, DISPLAY_BUFFER_SIZE, L"Pipeline (ms)   last     p50     p99     max");
+    for (int i = 0; i < MEASURE_COUNT && length > 0; i++) {
+        const LatencyHistogram* histogram = &session->diagnostics.histograms[i];
+        double last = session->diagnostics.last[i] < 0 ? 0.0 : TicksToMilliseconds(session->diagnostics.last[i], session->engine.data.frequency);
+        length += swprintf_s(buffer + length, DISPLAY_BUFFER_SIZE - length, L"\n%-10hs %8.3lf %7.3lf %7.3lf %7.3lf", PIPELINE_MEASURE_NAMES[i], last,
+            TicksToMilliseconds(LatencyPercentile(histogram, 50), session->engine.data.frequency),
+            TicksToMilliseconds(LatencyPercentile(histogram, 99), session->engine.data.frequency),
+            TicksToMilliseconds(histogram->max, session->engine.data.frequency));
+    }
+    if (length > 0) {
+        swprintf_s(buffer + length, DISPLAY_BUFFER_SIZE - length, L"\nFlagged: %llu of %llu trials",
+            (unsigned long long)session->diagnostics.flagged, (unsigned long long)session->diagnostics.trials);
+    }
 
-    case TIMER_REACT:
-        if (state.game_state == STATE_READY) {
-            state.game_state = STATE_REACT;
-            QueryPerformanceCounter(&data.start_time); // Start reaction timer
-            InvalidateRect(*hwnd, NULL, TRUE); // Force repaint
-        }
-        break;
+    RECT overlay_rectangle = *rect;
+    overlay_rectangle.left += 8;
+    overlay_rectangle.top += 8;
+    SelectObject(hdc, GetStockObject(ANSI_FIXED_FONT));
+    SetTextColor(hdc, RGB(session->config.results_font[0], session->config.results_font[1], session->config.results_font[2]));
+    DrawTextW(hdc, buffer, -1, &overlay_rectangle, DT_LEFT | DT_NOPREFIX);
+}
 
-    case TIMER_EARLY:
-        ResetLogic(*hwnd); // Reset the game after showing the "too early" screen
+void StateTextLogic(Session* session, const ReactionEngine* engine, GameState state, wchar_t* buffer, const wchar_t* begin_text) { // buffer holds DISPLAY_BUFFER_SIZE
+    switch (STATE_VIEWS[state].text) {
+    case STATE_TEXT_BEGIN:
+        swprintf_s(buffer, DISPLAY_BUFFER_SIZE, L"%s", begin_text);
         break;
-
-    case TIMER_DEBOUNCE:  // Debounce reset
-        state.debounce_active = false;
+    case STATE_TEXT_EARLY:
+        swprintf_s(buffer, DISPLAY_BUFFER_SIZE, L"Too early!\nTrials so far: %d", engine->state.trial_iteration);
+        break;
+    case STATE_TEXT_RESULT:
+        GameResultLogic(session, engine, buffer);
+        break;
+    default:
         break;
-
     }
 }
 
-void ResetLogic(HWND hwnd) {
-    KillTimer(hwnd, TIMER_READY);
-    KillTimer(hwnd, TIMER_REACT);
-    KillTimer(hwnd, TIMER_EARLY);
-
-    state.game_state = STATE_READY;
-   
-    SetTimer(hwnd, TIMER_READY, GenerateRandomDelay(config.min_delay, config.max_delay), NULL);
-    InvalidateRect(hwnd, NULL, TRUE);
-}
-
-void GameResultLogic(wchar_t* buffer) { // ##REVIEW## Hard to follow and combines visual data with game logic code. Needs clean up?
-    if (state.current_attempt < config.averaging_trials) {
-        swprintf_s(buffer, 100, L"Last: %.2lfms\nComplete %d trials for average.\nTrials so far: %d",
-            data.reaction_time_value, config.averaging_trials, state.trial_iteration);
+void GameResultLogic(Session* session, const ReactionEngine* engine, wchar_t* buffer) { // ##REVIEW## Hard to follow and combines visual data with game logic code. Needs clean up?
+    int length;
+    if (!AverageAvailable(engine)) {
+        length = swprintf_s(buffer, DISPLAY_BUFFER_SIZE, L"Last: %.2lfms\nComplete %d trials for average.\nTrials so far: %d",
+            engine->data.reaction_time_value, session->config.game.averaging_trials, engine->state.trial_iteration);
         } else {
-            double total = 0;
-            for (int i = 0; i < config.averaging_trials; i++) {
-                total += data.reaction_time_array[i];
-            }
-            double average = total / config.averaging_trials;
-            swprintf_s(buffer, 100, L"Last: %.2lfms\nAverage (last %d): %.2lfms\nTrials so far: %d",
-                data.reaction_time_value, config.averaging_trials, average, state.trial_iteration);
+            const RollingSummary* summary = &engine->data.rolling.summary; // Precomputed when the trial finished
+            length = swprintf_s(buffer, DISPLAY_BUFFER_SIZE, L"Last: %.2lfms\nAverage (last %d): %.2lfms (SD %.2lfms)\nMedian: %.2lfms | Best: %.2lfms\nTrials so far: %d",
+                engine->data.reaction_time_value, session->config.game.averaging_trials, summary->mean, summary->sd, summary->median, summary->min, engine->state.trial_iteration);
+        }
+        if (length > 0) { // Whole session distribution, a scan over a few KB of buckets
+            const LatencyHistogram* histogram = &engine->data.session_histogram;
+            length += swprintf_s(buffer + length, DISPLAY_BUFFER_SIZE - length, L"\nSession p50/p90/p99: %.1lf / %.1lf / %.1lfms",
+                TicksToMilliseconds(LatencyPercentile(histogram, 50), engine->data.frequency),
+                TicksToMilliseconds(LatencyPercentile(histogram, 90), engine->data.frequency),
+                TicksToMilliseconds(LatencyPercentile(histogram, 99), engine->data.frequency));
         }
-        if (config.trial_logging) {
-            AppendToLog(data.reaction_time_value,
-                state.trial_iteration, data.trial_log_path, NULL);
+        if (session->config.raw_input_debug && length > 0) { // Where the last input spent its time before it was handled
+            swprintf_s(buffer + length, DISPLAY_BUFFER_SIZE - length, L"\nMessage queue: %ums | Handoff: %.3lfms (%s)",
+                engine->data.last_trial.message_delay_ms, TicksToMilliseconds(engine->data.last_trial.dispatch - engine->data.last_trial.response, engine->data.frequency),
+                session->config.input_thread ? L"input thread" : L"UI thread");
         }
 }
 
-// Utility Functions
-void InitializeSettings(HWND* hwnd) {
-    QueryPerformanceFrequency(&data.frequency);
+void LaneRect(Session* session, int lane, RECT* rect) { // Panes fill the window in a near-square grid, in joining order
+    RECT client;
+    GetClientRect(session->hwnd, &client);
+    int columns = 1;
+    while (columns * columns < session->lanes.lane_count) columns++;
+    int rows = (session->lanes.lane_count + columns - 1) / columns;
+    int width = client.right / columns;
+    int height = client.bottom / rows;
+    rect->left = (lane % columns) * width;
+    rect->top = (lane / columns) * height;
+    rect->right = rect->left + width;
+    rect->bottom = rect->top + height;
+}
 
-    if (config.trial_logging) InitializeLogFileName(0);
-    if (config.debug_logging) InitializeLogFileName(1);
+void PaintLanes(Session* session, HDC hdc, const RECT* dirty, bool react) { // Blits the dirty part of every pane in (or not in) REACT
+    for (int i = 0; i < session->lanes.lane_count; i++) {
+        GameState state = session->lanes.lanes[i].engine.state.game_state;
+        RECT pane, area;
+        LaneRect(session, i, &pane);
+        if ((state == STATE_REACT) != react || !IntersectRect(&area, &pane, dirty)) {
+            continue;
+        }
+        PresentFrame(&session->lane_frames[i], state, hdc, &area);
+    }
+}
 
-    // Ensure Initial State
-    state.game_state = STATE_INITIAL;
+void RenderLaneFrame(HDC hdc, const RECT* rect, GameState state, void* context) { // One pane's cached frame, context is the lane
+    const ParticipantLane* lane = context;
+    Session* session = lane->owner;
+    HBRUSH brush;
+    SetBrush(session, &brush, state);
+    FillRect(hdc, rect, brush);
+    FrameRect(hdc, rect, GetStockObject(BLACK_BRUSH));
+    if (STATE_VIEWS[state].text == STATE_TEXT_NONE) {
+        return; // Plain color, like the single player frames
+    }
+
+    SetBkMode(hdc, TRANSPARENT);
+    HGDIOBJ previous_font = SelectObject(hdc, session->ui.font);
+    wchar_t buffer[DISPLAY_BUFFER_SIZE] = {0};
+    int length = swprintf_s(buffer, DISPLAY_BUFFER_SIZE, L"Player %d\n", lane->index + 1);
+    StateTextLogic(session, &lane->engine, state, buffer + length, lane->bound ? L"Press to Begin" : L"Press a key or click to join");
+    const uint8_t* color = STATE_VIEWS[state].early_font ? session->config.early_font : session->config.results_font;
+    SetTextColor(hdc, RGB(color[0], color[1], color[2]));
+
+    RECT text_rectangle = *rect;
+    DrawTextW(hdc, buffer, -1, &text_rectangle, DT_CALCRECT | DT_WORDBREAK | DT_CENTER);
+    RECT centered_rectangle = *rect;
+    centered_rectangle.top += (rect->bottom - rect->top - (text_rectangle.bottom - text_rectangle.top)) / 2;
+    DrawTextW(hdc, buffer, -1, &centered_rectangle, DT_CENTER | DT_WORDBREAK);
+    SelectObject(hdc, previous_font);
+}
 
-    // Prepare font
-    ui.font_weight = FW_REGULAR;
-    ui.italics_enabled = FALSE;
-    if (!wcscmp(config.font_style, L"Bold")) {
-        ui.font_weight = FW_BOLD;
+void ResizeLaneFrames(Session* session, HDC reference) {
+    for (int i = 0; i < session->lanes.lane_count; i++) {
+        FrameCache* frames = &session->lane_frames[i];
+        RECT pane;
+        LaneRect(session, i, &pane);
+        if (!ResizeFrameCache(frames, reference, pane.right - pane.left, pane.bottom - pane.top)) {
+            HandleError(session, L"Failed to allocate frame buffers");
+        }
+        frames->origin = (POINT){pane.left, pane.top};
+        PrepareFrame(frames, STATE_REACT);
     }
-    if (!wcscmp(config.font_style, L"Italic")) {
-        ui.italics_enabled = TRUE;
+}
+
+// Utility Functions
+void InitializeSettings(Session* session) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    EnginePlatform platform = {
+        .context = session,
+        .now = PlatformNow,
+        .set_timer = PlatformSetTimer,
+        .kill_timer = PlatformKillTimer,
+        .request_repaint = PlatformRequestRepaint,
+        .schedule_stimulus = PlatformScheduleStimulus,
+        .cancel_stimulus = PlatformCancelStimulus,
+        .trial_complete = PlatformTrialComplete
+    };
+    TraceThread("UI");
+    SetTraceEnabled(session->config.trace);
+    session->data.seed = session->config.random_seed ? session->config.random_seed : NewSessionSeed();
+    if (!InitializeEngine(&session->engine, &session->config.game, &platform, frequency.QuadPart, &session->config.foreperiods, session->data.seed)) {
+        HandleError(session, L"Failed to allocate trial statistics");
     }
-    if (!wcscmp(config.font_style, L"Bold/Italic")) {
-        ui.font_weight = FW_BOLD;
-        ui.italics_enabled = TRUE;
+    if (!InitializeLatencyDiagnostics(&session->diagnostics, &(DiagnosticsSettings){frequency.QuadPart, MillisecondsToTicks(session->config.diagnostics_flag_threshold, frequency.QuadPart)})) {
+        HandleError(session, L"Failed to allocate latency diagnostics");
     }
-    ui.font = CreateFontW(config.font_size, 0, 0, 0, ui.font_weight, ui.italics_enabled, FALSE, FALSE, ANSI_CHARSET,
-        OUT_TT_PRECIS, CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
-        DEFAULT_PITCH | FF_DONTCARE, config.font_name);
-    if (!ui.font) {
-        HandleError(L"Failed to create font.");
+
+    if (!StartStimulusScheduler(&session->scheduler, session->config.stimulus_spin_window, PlatformStimulusOnset, session)) {
+        HandleError(session, L"Failed to start stimulus scheduler");
     }
 
-    // Raw input
-    if (config.raw_keyboard) RegisterForRawInput(*hwnd, 0x06);
-    if (config.raw_mouse) RegisterForRawInput(*hwnd, 0x02);
-    if (config.raw_input_debug) {
+    if ((session->config.trial_logging || session->config.debug_logging || session->config.input_recording || session->config.trace) && !InitializeLogDirectory(session)) {
+        HandleError(session, L"Failed to create log directory");
+    }
+    if (session->config.debug_logging) InitializeLogFileName(session, 1);
+    if (session->config.trial_logging || session->config.input_recording) InitializeLogFileName(session, 0);
+    if (session->config.participants > 1) InitializeLanes(session, frequency.QuadPart);
+    if (session->config.trial_logging && !session->lanes.lane_count) StartTrialLogging(session);
+    if (session->config.input_recording && !session->lanes.lane_count) StartInputRecording(session); // A recording replays through one engine
+    if (session->config.telemetry) StartTelemetry(session);
+
+    RebuildFont(session);
+    ApplyRawInputSettings(session);
+    if (session->config.raw_input_debug) {
         wchar_t message[256];
-        swprintf(message, sizeof(message) / sizeof(wchar_t), L"RawKeyboardEnable: %d\nRawMouseEnable: %d\nRegisterForRawKeyboardInput: %s\nRegisterForRawMouseInput: %s", 
-            config.raw_keyboard, config.raw_mouse, RegisterForRawInput(*hwnd, 0x06) ? L"True" : L"False", RegisterForRawInput(*hwnd, 0x02) ? L"True" : L"False");
+        swprintf(message, sizeof(message) / sizeof(wchar_t), L"RawKeyboardEnable: %d\nRawMouseEnable: %d\nInputThreadEnabled: %d", 
+            session->config.raw_keyboard, session->config.raw_mouse, session->config.input_thread);
         MessageBoxW(NULL, message, L"Raw Input Variables", MB_OK);
     }
+
+    if (session->config.hot_reload) { // A convenience, the tester works the same without it
+        char directory[MAX_PATH];
+        if (WideCharToMultiByte(CP_ACP, 0, session->data.config_directory, -1, directory, MAX_PATH, NULL, NULL)) {
+            StartConfigWatcher(&session->config_watcher, directory, "user.cfg", PlatformConfigChanged, session);
+        }
+    }
 }
 
-void HandleError(const wchar_t* error_message) {
+void HandleError(Session* session, const wchar_t* error_message) {
     MessageBoxW(NULL, error_message, L"Error", MB_OK);
-    if (config.debug_logging){
-        AppendToLog(0, 0, data.debug_log_path, error_message);
+    if (session->config.debug_logging){
+        AppendToLog(session->data.debug_log_path, error_message);
     }
+    StopTrialLogger(&session->trial_logger); // Keep the trials recorded so far
     exit(1);
 }
 
-void SetBrush(HBRUSH* brush) {
-    switch (state.game_state) {
-    case STATE_INITIAL:
-        *brush = ui.result_brush;
-        break;
-
-    case STATE_REACT:
-        *brush = ui.react_brush;
-        break;
+void SetBrush(Session* session, HBRUSH* brush, GameState state) {
+    if ((unsigned)state >= STATE_COUNT) {
+        *brush = session->ui.brushes[STATE_COLOR_READY];
+        HandleError(session, L"Invalid or undefined program state!");
+        return;
+    }
+    *brush = session->ui.brushes[STATE_VIEWS[state].background];
+}
 
-    case STATE_EARLY:
-        *brush = ui.early_brush;
-        break;
+// Engine platform callbacks (context is the session)
+int64_t PlatformNow(void* context) {
+    (void)context;
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
 
-    case STATE_RESULT:
-        *brush = ui.result_brush;
-        break;
+void PlatformSetTimer(void* context, int timer_id, int delay_ms) {
+    Session* session = context;
+    if (timer_id <= TIMER_DEBOUNCE) session->timer_due[timer_id] = PlatformNow(NULL) + MillisecondsToTicks(delay_ms, session->engine.data.frequency);
+    SetTimer(session->hwnd, timer_id, delay_ms, NULL);
+}
 
-    case STATE_READY:
-        *brush = ui.ready_brush;
-        break;
+void PlatformKillTimer(void* context, int timer_id) {
+    Session* session = context;
+    if (timer_id <= TIMER_DEBOUNCE) session->timer_due[timer_id] = 0;
+    KillTimer(session->hwnd, timer_id);
+}
 
-    default:
-        *brush = ui.ready_brush;
-        HandleError(L"Invalid or undefined program state!");
-        break;
+void PlatformRequestRepaint(void* context) { // Called on every state change
+    Session* session = context;
+    GameState state = session->engine.state.game_state;
+    if (STATE_VIEWS[state].text != STATE_TEXT_NONE) {
+        InvalidateFrame(&session->frames, state); // New text, rendered once by the next paint
     }
+    InvalidateRect(session->hwnd, NULL, FALSE);
+    if (state == STATE_READY) {
+        PrepareFrame(&session->frames, STATE_REACT); // Only redone after a resize or config change, normally already there
+    }
+    PublishParticipant(&session->telemetry, 0, &session->engine, PlatformNow(NULL));
 }
 
-void ValidateColors(const COLORREF color[]) {
-    for (int i = 0; i < 3; i++) {
-        if (color[i] > 255) {
-            HandleError(L"Invalid color values in user.cfg");
-        }
-    }
+void PlatformScheduleStimulus(void* context, int64_t deadline_tick) {
+    Session* session = context;
+    ArmStimulus(&session->scheduler, deadline_tick);
+}
+
+void PlatformCancelStimulus(void* context) {
+    Session* session = context;
+    CancelStimulus(&session->scheduler);
 }
 
-void RemoveCommentFromString(wchar_t* str) { // Removes comments and trailing spaces from strings read from .cfg files
-    wchar_t* semicolon_position = wcschr(str, L';');
-    if (semicolon_position) {
-        *semicolon_position = L'\0';
+void PlatformTrialComplete(void* context, const TrialRecord* record) {
+    Session* session = context;
+    AddTrialDiagnostics(&session->diagnostics, record);
+    if (session->config.trial_logging) {
+        LogTrial(&session->trial_logger, record);
     }
+    PublishTrial(&session->telemetry, 0, record);
+    PublishDiagnostics(&session->telemetry, &session->diagnostics);
+}
+
+void PlatformStimulusOnset(void* context, int64_t scheduled_tick, int64_t onset_tick) { // Runs on the scheduler thread
+    Session* session = context;
+    PostMessageW(session->hwnd, WM_APP_STIMULUS, (WPARAM)scheduled_tick, (LPARAM)onset_tick);
+}
+
+void PlatformConfigChanged(void* context) { // Runs on the config watcher thread
+    Session* session = context;
+    PostMessageW(session->hwnd, WM_APP_CONFIG, 0, 0);
+}
 
-    size_t len = wcslen(str);
-    while (len > 0 && iswspace(str[len - 1])) { // Loop to remove any trailing whitespace after excluding the comment
-        str[len - 1] = L'\0';
-        len--;
+// Participant lane callbacks (context is the lane, its owner the session)
+void LaneSetTimer(void* context, int timer_id, int delay_ms) {
+    ParticipantLane* lane = context;
+    Session* session = lane->owner;
+    SetTimer(session->hwnd, LANE_TIMER_BASE + lane->index * LANE_TIMER_STRIDE + timer_id, delay_ms, NULL);
+}
+
+void LaneKillTimer(void* context, int timer_id) {
+    ParticipantLane* lane = context;
+    Session* session = lane->owner;
+    KillTimer(session->hwnd, LANE_TIMER_BASE + lane->index * LANE_TIMER_STRIDE + timer_id);
+}
+
+void LaneRequestRepaint(void* context) { // Only this lane's pane
+    ParticipantLane* lane = context;
+    Session* session = lane->owner;
+    GameState state = lane->engine.state.game_state;
+    if (STATE_VIEWS[state].text != STATE_TEXT_NONE) {
+        InvalidateFrame(&session->lane_frames[lane->index], state);
+    }
+    RECT pane;
+    LaneRect(session, lane->index, &pane);
+    InvalidateRect(session->hwnd, &pane, FALSE);
+    if (state == STATE_READY) {
+        PrepareFrame(&session->lane_frames[lane->index], STATE_REACT);
     }
+    PublishParticipant(&session->telemetry, lane->index, &lane->engine, PlatformNow(NULL));
 }
 
-int GenerateRandomDelay(int min, int max) { // Rejection Sampling RNG
-    int range = max - min + 1;
-    int buckets = RAND_MAX / range;
-    int limit = buckets * range;
+void LaneScheduleStimulus(void* context, int64_t deadline_tick) {
+    ParticipantLane* lane = context;
+    ArmStimulus(&lane->scheduler, deadline_tick);
+}
+
+void LaneCancelStimulus(void* context) {
+    ParticipantLane* lane = context;
+    CancelStimulus(&lane->scheduler);
+}
 
-    int r;
-    do {
-        r = rand();
-    } while (r >= limit);
+void LaneTrialComplete(void* context, const TrialRecord* record) {
+    ParticipantLane* lane = context;
+    Session* session = lane->owner;
+    AddTrialDiagnostics(&session->diagnostics, record); // The pipeline is shared, so are its measurements
+    if (lane->logging) {
+        LogTrial(&lane->logger, record);
+    }
+    PublishTrial(&session->telemetry, lane->index, record);
+    PublishDiagnostics(&session->telemetry, &session->diagnostics);
+}
 
-    return min + (r / buckets);
+void LaneStimulusOnset(void* context, int64_t scheduled_tick, int64_t onset_tick) { // Runs on the lane's scheduler thread
+    ParticipantLane* lane = context;
+    Session* session = lane->owner;
+    WPARAM lane_tick = ((WPARAM)lane->index << LANE_STIMULUS_TICK_BITS) | ((WPARAM)scheduled_tick & LANE_STIMULUS_TICK_MASK);
+    PostMessageW(session->hwnd, WM_APP_LANE_STIMULUS, lane_tick, (LPARAM)onset_tick);
 }
 
 // Configuration and setup functions
-bool InitializeConfigFileAndPath(wchar_t* cfg_path) { // Initializes paths and attempts to copy default.cfg to user.cfg
+bool InitializeConfigFileAndPath(Session* session, wchar_t* cfg_path) { // Initializes paths and attempts to copy default.cfg to user.cfg
     wchar_t exe_path[MAX_PATH];
     wchar_t default_cfg_path[MAX_PATH];
 
     if (!GetModuleFileNameW(NULL, exe_path, MAX_PATH)) {
-        HandleError(L"Failed to get module file name");
+        HandleError(session, L"Failed to get module file name");
     }
 
     wchar_t* last_slash = wcsrchr(exe_path, '\\');  // Find the last directory separator
     if (last_slash) *(last_slash + 1) = L'\0';  // Null-terminate to get directory path
 
-    if (swprintf_s(cfg_path, MAX_PATH, L"%s/config/%s", exe_path, L"user.cfg") < 0 ||
-        swprintf_s(default_cfg_path, MAX_PATH, L"%s/config/%s", exe_path, L"default.cfg") < 0) {
-        HandleError(L"Failed to create config paths");
+    if (swprintf_s(session->data.config_directory, MAX_PATH, L"%sconfig", exe_path) < 0 ||
+        swprintf_s(cfg_path, MAX_PATH, L"%s\\%s", session->data.config_directory, L"user.cfg") < 0 ||
+        swprintf_s(default_cfg_path, MAX_PATH, L"%s\\%s", session->data.config_directory, L"default.cfg") < 0) {
+        HandleError(session, L"Failed to create config paths");
     }
 
     if (GetFileAttributesW(cfg_path) == INVALID_FILE_ATTRIBUTES) {  // If user.cfg doesn't exist, copy from default.cfg
         FILE* default_file;
         errno_t err1 = _wfopen_s(&default_file, default_cfg_path, L"rb");
         if (err1 != 0 || !default_file) {
-            HandleError(L"Failed to open default.cfg");
+            HandleError(session, L"Failed to open default.cfg");
         }
 
         FILE* new_file;
         errno_t err2 = _wfopen_s(&new_file, cfg_path, L"wb");
         if (err2 != 0 || !new_file) {
             fclose(default_file);
-            HandleError(L"Failed to create user.cfg");
+            HandleError(session, L"Failed to create user.cfg");
         }
 
         char buffer[1024];
@@ -500,7 +785,7 @@ bool InitializeConfigFileAndPath(wchar_t* cfg_path) { // Initializes paths and a
         while ((bytes_read = fread(buffer, 1, sizeof(buffer), default_file)) > 0) {  // Copy contents from default.cfg to user.cfg in chunks
             if (fwrite(buffer, 1, bytes_read, new_file) < bytes_read) { // Has write operation written the correct number of bytes?
                 fclose(new_file); fclose(default_file);
-                HandleError(L"Failed to write to user.cfg");
+                HandleError(session, L"Failed to write to user.cfg");
             }
         }
         fclose(new_file); fclose(default_file);
@@ -508,80 +793,409 @@ bool InitializeConfigFileAndPath(wchar_t* cfg_path) { // Initializes paths and a
     return true;
 }
 
-void LoadColorConfiguration(const wchar_t* cfg_path, const wchar_t* section_name, const wchar_t* colorName, const COLORREF* color) { // Load RGB
-    wchar_t buffer[255];
-    GetPrivateProfileStringW(section_name, colorName, L"", buffer, sizeof(buffer) / sizeof(wchar_t), cfg_path);  // Retrieve color configuration as comma-separated RGB values
+// Every key in user.cfg and the settings group it belongs to, a reload only rebuilds the groups whose keys changed
+typedef struct {
+    const char* section;
+    const char* key;
+    uint32_t group;
+} ConfigKey;
+
+static const ConfigKey CONFIG_KEYS[] = {
+    {"Resolution", "ResolutionWidth", CONFIG_GROUP_RESOLUTION},
+    {"Resolution", "ResolutionHeight", CONFIG_GROUP_RESOLUTION},
+    {"Colors", "ReadyColor", CONFIG_GROUP_READY_COLOR},
+    {"Colors", "ReactColor", CONFIG_GROUP_REACT_COLOR},
+    {"Colors", "EarlyColor", CONFIG_GROUP_EARLY_COLOR},
+    {"Colors", "ResultColor", CONFIG_GROUP_RESULT_COLOR},
+    {"Fonts", "FontName", CONFIG_GROUP_FONT},
+    {"Fonts", "FontSize", CONFIG_GROUP_FONT},
+    {"Fonts", "FontStyle", CONFIG_GROUP_FONT},
+    {"Fonts", "EarlyFontColor", CONFIG_GROUP_TEXT_COLORS},
+    {"Fonts", "ResultsFontColor", CONFIG_GROUP_TEXT_COLORS},
+    {"Delays", "MinDelay", CONFIG_GROUP_FOREPERIOD},
+    {"Delays", "MaxDelay", CONFIG_GROUP_FOREPERIOD},
+    {"Delays", "ForeperiodDistribution", CONFIG_GROUP_FOREPERIOD},
+    {"Delays", "ForeperiodMean", CONFIG_GROUP_FOREPERIOD},
+    {"Delays", "ForeperiodWeights", CONFIG_GROUP_FOREPERIOD},
+    {"Delays", "ForeperiodTable", CONFIG_GROUP_FOREPERIOD},
+    {"Delays", "EarlyResetDelay", CONFIG_GROUP_GAME},
+    {"Delays", "VirtualDebounce", CONFIG_GROUP_GAME},
+    {"Delays", "StimulusSpinWindow", CONFIG_GROUP_SPIN_WINDOW},
+    {"Trial", "AveragingTrials", CONFIG_GROUP_GAME},
+    {"Trial", "TotalTrials", CONFIG_GROUP_GAME},
+    {"Trial", "HistogramPrecision", CONFIG_GROUP_GAME},
+    {"Trial", "TrialLogFormat", CONFIG_GROUP_STARTUP},
+    {"Trial", "LogFlushInterval", CONFIG_GROUP_LOG_FLUSH},
+    {"Trial", "RandomSeed", CONFIG_GROUP_STARTUP},
+    {"Trial", "DiagnosticsFlagThreshold", CONFIG_GROUP_STARTUP},
+    {"Trial", "Participants", CONFIG_GROUP_STARTUP},
+    {"Toggles", "RawKeyboardEnabled", CONFIG_GROUP_RAW_INPUT},
+    {"Toggles", "RawMouseEnabled", CONFIG_GROUP_RAW_INPUT},
+    {"Toggles", "InputThreadEnabled", CONFIG_GROUP_RAW_INPUT},
+    {"Toggles", "RawInputDebug", CONFIG_GROUP_DISPLAY},
+    {"Toggles", "TrialLoggingEnabled", CONFIG_GROUP_STARTUP},
+    {"Toggles", "DebugLoggingEnabled", CONFIG_GROUP_STARTUP},
+    {"Toggles", "HotReloadEnabled", CONFIG_GROUP_STARTUP},
+    {"Toggles", "InputRecordingEnabled", CONFIG_GROUP_STARTUP},
+    {"Toggles", "TraceEnabled", CONFIG_GROUP_TRACE},
+    {"Toggles", "DiagnosticsOverlay", CONFIG_GROUP_DISPLAY},
+    {"Toggles", "DiagnosticsLogging", CONFIG_GROUP_STARTUP},
+    {"Toggles", "TelemetryEnabled", CONFIG_GROUP_STARTUP},
+    {"Toggles", "TelemetryName", CONFIG_GROUP_STARTUP}
+};
+
+static void ReportConfigError(Session* session, const wchar_t* message) {
+    if (!session->config_reloading) {
+        HandleError(session, message);
+    }
+    if (!session->config_error[0]) { // The first error is the useful one
+        wcsncpy_s(session->config_error, 256, message, _TRUNCATE);
+    }
+}
+
+static void ReportInvalidKey(Session* session, const char* key) {
+    wchar_t error_message[256];
+    swprintf_s(error_message, 256, L"Invalid value for %hs in user.cfg", key);
+    ReportConfigError(session, error_message);
+}
+
+static int ReadConfigInt(Session* session, const ConfigFile* cfg, const char* section, const char* key, int fallback, int min, int max) {
+    int value;
+    if (!ConfigInt(cfg, section, key, fallback, min, max, &value)) {
+        ReportInvalidKey(session, key);
+    }
+    return value;
+}
+
+static void ReadConfigString(Session* session, const ConfigFile* cfg, const char* section, const char* key, const char* fallback, wchar_t* target) { // target holds MAX_PATH
+    const char* value = ConfigString(cfg, section, key, fallback);
+    if (!MultiByteToWideChar(CP_ACP, 0, value, -1, target, MAX_PATH)) {
+        ReportInvalidKey(session, key);
+    }
+}
+
+static bool ReadConfigFile(Session* session, ConfigFile* cfg) { // One read of user.cfg, every lookup after that is in memory
+    FILE* cfg_file;
+    if (_wfopen_s(&cfg_file, session->data.config_path, L"rb") != 0 || !cfg_file) {
+        return false;
+    }
+    bool loaded = LoadConfigFile(cfg, cfg_file);
+    fclose(cfg_file);
+    return loaded;
+}
+
+static bool LoadForeperiodTableFile(Session* session, ForeperiodDistribution* distribution, const char* file_name) { // Relative to the config folder
+    wchar_t name[MAX_PATH];
+    wchar_t path[MAX_PATH];
+    FILE* file;
+    if (!*file_name || !MultiByteToWideChar(CP_ACP, 0, file_name, -1, name, MAX_PATH) ||
+        swprintf_s(path, MAX_PATH, L"%s\\%s", session->data.config_directory, name) < 0 ||
+        _wfopen_s(&file, path, L"rb") != 0 || !file) {
+        return false;
+    }
+    bool loaded = LoadForeperiodTable(distribution, file);
+    fclose(file);
+    return loaded;
+}
+
+static void LoadForeperiodConfiguration(Session* session, const ConfigFile* cfg, ForeperiodDistribution* distribution, int min_delay, int max_delay) { // Tables are built once here, a trial only does a lookup
+    const char* model = ConfigString(cfg, "Delays", "ForeperiodDistribution", DEFAULT_FOREPERIOD_DISTRIBUTION);
+    if (!strcmp(model, "Uniform")) {
+        BuildUniformForeperiods(distribution, min_delay, max_delay); // Range already checked
+    } else if (!strcmp(model, "Exponential")) {
+        int mean = ReadConfigInt(session, cfg, "Delays", "ForeperiodMean", DEFAULT_FOREPERIOD_MEAN, 1, INT_MAX);
+        if (!BuildExponentialForeperiods(distribution, min_delay, max_delay, mean)) {
+            ReportConfigError(session, L"Failed to build the exponential foreperiod table");
+        }
+    } else if (!strcmp(model, "Weighted")) {
+        if (!BuildWeightedForeperiods(distribution, ConfigString(cfg, "Delays", "ForeperiodWeights", ""))) {
+            ReportInvalidKey(session, "ForeperiodWeights");
+        }
+    } else if (!strcmp(model, "Table")) {
+        if (!LoadForeperiodTableFile(session, distribution, ConfigString(cfg, "Delays", "ForeperiodTable", ""))) {
+            ReportConfigError(session, L"Failed to read the ForeperiodTable file in the config folder");
+        }
+    } else {
+        ReportInvalidKey(session, "ForeperiodDistribution");
+    }
+}
+
+static void LoadConfigGroups(Session* session, const ConfigFile* cfg, Configuration* target, uint32_t groups) { // Only touches the fields of the given groups
+    if (groups & CONFIG_GROUP_RESOLUTION) {
+        target->resolution_width = ReadConfigInt(session, cfg, "Resolution", "ResolutionWidth", DEFAULT_RESOLUTION_WIDTH, 1, 65535);
+        target->resolution_height = ReadConfigInt(session, cfg, "Resolution", "ResolutionHeight", DEFAULT_RESOLUTION_HEIGHT, 1, 65535);
+    }
+
+    if (groups & CONFIG_GROUP_READY_COLOR) LoadColorConfiguration(session, cfg, "Colors", "ReadyColor", target->ready_color);
+    if (groups & CONFIG_GROUP_REACT_COLOR) LoadColorConfiguration(session, cfg, "Colors", "ReactColor", target->react_color);
+    if (groups & CONFIG_GROUP_EARLY_COLOR) LoadColorConfiguration(session, cfg, "Colors", "EarlyColor", target->early_color);
+    if (groups & CONFIG_GROUP_RESULT_COLOR) LoadColorConfiguration(session, cfg, "Colors", "ResultColor", target->result_color);
+
+    if (groups & CONFIG_GROUP_FOREPERIOD) {
+        int min_delay = ReadConfigInt(session, cfg, "Delays", "MinDelay", DEFAULT_MIN_DELAY, 0, INT_MAX);
+        int max_delay = ReadConfigInt(session, cfg, "Delays", "MaxDelay", DEFAULT_MAX_DELAY, 0, INT_MAX);
+        if (max_delay < min_delay) {
+            ReportConfigError(session, L"MaxDelay cannot be less than MinDelay in user.cfg");
+        }
+        LoadForeperiodConfiguration(session, cfg, &target->foreperiods, min_delay, max_delay);
+    }
+
+    if (groups & CONFIG_GROUP_GAME) {
+        target->game.early_reset_delay = ReadConfigInt(session, cfg, "Delays", "EarlyResetDelay", DEFAULT_EARLY_RESET_DELAY, 0, INT_MAX);
+        target->game.virtual_debounce = ReadConfigInt(session, cfg, "Delays", "VirtualDebounce", DEFAULT_VIRTUAL_DEBOUNCE, 0, INT_MAX);
+        target->game.averaging_trials = ReadConfigInt(session, cfg, "Trial", "AveragingTrials", DEFAULT_AVG_TRIALS, 1, INT_MAX);
+        target->game.total_trials = ReadConfigInt(session, cfg, "Trial", "TotalTrials", DEFAULT_TOTAL_TRIALS, 1, INT_MAX); // ##REVIEW##LOW## total_trials is not yet utilized for anything
+        target->game.histogram_precision = ReadConfigInt(session, cfg, "Trial", "HistogramPrecision", DEFAULT_HISTOGRAM_PRECISION,
+            HISTOGRAM_MIN_SIGNIFICANT_BITS, HISTOGRAM_MAX_SIGNIFICANT_BITS);
+    }
+    if (groups & CONFIG_GROUP_SPIN_WINDOW) {
+        target->stimulus_spin_window = ReadConfigInt(session, cfg, "Delays", "StimulusSpinWindow", DEFAULT_STIMULUS_SPIN_WINDOW, 0, INT_MAX);
+    }
 
-    if (!wcslen(buffer)) {
-        HandleError(L"Failed to read color configuration");
+    if (groups & CONFIG_GROUP_RAW_INPUT) {
+        target->raw_keyboard = ReadConfigInt(session, cfg, "Toggles", "RawKeyboardEnabled", DEFAULT_RAWKEYBOARDENABLE, 0, 1);
+        target->raw_mouse = ReadConfigInt(session, cfg, "Toggles", "RawMouseEnabled", DEFAULT_RAWMOUSEENABLE, 0, 1);
+        target->input_thread = ReadConfigInt(session, cfg, "Toggles", "InputThreadEnabled", DEFAULT_INPUT_THREAD_ENABLE, 0, 1);
+    }
+    if (groups & CONFIG_GROUP_DISPLAY) {
+        target->raw_input_debug = ReadConfigInt(session, cfg, "Toggles", "RawInputDebug", 0, 0, 1);
+        target->diagnostics_overlay = ReadConfigInt(session, cfg, "Toggles", "DiagnosticsOverlay", 0, 0, 1);
+    }
+
+    if (groups & CONFIG_GROUP_STARTUP) {
+        target->trial_logging = ReadConfigInt(session, cfg, "Toggles", "TrialLoggingEnabled", 0, 0, 1);
+        target->debug_logging = ReadConfigInt(session, cfg, "Toggles", "DebugLoggingEnabled", 0, 0, 1);
+        target->hot_reload = ReadConfigInt(session, cfg, "Toggles", "HotReloadEnabled", DEFAULT_HOT_RELOAD_ENABLE, 0, 1);
+        target->input_recording = ReadConfigInt(session, cfg, "Toggles", "InputRecordingEnabled", 0, 0, 1);
+        target->diagnostics_logging = ReadConfigInt(session, cfg, "Toggles", "DiagnosticsLogging", 0, 0, 1);
+        target->diagnostics_flag_threshold = ReadConfigInt(session, cfg, "Trial", "DiagnosticsFlagThreshold", DEFAULT_DIAGNOSTICS_FLAG_THRESHOLD, 0, DIAGNOSTICS_HIGHEST_MS);
+        target->participants = ReadConfigInt(session, cfg, "Trial", "Participants", DEFAULT_PARTICIPANTS, 1, MAX_PARTICIPANTS);
+        target->telemetry = ReadConfigInt(session, cfg, "Toggles", "TelemetryEnabled", 0, 0, 1);
+        const char* telemetry_name = ConfigString(cfg, "Toggles", "TelemetryName", DEFAULT_TELEMETRY_NAME);
+        if (!ValidTelemetryName(telemetry_name)) {
+            ReportInvalidKey(session, "TelemetryName");
+        }
+        snprintf(target->telemetry_name, sizeof(target->telemetry_name), "%s", telemetry_name);
+
+        const char* log_format = ConfigString(cfg, "Trial", "TrialLogFormat", DEFAULT_TRIAL_LOG_FORMAT);
+        target->text_log = !strcmp(log_format, "Text") || !strcmp(log_format, "Both");
+        target->session_file = !strcmp(log_format, "Binary") || !strcmp(log_format, "Both");
+        if (!target->text_log && !target->session_file) {
+            ReportConfigError(session, L"Invalid trial log format in user.cfg");
+        }
+
+        const char* seed = ConfigString(cfg, "Trial", "RandomSeed", DEFAULT_RANDOM_SEED); // 64 bits, decimal or 0x hex
+        char* seed_end;
+        errno = 0;
+        target->random_seed = strtoull(seed, &seed_end, 0);
+        if (!*seed || *seed == '-' || *seed_end || errno == ERANGE) {
+            ReportInvalidKey(session, "RandomSeed");
+        }
+    }
+    if (groups & CONFIG_GROUP_TRACE) {
+        target->trace = ReadConfigInt(session, cfg, "Toggles", "TraceEnabled", 0, 0, 1);
+    }
+    if (groups & CONFIG_GROUP_LOG_FLUSH) {
+        target->log_flush_interval = ReadConfigInt(session, cfg, "Trial", "LogFlushInterval", DEFAULT_LOG_FLUSH_INTERVAL, 1, INT_MAX);
     }
 
-    swscanf_s(buffer, L"%d,%d,%d", &color[0], &color[1], &color[2]);  // Extract individual RGB values
-    ValidateColors(color);
+    if (groups & CONFIG_GROUP_TEXT_COLORS) {
+        LoadColorConfiguration(session, cfg, "Fonts", "EarlyFontColor", target->early_font);
+        LoadColorConfiguration(session, cfg, "Fonts", "ResultsFontColor", target->results_font);
+    }
+
+    if (groups & CONFIG_GROUP_FONT) {
+        ReadConfigString(session, cfg, "Fonts", "FontName", DEFAULT_FONT_NAME, target->font_name);
+        if (!wcslen(target->font_name)) {
+            ReportConfigError(session, L"Failed to read font configuration");
+        }
+
+        target->font_size = ReadConfigInt(session, cfg, "Fonts", "FontSize", DEFAULT_FONT_SIZE, 1, 1000);
+        ReadConfigString(session, cfg, "Fonts", "FontStyle", DEFAULT_FONT_STYLE, target->font_style);
+    }
 }
 
-void LoadConfig() { // ##REVIEW## Probably need more error handling for bad values in config?
-    COLORREF ready_color[3], react_color[3], early_color[3], result_color[3];
-    wchar_t cfg_path[MAX_PATH];
+static uint32_t DiffConfig(const ConfigFile* previous, const ConfigFile* current) { // Groups with at least one key whose text changed
+    uint32_t changed = 0;
+    for (size_t i = 0; i < sizeof(CONFIG_KEYS) / sizeof(CONFIG_KEYS[0]); i++) {
+        const char* before = ConfigString(previous, CONFIG_KEYS[i].section, CONFIG_KEYS[i].key, NULL);
+        const char* after = ConfigString(current, CONFIG_KEYS[i].section, CONFIG_KEYS[i].key, NULL);
+        if ((before == NULL) != (after == NULL) || (before && strcmp(before, after) != 0)) {
+            changed |= CONFIG_KEYS[i].group;
+        }
+    }
+    return changed;
+}
+
+void LoadColorConfiguration(Session* session, const ConfigFile* cfg, const char* section_name, const char* color_name, uint8_t* color) { // Load RGB
+    if (!ConfigColor(cfg, section_name, color_name, color)) {  // Comma-separated RGB values, each 0-255
+        ReportConfigError(session, L"Invalid color values in user.cfg");
+    }
+}
 
-    if (!InitializeConfigFileAndPath(cfg_path)) {
+void LoadConfig(Session* session) {
+    if (!InitializeConfigFileAndPath(session, session->data.config_path)) {
         exit(1);
     }
+    if (!ReadConfigFile(session, &session->active_config)) {
+        HandleError(session, L"Failed to read user.cfg");
+    }
 
-    config.resolution_width = GetPrivateProfileIntW(L"Resolution", L"ResolutionWidth", DEFAULT_RESOLUTION_WIDTH, cfg_path);
-    config.resolution_height = GetPrivateProfileIntW(L"Resolution", L"ResolutionHeight", DEFAULT_RESOLUTION_HEIGHT, cfg_path);
+    LoadConfigGroups(session, &session->active_config, &session->config, CONFIG_GROUP_ALL);
+    RebuildBrushes(session, CONFIG_GROUP_BRUSHES);
+}
 
-    LoadColorConfiguration(cfg_path, L"Colors", L"ReadyColor", ready_color);
-    LoadColorConfiguration(cfg_path, L"Colors", L"ReactColor", react_color);
-    LoadColorConfiguration(cfg_path, L"Colors", L"EarlyColor", early_color);
-    LoadColorConfiguration(cfg_path, L"Colors", L"ResultColor", result_color);
+static void RebuildBrush(HBRUSH* brush, const uint8_t* color) {
+    if (*brush) {
+        DeleteObject(*brush); // Only ever used for FillRect, never selected into a DC
+    }
+    *brush = CreateSolidBrush(RGB(color[0], color[1], color[2]));
+}
 
-    ui.ready_brush = CreateSolidBrush(RGB(ready_color[0], ready_color[1], ready_color[2]));
-    ui.react_brush = CreateSolidBrush(RGB(react_color[0], react_color[1], react_color[2]));
-    ui.early_brush = CreateSolidBrush(RGB(early_color[0], early_color[1], early_color[2]));
-    ui.result_brush = CreateSolidBrush(RGB(result_color[0], result_color[1], result_color[2]));
+void RebuildBrushes(Session* session, uint32_t groups) {
+    if (groups & CONFIG_GROUP_READY_COLOR) RebuildBrush(&session->ui.brushes[STATE_COLOR_READY], session->config.ready_color);
+    if (groups & CONFIG_GROUP_REACT_COLOR) RebuildBrush(&session->ui.brushes[STATE_COLOR_REACT], session->config.react_color);
+    if (groups & CONFIG_GROUP_EARLY_COLOR) RebuildBrush(&session->ui.brushes[STATE_COLOR_EARLY], session->config.early_color);
+    if (groups & CONFIG_GROUP_RESULT_COLOR) RebuildBrush(&session->ui.brushes[STATE_COLOR_RESULT], session->config.result_color);
+}
 
-    config.min_delay = GetPrivateProfileIntW(L"Delays", L"MinDelay", DEFAULT_MIN_DELAY, cfg_path);
-    config.max_delay = GetPrivateProfileIntW(L"Delays", L"MaxDelay", DEFAULT_MAX_DELAY, cfg_path);
-    config.early_reset_delay = GetPrivateProfileIntW(L"Delays", L"EarlyResetDelay", DEFAULT_EARLY_RESET_DELAY, cfg_path);
+void RebuildFont(Session* session) { // The old font is kept until its replacement exists
+    int font_weight = FW_REGULAR;
+    BOOL italics_enabled = FALSE;
+    if (!wcscmp(session->config.font_style, L"Bold")) {
+        font_weight = FW_BOLD;
+    }
+    if (!wcscmp(session->config.font_style, L"Italic")) {
+        italics_enabled = TRUE;
+    }
+    if (!wcscmp(session->config.font_style, L"Bold/Italic")) {
+        font_weight = FW_BOLD;
+        italics_enabled = TRUE;
+    }
+    HFONT font = CreateFontW(session->config.font_size, 0, 0, 0, font_weight, italics_enabled, FALSE, FALSE, ANSI_CHARSET,
+        OUT_TT_PRECIS, CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
+        DEFAULT_PITCH | FF_DONTCARE, session->config.font_name);
+    if (!font) {
+        ReportConfigError(session, L"Failed to create font.");
+        return;
+    }
 
-    if (config.max_delay < config.min_delay) {
-        HandleError(L"MaxDelay cannot be less than MinDelay in user.cfg");
+    if (session->ui.font) {
+        DeleteObject(session->ui.font); // Only selected into a DC while painting, which can't overlap with this
     }
+    session->ui.font = font;
+    session->ui.font_weight = font_weight;
+    session->ui.italics_enabled = italics_enabled;
+}
 
-    config.virtual_debounce = GetPrivateProfileIntW(L"Delays", L"VirtualDebounce", DEFAULT_VIRTUAL_DEBOUNCE, cfg_path);
+void ReloadConfig(Session* session) { // Runs on the UI thread, between messages, so no paint or input is half handled
+    ConfigFile cfg;
+    if (!ReadConfigFile(session, &cfg)) {
+        return; // Usually the editor still has the file open, its next write brings us back here
+    }
 
-    config.raw_keyboard = GetPrivateProfileIntW(L"Toggles", L"RawKeyboardEnabled", DEFAULT_RAWKEYBOARDENABLE, cfg_path);
-    config.raw_mouse = GetPrivateProfileIntW(L"Toggles", L"RawMouseEnabled", DEFAULT_RAWMOUSEENABLE, cfg_path);
-    config.raw_input_debug = GetPrivateProfileIntW(L"Toggles", L"RawInputDebug", 0, cfg_path);
-    config.trial_logging = GetPrivateProfileIntW(L"Toggles", L"TrialLoggingEnabled", 0, cfg_path);
-    config.debug_logging = GetPrivateProfileIntW(L"Toggles", L"DebugLoggingEnabled", 0, cfg_path);
+    uint32_t changed = DiffConfig(&session->active_config, &cfg) & ~CONFIG_GROUP_STARTUP; // Logging and the watcher itself need a restart
+    if (!changed) {
+        FreeConfig(&session->active_config);
+        session->active_config = cfg;
+        return;
+    }
+    TRACE_BEGIN(TRACE_CONFIG_RELOAD, changed);
+
+    // Parse into a copy first, an invalid value leaves every setting as it was
+    Configuration staged = session->config;
+    session->config_reloading = true;
+    session->config_error[0] = L'\0';
+    LoadConfigGroups(session, &cfg, &staged, changed);
+    if (session->config_error[0]) {
+        FreeForeperiodDistribution(&staged.foreperiods);
+        FreeConfig(&cfg); // Keep diffing against the last good file so the fix is picked up in full
+    } else {
+        Configuration previous = session->config;
+        session->config = staged;
+
+        if (changed & CONFIG_GROUP_BRUSHES) RebuildBrushes(session, changed);
+        if (changed & CONFIG_GROUP_FONT) RebuildFont(session);
+        if (changed & CONFIG_GROUP_GAME) {
+            if (UpdateEngineConfig(&session->engine, &session->config.game)) {
+                RecordEngineConfig(&session->recorder);
+            } else {
+                session->config.game = previous.game;
+                ReportConfigError(session, L"Failed to allocate trial statistics");
+            }
+            for (int i = 0; i < session->lanes.lane_count; i++) {
+                if (!UpdateEngineConfig(&session->lanes.lanes[i].engine, &session->config.game)) {
+                    ReportConfigError(session, L"Failed to allocate trial statistics");
+                }
+            }
+        }
+        if (changed & CONFIG_GROUP_FOREPERIOD) {
+            SetEngineForeperiods(&session->engine, &session->config.foreperiods);
+            RecordForeperiods(&session->recorder);
+            for (int i = 0; i < session->lanes.lane_count; i++) {
+                ForeperiodDistribution foreperiods;
+                if (CopyForeperiodDistribution(&foreperiods, &session->engine.data.foreperiods.distribution)) {
+                    SetEngineForeperiods(&session->lanes.lanes[i].engine, &foreperiods);
+                } else {
+                    ReportConfigError(session, L"Failed to copy the foreperiod table");
+                }
+            }
+        }
+        if (changed & CONFIG_GROUP_SPIN_WINDOW) {
+            SetStimulusSpinWindow(&session->scheduler, session->config.stimulus_spin_window);
+            for (int i = 0; i < session->lanes.lane_count; i++) {
+                SetStimulusSpinWindow(&session->lanes.lanes[i].scheduler, session->config.stimulus_spin_window);
+            }
+        }
+        if ((changed & CONFIG_GROUP_LOG_FLUSH) && session->config.trial_logging) SetTrialLogFlushInterval(&session->trial_logger, session->config.log_flush_interval);
+        if (changed & CONFIG_GROUP_RAW_INPUT) ApplyRawInputSettings(session);
+        if (changed & CONFIG_GROUP_TRACE) SetTraceEnabled(session->config.trace);
+        if (changed & CONFIG_GROUP_RESOLUTION) {
+            SetWindowPos(session->hwnd, NULL, 0, 0, session->config.resolution_width, session->config.resolution_height, SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
+        }
 
-    config.averaging_trials = GetPrivateProfileIntW(L"Trial", L"AveragingTrials", DEFAULT_AVG_TRIALS, cfg_path);
-    if (config.averaging_trials <= 0) {
-        HandleError(L"Invalid number of averaging trials in user.cfg");
+        FreeConfig(&session->active_config);
+        session->active_config = cfg;
+        InvalidateFrames(&session->frames);
+        PrepareFrame(&session->frames, STATE_REACT);
+        for (int i = 0; i < session->lanes.lane_count; i++) {
+            InvalidateFrames(&session->lane_frames[i]);
+            PrepareFrame(&session->lane_frames[i], STATE_REACT);
+        }
+        InvalidateRect(session->hwnd, NULL, FALSE);
     }
-    config.total_trials = GetPrivateProfileIntW(L"Trial", L"TotalTrials", DEFAULT_TOTAL_TRIALS, cfg_path); // ##REVIEW##LOW## total_trials is not yet utilized for anything 
-    if (config.total_trials <= 0) {
-        HandleError(L"Invalid number of total trials in user.cfg");
+    session->config_reloading = false;
+    TRACE_END(TRACE_CONFIG_RELOAD);
+
+    if (session->config_error[0]) {
+        MessageBeep(MB_ICONWARNING);
+        if (session->config.debug_logging) {
+            AppendToLog(session->data.debug_log_path, session->config_error);
+        }
     }
+}
 
-    LoadColorConfiguration(cfg_path, L"Fonts", L"EarlyFontColor", config.early_font);
-    LoadColorConfiguration(cfg_path, L"Fonts", L"ResultsFontColor", config.results_font);
+bool InitializeLogDirectory(Session* session) { // Resolves <exe dir>\log once and makes sure it exists
+    wchar_t exe_path[MAX_PATH];
 
-    GetPrivateProfileStringW(L"Fonts", L"FontName", DEFAULT_FONT_NAME, config.font_name, (DWORD)MAX_PATH, cfg_path);
-    RemoveCommentFromString(config.font_name);
-    if (!wcslen(config.font_name)) {
-        HandleError(L"Failed to read font configuration");
+    if (!GetModuleFileName(NULL, exe_path, MAX_PATH)) {
+        return false;
     }
 
-    config.font_size = GetPrivateProfileIntW(L"Fonts", L"FontSize", DEFAULT_FONT_SIZE, cfg_path);
+    wchar_t* last_slash = wcsrchr(exe_path, '\\');
+    if (last_slash) {
+        *(last_slash + 1) = L'\0';
+    }
 
-    GetPrivateProfileStringW(L"Fonts", L"FontStyle", DEFAULT_FONT_STYLE, config.font_style, (DWORD)MAX_PATH, cfg_path);
-    RemoveCommentFromString(config.font_style);
+    swprintf_s(session->data.log_directory, MAX_PATH, L"%slog", exe_path);
+    if (!CreateDirectory(session->data.log_directory, NULL) && GetLastError() != ERROR_ALREADY_EXISTS) {
+        session->data.log_directory[0] = L'\0';
+        return false;
+    }
+    return true;
 }
 
-void InitializeLogFileName(int log_type) { // log_type = 0 = trial log, log_type = 1 = debug log
+void InitializeLogFileName(Session* session, int log_type) { // log_type = 0 = trial log, log_type = 1 = debug log
     time_t t;
     struct tm* tmp;
     
@@ -595,56 +1209,215 @@ void InitializeLogFileName(int log_type) { // log_type = 0 = trial log, log_type
 
     if (log_type) {
         wcsftime(timestamp, timestamp_length, L"%Y%m%d%H%M%S", tmp);  // Format YYYYMMDDHHMMSS
-        swprintf_s(data.debug_log_path, MAX_PATH, L"log\\DEBUG_Log_%s.log", timestamp);
+        swprintf_s(session->data.debug_log_path, MAX_PATH, L"%s\\DEBUG_Log_%s.log", session->data.log_directory, timestamp);
     } else {
         wcsftime(timestamp, timestamp_length, L"%Y%m%d%H%M%S", tmp);  // Format YYYYMMDDHHMMSS
-        swprintf_s(data.trial_log_path, MAX_PATH, L"log\\Log_%s.log", timestamp);
+        swprintf_s(session->data.trial_log_path, MAX_PATH, L"%s\\Log_%s.log", session->data.log_directory, timestamp);
+        swprintf_s(session->data.session_file_path, MAX_PATH, L"%s\\Session_%s.rts", session->data.log_directory, timestamp);
+        swprintf_s(session->data.recording_path, MAX_PATH, L"%s\\Input_%s.rec", session->data.log_directory, timestamp);
+        session->data.session_start = t;
+        session->data.session_id = ((uint64_t)t << 20) | (GetCurrentProcessId() & 0xFFFFF); // Start time, process id breaks ties
     }
 }
 
-bool AppendToLog(double value, int iteration, wchar_t* logfile, const wchar_t* external_error_message) {  // Handles log file operations
-    wchar_t exe_path[MAX_PATH];
-    wchar_t log_file_path[MAX_PATH];
-    wchar_t log_dir_path[MAX_PATH];
+uint64_t NewSessionSeed() { // Only has to differ between sessions, SeedRandom does the mixing
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    uint64_t seed = ((uint64_t)time(NULL) << 32) ^ (uint64_t)counter.QuadPart ^ ((uint64_t)GetCurrentProcessId() << 16);
+    return seed ? seed : 1; // 0 means "pick one" in user.cfg
+}
 
-    // Get the directory where the executable is running
-    if (!GetModuleFileName(NULL, exe_path, MAX_PATH)) {
-        HandleError(L"Failed to get module file name");
-    } else {
-        wchar_t* last_slash = wcsrchr(exe_path, '\\');
-        if (last_slash) {
-            *(last_slash + 1) = L'\0';
+static FILE* OpenLogFile(Session* session, const wchar_t* path, const wchar_t* mode) {
+    FILE* log_file;
+    errno_t err = _wfopen_s(&log_file, path, mode);
+    if (err != 0 || !log_file) {
+        wchar_t error_message[512];
+        _wcserror_s(error_message, sizeof(error_message) / sizeof(wchar_t), err);
+        HandleError(session, error_message);
+    }
+    return log_file;
+}
+
+void StartTrialLogging(Session* session) { // The files stay open for the whole session, the logger thread does all the writing
+    FILE* log_file = session->config.text_log ? OpenLogFile(session, session->data.trial_log_path, L"a") : NULL;
+    if (log_file) {
+        fprintf(log_file, "Seed: %llu\n", (unsigned long long)session->data.seed); // RandomSeed to replay this session's foreperiods
+    }
+    SessionWriter* writer = NULL;
+    if (session->config.session_file) {
+        if (!OpenSessionWriter(&session->session_writer, OpenLogFile(session, session->data.session_file_path, L"wb"), session->data.session_id, session->engine.data.frequency, (int64_t)session->data.session_start, session->data.seed)) {
+            HandleError(session, L"Failed to write session file header");
         }
+        writer = &session->session_writer;
+    }
+    if (!StartTrialLogger(&session->trial_logger, log_file, writer, session->config.log_flush_interval, session->config.diagnostics_logging ? &session->diagnostics.settings : NULL)) {
+        HandleError(session, L"Failed to start trial logger");
+    }
+}
 
-        // Create full path for the log directory
-        swprintf_s(log_dir_path, MAX_PATH, L"%slog", exe_path);
+void StartInputRecording(Session* session) { // Has to run before the first event reaches the engine, replay starts from a fresh one
+    if (!StartEventRecorder(&session->recorder, OpenLogFile(session, session->data.recording_path, L"wb"), &session->engine, session->data.session_id, (int64_t)session->data.session_start)) {
+        HandleError(session, L"Failed to write input recording header");
+    }
+}
 
-        // Ensure log directory exists
-        if (!CreateDirectory(log_dir_path, NULL) && GetLastError() != ERROR_ALREADY_EXISTS) {
-            HandleError(L"Failed to create log directory");
-        } else {
-            // Create full path for the log file
-            swprintf_s(log_file_path, MAX_PATH, L"%s%s", exe_path, logfile);
-
-            // Append to the log file
-            FILE* log_file;
-            errno_t err = _wfopen_s(&log_file, log_file_path, L"a");
-            if (err != 0 || !log_file) {
-                wchar_t error_message[512];
-                _wcserror_s(error_message, sizeof(error_message) / sizeof(wchar_t), err);
-                HandleError(error_message);
-            } else if (!value && !iteration) { // Hypothetically value == 0 && iteration == 0 shouldn't be possible unless the values are forced
-                fwprintf(log_file, L"ERROR: %s\n", external_error_message); // Note: This only logs errors after we have already loaded the config
-                fclose(log_file);
-                return true;
-            } else if (config.trial_logging) {
-                fwprintf(log_file, L"Trial %d: %f\n", iteration, value);
-                fclose(log_file);
-                return true;
-            }
+void InitializeLanes(Session* session, int64_t frequency) { // After the session engine, every lane starts from a copy of its foreperiods
+    if (!session->config.raw_keyboard && !session->config.raw_mouse) {
+        HandleError(session, L"Participants above 1 need RawKeyboardEnabled or RawMouseEnabled, only raw input tells devices apart");
+    }
+    if (!InitializeParticipantLanes(&session->lanes, session->config.participants, session)) {
+        HandleError(session, L"Failed to allocate participant lanes");
+    }
+    for (int i = 0; i < session->lanes.lane_count; i++) {
+        ParticipantLane* lane = &session->lanes.lanes[i];
+        EnginePlatform platform = {
+            .context = lane,
+            .now = PlatformNow,
+            .set_timer = LaneSetTimer,
+            .kill_timer = LaneKillTimer,
+            .request_repaint = LaneRequestRepaint,
+            .schedule_stimulus = LaneScheduleStimulus,
+            .cancel_stimulus = LaneCancelStimulus,
+            .trial_complete = LaneTrialComplete
+        };
+        ForeperiodDistribution foreperiods;
+        if (!CopyForeperiodDistribution(&foreperiods, &session->engine.data.foreperiods.distribution) ||
+            !InitializeEngine(&lane->engine, &session->config.game, &platform, frequency, &foreperiods, session->data.seed + (uint64_t)i)) {
+            HandleError(session, L"Failed to allocate trial statistics");
         }
+        if (!StartStimulusScheduler(&lane->scheduler, session->config.stimulus_spin_window, LaneStimulusOnset, lane)) {
+            HandleError(session, L"Failed to start stimulus scheduler");
+        }
+        if (session->config.trial_logging) StartLaneLogging(session, lane);
+        session->lane_frames[i] = (FrameCache){.render = RenderLaneFrame, .context = lane};
     }
-    return false;
+    HDC window_dc = GetDC(session->hwnd); // The window had its first WM_SIZE before the lanes existed
+    ResizeLaneFrames(session, window_dc);
+    ReleaseDC(session->hwnd, window_dc);
+}
+
+void StartLaneLogging(Session* session, ParticipantLane* lane) { // Log_<timestamp>_P<n>.log and Session_<timestamp>_P<n>.rts
+    wchar_t path[MAX_PATH];
+    uint64_t seed = session->data.seed + (uint64_t)lane->index;
+    FILE* log_file = NULL;
+    if (session->config.text_log) {
+        swprintf_s(path, MAX_PATH, L"%.*s_P%d.log", (int)wcslen(session->data.trial_log_path) - 4, session->data.trial_log_path, lane->index + 1);
+        log_file = OpenLogFile(session, path, L"a");
+        fprintf(log_file, "Seed: %llu\n", (unsigned long long)seed);
+    }
+    SessionWriter* writer = NULL;
+    if (session->config.session_file) {
+        swprintf_s(path, MAX_PATH, L"%.*s_P%d.rts", (int)wcslen(session->data.session_file_path) - 4, session->data.session_file_path, lane->index + 1);
+        if (!OpenSessionWriter(&lane->session_writer, OpenLogFile(session, path, L"wb"), session->data.session_id, lane->engine.data.frequency, (int64_t)session->data.session_start, seed)) {
+            HandleError(session, L"Failed to write session file header");
+        }
+        writer = &lane->session_writer;
+    }
+    if (!StartTrialLogger(&lane->logger, log_file, writer, session->config.log_flush_interval, session->config.diagnostics_logging ? &session->diagnostics.settings : NULL)) {
+        HandleError(session, L"Failed to start trial logger");
+    }
+    lane->logging = true;
+}
+
+void StartTelemetry(Session* session) { // One slot for the session engine, or one per lane
+    if (!session->data.session_id) { // Only set when logging
+        session->data.session_id = ((uint64_t)time(NULL) << 20) | (GetCurrentProcessId() & 0xFFFFF);
+    }
+    int participants = session->lanes.lane_count ? session->lanes.lane_count : 1;
+    if (!OpenTelemetryWriter(&session->telemetry, session->config.telemetry_name, participants, session->data.session_id, session->data.seed, &session->diagnostics.settings)) {
+        HandleError(session, L"Failed to publish telemetry, another running tester (or a dashboard still reading the last one) holds the same TelemetryName");
+    }
+    for (int i = 0; i < participants; i++) {
+        PublishParticipant(&session->telemetry, i, session->lanes.lane_count ? &session->lanes.lanes[i].engine : &session->engine, PlatformNow(NULL));
+    }
+}
+
+void StopLanes(Session* session) { // Threads only, the engines go with FreeParticipantLanes
+    for (int i = 0; i < session->lanes.lane_count; i++) {
+        ParticipantLane* lane = &session->lanes.lanes[i];
+        StopStimulusScheduler(&lane->scheduler);
+        if (lane->logging) StopTrialLogger(&lane->logger);
+        lane->logging = false;
+    }
+}
+
+void DumpTrace(Session* session) { // Last events of every thread, opens in chrome://tracing or ui.perfetto.dev
+    if (!session->data.log_directory[0] && !InitializeLogDirectory(session)) {
+        return; // Turned on by a reload, the log folder may not exist yet
+    }
+    wchar_t timestamp[20];
+    time_t t = time(NULL);
+    struct tm local_time;
+    localtime_s(&local_time, &t);
+    wcsftime(timestamp, sizeof(timestamp) / sizeof(wchar_t), L"%Y%m%d%H%M%S", &local_time);
+
+    wchar_t trace_path[MAX_PATH];
+    swprintf_s(trace_path, MAX_PATH, L"%s\\Trace_%s.json", session->data.log_directory, timestamp);
+    FILE* file;
+    if (_wfopen_s(&file, trace_path, L"w") == 0 && file) {
+        WriteTrace(file);
+        fclose(file);
+    }
+}
+
+void SaveDiagnosticsSummary(Session* session) { // Appended to the text log once the logger thread has closed it
+    FILE* file;
+    if (_wfopen_s(&file, session->data.trial_log_path, L"a") != 0 || !file) {
+        return;
+    }
+    fprintf(file, "Diagnostics: %llu trials, %llu flagged\n", (unsigned long long)session->diagnostics.trials, (unsigned long long)session->diagnostics.flagged);
+    for (int i = 0; i < MEASURE_COUNT; i++) {
+        const LatencyHistogram* histogram = &session->diagnostics.histograms[i];
+        fprintf(file, "Diagnostics %s: p50 %.3f p90 %.3f p99 %.3f max %.3f ms (%llu samples)\n", PIPELINE_MEASURE_NAMES[i],
+            TicksToMilliseconds(LatencyPercentile(histogram, 50), session->engine.data.frequency),
+            TicksToMilliseconds(LatencyPercentile(histogram, 90), session->engine.data.frequency),
+            TicksToMilliseconds(LatencyPercentile(histogram, 99), session->engine.data.frequency),
+            TicksToMilliseconds(histogram->max, session->engine.data.frequency), (unsigned long long)histogram->total);
+    }
+    fclose(file);
+}
+
+void SaveSessionHistory(Session* session) { // Folds this session's histogram into log\history.hist so percentiles cover every session
+    wchar_t history_path[MAX_PATH];
+    swprintf_s(history_path, MAX_PATH, L"%s\\%s", session->data.log_directory, HISTORY_FILE_NAME);
+
+    LatencyHistogram history;
+    FILE* file;
+    bool loaded = false;
+    if (_wfopen_s(&file, history_path, L"rb") == 0 && file) {
+        loaded = LoadLatencyHistogram(&history, file);
+        fclose(file);
+    }
+    if (!loaded) { // First session (or an unreadable file), start over with this session's layout
+        if (!InitializeLatencyHistogram(&history, session->engine.data.session_histogram.highest_trackable, session->engine.data.session_histogram.significant_bits, session->engine.data.frequency)) {
+            return;
+        }
+    }
+    MergeLatencyHistogram(&history, &session->engine.data.session_histogram);
+    for (int i = 0; i < session->lanes.lane_count; i++) {
+        MergeLatencyHistogram(&history, &session->lanes.lanes[i].engine.data.session_histogram);
+    }
+
+    if (_wfopen_s(&file, history_path, L"wb") == 0 && file) {
+        SaveLatencyHistogram(&history, file);
+        fclose(file);
+    }
+    FreeLatencyHistogram(&history);
+}
+
+bool AppendToLog(const wchar_t* log_file_path, const wchar_t* external_error_message) { // Synchronous, only used for errors right before exiting
+    if (!log_file_path[0]) {
+        return false; // Log directory not resolved yet
+    }
+
+    FILE* log_file;
+    errno_t err = _wfopen_s(&log_file, log_file_path, L"a");
+    if (err != 0 || !log_file) {
+        return false; // Called from HandleError, so there is nobody left to report this to
+    }
+    fwprintf(log_file, L"ERROR: %s\n", external_error_message); // Note: This only logs errors after we have already loaded the config
+    fclose(log_file);
+    return true;
 }
 
 void LoadAndSetIcon(HWND hwnd) {
@@ -672,121 +1445,119 @@ void LoadAndSetIcon(HWND hwnd) {
 }
 
 // Input Functions
-bool RegisterForRawInput(HWND hwnd, USHORT usage) {
+bool RegisterForRawInput(Session* session, USHORT usage) {
     RAWINPUTDEVICE rid = {0};
     rid.usUsagePage = 0x01;
     rid.usUsage = usage;
     rid.dwFlags = 0;
-    rid.hwndTarget = hwnd;
+    rid.hwndTarget = session->hwnd;
 
     if (!RegisterRawInputDevices(&rid, 1, sizeof(rid))) {
-        HandleError(L"Failed to register raw input device");
+        HandleError(session, L"Failed to register raw input device");
     }
     return true;
 }
 
-void HandleInput(HWND hwnd, bool is_mouse_input) {   // Primary input logic is done here
-    if ((!state.mouse_active && is_mouse_input) || (state.debounce_active)) {
-        return;  // Ignore mouse clicks outside of active area
-    }
-
-    switch(state.game_state) {
-    case STATE_INITIAL:
-        state.game_state = STATE_READY;
-        SetTimer(hwnd, TIMER_READY, GenerateRandomDelay(config.min_delay, config.max_delay), NULL);
-        InvalidateRect(hwnd, NULL, TRUE);
-        break;
-
-    case STATE_REACT:
-        state.trial_iteration++;
-        QueryPerformanceCounter(&data.end_time);
-        data.reaction_time_value = ((double)(data.end_time.QuadPart - data.start_time.QuadPart) / data.frequency.QuadPart) * 1000;
-
-        // ##REVIEW##HIGH## This is a rolling array of values
-        data.reaction_time_array[state.current_attempt % config.averaging_trials] = data.reaction_time_value; 
-        state.current_attempt++;
-
-        state.game_state = STATE_RESULT;
-        InvalidateRect(hwnd, NULL, TRUE);
-        break;
-
-    case STATE_EARLY:
-    case STATE_RESULT:
-        if ((state.game_state == STATE_RESULT) && state.current_attempt == config.averaging_trials) { // ##REVIEW## This is messy
-            state.current_attempt = 0;
-            for (int i = 0; i < config.averaging_trials; i++) {
-                data.reaction_time_array[i] = 0;
-            }
-        }
-        ResetLogic(hwnd);
-        break;
+void UnregisterRawInput(USHORT usage) {
+    RAWINPUTDEVICE rid = {0};
+    rid.usUsagePage = 0x01;
+    rid.usUsage = usage;
+    rid.dwFlags = RIDEV_REMOVE;
+    rid.hwndTarget = NULL; // Required for RIDEV_REMOVE
+    RegisterRawInputDevices(&rid, 1, sizeof(rid)); // Nothing to do if it was never registered
+}
 
-    case STATE_READY:
-        state.game_state = STATE_EARLY;
-        KillTimer(hwnd, TIMER_READY);
-        if (config.early_reset_delay > 0) {
-            SetTimer(hwnd, TIMER_EARLY, config.early_reset_delay, NULL); // Early state eventually resets back to Ready state automatically
+void ApplyRawInputSettings(Session* session) { // Tears down the active capture path, then sets up the configured one
+    if (session->data.input_thread_running) {
+        StopInputThread(&session->input_thread);
+        session->data.input_thread_running = false;
+    }
+    if (session->data.raw_keyboard_registered) UnregisterRawInput(0x06);
+    if (session->data.raw_mouse_registered) UnregisterRawInput(0x02);
+
+    // Raw input, either captured on a dedicated thread or delivered to the main window as WM_INPUT
+    session->config.input_thread = session->config.input_thread && (session->config.raw_keyboard || session->config.raw_mouse);
+    if (session->config.input_thread) {
+        session->data.input_thread_running = StartInputThread(&session->input_thread, session->hwnd, WM_APP_INPUT, session->config.raw_keyboard, session->config.raw_mouse);
+        if (!session->data.input_thread_running) {
+            ReportConfigError(session, L"Failed to start input capture thread"); // Exits at startup, falls back to WM_INPUT on reload
+            session->config.input_thread = false;
         }
-        InvalidateRect(hwnd, NULL, TRUE);
-        break;
     }
-
-    if ((config.virtual_debounce > 0) && (!state.debounce_active)) { // Activate debounce if enabled
-        state.debounce_active = true;
-        SetTimer(hwnd, TIMER_DEBOUNCE, config.virtual_debounce, NULL);
+    if (!session->config.input_thread) {
+        if (session->config.raw_keyboard) RegisterForRawInput(session, 0x06);
+        if (session->config.raw_mouse) RegisterForRawInput(session, 0x02);
     }
+    session->data.raw_keyboard_registered = session->config.raw_keyboard;
+    session->data.raw_mouse_registered = session->config.raw_mouse;
 }
 
-void HandleRawInput(HWND* hwnd, LPARAM* lParam) { // ##REVIEW## Keyboard and Mouse functions should be simplified and then moved into this function if possible
-    UINT dwSize = 0;
-    GetRawInputData((HRAWINPUT)*lParam, RID_INPUT, NULL, &dwSize, sizeof(RAWINPUTHEADER));
-    LPBYTE lpb = (LPBYTE)malloc(dwSize * sizeof(BYTE));
-
-    if (lpb == NULL) {
-        return;
-    }
+void HandleRawInput(Session* session, LPARAM* lParam) { // Single-thread path, used when InputThreadEnabled=0
+    int64_t arrival_tick = PlatformNow(NULL);
+    uint32_t message_delay_ms = GetTickCount() - (DWORD)GetMessageTime();
+    TRACE_INSTANT(TRACE_RAW_INPUT, message_delay_ms, 0);
 
-    if (GetRawInputData((HRAWINPUT)*lParam, RID_INPUT, lpb, &dwSize, sizeof(RAWINPUTHEADER)) != dwSize) {
-        HandleError(L"GetRawInputData did not return correct size!");
-        free(lpb);
+    RAWINPUT raw; // Keyboard and mouse packets always fit, no allocation needed
+    UINT size = sizeof(raw);
+    if (GetRawInputData((HRAWINPUT)*lParam, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) == (UINT)-1) {
+        return; // Not a keyboard or mouse packet (or already consumed), nothing to do
     }
 
-    RAWINPUT* raw = (RAWINPUT*)lpb;
-
-    if (raw->header.dwType == RIM_TYPEKEYBOARD && config.raw_keyboard) {
-        HandleRawKeyboardInput(raw, *hwnd);
-    }
-    else if (raw->header.dwType == RIM_TYPEMOUSE && config.raw_mouse) {
-        HandleRawMouseInput(raw, *hwnd);
+    InputEventBatch batch = {.count = 0};
+    if (RawInputToEvent(&raw, arrival_tick, message_delay_ms, &batch.events[0])) {
+        batch.count = 1;
+        if (session->lanes.lane_count) {
+            DispatchLaneBatch(&session->lanes, &batch, session->config.raw_keyboard, session->config.raw_mouse);
+            return;
+        }
+        RecordInputBatch(&session->recorder, &batch, session->config.raw_keyboard, session->config.raw_mouse);
+        DispatchInputBatch(&session->engine, &batch, session->config.raw_keyboard, session->config.raw_mouse);
     }
-
-    free(lpb);
 }
 
-void HandleRawKeyboardInput(RAWINPUT* raw, HWND hwnd) {
-    int vkey = raw->data.keyboard.VKey;
-
-    if (raw->data.keyboard.Flags == RI_KEY_MAKE && IsAlphanumeric(vkey) && !state.key_states[vkey]) {
-        HandleInput(hwnd, false);
-        state.key_states[vkey] = true;
-    }
-    else if (raw->data.keyboard.Flags == RI_KEY_BREAK) {
-        state.key_states[vkey] = false;
+void HandleLegacyKeyboard(Session* session) { // WM_KEYDOWN/WM_KEYUP path (RawKeyboardEnabled=0), key edges go through the same dispatch as raw input
+    InputEventBatch batch = {.count = 0};
+    int64_t arrival_tick = PlatformNow(NULL);
+    uint32_t message_delay_ms = GetTickCount() - (DWORD)GetMessageTime();
+
+    for (int vkey = 0; vkey <= 255; vkey++) {
+        if (IsAlphanumeric(vkey)) {
+            bool is_key_pressed = GetAsyncKeyState(vkey) & 0x8000;
+            if (is_key_pressed != (bool)session->engine.state.key_states[vkey]) {
+                batch.events[batch.count++] = (InputEvent){
+                    .arrival_tick = arrival_tick,
+                    .message_delay_ms = message_delay_ms,
+                    .key = (uint16_t)vkey,
+                    .source = INPUT_SOURCE_KEYBOARD,
+                    .pressed = is_key_pressed
+                };
+            }
+        }
     }
+    RecordInputBatch(&session->recorder, &batch, true, false);
+    DispatchInputBatch(&session->engine, &batch, true, false);
 }
 
-void HandleRawMouseInput(RAWINPUT* raw, HWND hwnd) {
-    static bool was_button_pressed = false;
-
-    if (raw->data.mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_DOWN && !was_button_pressed) {
-        HandleInput(hwnd, true);
-        was_button_pressed = true;
-    }
-    else if (raw->data.mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_UP && was_button_pressed) {
-        was_button_pressed = false;
+void DrainInputEvents(Session* session) {
+    AcknowledgeInputNotification(&session->input_thread);
+    TRACE_BEGIN(TRACE_INPUT_DRAIN, 0);
+
+    InputEventBatch* batch = &session->input_batch;
+    bool focused = GetForegroundWindow() == session->hwnd; // The capture thread sees input for every window, only ours counts
+    while (PopInputBatch(&session->input_thread, batch)) {
+        if (!focused) { // Keep releases so key states can't get stuck
+            uint32_t kept = 0;
+            for (uint32_t i = 0; i < batch->count; i++) {
+                if (!batch->events[i].pressed) batch->events[kept++] = batch->events[i];
+            }
+            batch->count = kept;
+        }
+        if (session->lanes.lane_count) {
+            DispatchLaneBatch(&session->lanes, batch, session->config.raw_keyboard, session->config.raw_mouse);
+            continue;
+        }
+        RecordInputBatch(&session->recorder, batch, session->config.raw_keyboard, session->config.raw_mouse);
+        DispatchInputBatch(&session->engine, batch, session->config.raw_keyboard, session->config.raw_mouse);
     }
-}
-
-bool IsAlphanumeric(int vkey) {
-    return (vkey >= '0' && vkey <= '9') || (vkey >= 'A' && vkey <= 'Z');
+    TRACE_END(TRACE_INPUT_DRAIN);
 }
\ No newline at end of file
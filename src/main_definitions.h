@@ -1,53 +1,114 @@
-// Various default settings and timer names
+// Various default settings
 #pragma once
-#define TIMER_READY 1
-#define TIMER_REACT 2
-#define TIMER_EARLY 3
-#define TIMER_DEBOUNCE 4 
-#define DEFAULT_MIN_DELAY 1000
-#define DEFAULT_MAX_DELAY 3000
-#define DEFAULT_EARLY_RESET_DELAY 3000
-#define DEFAULT_VIRTUAL_DEBOUNCE 50
-#define DEFAULT_AVG_TRIALS 5
-#define DEFAULT_TOTAL_TRIALS 1000
-#define DEFAULT_RAWKEYBOARDENABLE 1
-#define DEFAULT_RAWMOUSEENABLE 1
-#define DEFAULT_FONT_SIZE 32
-#define DEFAULT_FONT_NAME L"Arial"
-#define DEFAULT_FONT_STYLE L"Regular"
-#define DEFAULT_RESOLUTION_WIDTH 1280
-#define DEFAULT_RESOLUTION_HEIGHT 720
+#include "reaction_engine.h"
+#include "input_events.h"
+#include "config_parser.h"
+#include "config_defaults.h"
+#include "participant_lanes.h"
+
+// Application messages (wParam/lParam carry 64-bit ticks, the Makefile targets 64-bit Windows)
+#define WM_APP_STIMULUS (WM_APP + 1)
+#define WM_APP_INPUT (WM_APP + 2)
+#define WM_APP_CONFIG (WM_APP + 3)
+#define WM_APP_LANE_STIMULUS (WM_APP + 4) // wParam = lane and scheduled tick (LANE_STIMULUS_*), lParam = actual onset tick
+
+// WM_APP_LANE_STIMULUS wParam: lane index above LANE_STIMULUS_TICK_BITS, the scheduled tick below (QPC runs at 10 MHz, centuries)
+#define LANE_STIMULUS_TICK_BITS 58
+#define LANE_STIMULUS_TICK_MASK ((1ull << LANE_STIMULUS_TICK_BITS) - 1)
+
+// Participant lane timers: SetTimer id = LANE_TIMER_BASE + lane * LANE_TIMER_STRIDE + engine timer id
+#define LANE_TIMER_BASE 0x100
+#define LANE_TIMER_STRIDE (TIMER_DEBOUNCE + 1)
+
+// Settings groups, a config reload only rebuilds what the changed keys belong to
+#define CONFIG_GROUP_RESOLUTION   (1u << 0)
+#define CONFIG_GROUP_READY_COLOR  (1u << 1)
+#define CONFIG_GROUP_REACT_COLOR  (1u << 2)
+#define CONFIG_GROUP_EARLY_COLOR  (1u << 3)
+#define CONFIG_GROUP_RESULT_COLOR (1u << 4)
+#define CONFIG_GROUP_TEXT_COLORS  (1u << 5)
+#define CONFIG_GROUP_FONT         (1u << 6)
+#define CONFIG_GROUP_GAME         (1u << 7)   // Everything in EngineConfig
+#define CONFIG_GROUP_SPIN_WINDOW  (1u << 8)
+#define CONFIG_GROUP_RAW_INPUT    (1u << 9)
+#define CONFIG_GROUP_DISPLAY      (1u << 10)  // RawInputDebug and the diagnostics overlay, only read while painting
+#define CONFIG_GROUP_LOG_FLUSH    (1u << 11)
+#define CONFIG_GROUP_STARTUP      (1u << 12)  // Logging and hot reload, only read at startup
+#define CONFIG_GROUP_FOREPERIOD   (1u << 13)
+#define CONFIG_GROUP_TRACE        (1u << 14)
+#define CONFIG_GROUP_BRUSHES      (CONFIG_GROUP_READY_COLOR | CONFIG_GROUP_REACT_COLOR | CONFIG_GROUP_EARLY_COLOR | CONFIG_GROUP_RESULT_COLOR)
+#define CONFIG_GROUP_ALL          ((1u << 15) - 1)
+
+#define DISPLAY_BUFFER_SIZE 512
+#define HISTORY_FILE_NAME L"history.hist"
+#define TRACE_DUMP_KEY VK_F9 // Writes log\Trace_<timestamp>.json while TraceEnabled=1
+
+typedef struct Session Session; // One running test, defined in main.c
 
 // Forward declarations for window procedure and other functions.
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParamg);
 
 // Game Logic Functions
-void DisplayLogic(HDC* hdc, HWND* hwnd, HBRUSH* brush);
-void TimerStateLogic(WPARAM* wParam, HWND* hwnd);
-void ResetLogic(HWND hwnd);
-void GameResultLogic(wchar_t* buffer);
+void DisplayLogic(HDC hdc, const RECT* rect, GameState state, void* context);
+void DiagnosticsOverlay(Session* session, HDC hdc, const RECT* rect);
+void StateTextLogic(Session* session, const ReactionEngine* engine, GameState state, wchar_t* buffer, const wchar_t* begin_text);
+void GameResultLogic(Session* session, const ReactionEngine* engine, wchar_t* buffer);
+void PaintLanes(Session* session, HDC hdc, const RECT* dirty, bool react);
+void RenderLaneFrame(HDC hdc, const RECT* rect, GameState state, void* context);
+void ResizeLaneFrames(Session* session, HDC reference);
+void LaneRect(Session* session, int lane, RECT* rect);
 
 // Utility Functions
-void InitializeSettings(HWND* hwnd);
-void HandleError(const wchar_t* error_message);
-void SetBrush(HBRUSH* brush);
-void ValidateColors(const COLORREF color[]);
-void RemoveCommentFromString(wchar_t* str);
-int  GenerateRandomDelay(int min, int max);
+void InitializeSettings(Session* session);
+void HandleError(Session* session, const wchar_t* error_message);
+void SetBrush(Session* session, HBRUSH* brush, GameState state);
+
+// Engine Platform Functions
+int64_t PlatformNow(void* context);
+void PlatformSetTimer(void* context, int timer_id, int delay_ms);
+void PlatformKillTimer(void* context, int timer_id);
+void PlatformRequestRepaint(void* context);
+void PlatformScheduleStimulus(void* context, int64_t deadline_tick);
+void PlatformCancelStimulus(void* context);
+void PlatformTrialComplete(void* context, const TrialRecord* record);
+void PlatformStimulusOnset(void* context, int64_t scheduled_tick, int64_t onset_tick);
+void PlatformConfigChanged(void* context);
+
+// Participant Lane Functions (context is the lane)
+void LaneSetTimer(void* context, int timer_id, int delay_ms);
+void LaneKillTimer(void* context, int timer_id);
+void LaneRequestRepaint(void* context);
+void LaneScheduleStimulus(void* context, int64_t deadline_tick);
+void LaneCancelStimulus(void* context);
+void LaneTrialComplete(void* context, const TrialRecord* record);
+void LaneStimulusOnset(void* context, int64_t scheduled_tick, int64_t onset_tick);
+void InitializeLanes(Session* session, int64_t frequency);
+void StartLaneLogging(Session* session, ParticipantLane* lane);
+void StartTelemetry(Session* session);
+void StopLanes(Session* session);
 
 // Configuration and Setup Functions
-bool InitializeConfigFileAndPath(wchar_t* cfg_path);
-void LoadColorConfiguration(const wchar_t* cfg_path, const wchar_t* section_name, const wchar_t* color_name, const COLORREF* target_color_array);
-void LoadConfig();
-void InitializeLogFileName(int log_type);
-bool AppendToLog(double value, int iteration, wchar_t* log_file, const wchar_t* external_error_message);
+bool InitializeConfigFileAndPath(Session* session, wchar_t* cfg_path);
+void LoadColorConfiguration(Session* session, const ConfigFile* cfg, const char* section_name, const char* color_name, uint8_t* target_color_array);
+void LoadConfig(Session* session);
+void RebuildBrushes(Session* session, uint32_t groups);
+void RebuildFont(Session* session);
+void ReloadConfig(Session* session);
+bool InitializeLogDirectory(Session* session);
+void InitializeLogFileName(Session* session, int log_type);
+uint64_t NewSessionSeed();
+void StartTrialLogging(Session* session);
+void StartInputRecording(Session* session);
+void DumpTrace(Session* session);
+void SaveDiagnosticsSummary(Session* session);
+void SaveSessionHistory(Session* session);
+bool AppendToLog(const wchar_t* log_file_path, const wchar_t* external_error_message);
 void LoadAndSetIcon(HWND hwnd);
 
 // Input Functions
-bool RegisterForRawInput(HWND hwnd, USHORT usage);
-void HandleInput(HWND hwnd, bool is_mouse_input);
-void HandleRawInput(HWND* hwnd, LPARAM* lParam);
-void HandleRawKeyboardInput(RAWINPUT* raw, HWND hwnd);
-void HandleRawMouseInput(RAWINPUT* raw, HWND hwnd);
-bool IsAlphanumeric(int vkey);
-void UpdateKeyState(int vkey, HWND hwnd);
\ No newline at end of file
+bool RegisterForRawInput(Session* session, USHORT usage);
+void UnregisterRawInput(USHORT usage);
+void ApplyRawInputSettings(Session* session);
+void HandleRawInput(Session* session, LPARAM* lParam);
+void HandleLegacyKeyboard(Session* session);
+void DrainInputEvents(Session* session);
\ No newline at end of file
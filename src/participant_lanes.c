@@ -0,0 +1,84 @@
+#include <stdlib.h>
+#include <string.h>
+#include "participant_lanes.h"
+
+static uint32_t TableSlot(uint64_t device) { // Fibonacci hashing, handles are often multiples of 8 or 16
+    return (uint32_t)((device * 0x9E3779B97F4A7C15ull) >> 57) & (LANE_TABLE_SIZE - 1);
+}
+
+bool InitializeParticipantLanes(ParticipantLanes* lanes, int lane_count, void* owner) {
+    memset(lanes, 0, sizeof(*lanes));
+    memset(lanes->table_lanes, -1, sizeof(lanes->table_lanes));
+    if (lane_count < 1 || lane_count > MAX_PARTICIPANTS) {
+        return false;
+    }
+    lanes->lanes = calloc((size_t)lane_count, sizeof(ParticipantLane));
+    if (!lanes->lanes) {
+        return false;
+    }
+    lanes->lane_count = lane_count;
+    for (int i = 0; i < lane_count; i++) {
+        lanes->lanes[i].index = i;
+        lanes->lanes[i].owner = owner;
+    }
+    return true;
+}
+
+void FreeParticipantLanes(ParticipantLanes* lanes) {
+    for (int i = 0; i < lanes->lane_count; i++) {
+        FreeEngine(&lanes->lanes[i].engine);
+    }
+    free(lanes->lanes);
+    lanes->lanes = NULL;
+    lanes->lane_count = 0;
+}
+
+int FindLane(const ParticipantLanes* lanes, uint64_t device) {
+    for (uint32_t slot = TableSlot(device);; slot = (slot + 1) & (LANE_TABLE_SIZE - 1)) {
+        int lane = lanes->table_lanes[slot];
+        if (lane < 0 || lanes->table_devices[slot] == device) {
+            return lane; // The table never fills, an empty slot always ends the probe
+        }
+    }
+}
+
+int BindLane(ParticipantLanes* lanes, uint64_t device) {
+    uint32_t slot = TableSlot(device);
+    for (; lanes->table_lanes[slot] >= 0; slot = (slot + 1) & (LANE_TABLE_SIZE - 1)) {
+        if (lanes->table_devices[slot] == device) {
+            return lanes->table_lanes[slot];
+        }
+    }
+    if (lanes->bound_count == lanes->lane_count) {
+        return -1;
+    }
+
+    int lane = lanes->bound_count++;
+    lanes->table_devices[slot] = device;
+    lanes->table_lanes[slot] = (int8_t)lane;
+    lanes->lanes[lane].device = device;
+    lanes->lanes[lane].bound = true;
+    return lane;
+}
+
+void DispatchLaneBatch(ParticipantLanes* lanes, const InputEventBatch* batch, bool keyboard_enabled, bool mouse_enabled) {
+    for (uint32_t i = 0; i < batch->count; i++) {
+        const InputEvent* event = &batch->events[i];
+        bool keyboard = event->source == INPUT_SOURCE_KEYBOARD;
+        if (keyboard ? !keyboard_enabled : !mouse_enabled) {
+            continue;
+        }
+        if (keyboard && event->pressed && !IsAlphanumeric(event->key & 0xFF)) {
+            continue; // Only a test key claims a lane, not a modifier still held from launching the tester
+        }
+
+        int lane = event->pressed ? BindLane(lanes, event->device) : FindLane(lanes, event->device);
+        if (lane < 0) {
+            lanes->unrouted += event->pressed;
+            continue;
+        }
+        ReactionEngine* engine = &lanes->lanes[lane].engine;
+        if (keyboard) HandleRawKeyboardInput(engine, event);
+        else HandleRawMouseInput(engine, event);
+    }
+}
@@ -0,0 +1,43 @@
+// Per-device participant lanes: several people at one station, each on their own keyboard or mouse. Every lane
+// has its own engine (game state, key states, rolling stats, histogram) and its own log stream. A device joins
+// with its first press and keeps its lane for the session; events are routed by device handle through an
+// open-addressed table, so finding the lane is a hash and usually one probe, whatever the number of devices.
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "input_events.h"
+#include "reaction_engine.h"
+#include "stimulus_scheduler.h"
+#include "trial_logger.h"
+
+#define MAX_PARTICIPANTS 32
+#define LANE_TABLE_SIZE 128     // Power of two, at most a quarter full with every lane bound
+
+typedef struct {
+    ReactionEngine engine;      // Set up by the frontend, platform context is usually the lane itself
+    StimulusScheduler scheduler; // Each lane runs its own foreperiod, started by the frontend
+    TrialLogger logger;         // Started by the frontend when logging, one file set per participant
+    SessionWriter session_writer;
+    bool logging;
+    bool bound;
+    uint64_t device;            // InputEvent.device of the keyboard or mouse that joined this lane
+    int index;
+    void* owner;                // Frontend state, for the platform callbacks
+} ParticipantLane;
+
+typedef struct {
+    ParticipantLane* lanes;
+    int lane_count;
+    int bound_count;
+    uint64_t table_devices[LANE_TABLE_SIZE];
+    int8_t table_lanes[LANE_TABLE_SIZE];    // -1 = empty slot
+    uint64_t unrouted;          // Events from devices that could not get a lane (all taken)
+} ParticipantLanes;
+
+bool InitializeParticipantLanes(ParticipantLanes* lanes, int lane_count, void* owner);   // Engines are left to the caller
+void FreeParticipantLanes(ParticipantLanes* lanes);    // Frees the engines, loggers and schedulers must be stopped first
+int FindLane(const ParticipantLanes* lanes, uint64_t device);   // -1 = device has no lane
+int BindLane(ParticipantLanes* lanes, uint64_t device);         // Its lane, else the next free one, -1 = all taken
+// Routes every event to the engine of its device's lane. A press from a new device claims the next free lane,
+// releases from unknown devices are dropped.
+void DispatchLaneBatch(ParticipantLanes* lanes, const InputEventBatch* batch, bool keyboard_enabled, bool mouse_enabled);
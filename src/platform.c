@@ -0,0 +1,377 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64 // fseeko takes a 64-bit off_t on 32-bit builds too
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+#include <stdio.h>
+#include "platform.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+// Clock
+int64_t ClockNow(void) {
+#ifdef _WIN32
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+int64_t ClockFrequency(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return frequency.QuadPart;
+#else
+    return 1000000000;
+#endif
+}
+
+int64_t MillisecondsToTicks(int64_t ms, int64_t frequency) {
+    return (ms / 1000) * frequency + (ms % 1000) * frequency / 1000; // Split to avoid overflow on large values
+}
+
+int64_t MicrosecondsToTicks(int64_t us, int64_t frequency) {
+    return (us / 1000000) * frequency + (us % 1000000) * frequency / 1000000;
+}
+
+double TicksToMilliseconds(int64_t ticks, int64_t frequency) {
+    return ((double)ticks / frequency) * 1000;
+}
+
+// Threads
+#ifdef _WIN32
+static DWORD WINAPI ThreadTrampoline(LPVOID arg) {
+    PlatformThread* thread = arg;
+    thread->entry(thread->arg);
+    return 0;
+}
+#else
+static void* ThreadTrampoline(void* arg) {
+    PlatformThread* thread = arg;
+    thread->entry(thread->arg);
+    return NULL;
+}
+#endif
+
+bool StartThread(PlatformThread* thread, void (*entry)(void* arg), void* arg) {
+    thread->entry = entry;
+    thread->arg = arg;
+#ifdef _WIN32
+    thread->handle = CreateThread(NULL, 0, ThreadTrampoline, thread, 0, NULL);
+    return thread->handle != NULL;
+#else
+    return pthread_create(&thread->handle, NULL, ThreadTrampoline, thread) == 0;
+#endif
+}
+
+void JoinThread(PlatformThread* thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+}
+
+void RaiseThreadPriority(void) {
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#else
+    struct sched_param param = {.sched_priority = sched_get_priority_min(SCHED_FIFO)};
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param); // Needs CAP_SYS_NICE, otherwise stays at normal priority
+#endif
+}
+
+int ProcessorCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+void CpuRelax(void) {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
+
+// Events
+bool InitializeEvent(PlatformEvent* event) {
+#ifdef _WIN32
+    event->handle = CreateEventW(NULL, FALSE, FALSE, NULL);
+    return event->handle != NULL;
+#else
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    bool ok = pthread_cond_init(&event->cond, &attributes) == 0 && pthread_mutex_init(&event->lock, NULL) == 0;
+    pthread_condattr_destroy(&attributes);
+    event->signaled = false;
+    return ok;
+#endif
+}
+
+void DestroyEvent(PlatformEvent* event) {
+#ifdef _WIN32
+    CloseHandle(event->handle);
+#else
+    pthread_cond_destroy(&event->cond);
+    pthread_mutex_destroy(&event->lock);
+#endif
+}
+
+void SignalEvent(PlatformEvent* event) {
+#ifdef _WIN32
+    SetEvent(event->handle);
+#else
+    pthread_mutex_lock(&event->lock);
+    event->signaled = true;
+    pthread_cond_signal(&event->cond);
+    pthread_mutex_unlock(&event->lock);
+#endif
+}
+
+bool WaitEvent(PlatformEvent* event, int timeout_ms) {
+#ifdef _WIN32
+    return WaitForSingleObject(event->handle, timeout_ms < 0 ? INFINITE : (DWORD)timeout_ms) == WAIT_OBJECT_0;
+#else
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&event->lock);
+    while (!event->signaled) {
+        int result = timeout_ms < 0 ? pthread_cond_wait(&event->cond, &event->lock)
+                                    : pthread_cond_timedwait(&event->cond, &event->lock, &deadline);
+        if (result != 0) {
+            break; // Timed out
+        }
+    }
+    bool signaled = event->signaled;
+    event->signaled = false;
+    pthread_mutex_unlock(&event->lock);
+    return signaled;
+#endif
+}
+
+// Memory mapped files
+bool MapFile(PlatformMapping* mapping, const char* path) {
+    mapping->data = NULL;
+    mapping->size = 0;
+#ifdef _WIN32
+    mapping->mapping = NULL;
+    mapping->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (mapping->file == INVALID_HANDLE_VALUE) {
+        mapping->file = NULL;
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(mapping->file, &size)) {
+        UnmapFile(mapping);
+        return false;
+    }
+    if (size.QuadPart == 0) {
+        return true;
+    }
+
+    mapping->mapping = CreateFileMappingA(mapping->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    mapping->data = mapping->mapping ? MapViewOfFile(mapping->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!mapping->data) {
+        UnmapFile(mapping);
+        return false;
+    }
+    mapping->size = (size_t)size.QuadPart;
+    return true;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    if (info.st_size == 0) {
+        close(fd);
+        return true;
+    }
+
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file alive
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+    mapping->data = data;
+    mapping->size = (size_t)info.st_size;
+    return true;
+#endif
+}
+
+void UnmapFile(PlatformMapping* mapping) {
+#ifdef _WIN32
+    if (mapping->data) UnmapViewOfFile(mapping->data);
+    if (mapping->mapping) CloseHandle(mapping->mapping);
+    if (mapping->file) CloseHandle(mapping->file);
+    mapping->mapping = NULL;
+    mapping->file = NULL;
+#else
+    if (mapping->data) munmap((void*)mapping->data, mapping->size);
+#endif
+    mapping->data = NULL;
+    mapping->size = 0;
+}
+
+bool SeekFile(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+// Shared memory
+bool CreateSharedMemory(PlatformSharedMemory* memory, const char* name, size_t size) {
+    memory->data = NULL;
+    memory->size = 0;
+    memory->owner = true;
+#ifdef _WIN32
+    char full_name[128];
+    snprintf(full_name, sizeof(full_name), "Local\\%s", name);
+    memory->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)size, full_name); // Page file backed, zeroed
+    if (memory->mapping && GetLastError() == ERROR_ALREADY_EXISTS) { // Another live process publishes under this name
+        CloseHandle(memory->mapping);
+        memory->mapping = NULL;
+        return false;
+    }
+    memory->data = memory->mapping ? MapViewOfFile(memory->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size) : NULL;
+    if (!memory->data) {
+        CloseSharedMemory(memory);
+        return false;
+    }
+#else
+    snprintf(memory->name, sizeof(memory->name), "/%s", name);
+    int fd = shm_open(memory->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    void* data = ftruncate(fd, (off_t)size) == 0 ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (data == MAP_FAILED) {
+        shm_unlink(memory->name);
+        return false;
+    }
+    memory->data = data;
+#endif
+    memory->size = size;
+    return true;
+}
+
+bool OpenSharedMemory(PlatformSharedMemory* memory, const char* name, size_t size) {
+    memory->data = NULL;
+    memory->size = 0;
+    memory->owner = false;
+#ifdef _WIN32
+    char full_name[128];
+    snprintf(full_name, sizeof(full_name), "Local\\%s", name);
+    memory->mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, full_name);
+    memory->data = memory->mapping ? MapViewOfFile(memory->mapping, FILE_MAP_READ, 0, 0, size) : NULL;
+    if (!memory->data) {
+        CloseSharedMemory(memory);
+        return false;
+    }
+#else
+    snprintf(memory->name, sizeof(memory->name), "/%s", name);
+    int fd = shm_open(memory->name, O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    void* data = fstat(fd, &info) == 0 && (size_t)info.st_size >= size ? mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    memory->data = data;
+#endif
+    memory->size = size;
+    return true;
+}
+
+void CloseSharedMemory(PlatformSharedMemory* memory) {
+#ifdef _WIN32
+    if (memory->data) UnmapViewOfFile(memory->data);
+    if (memory->mapping) CloseHandle(memory->mapping); // The name lives as long as any handle or view
+    memory->mapping = NULL;
+#else
+    if (memory->data) munmap(memory->data, memory->size);
+    if (memory->data && memory->owner) shm_unlink(memory->name);
+#endif
+    memory->data = NULL;
+    memory->size = 0;
+}
+
+bool RemoveSharedMemory(const char* name) {
+#ifdef _WIN32
+    (void)name;
+    return false;
+#else
+    char full_name[128];
+    snprintf(full_name, sizeof(full_name), "/%s", name);
+    return shm_unlink(full_name) == 0; // Readers still mapping it keep their view
+#endif
+}
+
+// Processes
+uint32_t CurrentProcessId(void) {
+#ifdef _WIN32
+    return (uint32_t)GetCurrentProcessId();
+#else
+    return (uint32_t)getpid();
+#endif
+}
+
+bool ProcessAlive(uint32_t pid) {
+#ifdef _WIN32
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, (DWORD)pid);
+    if (!process) {
+        return GetLastError() == ERROR_ACCESS_DENIED;
+    }
+    DWORD exit_code = 0;
+    bool alive = GetExitCodeProcess(process, &exit_code) && exit_code == STILL_ACTIVE;
+    CloseHandle(process);
+    return alive;
+#else
+    return kill((pid_t)pid, 0) == 0 || errno == EPERM;
+#endif
+}
@@ -0,0 +1,87 @@
+// Portable clock and thread helpers shared by the engine modules
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+typedef void* PlatformThreadHandle;
+#else
+#include <pthread.h>
+typedef pthread_t PlatformThreadHandle;
+#endif
+
+// Auto-reset event used to wake worker threads
+typedef struct {
+#ifdef _WIN32
+    void* handle;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool signaled;
+#endif
+} PlatformEvent;
+
+// Read-only view of a whole file
+typedef struct {
+    const void* data;
+    size_t size;
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#endif
+} PlatformMapping;
+
+// Named shared memory, visible to other processes of the same user (Local\\name on Windows, /name under /dev/shm)
+typedef struct {
+    void* data;
+    size_t size;
+    bool owner;                 // Created it, the name goes away when the owner closes it
+#ifdef _WIN32
+    void* mapping;
+#else
+    char name[128];
+#endif
+} PlatformSharedMemory;
+
+typedef struct {
+    PlatformThreadHandle handle;
+    void (*entry)(void* arg);
+    void* arg;
+} PlatformThread;
+
+// High resolution monotonic clock (QueryPerformanceCounter or CLOCK_MONOTONIC in ns)
+int64_t ClockNow(void);
+int64_t ClockFrequency(void);
+int64_t MillisecondsToTicks(int64_t ms, int64_t frequency);
+int64_t MicrosecondsToTicks(int64_t us, int64_t frequency);
+double  TicksToMilliseconds(int64_t ticks, int64_t frequency);
+
+// Threads
+bool StartThread(PlatformThread* thread, void (*entry)(void* arg), void* arg);
+void JoinThread(PlatformThread* thread);
+void RaiseThreadPriority(void);   // Applies to the calling thread, best effort
+int  ProcessorCount(void);        // Online logical processors, at least 1
+void CpuRelax(void);              // Pause hint for spin loops
+
+// Events
+bool InitializeEvent(PlatformEvent* event);
+void DestroyEvent(PlatformEvent* event);
+void SignalEvent(PlatformEvent* event);
+bool WaitEvent(PlatformEvent* event, int timeout_ms);   // Returns true if signaled, false on timeout
+
+// Memory mapped files
+bool MapFile(PlatformMapping* mapping, const char* path);  // Empty files map to data = NULL, size = 0
+void UnmapFile(PlatformMapping* mapping);
+bool SeekFile(FILE* file, uint64_t offset); // From the start, past 2 GiB too (long is 32 bits on Windows)
+
+// Shared memory
+bool CreateSharedMemory(PlatformSharedMemory* memory, const char* name, size_t size); // Read-write and zeroed, fails if the name is taken
+bool OpenSharedMemory(PlatformSharedMemory* memory, const char* name, size_t size);   // Read-only view of an existing one, at least size bytes
+void CloseSharedMemory(PlatformSharedMemory* memory);
+bool RemoveSharedMemory(const char* name); // Frees the name of a dead owner's segment. Windows frees it with the last handle, so never there
+
+// Processes
+uint32_t CurrentProcessId(void);
+bool ProcessAlive(uint32_t pid);  // True if it exists, or can't be told apart from a live one
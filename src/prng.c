@@ -0,0 +1,57 @@
+#include "prng.h"
+
+static uint64_t SplitMix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static uint64_t RotateLeft(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+void SeedRandom(RandomState* random, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        random->s[i] = SplitMix64(&seed); // Never all zero
+    }
+}
+
+uint64_t NextRandom(RandomState* random) {
+    uint64_t* s = random->s;
+    uint64_t result = RotateLeft(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = RotateLeft(s[3], 45);
+    return result;
+}
+
+uint32_t RandomBelow(RandomState* random, uint32_t range) { // Lemire's multiply-shift, rejects only the few biased low products
+    uint64_t product = (NextRandom(random) >> 32) * range;
+    uint32_t low = (uint32_t)product;
+    if (low < range) {
+        uint32_t threshold = (uint32_t)-range % range;
+        while (low < threshold) {
+            product = (NextRandom(random) >> 32) * range;
+            low = (uint32_t)product;
+        }
+    }
+    return (uint32_t)(product >> 32);
+}
+
+int32_t RandomInRange(RandomState* random, int32_t min, int32_t max) {
+    uint32_t span = (uint32_t)max - (uint32_t)min; // No overflow for any min <= max
+    if (span == UINT32_MAX) {
+        return (int32_t)(NextRandom(random) >> 32);
+    }
+    return (int32_t)((uint32_t)min + RandomBelow(random, span + 1));
+}
+
+double RandomUnit(RandomState* random) {
+    return (double)(NextRandom(random) >> 11) * 0x1.0p-53;
+}
@@ -0,0 +1,13 @@
+// xoshiro256** pseudo-random generator. Same seed, same sequence on every platform, no libc state.
+#pragma once
+#include <stdint.h>
+
+typedef struct {
+    uint64_t s[4];
+} RandomState;
+
+void SeedRandom(RandomState* random, uint64_t seed);                // Expands the seed with splitmix64, any value is fine
+uint64_t NextRandom(RandomState* random);
+uint32_t RandomBelow(RandomState* random, uint32_t range);          // Uniform in [0, range), range > 0
+int32_t RandomInRange(RandomState* random, int32_t min, int32_t max); // Uniform in [min, max], inclusive
+double RandomUnit(RandomState* random);                             // Uniform in [0, 1), 53 bits
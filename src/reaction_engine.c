@@ -0,0 +1,283 @@
+#include <string.h>
+#include "reaction_engine.h"
+#include "platform.h"
+#include "trace.h"
+
+static void EnterState(ReactionEngine* engine, GameState state) {
+    TRACE_INSTANT(TRACE_STATE, engine->state.game_state, state);
+    engine->state.game_state = state;
+}
+
+static void ArmStimulus(ReactionEngine* engine, GameState next) { // Enters the foreperiod, the scheduler answers with StimulusOnset
+    const EnginePlatform* platform = &engine->platform;
+    int delay = NextForeperiod(&engine->data.foreperiods);
+
+    EnterState(engine, next);
+    engine->data.foreperiod_ms = delay;
+    engine->data.scheduled_onset = platform->now(platform->context) + MillisecondsToTicks(delay, engine->data.frequency);
+    platform->schedule_stimulus(platform->context, engine->data.scheduled_onset);
+}
+
+bool InitializeEngine(ReactionEngine* engine, const EngineConfig* config, const EnginePlatform* platform, int64_t frequency, ForeperiodDistribution* foreperiods, uint64_t seed) {
+    memset(engine, 0, sizeof(*engine));
+    engine->config = *config;
+    engine->platform = *platform;
+    engine->data.frequency = frequency;
+    engine->state.game_state = STATE_INITIAL;
+    if (!InitializeRollingStats(&engine->data.rolling, config->averaging_trials)) {
+        FreeForeperiodDistribution(foreperiods);
+        return false;
+    }
+    if (!InitializeLatencyHistogram(&engine->data.session_histogram, MillisecondsToTicks(HISTOGRAM_HIGHEST_MS, frequency), config->histogram_precision, frequency)) {
+        FreeRollingStats(&engine->data.rolling);
+        FreeForeperiodDistribution(foreperiods);
+        return false;
+    }
+    if (!InitializeForeperiodSchedule(&engine->data.foreperiods, seed, foreperiods, (uint32_t)config->total_trials)) {
+        FreeRollingStats(&engine->data.rolling);
+        FreeLatencyHistogram(&engine->data.session_histogram);
+        return false;
+    }
+    return true;
+}
+
+void FreeEngine(ReactionEngine* engine) {
+    FreeRollingStats(&engine->data.rolling);
+    FreeLatencyHistogram(&engine->data.session_histogram);
+    FreeForeperiodSchedule(&engine->data.foreperiods);
+}
+
+bool UpdateEngineConfig(ReactionEngine* engine, const EngineConfig* config) {
+    TrialData* data = &engine->data;
+    bool rebucket = config->histogram_precision != engine->config.histogram_precision;
+
+    LatencyHistogram histogram;
+    if (rebucket && !InitializeLatencyHistogram(&histogram, data->session_histogram.highest_trackable, config->histogram_precision, data->frequency)) {
+        return false;
+    }
+    if (config->averaging_trials != engine->config.averaging_trials && !ResizeRollingStats(&data->rolling, config->averaging_trials)) {
+        if (rebucket) FreeLatencyHistogram(&histogram);
+        return false;
+    }
+    if (rebucket) { // Re-bucket what has been recorded so far
+        MergeLatencyHistogram(&histogram, &data->session_histogram);
+        FreeLatencyHistogram(&data->session_histogram);
+        data->session_histogram = histogram;
+    }
+
+    // Delays are only read when a trial is armed or a timer is set, so the running trial is not affected
+    engine->config = *config;
+    return true;
+}
+
+void SetEngineForeperiods(ReactionEngine* engine, ForeperiodDistribution* foreperiods) {
+    SetForeperiodDistribution(&engine->data.foreperiods, foreperiods); // The foreperiod already running was drawn earlier
+}
+
+static void EmitTrial(ReactionEngine* engine, TrialOutcome outcome, bool is_mouse_input, int64_t input_tick, int64_t dispatch_tick) {
+    const EnginePlatform* platform = &engine->platform;
+    TrialRecord record = {
+        .scheduled_onset = engine->data.scheduled_onset,
+        .onset = outcome == TRIAL_VALID ? engine->data.start_time : 0,
+        .response = input_tick,
+        .dispatch = dispatch_tick,
+        .stimulus_dispatch = outcome == TRIAL_VALID ? engine->data.stimulus_dispatch : 0,
+        .presented = outcome == TRIAL_VALID ? engine->data.presented : 0,
+        .reaction_time_ms = outcome == TRIAL_VALID ? engine->data.reaction_time_value : 0,
+        .trial = engine->state.trial_iteration,
+        .message_delay_ms = engine->data.message_delay_ms,
+        .foreperiod_ms = engine->data.foreperiod_ms,
+        .key = engine->data.input_key,
+        .outcome = (uint8_t)outcome,
+        .is_mouse = is_mouse_input
+    };
+    engine->data.last_trial = record;
+    TRACE_INSTANT(TRACE_TRIAL, record.trial, outcome);
+    if (platform->trial_complete) {
+        platform->trial_complete(platform->context, &record);
+    }
+}
+
+// Transition actions, each one enters the row's next state itself so it controls where in its side effects that happens
+typedef struct {
+    int64_t tick;               // Arrival of the input, or the actual stimulus onset
+    int64_t scheduled_tick;     // Onsets only, the deadline the scheduler was armed with
+    bool is_mouse;
+} EventArgs;
+
+typedef void (*TransitionAction)(ReactionEngine* engine, GameState next, const EventArgs* args);
+
+static void IgnoreEvent(ReactionEngine* engine, GameState next, const EventArgs* args) {
+    (void)engine; (void)next; (void)args;
+}
+
+static void StartTrial(ReactionEngine* engine, GameState next, const EventArgs* args) {
+    (void)args;
+    ArmStimulus(engine, next);
+    engine->platform.request_repaint(engine->platform.context);
+}
+
+static void RestartTrial(ReactionEngine* engine, GameState next, const EventArgs* args) {
+    const EnginePlatform* platform = &engine->platform;
+    (void)args;
+    platform->cancel_stimulus(platform->context);
+    platform->kill_timer(platform->context, TIMER_EARLY);
+
+    ArmStimulus(engine, next);
+    platform->request_repaint(platform->context);
+}
+
+static void Respond(ReactionEngine* engine, GameState next, const EventArgs* args) { // The measured path, kept free of mode checks
+    ProgramState* state = &engine->state;
+    TrialData* data = &engine->data;
+    const EnginePlatform* platform = &engine->platform;
+
+    state->trial_iteration++;
+    data->end_time = args->tick;
+    data->input_dispatch = platform->now(platform->context);
+    data->reaction_time_value = ((double)(data->end_time - data->start_time) / data->frequency) * 1000;
+    PushRollingStats(&data->rolling, data->reaction_time_value);
+    RecordLatency(&data->session_histogram, data->end_time - data->start_time);
+
+    EnterState(engine, next);
+    EmitTrial(engine, TRIAL_VALID, args->is_mouse, args->tick, data->input_dispatch);
+    platform->request_repaint(platform->context);
+}
+
+static void RespondEarly(ReactionEngine* engine, GameState next, const EventArgs* args) {
+    const EnginePlatform* platform = &engine->platform;
+
+    EnterState(engine, next);
+    platform->cancel_stimulus(platform->context);
+    EmitTrial(engine, TRIAL_EARLY, args->is_mouse, args->tick, platform->now(platform->context));
+    if (engine->config.early_reset_delay > 0) {
+        platform->set_timer(platform->context, TIMER_EARLY, engine->config.early_reset_delay); // Early state eventually resets back to Ready state automatically
+    }
+    platform->request_repaint(platform->context);
+}
+
+static void PresentStimulus(ReactionEngine* engine, GameState next, const EventArgs* args) {
+    // The onset is reported from another thread, so drop it if the trial it was armed for has been cancelled
+    if (args->scheduled_tick != engine->data.scheduled_onset) {
+        return;
+    }
+
+    TRACE_BEGIN(TRACE_STIMULUS_ONSET, (args->tick - args->scheduled_tick) * 1000000 / engine->data.frequency);
+    EnterState(engine, next);
+    engine->data.start_time = args->tick; // Start reaction timer at the actual onset, not when this call is dispatched
+    engine->data.stimulus_dispatch = engine->platform.now(engine->platform.context);
+    engine->data.presented = 0;
+    engine->platform.request_repaint(engine->platform.context);
+    TRACE_END(TRACE_STIMULUS_ONSET);
+}
+
+typedef enum {
+    ACTION_IGNORE,              // Zero, so a pair left out of the table is a no-op
+    ACTION_START_TRIAL,
+    ACTION_RESTART_TRIAL,
+    ACTION_RESPOND,
+    ACTION_RESPOND_EARLY,
+    ACTION_PRESENT_STIMULUS,
+    ACTION_COUNT
+} TransitionActionId;
+
+static const TransitionAction ACTIONS[] = {
+    [ACTION_IGNORE] = IgnoreEvent,
+    [ACTION_START_TRIAL] = StartTrial,
+    [ACTION_RESTART_TRIAL] = RestartTrial,
+    [ACTION_RESPOND] = Respond,
+    [ACTION_RESPOND_EARLY] = RespondEarly,
+    [ACTION_PRESENT_STIMULUS] = PresentStimulus
+};
+_Static_assert(sizeof(ACTIONS) / sizeof(ACTIONS[0]) == ACTION_COUNT, "Every transition action needs a handler");
+
+typedef struct {
+    uint8_t next;               // GameState
+    uint8_t action;             // TransitionActionId
+} Transition;
+
+// The whole game: 2 bytes per (state, event), the table fits in one cache line. New paradigms add states and rows here.
+static const Transition TRANSITIONS[STATE_COUNT][ENGINE_EVENT_COUNT] = {
+    [STATE_INITIAL] = {
+        [ENGINE_EVENT_INPUT] = {STATE_READY, ACTION_START_TRIAL},
+    },
+    [STATE_READY] = {
+        [ENGINE_EVENT_INPUT] = {STATE_EARLY, ACTION_RESPOND_EARLY},
+        [ENGINE_EVENT_ONSET] = {STATE_REACT, ACTION_PRESENT_STIMULUS},
+    },
+    [STATE_REACT] = {
+        [ENGINE_EVENT_INPUT] = {STATE_RESULT, ACTION_RESPOND},
+    },
+    [STATE_EARLY] = {
+        [ENGINE_EVENT_INPUT] = {STATE_READY, ACTION_RESTART_TRIAL},
+        [ENGINE_EVENT_EARLY_TIMEOUT] = {STATE_READY, ACTION_RESTART_TRIAL}, // Reset after showing the "too early" screen
+    },
+    [STATE_RESULT] = {
+        [ENGINE_EVENT_INPUT] = {STATE_READY, ACTION_RESTART_TRIAL},
+    },
+};
+_Static_assert(sizeof(TRANSITIONS) == STATE_COUNT * ENGINE_EVENT_COUNT * sizeof(Transition), "One row per state and event");
+_Static_assert(STATE_COUNT <= UINT8_MAX && ACTION_COUNT <= UINT8_MAX, "Transition fields are bytes");
+
+const StateView STATE_VIEWS[STATE_COUNT] = {
+    [STATE_INITIAL] = {STATE_COLOR_RESULT, STATE_TEXT_BEGIN, false},
+    [STATE_READY] = {STATE_COLOR_READY, STATE_TEXT_NONE, false},
+    [STATE_REACT] = {STATE_COLOR_REACT, STATE_TEXT_NONE, false},
+    [STATE_EARLY] = {STATE_COLOR_EARLY, STATE_TEXT_EARLY, true},
+    [STATE_RESULT] = {STATE_COLOR_RESULT, STATE_TEXT_RESULT, false},
+};
+
+static void DispatchEvent(ReactionEngine* engine, EngineEvent event, const EventArgs* args) { // One indexed load, one call
+    const Transition* transition = &TRANSITIONS[engine->state.game_state][event];
+    ACTIONS[transition->action](engine, (GameState)transition->next, args);
+}
+
+// Game Logic Functions
+void HandleInput(ReactionEngine* engine, bool is_mouse_input, int64_t input_tick) {   // Primary input logic is done here
+    ProgramState* state = &engine->state;
+    const EngineConfig* config = &engine->config;
+    const EnginePlatform* platform = &engine->platform;
+
+    TRACE_BEGIN(TRACE_HANDLE_INPUT, is_mouse_input);
+    if ((!state->mouse_active && is_mouse_input) || (state->debounce_active)) {
+        TRACE_END(TRACE_HANDLE_INPUT);
+        return;  // Ignore mouse clicks outside of active area
+    }
+
+    DispatchEvent(engine, ENGINE_EVENT_INPUT, &(EventArgs){.tick = input_tick, .is_mouse = is_mouse_input});
+
+    if ((config->virtual_debounce > 0) && (!state->debounce_active)) { // Activate debounce if enabled
+        state->debounce_active = true;
+        platform->set_timer(platform->context, TIMER_DEBOUNCE, config->virtual_debounce);
+    }
+    TRACE_END(TRACE_HANDLE_INPUT);
+}
+
+void TimerStateLogic(ReactionEngine* engine, int timer_id) {
+    TRACE_BEGIN(TRACE_TIMER_LOGIC, timer_id);
+    if (timer_id == TIMER_EARLY) {
+        DispatchEvent(engine, ENGINE_EVENT_EARLY_TIMEOUT, &(EventArgs){0});
+    } else if (timer_id == TIMER_DEBOUNCE) { // Not a state change, only gates input
+        engine->state.debounce_active = false;
+    }
+    TRACE_END(TRACE_TIMER_LOGIC);
+}
+
+void ResetLogic(ReactionEngine* engine) {
+    RestartTrial(engine, STATE_READY, NULL);
+}
+
+void StimulusOnset(ReactionEngine* engine, int64_t scheduled_tick, int64_t onset_tick) {
+    DispatchEvent(engine, ENGINE_EVENT_ONSET, &(EventArgs){.tick = onset_tick, .scheduled_tick = scheduled_tick});
+}
+
+void StimulusPresented(ReactionEngine* engine, int64_t tick) {
+    if (engine->state.game_state == STATE_REACT && engine->data.presented == 0) {
+        engine->data.presented = tick;
+    }
+}
+
+bool AverageAvailable(const ReactionEngine* engine) { // The window has to fill up once, after that it rolls
+    return engine->data.rolling.count >= engine->config.averaging_trials;
+}
+
@@ -0,0 +1,150 @@
+// Platform-neutral reaction test engine. Frontends inject a clock, timers and a repaint hook.
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "rolling_stats.h"
+#include "latency_histogram.h"
+#include "foreperiod.h"
+
+// Timer names (one-shot, the frontend calls TimerStateLogic when one expires)
+#define TIMER_EARLY 1
+#define TIMER_DEBOUNCE 2
+
+#define HISTOGRAM_HIGHEST_MS 60000 // Reaction times above this share the last histogram bucket
+
+typedef enum {
+    STATE_INITIAL,
+    STATE_READY,
+    STATE_REACT,
+    STATE_EARLY,
+    STATE_RESULT,
+    STATE_COUNT
+} GameState;
+
+// What moves the state machine, each (state, event) pair has one row in the engine's transition table
+typedef enum {
+    ENGINE_EVENT_INPUT,         // Press or click that got past the debounce
+    ENGINE_EVENT_ONSET,         // The scheduler reached the stimulus deadline
+    ENGINE_EVENT_EARLY_TIMEOUT, // TIMER_EARLY expired
+    ENGINE_EVENT_COUNT
+} EngineEvent;
+
+// How each state is shown, frontends map these onto their own brushes, pixels and strings
+typedef enum {
+    STATE_COLOR_READY,
+    STATE_COLOR_REACT,
+    STATE_COLOR_EARLY,
+    STATE_COLOR_RESULT,
+    STATE_COLOR_COUNT
+} StateColor;
+
+typedef enum {
+    STATE_TEXT_NONE,            // Plain color, nothing to render per trial
+    STATE_TEXT_BEGIN,
+    STATE_TEXT_EARLY,           // Trial count
+    STATE_TEXT_RESULT           // Last, rolling and session statistics
+} StateText;
+
+typedef struct {
+    uint8_t background;         // StateColor
+    uint8_t text;               // StateText
+    bool early_font;            // EarlyFontColor instead of ResultsFontColor
+} StateView;
+
+extern const StateView STATE_VIEWS[STATE_COUNT];
+
+typedef enum {
+    TRIAL_VALID,
+    TRIAL_EARLY
+} TrialOutcome;
+
+// Emitted once per finished trial (valid reaction or early press), ticks are platform ticks
+typedef struct {
+    int64_t scheduled_onset;
+    int64_t onset;              // 0 for early presses
+    int64_t response;           // Arrival of the input event
+    int64_t dispatch;           // When the engine handled it
+    int64_t stimulus_dispatch;  // When the engine handled the onset and asked for the react frame, 0 for early presses
+    int64_t presented;          // End of the first paint of the react frame, 0 for early presses or if it never got painted
+    double reaction_time_ms;    // 0 for early presses
+    int32_t trial;              // Valid trials so far, including this one
+    uint32_t message_delay_ms;
+    int32_t foreperiod_ms;      // Random delay drawn for this trial
+    uint16_t key;               // Virtual key, or mouse button for mouse input
+    uint8_t outcome;            // TrialOutcome
+    uint8_t is_mouse;
+} TrialRecord;
+
+// Services provided by the frontend (Win32 window, headless driver, ...)
+typedef struct {
+    void* context;                                                  // Passed back to every callback
+    int64_t (*now)(void* context);                                  // Current tick count, e.g. QueryPerformanceCounter
+    void (*set_timer)(void* context, int timer_id, int delay_ms);   // Arms (or re-arms) a one-shot timer
+    void (*kill_timer)(void* context, int timer_id);
+    void (*request_repaint)(void* context);
+    void (*schedule_stimulus)(void* context, int64_t deadline_tick); // READY->REACT at an absolute tick, answered with StimulusOnset
+    void (*cancel_stimulus)(void* context);
+    void (*trial_complete)(void* context, const TrialRecord* record); // Optional, may be NULL
+} EnginePlatform;
+
+// Game options
+typedef struct {
+    int averaging_trials;
+    int total_trials;
+    int early_reset_delay;
+    int virtual_debounce;
+    int histogram_precision;    // Significant bits of the session histogram
+} EngineConfig;
+
+typedef struct {
+    // Game State
+    GameState game_state;
+    int trial_iteration;
+
+    // Input State
+    bool mouse_active;
+    bool debounce_active;
+    bool mouse_button_down;
+    int key_states[256];
+} ProgramState;
+
+typedef struct {
+    double reaction_time_value;
+    RollingStats rolling;       // Last averaging_trials reaction times
+    LatencyHistogram session_histogram; // Every valid reaction this session, in ticks
+    // Timing (in platform ticks)
+    int64_t scheduled_onset;    // Deadline handed to the scheduler for the current trial
+    int64_t start_time;         // Actual stimulus onset
+    int64_t end_time;           // Arrival of the reacting input event
+    int64_t input_dispatch;     // When the game logic got to handle that event
+    int64_t stimulus_dispatch;  // When StimulusOnset ran
+    int64_t presented;          // Reported by the frontend once the react frame is on screen, 0 until then
+    uint32_t message_delay_ms;  // OS message queue delay reported for the input being handled
+    uint16_t input_key;         // Key or button of the input being handled
+    int32_t foreperiod_ms;      // Delay drawn for the current trial
+    ForeperiodSchedule foreperiods;
+
+    TrialRecord last_trial;
+    int64_t frequency;
+} TrialData;
+
+typedef struct {
+    EngineConfig config;
+    EnginePlatform platform;
+    ProgramState state;
+    TrialData data;
+} ReactionEngine;
+
+// Takes ownership of foreperiods, seed drives the draws from it
+bool InitializeEngine(ReactionEngine* engine, const EngineConfig* config, const EnginePlatform* platform, int64_t frequency, ForeperiodDistribution* foreperiods, uint64_t seed);
+void FreeEngine(ReactionEngine* engine);
+bool UpdateEngineConfig(ReactionEngine* engine, const EngineConfig* config); // Live change, the current trial keeps running
+void SetEngineForeperiods(ReactionEngine* engine, ForeperiodDistribution* foreperiods); // Takes ownership, applies from the next trial on
+
+// Game Logic Functions
+void HandleInput(ReactionEngine* engine, bool is_mouse_input, int64_t input_tick); // input_tick = when the event arrived
+void TimerStateLogic(ReactionEngine* engine, int timer_id);
+void ResetLogic(ReactionEngine* engine);
+void StimulusOnset(ReactionEngine* engine, int64_t scheduled_tick, int64_t onset_tick);
+void StimulusPresented(ReactionEngine* engine, int64_t tick); // The react frame finished painting, only the first call per trial counts
+bool AverageAvailable(const ReactionEngine* engine);
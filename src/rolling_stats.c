@@ -0,0 +1,241 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rolling_stats.h"
+
+// Treap helpers (nodes are addressed by ring slot, -1 is null)
+static int32_t NodeSize(const RollingStats* stats, int32_t node) {
+    return node < 0 ? 0 : stats->nodes[node].size;
+}
+
+static void UpdateSize(RollingStats* stats, int32_t node) {
+    stats->nodes[node].size = 1 + NodeSize(stats, stats->nodes[node].left) + NodeSize(stats, stats->nodes[node].right);
+}
+
+static bool KeyLess(const StatNode* a, double value, uint64_t sequence) {
+    return a->value < value || (a->value == value && a->sequence < sequence);
+}
+
+static void Split(RollingStats* stats, int32_t node, double value, uint64_t sequence, int32_t* left, int32_t* right) { // left < key <= right
+    if (node < 0) {
+        *left = *right = -1;
+        return;
+    }
+    if (KeyLess(&stats->nodes[node], value, sequence)) {
+        Split(stats, stats->nodes[node].right, value, sequence, &stats->nodes[node].right, right);
+        *left = node;
+    } else {
+        Split(stats, stats->nodes[node].left, value, sequence, left, &stats->nodes[node].left);
+        *right = node;
+    }
+    UpdateSize(stats, node);
+}
+
+static int32_t Merge(RollingStats* stats, int32_t left, int32_t right) { // Every key in left is smaller than every key in right
+    if (left < 0) return right;
+    if (right < 0) return left;
+
+    if (stats->nodes[left].priority > stats->nodes[right].priority) {
+        stats->nodes[left].right = Merge(stats, stats->nodes[left].right, right);
+        UpdateSize(stats, left);
+        return left;
+    }
+    stats->nodes[right].left = Merge(stats, left, stats->nodes[right].left);
+    UpdateSize(stats, right);
+    return right;
+}
+
+static int32_t Erase(RollingStats* stats, int32_t node, double value, uint64_t sequence) {
+    StatNode* current = &stats->nodes[node];
+    if (current->value == value && current->sequence == sequence) {
+        return Merge(stats, current->left, current->right);
+    }
+    if (KeyLess(current, value, sequence)) {
+        current->right = Erase(stats, current->right, value, sequence);
+    } else {
+        current->left = Erase(stats, current->left, value, sequence);
+    }
+    UpdateSize(stats, node);
+    return node;
+}
+
+static double Kth(const RollingStats* stats, int32_t k) { // 0-based rank
+    int32_t node = stats->root;
+    for (;;) {
+        int32_t left_size = NodeSize(stats, stats->nodes[node].left);
+        if (k < left_size) {
+            node = stats->nodes[node].left;
+        } else if (k == left_size) {
+            return stats->nodes[node].value;
+        } else {
+            k -= left_size + 1;
+            node = stats->nodes[node].right;
+        }
+    }
+}
+
+static uint32_t NextPriority(RollingStats* stats) { // xorshift32
+    uint32_t x = stats->priority_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    stats->priority_state = x;
+    return x;
+}
+
+// Monotonic deque helpers
+static double SequenceValue(const RollingStats* stats, uint64_t sequence) {
+    return stats->values[sequence % stats->capacity];
+}
+
+static void DequePush(RollingStats* stats, uint64_t* deque, int head, int* count, uint64_t sequence, bool keep_min) {
+    double value = SequenceValue(stats, sequence);
+    while (*count > 0) { // Drop everything that can never become the min (or max) again
+        double back = SequenceValue(stats, deque[(head + *count - 1) % stats->capacity]);
+        if (keep_min ? back < value : back > value) {
+            break;
+        }
+        (*count)--;
+    }
+    deque[(head + *count) % stats->capacity] = sequence;
+    (*count)++;
+}
+
+static void DequeEvict(RollingStats* stats, uint64_t* deque, int* head, int* count, uint64_t sequence) {
+    if (*count > 0 && deque[*head] == sequence) {
+        *head = (*head + 1) % stats->capacity;
+        (*count)--;
+    }
+}
+
+static void RecomputeMoments(RollingStats* stats) { // Exact two-pass recompute, bounds drift from the incremental updates
+    double total = 0;
+    for (int i = 0; i < stats->count; i++) {
+        total += stats->values[i];
+    }
+    stats->mean = total / stats->count;
+
+    double m2 = 0;
+    for (int i = 0; i < stats->count; i++) {
+        double delta = stats->values[i] - stats->mean;
+        m2 += delta * delta;
+    }
+    stats->m2 = m2;
+}
+
+static void UpdateSummary(RollingStats* stats) {
+    RollingSummary* summary = &stats->summary;
+    summary->count = stats->count;
+    summary->mean = stats->mean;
+    summary->sd = stats->count > 1 ? sqrt(fmax(stats->m2, 0) / (stats->count - 1)) : 0;
+    summary->min = SequenceValue(stats, stats->min_deque[stats->min_head]);
+    summary->max = SequenceValue(stats, stats->max_deque[stats->max_head]);
+    summary->median = RollingPercentile(stats, 50);
+    summary->p90 = RollingPercentile(stats, 90);
+}
+
+bool InitializeRollingStats(RollingStats* stats, int window) {
+    memset(stats, 0, sizeof(*stats));
+    if (window <= 0) {
+        return false;
+    }
+
+    stats->capacity = window;
+    stats->values = malloc(sizeof(double) * window);
+    stats->nodes = malloc(sizeof(StatNode) * window);
+    stats->min_deque = malloc(sizeof(uint64_t) * window);
+    stats->max_deque = malloc(sizeof(uint64_t) * window);
+    if (!stats->values || !stats->nodes || !stats->min_deque || !stats->max_deque) {
+        FreeRollingStats(stats);
+        return false;
+    }
+    stats->root = -1;
+    stats->priority_state = 2463534242u;
+    return true;
+}
+
+void FreeRollingStats(RollingStats* stats) {
+    free(stats->values);
+    free(stats->nodes);
+    free(stats->min_deque);
+    free(stats->max_deque);
+    memset(stats, 0, sizeof(*stats));
+    stats->root = -1;
+}
+
+bool ResizeRollingStats(RollingStats* stats, int window) {
+    RollingStats resized;
+    if (!InitializeRollingStats(&resized, window)) {
+        return false;
+    }
+
+    int keep = stats->count < window ? stats->count : window;
+    for (uint64_t sequence = stats->pushed - (uint64_t)keep; sequence < stats->pushed; sequence++) {
+        PushRollingStats(&resized, SequenceValue(stats, sequence));
+    }
+    FreeRollingStats(stats);
+    *stats = resized;
+    return true;
+}
+
+void PushRollingStats(RollingStats* stats, double value) {
+    uint64_t sequence = stats->pushed++;
+    int slot = (int)(sequence % stats->capacity);
+
+    if (stats->count == stats->capacity) { // Window full, the value in this slot leaves
+        double old_value = stats->values[slot];
+        uint64_t old_sequence = sequence - stats->capacity;
+
+        stats->root = Erase(stats, stats->root, old_value, old_sequence);
+        DequeEvict(stats, stats->min_deque, &stats->min_head, &stats->min_count, old_sequence);
+        DequeEvict(stats, stats->max_deque, &stats->max_head, &stats->max_count, old_sequence);
+
+        double delta = old_value - stats->mean;
+        stats->mean -= delta / (stats->count - 1 > 0 ? stats->count - 1 : 1);
+        stats->m2 -= delta * (old_value - stats->mean);
+        stats->count--;
+        if (stats->count == 0) {
+            stats->mean = 0;
+            stats->m2 = 0;
+        }
+    }
+
+    stats->values[slot] = value;
+    stats->count++;
+    double delta = value - stats->mean;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (value - stats->mean);
+    if (stats->count == stats->capacity && slot == stats->capacity - 1) {
+        RecomputeMoments(stats); // Once per window, so amortized O(1)
+    }
+
+    StatNode* node = &stats->nodes[slot];
+    node->value = value;
+    node->sequence = sequence;
+    node->priority = NextPriority(stats);
+    node->left = node->right = -1;
+    node->size = 1;
+    int32_t left, right;
+    Split(stats, stats->root, value, sequence, &left, &right);
+    stats->root = Merge(stats, Merge(stats, left, slot), right);
+
+    DequePush(stats, stats->min_deque, stats->min_head, &stats->min_count, sequence, true);
+    DequePush(stats, stats->max_deque, stats->max_head, &stats->max_count, sequence, false);
+
+    UpdateSummary(stats);
+}
+
+double RollingPercentile(const RollingStats* stats, double percentile) {
+    if (stats->count == 0) {
+        return 0;
+    }
+
+    double position = (percentile / 100) * (stats->count - 1);
+    int32_t lower = (int32_t)position;
+    if (lower >= stats->count - 1) {
+        return Kth(stats, stats->count - 1);
+    }
+    double fraction = position - lower;
+    double low = Kth(stats, lower);
+    return fraction > 0 ? low + (Kth(stats, lower + 1) - low) * fraction : low;
+}
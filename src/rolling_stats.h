@@ -0,0 +1,51 @@
+// Rolling window statistics over the last N reaction times.
+// Mean/variance and min/max update in (amortized) O(1), order statistics come from a size-augmented treap in O(log N).
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+// Precomputed after every push so the display never does any math
+typedef struct {
+    int count;
+    double mean;
+    double sd;          // Sample standard deviation
+    double min;
+    double max;
+    double median;
+    double p90;
+} RollingSummary;
+
+typedef struct {
+    double value;
+    uint64_t sequence;  // Breaks ties so every key is unique
+    uint32_t priority;
+    int32_t left;
+    int32_t right;
+    int32_t size;
+} StatNode;
+
+typedef struct {
+    int capacity;
+    int count;
+    uint64_t pushed;            // Total values ever pushed, also the sequence of the next one
+    double* values;             // Ring buffer, slot = sequence % capacity
+    StatNode* nodes;            // Treap node for each ring slot
+    int32_t root;
+    uint32_t priority_state;
+
+    double mean;                // Welford accumulators for the current window
+    double m2;
+
+    uint64_t* min_deque;        // Monotonic deques of sequences, front is the current min/max
+    uint64_t* max_deque;
+    int min_head, min_count;
+    int max_head, max_count;
+
+    RollingSummary summary;
+} RollingStats;
+
+bool InitializeRollingStats(RollingStats* stats, int window);
+void FreeRollingStats(RollingStats* stats);
+bool ResizeRollingStats(RollingStats* stats, int window);  // Keeps the newest values that still fit, unchanged on failure
+void PushRollingStats(RollingStats* stats, double value);
+double RollingPercentile(const RollingStats* stats, double percentile); // percentile in [0, 100], linear interpolation
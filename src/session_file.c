@@ -0,0 +1,255 @@
+#include <stdlib.h>
+#include <string.h>
+#include "session_file.h"
+#include "input_events.h"
+
+_Static_assert(sizeof(SessionFileHeader) == 64, "SessionFileHeader is part of the file format");
+_Static_assert(sizeof(SessionBlock) % 8 == 0, "Blocks must keep the columns 8-byte aligned");
+_Static_assert(sizeof(SessionIndexEntry) == 40, "SessionIndexEntry is part of the file format");
+
+// Version 1 block, read only
+typedef struct {
+    uint32_t count;
+    uint32_t valid_count;
+    uint64_t session_id;
+    int64_t first_response;
+    int64_t last_response;
+    int64_t scheduled_onset[SESSION_BLOCK_CAPACITY];
+    int64_t onset[SESSION_BLOCK_CAPACITY];
+    int64_t response[SESSION_BLOCK_CAPACITY];
+    int64_t dispatch[SESSION_BLOCK_CAPACITY];
+    int32_t foreperiod_ms[SESSION_BLOCK_CAPACITY];
+    int32_t trial[SESSION_BLOCK_CAPACITY];
+    uint32_t message_delay_ms[SESSION_BLOCK_CAPACITY];
+    uint16_t key[SESSION_BLOCK_CAPACITY];
+    uint8_t outcome[SESSION_BLOCK_CAPACITY];
+    uint8_t source[SESSION_BLOCK_CAPACITY];
+} SessionBlockV1;
+
+static uint64_t FileBlockOffset(uint32_t block, size_t block_size) {
+    return sizeof(SessionFileHeader) + (uint64_t)block * block_size;
+}
+
+static uint64_t BlockOffset(uint32_t block) {
+    return FileBlockOffset(block, sizeof(SessionBlock));
+}
+
+static void ResetBlock(SessionWriter* writer) {
+    memset(&writer->block, 0, sizeof(writer->block));
+    writer->block.session_id = writer->header.session_id;
+    writer->dirty = false;
+}
+
+static bool WriteBlock(SessionWriter* writer) { // Fixed offset, so a partial block is simply overwritten later
+    if (!SeekFile(writer->file, BlockOffset(writer->block_number)) ||
+        fwrite(&writer->block, sizeof(writer->block), 1, writer->file) != 1) {
+        return false;
+    }
+    writer->dirty = false;
+    return true;
+}
+
+static bool AddIndexEntry(SessionWriter* writer) {
+    if (writer->block_number >= writer->index_capacity) {
+        uint32_t capacity = writer->index_capacity ? writer->index_capacity * 2 : 64;
+        SessionIndexEntry* index = realloc(writer->index, capacity * sizeof(SessionIndexEntry));
+        if (!index) {
+            return false;
+        }
+        writer->index = index;
+        writer->index_capacity = capacity;
+    }
+
+    writer->index[writer->block_number] = (SessionIndexEntry){
+        .session_id = writer->block.session_id,
+        .first_response = writer->block.first_response,
+        .last_response = writer->block.last_response,
+        .offset = BlockOffset(writer->block_number),
+        .count = writer->block.count,
+        .valid_count = writer->block.valid_count
+    };
+    return true;
+}
+
+bool OpenSessionWriter(SessionWriter* writer, FILE* file, uint64_t session_id, int64_t frequency, int64_t start_time, uint64_t seed) {
+    writer->file = file;
+    writer->header = (SessionFileHeader){
+        .magic = SESSION_FILE_MAGIC,
+        .version = SESSION_FILE_VERSION,
+        .header_size = sizeof(SessionFileHeader),
+        .block_size = sizeof(SessionBlock),
+        .block_capacity = SESSION_BLOCK_CAPACITY,
+        .session_id = session_id,
+        .frequency = frequency,
+        .start_time = start_time,
+        .seed = seed
+    };
+    writer->block_number = 0;
+    writer->index = NULL;
+    writer->index_capacity = 0;
+    ResetBlock(writer);
+
+    return fwrite(&writer->header, sizeof(writer->header), 1, file) == 1;
+}
+
+bool AppendSessionRecord(SessionWriter* writer, const TrialRecord* record) {
+    SessionBlock* block = &writer->block;
+    if (block->count == SESSION_BLOCK_CAPACITY) {
+        if (!WriteBlock(writer) || !AddIndexEntry(writer)) {
+            return false;
+        }
+        writer->block_number++;
+        ResetBlock(writer);
+    }
+
+    uint32_t i = block->count++;
+    block->scheduled_onset[i] = record->scheduled_onset;
+    block->onset[i] = record->onset;
+    block->response[i] = record->response;
+    block->dispatch[i] = record->dispatch;
+    block->stimulus_dispatch[i] = record->stimulus_dispatch;
+    block->presented[i] = record->presented;
+    block->foreperiod_ms[i] = record->foreperiod_ms;
+    block->trial[i] = record->trial;
+    block->message_delay_ms[i] = record->message_delay_ms;
+    block->key[i] = record->key;
+    block->outcome[i] = record->outcome;
+    block->source[i] = record->is_mouse ? INPUT_SOURCE_MOUSE : INPUT_SOURCE_KEYBOARD;
+
+    if (i == 0) {
+        block->first_response = record->response;
+    }
+    block->last_response = record->response;
+    if (record->outcome == TRIAL_VALID) {
+        block->valid_count++;
+    }
+    writer->dirty = true;
+    return true;
+}
+
+bool FlushSessionWriter(SessionWriter* writer) {
+    if (writer->dirty && !WriteBlock(writer)) {
+        return false;
+    }
+    return fflush(writer->file) == 0;
+}
+
+bool CloseSessionWriter(SessionWriter* writer) {
+    bool ok = true;
+    uint32_t block_count = writer->block_number;
+    if (writer->block.count > 0) {
+        ok = WriteBlock(writer) && AddIndexEntry(writer);
+        block_count++;
+    }
+
+    if (ok) {
+        SessionFileFooter footer = {.index_offset = BlockOffset(block_count), .block_count = block_count, .magic = SESSION_FOOTER_MAGIC};
+        ok = SeekFile(writer->file, footer.index_offset) &&
+             fwrite(writer->index, sizeof(SessionIndexEntry), block_count, writer->file) == block_count &&
+             fwrite(&footer, sizeof(footer), 1, writer->file) == 1;
+    }
+
+    ok = fclose(writer->file) == 0 && ok;
+    free(writer->index);
+    writer->file = NULL;
+    writer->index = NULL;
+    return ok;
+}
+
+static bool UpgradeBlocks(SessionFile* session) { // Version 1: same columns minus stimulus_dispatch and presented
+    if (!session->block_count) {
+        return true;
+    }
+    session->upgraded = calloc(session->block_count, sizeof(SessionBlock));
+    if (!session->upgraded) {
+        return false;
+    }
+    for (uint32_t b = 0; b < session->block_count; b++) {
+        const SessionBlockV1* old = (const SessionBlockV1*)((const uint8_t*)session->mapping.data + FileBlockOffset(b, sizeof(SessionBlockV1)));
+        SessionBlock* block = &session->upgraded[b];
+        block->count = old->count;
+        block->valid_count = old->valid_count;
+        block->session_id = old->session_id;
+        block->first_response = old->first_response;
+        block->last_response = old->last_response;
+        memcpy(block->scheduled_onset, old->scheduled_onset, sizeof(block->scheduled_onset));
+        memcpy(block->onset, old->onset, sizeof(block->onset));
+        memcpy(block->response, old->response, sizeof(block->response));
+        memcpy(block->dispatch, old->dispatch, sizeof(block->dispatch));
+        memcpy(block->foreperiod_ms, old->foreperiod_ms, sizeof(block->foreperiod_ms));
+        memcpy(block->trial, old->trial, sizeof(block->trial));
+        memcpy(block->message_delay_ms, old->message_delay_ms, sizeof(block->message_delay_ms));
+        memcpy(block->key, old->key, sizeof(block->key));
+        memcpy(block->outcome, old->outcome, sizeof(block->outcome));
+        memcpy(block->source, old->source, sizeof(block->source));
+    }
+    return true;
+}
+
+bool OpenSessionFile(SessionFile* session, const char* path) {
+    memset(session, 0, sizeof(*session));
+    if (!MapFile(&session->mapping, path)) {
+        return false;
+    }
+
+    const uint8_t* base = session->mapping.data;
+    size_t size = session->mapping.size;
+    session->header = (const SessionFileHeader*)base;
+    size_t block_size = size >= sizeof(SessionFileHeader) && session->header->version == 1 ? sizeof(SessionBlockV1) : sizeof(SessionBlock);
+    if (size < sizeof(SessionFileHeader) || session->header->magic != SESSION_FILE_MAGIC ||
+        (session->header->version != SESSION_FILE_VERSION && session->header->version != 1) ||
+        session->header->header_size != sizeof(SessionFileHeader) || session->header->block_size != block_size) {
+        CloseSessionFile(session);
+        return false;
+    }
+
+    session->block_count = (uint32_t)((size - sizeof(SessionFileHeader)) / block_size); // No footer, the session did not shut down cleanly
+    if (size >= sizeof(SessionFileHeader) + sizeof(SessionFileFooter)) {
+        const SessionFileFooter* footer = (const SessionFileFooter*)(base + size - sizeof(SessionFileFooter));
+        uint64_t index_end = footer->index_offset + (uint64_t)footer->block_count * sizeof(SessionIndexEntry);
+        if (footer->magic == SESSION_FOOTER_MAGIC && footer->index_offset == FileBlockOffset(footer->block_count, block_size) &&
+            index_end + sizeof(SessionFileFooter) == size) {
+            session->index = (const SessionIndexEntry*)(base + footer->index_offset); // Offsets are into the file, in its own layout
+            session->block_count = footer->block_count;
+        }
+    }
+    if (session->header->version == 1 && !UpgradeBlocks(session)) {
+        CloseSessionFile(session);
+        return false;
+    }
+    return true;
+}
+
+void CloseSessionFile(SessionFile* session) {
+    UnmapFile(&session->mapping);
+    free(session->upgraded);
+    session->upgraded = NULL;
+    session->header = NULL;
+    session->index = NULL;
+    session->block_count = 0;
+}
+
+const SessionBlock* SessionFileBlock(const SessionFile* session, uint32_t block) {
+    if (block >= session->block_count) {
+        return NULL;
+    }
+    if (session->upgraded) {
+        return &session->upgraded[block];
+    }
+    return (const SessionBlock*)((const uint8_t*)session->mapping.data + BlockOffset(block));
+}
+
+uint32_t FindSessionBlock(const SessionFile* session, int64_t tick) {
+    uint32_t low = 0;
+    uint32_t high = session->block_count;
+    while (low < high) { // Blocks are in arrival order, so last_response is sorted
+        uint32_t middle = low + (high - low) / 2;
+        int64_t last = session->index ? session->index[middle].last_response : SessionFileBlock(session, middle)->last_response;
+        if (last < tick) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
@@ -0,0 +1,100 @@
+// Binary columnar session file (.rts): one file per session, trial records in fixed-size blocks.
+//
+// Layout: SessionFileHeader | SessionBlock * N | SessionIndexEntry * N | SessionFileFooter
+// Blocks sit at fixed offsets, so the writer rewrites the last (partial) block in place on every flush
+// and a file without footer (crashed session) is still readable block by block.
+// Everything is little-endian and naturally aligned, the reader hands out pointers into the mapping.
+// Version 1 files (before the stimulus_dispatch and presented columns) are still read: OpenSessionFile converts
+// their blocks to the current layout once, with the missing columns zeroed.
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "platform.h"
+#include "reaction_engine.h"
+
+#define SESSION_FILE_MAGIC 0x53465452u         // "RTFS"
+#define SESSION_FOOTER_MAGIC 0x58465452u       // "RTFX"
+#define SESSION_FILE_VERSION 2                 // 2: stimulus_dispatch and presented columns
+#define SESSION_BLOCK_CAPACITY 1024
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t block_size;
+    uint32_t block_capacity;
+    uint32_t reserved;
+    uint64_t session_id;
+    int64_t frequency;          // Ticks per second of every timestamp in the file
+    int64_t start_time;         // Unix time the session started
+    uint64_t seed;              // Foreperiod generator seed, 0 in files written before it was logged
+    uint8_t padding[8];
+} SessionFileHeader;
+
+// Columns of up to SESSION_BLOCK_CAPACITY trials, the first count entries are valid
+typedef struct {
+    uint32_t count;
+    uint32_t valid_count;       // Trials with outcome TRIAL_VALID
+    uint64_t session_id;
+    int64_t first_response;     // Time range covered by the block
+    int64_t last_response;
+    int64_t scheduled_onset[SESSION_BLOCK_CAPACITY];
+    int64_t onset[SESSION_BLOCK_CAPACITY];         // 0 for early presses
+    int64_t response[SESSION_BLOCK_CAPACITY];
+    int64_t dispatch[SESSION_BLOCK_CAPACITY];
+    int64_t stimulus_dispatch[SESSION_BLOCK_CAPACITY]; // 0 for early presses
+    int64_t presented[SESSION_BLOCK_CAPACITY];         // 0 for early presses and frames that were never painted
+    int32_t foreperiod_ms[SESSION_BLOCK_CAPACITY];
+    int32_t trial[SESSION_BLOCK_CAPACITY];
+    uint32_t message_delay_ms[SESSION_BLOCK_CAPACITY];
+    uint16_t key[SESSION_BLOCK_CAPACITY];
+    uint8_t outcome[SESSION_BLOCK_CAPACITY];       // TrialOutcome
+    uint8_t source[SESSION_BLOCK_CAPACITY];        // InputSource
+} SessionBlock;
+
+// Footer index, one entry per block sorted by (session_id, first_response)
+typedef struct {
+    uint64_t session_id;
+    int64_t first_response;
+    int64_t last_response;
+    uint64_t offset;
+    uint32_t count;
+    uint32_t valid_count;
+} SessionIndexEntry;
+
+typedef struct {
+    uint64_t index_offset;
+    uint32_t block_count;
+    uint32_t magic;
+} SessionFileFooter;
+
+typedef struct {
+    FILE* file;
+    SessionFileHeader header;
+    uint32_t block_number;      // Block currently being filled
+    bool dirty;
+    SessionIndexEntry* index;
+    uint32_t index_capacity;
+    SessionBlock block;
+} SessionWriter;
+
+typedef struct {
+    PlatformMapping mapping;
+    const SessionFileHeader* header;
+    const SessionIndexEntry* index;    // NULL if the session never closed the file
+    uint32_t block_count;
+    SessionBlock* upgraded;     // Version 1 files only, every block in the current layout
+} SessionFile;
+
+// Writer, used from a single thread
+bool OpenSessionWriter(SessionWriter* writer, FILE* file, uint64_t session_id, int64_t frequency, int64_t start_time, uint64_t seed); // Takes ownership of file
+bool AppendSessionRecord(SessionWriter* writer, const TrialRecord* record);
+bool FlushSessionWriter(SessionWriter* writer);
+bool CloseSessionWriter(SessionWriter* writer);     // Writes the index and footer, closes the file
+
+// Zero-copy reader
+bool OpenSessionFile(SessionFile* session, const char* path);
+void CloseSessionFile(SessionFile* session);
+const SessionBlock* SessionFileBlock(const SessionFile* session, uint32_t block);
+uint32_t FindSessionBlock(const SessionFile* session, int64_t tick);  // First block ending at or after tick, block_count if none
@@ -0,0 +1,85 @@
+#include <stdlib.h>
+#include <string.h>
+#include "spsc_ring.h"
+
+bool InitializeSpscRing(SpscRing* ring, size_t item_size, size_t capacity) {
+    size_t rounded = 1;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+
+    ring->storage = calloc(rounded, item_size);
+    if (!ring->storage) {
+        return false;
+    }
+    ring->item_size = item_size;
+    ring->mask = rounded - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    return true;
+}
+
+void FreeSpscRing(SpscRing* ring) {
+    free(ring->storage);
+    ring->storage = NULL;
+}
+
+bool SpscPush(SpscRing* ring, const void* item) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail > ring->mask) {
+        return false;
+    }
+
+    memcpy(ring->storage + (head & ring->mask) * ring->item_size, item, ring->item_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool SpscPop(SpscRing* ring, void* item) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail == head) {
+        return false;
+    }
+
+    memcpy(item, ring->storage + (tail & ring->mask) * ring->item_size, ring->item_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+size_t SpscPushBatch(SpscRing* ring, const void* items, size_t count) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t space = ring->mask + 1 - (head - tail);
+    if (count > space) {
+        count = space;
+    }
+
+    const unsigned char* source = items;
+    for (size_t i = 0; i < count; i++) {
+        memcpy(ring->storage + ((head + i) & ring->mask) * ring->item_size, source + i * ring->item_size, ring->item_size);
+    }
+    atomic_store_explicit(&ring->head, head + count, memory_order_release); // Publish the whole batch at once
+    return count;
+}
+
+size_t SpscPopBatch(SpscRing* ring, void* items, size_t max_count) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t count = head - tail;
+    if (count > max_count) {
+        count = max_count;
+    }
+
+    unsigned char* destination = items;
+    for (size_t i = 0; i < count; i++) {
+        memcpy(destination + i * ring->item_size, ring->storage + ((tail + i) & ring->mask) * ring->item_size, ring->item_size);
+    }
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+    return count;
+}
+
+size_t SpscSize(SpscRing* ring) {
+    return atomic_load_explicit(&ring->head, memory_order_acquire) - atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
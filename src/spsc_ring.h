@@ -0,0 +1,24 @@
+// Lock-free single-producer/single-consumer ring of fixed-size items
+#pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CACHE_LINE_SIZE 64
+
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t head;   // Next slot to write, owned by the producer
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t tail;   // Next slot to read, owned by the consumer
+    _Alignas(CACHE_LINE_SIZE) unsigned char* storage;
+    size_t item_size;
+    size_t mask;                                    // Capacity - 1, capacity is a power of two
+} SpscRing;
+
+bool InitializeSpscRing(SpscRing* ring, size_t item_size, size_t capacity); // Capacity is rounded up to a power of two
+void FreeSpscRing(SpscRing* ring);
+bool SpscPush(SpscRing* ring, const void* item);   // Returns false when full
+bool SpscPop(SpscRing* ring, void* item);          // Returns false when empty
+size_t SpscPushBatch(SpscRing* ring, const void* items, size_t count);  // Returns how many were pushed
+size_t SpscPopBatch(SpscRing* ring, void* items, size_t max_count);     // Returns how many were popped
+size_t SpscSize(SpscRing* ring);
@@ -0,0 +1,157 @@
+#ifndef _WIN32
+#define _GNU_SOURCE
+#include <time.h>
+#endif
+#include "stimulus_scheduler.h"
+#include "trace.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+// Lock helpers so the worker loop reads the same on both platforms
+#ifdef _WIN32
+static void Lock(StimulusScheduler* scheduler) { AcquireSRWLockExclusive(&scheduler->lock); }
+static void Unlock(StimulusScheduler* scheduler) { ReleaseSRWLockExclusive(&scheduler->lock); }
+static void Wake(StimulusScheduler* scheduler) { SetEvent(scheduler->wake_event); }
+#else
+static void Lock(StimulusScheduler* scheduler) { pthread_mutex_lock(&scheduler->lock); }
+static void Unlock(StimulusScheduler* scheduler) { pthread_mutex_unlock(&scheduler->lock); }
+static void Wake(StimulusScheduler* scheduler) { pthread_cond_signal(&scheduler->wake); }
+#endif
+
+// Sleeps until wake_at (or until woken by arm/cancel/stop). Called with the lock held, returns with it held.
+static void CoarseWait(StimulusScheduler* scheduler, int64_t wake_at) {
+#ifdef _WIN32
+    Unlock(scheduler);
+    if (wake_at == INT64_MAX) {
+        WaitForSingleObject(scheduler->wake_event, INFINITE);
+    } else {
+        int64_t remaining = wake_at - ClockNow();
+        if (remaining > 0) {
+            LARGE_INTEGER due = {.QuadPart = -(remaining * 10000000 / scheduler->frequency)}; // Relative time in 100ns units
+            SetWaitableTimer(scheduler->wait_timer, &due, 0, NULL, NULL, FALSE);
+            HANDLE handles[2] = {scheduler->wake_event, scheduler->wait_timer};
+            WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+            CancelWaitableTimer(scheduler->wait_timer);
+        }
+    }
+    Lock(scheduler);
+#else
+    if (wake_at == INT64_MAX) {
+        pthread_cond_wait(&scheduler->wake, &scheduler->lock);
+    } else {
+        struct timespec ts = {.tv_sec = wake_at / 1000000000, .tv_nsec = wake_at % 1000000000}; // ClockNow is CLOCK_MONOTONIC in ns
+        pthread_cond_timedwait(&scheduler->wake, &scheduler->lock, &ts);
+    }
+#endif
+}
+
+static void SchedulerThread(void* arg) {
+    StimulusScheduler* scheduler = arg;
+    RaiseThreadPriority();
+    TraceThread("Stimulus scheduler");
+
+    Lock(scheduler);
+    while (scheduler->running) {
+        if (!scheduler->armed) {
+            CoarseWait(scheduler, INT64_MAX);
+            continue;
+        }
+
+        int64_t deadline = scheduler->deadline;
+        if (ClockNow() < deadline - scheduler->spin_ticks) {
+            CoarseWait(scheduler, deadline - scheduler->spin_ticks);
+            continue; // Re-check, the deadline may have been moved or cancelled while sleeping
+        }
+
+        // Final approach: busy-wait without the lock so arm/cancel never block behind the spin
+        Unlock(scheduler);
+        int64_t now;
+        while ((now = ClockNow()) < deadline) {
+            CpuRelax();
+        }
+        Lock(scheduler);
+
+        if (scheduler->armed && scheduler->deadline == deadline) {
+            scheduler->armed = false;
+            Unlock(scheduler);
+            TRACE_INSTANT(TRACE_STIMULUS_FIRE, (now - deadline) * 1000000 / scheduler->frequency, 0);
+            scheduler->on_onset(scheduler->context, deadline, now);
+            Lock(scheduler);
+        }
+    }
+    Unlock(scheduler);
+    TraceThreadExit();
+}
+
+bool StartStimulusScheduler(StimulusScheduler* scheduler, int spin_window_us, StimulusCallback on_onset, void* context) {
+    scheduler->frequency = ClockFrequency();
+    scheduler->spin_ticks = MicrosecondsToTicks(spin_window_us, scheduler->frequency);
+    scheduler->deadline = 0;
+    scheduler->armed = false;
+    scheduler->running = true;
+    scheduler->on_onset = on_onset;
+    scheduler->context = context;
+
+#ifdef _WIN32
+    InitializeSRWLock(&scheduler->lock);
+    scheduler->wake_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    // High resolution timers need Windows 10 1803+, fall back to a regular waitable timer (the spin window absorbs the coarser tick)
+    scheduler->wait_timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!scheduler->wait_timer) {
+        scheduler->wait_timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+    }
+    if (!scheduler->wake_event || !scheduler->wait_timer) {
+        return false;
+    }
+#else
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&scheduler->wake, &attributes);
+    pthread_condattr_destroy(&attributes);
+    pthread_mutex_init(&scheduler->lock, NULL);
+#endif
+
+    return StartThread(&scheduler->thread, SchedulerThread, scheduler);
+}
+
+void StopStimulusScheduler(StimulusScheduler* scheduler) {
+    Lock(scheduler);
+    scheduler->running = false;
+    scheduler->armed = false;
+    Wake(scheduler);
+    Unlock(scheduler);
+    JoinThread(&scheduler->thread);
+
+#ifdef _WIN32
+    CloseHandle(scheduler->wait_timer);
+    CloseHandle(scheduler->wake_event);
+#else
+    pthread_cond_destroy(&scheduler->wake);
+    pthread_mutex_destroy(&scheduler->lock);
+#endif
+}
+
+void ArmStimulus(StimulusScheduler* scheduler, int64_t deadline_tick) {
+    Lock(scheduler);
+    scheduler->deadline = deadline_tick;
+    scheduler->armed = true;
+    Wake(scheduler);
+    Unlock(scheduler);
+}
+
+void CancelStimulus(StimulusScheduler* scheduler) {
+    Lock(scheduler);
+    scheduler->armed = false;
+    Wake(scheduler);
+    Unlock(scheduler);
+}
+
+void SetStimulusSpinWindow(StimulusScheduler* scheduler, int spin_window_us) {
+    Lock(scheduler);
+    scheduler->spin_ticks = MicrosecondsToTicks(spin_window_us, scheduler->frequency);
+    Wake(scheduler);
+    Unlock(scheduler);
+}
@@ -0,0 +1,40 @@
+// High resolution stimulus scheduler: coarse sleep followed by a short busy-wait up to the deadline
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "platform.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+// Called on the scheduler thread once the deadline has been reached
+typedef void (*StimulusCallback)(void* context, int64_t scheduled_tick, int64_t onset_tick);
+
+typedef struct {
+    PlatformThread thread;
+#ifdef _WIN32
+    SRWLOCK lock;
+    HANDLE wake_event;    // Signalled on arm/cancel/stop
+    HANDLE wait_timer;    // High resolution waitable timer when available
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+#endif
+    int64_t frequency;
+    int64_t spin_ticks;
+    int64_t deadline;
+    bool armed;
+    bool running;
+
+    StimulusCallback on_onset;
+    void* context;
+} StimulusScheduler;
+
+bool StartStimulusScheduler(StimulusScheduler* scheduler, int spin_window_us, StimulusCallback on_onset, void* context);
+void StopStimulusScheduler(StimulusScheduler* scheduler);
+void ArmStimulus(StimulusScheduler* scheduler, int64_t deadline_tick);  // Replaces any pending deadline
+void CancelStimulus(StimulusScheduler* scheduler);
+void SetStimulusSpinWindow(StimulusScheduler* scheduler, int spin_window_us);  // Takes effect from the next wait
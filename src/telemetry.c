@@ -0,0 +1,222 @@
+#include <string.h>
+#include "telemetry.h"
+
+#define TELEMETRY_READ_ATTEMPTS 64  // A snapshot is a few hundred bytes, the writer is never in it for long
+
+_Static_assert((TELEMETRY_TRIAL_CAPACITY & (TELEMETRY_TRIAL_CAPACITY - 1)) == 0, "Trial ring capacity must be a power of two");
+_Static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "Shared memory needs address-free atomics");
+
+// Seqlock, one writer. The data is copied with plain stores and loads between the sequence updates, the fences
+// order them, and a reader keeps its copy only if the sequence was even and unchanged around it.
+static void BeginWrite(atomic_uint* sequence) {
+    atomic_store_explicit(sequence, atomic_load_explicit(sequence, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void EndWrite(atomic_uint* sequence) {
+    atomic_store_explicit(sequence, atomic_load_explicit(sequence, memory_order_relaxed) + 1, memory_order_release);
+}
+
+static bool ReadSnapshot(const atomic_uint* sequence, const void* data, void* copy, size_t size) {
+    for (int attempt = 0; attempt < TELEMETRY_READ_ATTEMPTS; attempt++) {
+        unsigned before = atomic_load_explicit((atomic_uint*)sequence, memory_order_acquire);
+        if (before & 1) {
+            CpuRelax();
+            continue;
+        }
+        memcpy(copy, data, size);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit((atomic_uint*)sequence, memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ValidTelemetryName(const char* name) { // The same string has to be a Windows object name and a POSIX shm name
+    size_t length = strlen(name);
+    if (length == 0 || length > TELEMETRY_MAX_NAME) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        char c = name[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Writer
+static bool StaleBlock(const char* name) { // Left behind by a tester that crashed or never removed it
+    PlatformSharedMemory memory;
+    if (!OpenSharedMemory(&memory, name, sizeof(TelemetryBlock))) {
+        return false; // Another layout (or gone already), leave it to whoever made it
+    }
+    const TelemetryBlock* block = memory.data;
+    bool stale = atomic_load_explicit((atomic_uint*)&block->magic, memory_order_acquire) == TELEMETRY_MAGIC && // Still being set up otherwise
+        block->version == TELEMETRY_VERSION && (atomic_load_explicit((atomic_uint*)&block->closed, memory_order_acquire) || !ProcessAlive(block->writer_pid));
+    CloseSharedMemory(&memory);
+    return stale;
+}
+
+bool OpenTelemetryWriter(TelemetryWriter* writer, const char* name, int participant_count, uint64_t session_id, uint64_t seed, const DiagnosticsSettings* settings) {
+    writer->block = NULL;
+    if (participant_count < 1 || participant_count > TELEMETRY_MAX_PARTICIPANTS || !ValidTelemetryName(name)) {
+        return false;
+    }
+    if (!CreateSharedMemory(&writer->memory, name, sizeof(TelemetryBlock)) &&
+        !(StaleBlock(name) && RemoveSharedMemory(name) && CreateSharedMemory(&writer->memory, name, sizeof(TelemetryBlock)))) {
+        return false;
+    }
+    TelemetryBlock* block = writer->memory.data; // Zeroed, so every sequence starts even
+    block->writer_pid = CurrentProcessId();
+    block->version = TELEMETRY_VERSION;
+    block->size = sizeof(TelemetryBlock);
+    block->participant_count = (uint32_t)participant_count;
+    block->trial_capacity = TELEMETRY_TRIAL_CAPACITY;
+    block->session_id = session_id;
+    block->seed = seed;
+    block->frequency = settings->frequency;
+    block->flag_ticks = settings->flag_ticks;
+    for (int i = 0; i < MEASURE_COUNT; i++) {
+        block->diagnostics.data.last[i] = -1;
+    }
+    memset(writer->participants, 0, sizeof(writer->participants));
+    atomic_store_explicit(&block->magic, TELEMETRY_MAGIC, memory_order_release);
+    writer->block = block;
+    return true;
+}
+
+void CloseTelemetryWriter(TelemetryWriter* writer) {
+    if (!writer->block) {
+        return;
+    }
+    atomic_store_explicit(&writer->block->closed, 1, memory_order_release);
+    CloseSharedMemory(&writer->memory);
+    writer->block = NULL;
+}
+
+void PublishParticipant(TelemetryWriter* writer, int participant, const ReactionEngine* engine, int64_t now) {
+    if (!writer->block || participant < 0 || (uint32_t)participant >= writer->block->participant_count) {
+        return;
+    }
+    TelemetryParticipant* data = &writer->participants[participant];
+    data->updated = now;
+    data->state = (uint32_t)engine->state.game_state;
+    if (data->trials != engine->state.trial_iteration) { // Only after a valid trial, keeps the stimulus path to one copy
+        const RollingSummary* summary = &engine->data.rolling.summary;
+        const LatencyHistogram* histogram = &engine->data.session_histogram;
+        data->trials = engine->state.trial_iteration;
+        data->last_ms = engine->data.reaction_time_value;
+        data->rolling_count = (uint32_t)summary->count;
+        data->rolling_mean_ms = summary->mean;
+        data->rolling_sd_ms = summary->sd;
+        data->rolling_min_ms = summary->min;
+        data->rolling_max_ms = summary->max;
+        data->rolling_median_ms = summary->median;
+        data->rolling_p90_ms = summary->p90;
+        data->session_p50_ms = TicksToMilliseconds(LatencyPercentile(histogram, 50), engine->data.frequency);
+        data->session_p90_ms = TicksToMilliseconds(LatencyPercentile(histogram, 90), engine->data.frequency);
+        data->session_p99_ms = TicksToMilliseconds(LatencyPercentile(histogram, 99), engine->data.frequency);
+    }
+
+    TelemetryParticipantSlot* slot = &writer->block->participants[participant];
+    BeginWrite(&slot->sequence);
+    memcpy(&slot->data, data, sizeof(*data));
+    EndWrite(&slot->sequence);
+}
+
+void PublishTrial(TelemetryWriter* writer, int participant, const TrialRecord* record) {
+    if (!writer->block || participant < 0 || (uint32_t)participant >= writer->block->participant_count) {
+        return;
+    }
+    writer->participants[participant].early_presses += record->outcome == TRIAL_EARLY; // Goes out with the state change that follows
+
+    TelemetryBlock* block = writer->block;
+    uint64_t index = atomic_load_explicit(&block->trials_written, memory_order_relaxed);
+    TelemetryTrialSlot* slot = &block->trials[index & (TELEMETRY_TRIAL_CAPACITY - 1)];
+    BeginWrite(&slot->sequence);
+    slot->data = (TelemetryTrial){.index = index, .participant = (uint32_t)participant, .record = *record};
+    EndWrite(&slot->sequence);
+    atomic_store_explicit(&block->trials_written, index + 1, memory_order_release);
+}
+
+void PublishDiagnostics(TelemetryWriter* writer, const LatencyDiagnostics* diagnostics) {
+    if (!writer->block) {
+        return;
+    }
+    TelemetryDiagnosticsSlot* slot = &writer->block->diagnostics;
+    BeginWrite(&slot->sequence);
+    memcpy(slot->data.last, diagnostics->last, sizeof(slot->data.last));
+    slot->data.trials = diagnostics->trials;
+    slot->data.flagged = diagnostics->flagged;
+    EndWrite(&slot->sequence);
+}
+
+// Reader
+bool OpenTelemetryReader(TelemetryReader* reader, const char* name) {
+    reader->block = NULL;
+    if (!ValidTelemetryName(name) || !OpenSharedMemory(&reader->memory, name, sizeof(TelemetryBlock))) {
+        return false;
+    }
+    const TelemetryBlock* block = reader->memory.data;
+    if (atomic_load_explicit((atomic_uint*)&block->magic, memory_order_acquire) != TELEMETRY_MAGIC || block->version != TELEMETRY_VERSION ||
+        block->size != sizeof(TelemetryBlock) || block->trial_capacity != TELEMETRY_TRIAL_CAPACITY) {
+        CloseSharedMemory(&reader->memory);
+        return false;
+    }
+    reader->block = block;
+    if (TelemetryClosed(reader)) { // Left behind by a crash, nothing will ever be published there
+        CloseTelemetryReader(reader);
+        return false;
+    }
+    uint64_t written = atomic_load_explicit((_Atomic uint64_t*)&block->trials_written, memory_order_acquire);
+    reader->next_trial = written > TELEMETRY_TRIAL_CAPACITY ? written - TELEMETRY_TRIAL_CAPACITY : 0; // Whatever is still in the ring
+    return true;
+}
+
+void CloseTelemetryReader(TelemetryReader* reader) {
+    if (reader->block) {
+        CloseSharedMemory(&reader->memory);
+        reader->block = NULL;
+    }
+}
+
+bool TelemetryClosed(const TelemetryReader* reader) { // Or crashed, the block then stays until a new tester replaces it
+    return atomic_load_explicit((atomic_uint*)&reader->block->closed, memory_order_acquire) != 0 || !ProcessAlive(reader->block->writer_pid);
+}
+
+bool ReadTelemetryParticipant(const TelemetryReader* reader, int participant, TelemetryParticipant* participant_out) {
+    if (participant < 0 || (uint32_t)participant >= reader->block->participant_count) {
+        return false;
+    }
+    const TelemetryParticipantSlot* slot = &reader->block->participants[participant];
+    return ReadSnapshot(&slot->sequence, &slot->data, participant_out, sizeof(*participant_out));
+}
+
+bool ReadTelemetryDiagnostics(const TelemetryReader* reader, TelemetryDiagnostics* diagnostics) {
+    const TelemetryDiagnosticsSlot* slot = &reader->block->diagnostics;
+    return ReadSnapshot(&slot->sequence, &slot->data, diagnostics, sizeof(*diagnostics));
+}
+
+uint32_t ReadTelemetryTrials(TelemetryReader* reader, TelemetryTrial* trials, uint32_t max_count, uint64_t* lost) {
+    const TelemetryBlock* block = reader->block;
+    uint64_t written = atomic_load_explicit((_Atomic uint64_t*)&block->trials_written, memory_order_acquire);
+    *lost = 0;
+    if (written - reader->next_trial > TELEMETRY_TRIAL_CAPACITY) { // Lapped, the oldest are gone
+        *lost = written - TELEMETRY_TRIAL_CAPACITY - reader->next_trial;
+        reader->next_trial = written - TELEMETRY_TRIAL_CAPACITY;
+    }
+
+    uint32_t count = 0;
+    for (; reader->next_trial < written && count < max_count; reader->next_trial++) {
+        const TelemetryTrialSlot* slot = &block->trials[reader->next_trial & (TELEMETRY_TRIAL_CAPACITY - 1)];
+        if (ReadSnapshot(&slot->sequence, &slot->data, &trials[count], sizeof(trials[count])) && trials[count].index == reader->next_trial) {
+            count++;
+        } else { // Being overwritten by a newer trial since the load above
+            (*lost)++;
+        }
+    }
+    return count;
+}
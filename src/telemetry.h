@@ -0,0 +1,118 @@
+// Live session telemetry in named shared memory, for dashboards that watch a running tester.
+//
+// The tester only ever writes: every participant and the pipeline diagnostics are a seqlocked snapshot, finished
+// trials go into a broadcast ring where each slot has its own sequence. Readers map the block read-only, copy and
+// retry if a sequence moved under them, and detect ring overruns from the trial index, so no number of readers can
+// block, slow or corrupt the tester. A reader that falls more than TELEMETRY_TRIAL_CAPACITY trials behind loses
+// the oldest ones and is told how many.
+#pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "latency_diagnostics.h"
+#include "platform.h"
+#include "reaction_engine.h"
+
+#define TELEMETRY_MAGIC 0x4D4C5452u            // "RTLM", stored last so a reader never sees a half-built block
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_MAX_NAME 64                  // Letters, digits, - and _ only
+#define TELEMETRY_MAX_PARTICIPANTS 32
+#define TELEMETRY_TRIAL_CAPACITY 256           // Power of two
+
+// One participant (the whole window, or one lane), what the result screen shows
+typedef struct {
+    int64_t updated;            // Tick of the last state change
+    uint32_t state;             // GameState
+    int32_t trials;             // Valid trials so far
+    uint32_t early_presses;
+    uint32_t rolling_count;     // Trials in the rolling window, the rolling fields are 0 until there are some
+    double last_ms;
+    double rolling_mean_ms;
+    double rolling_sd_ms;
+    double rolling_min_ms;
+    double rolling_max_ms;
+    double rolling_median_ms;
+    double rolling_p90_ms;
+    double session_p50_ms;      // Whole session, from the engine's histogram
+    double session_p90_ms;
+    double session_p99_ms;
+} TelemetryParticipant;
+
+typedef struct {
+    int64_t last[MEASURE_COUNT]; // Ticks, -1 = not measured yet
+    uint64_t trials;
+    uint64_t flagged;
+} TelemetryDiagnostics;
+
+typedef struct {
+    uint64_t index;             // Position in the stream, 0 for the first trial of the session
+    uint32_t participant;
+    uint32_t reserved;
+    TrialRecord record;         // Raw ticks, MeasureTrial gives the pipeline measures
+} TelemetryTrial;
+
+typedef struct {
+    _Alignas(64) atomic_uint sequence;  // Odd while the writer is in the middle of an update
+    TelemetryParticipant data;
+} TelemetryParticipantSlot;
+
+typedef struct {
+    _Alignas(64) atomic_uint sequence;
+    TelemetryDiagnostics data;
+} TelemetryDiagnosticsSlot;
+
+typedef struct {
+    _Alignas(64) atomic_uint sequence;
+    TelemetryTrial data;
+} TelemetryTrialSlot;
+
+// The shared block, fixed layout. Readers check magic, version and size before using anything else.
+typedef struct {
+    atomic_uint magic;
+    uint32_t version;
+    uint32_t size;              // sizeof(TelemetryBlock)
+    uint32_t participant_count;
+    uint32_t trial_capacity;
+    uint32_t writer_pid;        // The publishing tester, a new one only takes the name over once this process is gone
+    uint64_t session_id;
+    uint64_t seed;
+    int64_t frequency;          // Ticks per second, same clock for every process on the machine
+    int64_t flag_ticks;         // DiagnosticsFlagThreshold, for MeasureTrial on the reader side
+    atomic_uint closed;         // Set when the tester shuts down, a new session publishes a new block
+    _Alignas(64) _Atomic uint64_t trials_written;
+    TelemetryDiagnosticsSlot diagnostics;
+    TelemetryParticipantSlot participants[TELEMETRY_MAX_PARTICIPANTS];
+    TelemetryTrialSlot trials[TELEMETRY_TRIAL_CAPACITY];
+} TelemetryBlock;
+
+// Writer, owned by the UI thread. Every call is a no-op while the writer is not open.
+typedef struct {
+    PlatformSharedMemory memory;
+    TelemetryBlock* block;
+    TelemetryParticipant participants[TELEMETRY_MAX_PARTICIPANTS]; // Last published, the session percentiles are only redone after a trial
+} TelemetryWriter;
+
+bool ValidTelemetryName(const char* name);
+// False if another live tester publishes under name. A block left behind by a crashed one is replaced (not on Windows,
+// where it only outlives its tester while a reader still has it open).
+bool OpenTelemetryWriter(TelemetryWriter* writer, const char* name, int participant_count, uint64_t session_id, uint64_t seed, const DiagnosticsSettings* settings);
+void CloseTelemetryWriter(TelemetryWriter* writer);
+void PublishParticipant(TelemetryWriter* writer, int participant, const ReactionEngine* engine, int64_t now); // After a state change
+void PublishTrial(TelemetryWriter* writer, int participant, const TrialRecord* record);
+void PublishDiagnostics(TelemetryWriter* writer, const LatencyDiagnostics* diagnostics);
+
+// Reader, any number per block, in any process
+typedef struct {
+    PlatformSharedMemory memory;
+    const TelemetryBlock* block;
+    uint64_t next_trial;        // Stream index of the next trial ReadTelemetryTrials returns
+} TelemetryReader;
+
+bool OpenTelemetryReader(TelemetryReader* reader, const char* name); // False if nothing live is published under name, or another layout
+void CloseTelemetryReader(TelemetryReader* reader);
+bool TelemetryClosed(const TelemetryReader* reader); // The tester shut down or its process is gone
+// False if the snapshot kept changing for a few attempts (the writer never waits, so try again later)
+bool ReadTelemetryParticipant(const TelemetryReader* reader, int participant, TelemetryParticipant* participant_out);
+bool ReadTelemetryDiagnostics(const TelemetryReader* reader, TelemetryDiagnostics* diagnostics);
+// New trials since the last call, oldest first. lost = trials overwritten before they could be read.
+uint32_t ReadTelemetryTrials(TelemetryReader* reader, TelemetryTrial* trials, uint32_t max_count, uint64_t* lost);
@@ -0,0 +1,164 @@
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+
+#if TRACE_ENABLED
+typedef struct {
+    const char* name;
+    const char* args[2];        // NULL = not shown
+} TraceEventInfo;
+
+static const TraceEventInfo TRACE_EVENTS[TRACE_EVENT_COUNT] = {
+    [TRACE_HANDLE_INPUT] = {"HandleInput", {"is_mouse"}},
+    [TRACE_TIMER_LOGIC] = {"TimerStateLogic", {"timer"}},
+    [TRACE_STIMULUS_ONSET] = {"StimulusOnset", {"lateness_us"}},
+    [TRACE_STATE] = {"State", {"from", "to"}},
+    [TRACE_TRIAL] = {"Trial", {"trial", "outcome"}},
+    [TRACE_STIMULUS_FIRE] = {"StimulusFire", {"lateness_us"}},
+    [TRACE_INPUT_CAPTURED] = {"InputCaptured", {"events"}},
+    [TRACE_RAW_INPUT] = {"WM_INPUT", {"message_delay_ms"}},
+    [TRACE_INPUT_DRAIN] = {"DrainInputEvents", {NULL}},
+    [TRACE_PAINT] = {"WM_PAINT", {"state"}},
+    [TRACE_TIMER_FIRE] = {"WM_TIMER", {"timer"}},
+    [TRACE_LOG_WRITE] = {"LogWrite", {"bytes"}},
+    [TRACE_CONFIG_RELOAD] = {"ReloadConfig", {"groups"}}
+};
+
+typedef struct {
+    const char* name;
+    TraceRing* ring;
+    atomic_bool in_use;         // A live thread owns the ring
+    atomic_bool ready;          // name and ring are set, the dump may read them
+} TraceSlot;
+
+_Thread_local TraceRing* trace_ring;
+atomic_bool trace_enabled;
+static TraceSlot trace_slots[TRACE_MAX_THREADS];
+static atomic_int trace_slot_count;
+
+void TraceThread(const char* name) {
+    int count = atomic_load(&trace_slot_count);
+    for (int i = 0; i < count && i < TRACE_MAX_THREADS; i++) { // A thread that was restarted picks up where it left off
+        TraceSlot* slot = &trace_slots[i];
+        bool expected = false;
+        if (atomic_load(&slot->ready) && !strcmp(slot->name, name) && atomic_compare_exchange_strong(&slot->in_use, &expected, true)) {
+            trace_ring = slot->ring;
+            return;
+        }
+    }
+
+    int index = atomic_fetch_add(&trace_slot_count, 1);
+    if (index >= TRACE_MAX_THREADS) {
+        return; // Out of slots, this thread is not traced
+    }
+    TraceRing* ring = calloc(1, sizeof(TraceRing));
+    if (!ring) {
+        return;
+    }
+    TraceSlot* slot = &trace_slots[index];
+    slot->name = name;
+    slot->ring = ring;
+    atomic_store(&slot->in_use, true);
+    atomic_store(&slot->ready, true);
+    trace_ring = ring;
+}
+
+void TraceThreadExit(void) {
+    int count = atomic_load(&trace_slot_count);
+    for (int i = 0; i < count && i < TRACE_MAX_THREADS; i++) {
+        if (atomic_load(&trace_slots[i].ready) && trace_slots[i].ring == trace_ring) {
+            atomic_store(&trace_slots[i].in_use, false);
+        }
+    }
+    trace_ring = NULL;
+}
+
+void SetTraceEnabled(bool enabled) {
+    atomic_store(&trace_enabled, enabled);
+}
+
+static int64_t OldestTick(void) { // Timestamps are written relative to the oldest entry still around
+    int64_t oldest = INT64_MAX;
+    int count = atomic_load(&trace_slot_count);
+    for (int i = 0; i < count && i < TRACE_MAX_THREADS; i++) {
+        if (!atomic_load(&trace_slots[i].ready)) continue;
+        const TraceRing* ring = trace_slots[i].ring;
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (head == 0) continue;
+        uint64_t first = head > TRACE_RING_CAPACITY ? head - TRACE_RING_CAPACITY + 1 : 0; // +1, the writer may be on the oldest one
+        int64_t tick = ring->entries[first & (TRACE_RING_CAPACITY - 1)].tick;
+        if (tick < oldest) oldest = tick;
+    }
+    return oldest == INT64_MAX ? 0 : oldest;
+}
+
+static void WriteEntry(FILE* file, const TraceEntry* entry, int tid, int64_t base, double us_per_tick, bool* first) {
+    if (entry->event >= TRACE_EVENT_COUNT) {
+        return;
+    }
+    const TraceEventInfo* info = &TRACE_EVENTS[entry->event];
+    fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d", *first ? "" : ",", info->name, entry->phase,
+        (double)(entry->tick - base) * us_per_tick, tid);
+    if (entry->phase == 'i') {
+        fputs(",\"s\":\"t\"", file);
+    }
+    if (entry->phase != 'E' && info->args[0]) {
+        fprintf(file, ",\"args\":{\"%s\":%lld", info->args[0], (long long)entry->args[0]);
+        if (info->args[1]) fprintf(file, ",\"%s\":%lld", info->args[1], (long long)entry->args[1]);
+        fputc('}', file);
+    }
+    fputc('}', file);
+    *first = false;
+}
+
+bool WriteTrace(FILE* file) {
+    TraceEntry* copy = malloc(TRACE_RING_CAPACITY * sizeof(TraceEntry));
+    if (!copy) {
+        return false;
+    }
+    int64_t base = OldestTick();
+    double us_per_tick = 1e6 / (double)ClockFrequency();
+    bool first = true;
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+
+    int count = atomic_load(&trace_slot_count);
+    for (int i = 0; i < count && i < TRACE_MAX_THREADS; i++) {
+        const TraceSlot* slot = &trace_slots[i];
+        if (!atomic_load(&slot->ready)) continue;
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", first ? "" : ",", i + 1, slot->name);
+        first = false;
+
+        // Copy first, then drop whatever the writer may have overwritten while we were copying
+        uint64_t head = atomic_load_explicit(&slot->ring->head, memory_order_acquire);
+        uint64_t start = head > TRACE_RING_CAPACITY ? head - TRACE_RING_CAPACITY : 0;
+        for (uint64_t n = start; n < head; n++) {
+            copy[n - start] = slot->ring->entries[n & (TRACE_RING_CAPACITY - 1)];
+        }
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t after = atomic_load_explicit(&slot->ring->head, memory_order_relaxed);
+        uint64_t valid = after >= TRACE_RING_CAPACITY && after - TRACE_RING_CAPACITY + 1 > start ? after - TRACE_RING_CAPACITY + 1 : start;
+        for (uint64_t n = valid; n < head; n++) {
+            WriteEntry(file, &copy[n - start], i + 1, base, us_per_tick, &first);
+        }
+    }
+    fputs("\n]}\n", file);
+    free(copy);
+    return !ferror(file);
+}
+#else
+void TraceThread(const char* name) {
+    (void)name;
+}
+
+void TraceThreadExit(void) {
+}
+
+void SetTraceEnabled(bool enabled) {
+    (void)enabled;
+}
+
+bool WriteTrace(FILE* file) {
+    (void)file;
+    return false;
+}
+#endif
@@ -0,0 +1,83 @@
+// Trace events for the whole trial lifecycle, dumped as Chrome trace-event JSON (chrome://tracing, Perfetto).
+//
+// Every thread that traces registers once and gets its own ring of fixed-size entries (tick, event, two args).
+// Recording is a thread-local load, a clock read and a 32-byte store with no locks or atomics beyond a release
+// store of the head, so the rings always hold the most recent TRACE_RING_CAPACITY events of each thread.
+// Build with TRACE_ENABLED=0 (make TRACE=0) to compile every TRACE_* macro out.
+#pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "platform.h"
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#define TRACE_RING_CAPACITY (1 << 14)   // Entries per thread, a power of two
+#define TRACE_MAX_THREADS 16
+
+typedef enum {
+    TRACE_HANDLE_INPUT,         // Engine input handling, arg = is_mouse
+    TRACE_TIMER_LOGIC,          // Engine timer handling, arg = timer id
+    TRACE_STIMULUS_ONSET,       // Engine onset handling, arg = scheduler lateness in us
+    TRACE_STATE,                // Game state change, args = from, to
+    TRACE_TRIAL,                // Trial finished, args = trial, outcome
+    TRACE_STIMULUS_FIRE,        // Scheduler released the onset, arg = lateness in us
+    TRACE_INPUT_CAPTURED,       // Capture thread read raw input, arg = events
+    TRACE_RAW_INPUT,            // WM_INPUT on the UI thread, arg = message delay in ms
+    TRACE_INPUT_DRAIN,          // UI thread draining the capture ring
+    TRACE_PAINT,                // WM_PAINT, arg = game state
+    TRACE_TIMER_FIRE,           // WM_TIMER, arg = timer id
+    TRACE_LOG_WRITE,            // Trial logger flush, arg = bytes
+    TRACE_CONFIG_RELOAD,        // user.cfg reload, arg = changed groups
+    TRACE_EVENT_COUNT
+} TraceEventId;
+
+typedef struct {
+    int64_t tick;
+    int64_t args[2];
+    uint16_t event;             // TraceEventId
+    char phase;                 // 'B'egin, 'E'nd or 'i'nstant
+    uint8_t padding[5];
+} TraceEntry;
+
+typedef struct {
+    atomic_uint_fast64_t head;  // Entries written so far, the ring holds the last TRACE_RING_CAPACITY
+    TraceEntry entries[TRACE_RING_CAPACITY];
+} TraceRing;
+
+// Setup. TraceThread is called once at the top of each thread that traces, events from other threads are dropped.
+void TraceThread(const char* name);    // Name must outlive the process (a literal)
+void TraceThreadExit(void);            // Lets a restarted thread of the same name reuse the ring
+void SetTraceEnabled(bool enabled);    // Runtime switch, off by default
+bool WriteTrace(FILE* file);           // JSON of everything still in the rings, safe while other threads keep tracing
+
+#if TRACE_ENABLED
+extern _Thread_local TraceRing* trace_ring;
+extern atomic_bool trace_enabled;
+
+static inline void TraceRecord(TraceEventId event, char phase, int64_t arg0, int64_t arg1) {
+    TraceRing* ring = trace_ring;
+    if (!ring || !atomic_load_explicit(&trace_enabled, memory_order_relaxed)) {
+        return;
+    }
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed); // Only this thread writes it
+    TraceEntry* entry = &ring->entries[head & (TRACE_RING_CAPACITY - 1)];
+    entry->tick = ClockNow();
+    entry->args[0] = arg0;
+    entry->args[1] = arg1;
+    entry->event = (uint16_t)event;
+    entry->phase = phase;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+#define TRACE_BEGIN(event, arg) TraceRecord((event), 'B', (arg), 0)
+#define TRACE_END(event) TraceRecord((event), 'E', 0, 0)
+#define TRACE_INSTANT(event, arg0, arg1) TraceRecord((event), 'i', (arg0), (arg1))
+#else
+#define TRACE_BEGIN(event, arg) ((void)0)
+#define TRACE_END(event) ((void)0)
+#define TRACE_INSTANT(event, arg0, arg1) ((void)0)
+#endif
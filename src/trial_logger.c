@@ -0,0 +1,123 @@
+#include "trial_logger.h"
+#include "trace.h"
+
+static void FlushBuffer(TrialLogger* logger) {
+    if (logger->session) {
+        FlushSessionWriter(logger->session);
+    }
+    if (logger->buffer_used) {
+        TRACE_BEGIN(TRACE_LOG_WRITE, (int64_t)logger->buffer_used);
+        fwrite(logger->buffer, 1, logger->buffer_used, logger->file);
+        fflush(logger->file);
+        logger->buffer_used = 0;
+        TRACE_END(TRACE_LOG_WRITE);
+    }
+}
+
+static void FormatRecord(TrialLogger* logger, const TrialRecord* record) {
+    if (logger->session) {
+        AppendSessionRecord(logger->session, record); // Every trial, early presses included
+    }
+    if (!logger->file || record->outcome != TRIAL_VALID) {
+        return; // The text format only lists valid trials
+    }
+    if (TRIAL_LOG_BUFFER_SIZE - logger->buffer_used < 256) {
+        FlushBuffer(logger);
+    }
+
+    char* line = logger->buffer + logger->buffer_used;
+    size_t room = TRIAL_LOG_BUFFER_SIZE - logger->buffer_used;
+    int length = snprintf(line, room, "Trial %d: %f", record->trial, record->reaction_time_ms);
+    if (length > 0 && logger->diagnostics_enabled) {
+        int64_t measures[TRIAL_MEASURE_COUNT];
+        bool flagged = MeasureTrial(record, &logger->diagnostics, measures);
+        length += snprintf(line + length, room - length, " |");
+        for (int i = 0; i < TRIAL_MEASURE_COUNT; i++) {
+            if (measures[i] < 0) {
+                length += snprintf(line + length, room - length, " %s -", PIPELINE_MEASURE_NAMES[i]);
+            } else {
+                length += snprintf(line + length, room - length, " %s %.3f", PIPELINE_MEASURE_NAMES[i], TicksToMilliseconds(measures[i], logger->diagnostics.frequency));
+            }
+        }
+        length += snprintf(line + length, room - length, " ms%s", flagged ? " FLAGGED" : "");
+    }
+    if (length > 0) {
+        length += snprintf(line + length, room - length, "\n");
+        logger->buffer_used += (size_t)length;
+    }
+}
+
+static void DrainRecords(TrialLogger* logger) {
+    TrialRecord records[64];
+    size_t count;
+    while ((count = SpscPopBatch(&logger->ring, records, 64)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            FormatRecord(logger, &records[i]);
+        }
+    }
+}
+
+static void LoggerThread(void* arg) {
+    TrialLogger* logger = arg;
+    TraceThread("Trial logger");
+
+    while (atomic_load(&logger->running)) {
+        WaitEvent(&logger->wake, atomic_load(&logger->flush_interval_ms));
+        DrainRecords(logger);
+        FlushBuffer(logger);
+    }
+    DrainRecords(logger); // Anything pushed before StopTrialLogger
+    FlushBuffer(logger);
+    TraceThreadExit();
+}
+
+bool StartTrialLogger(TrialLogger* logger, FILE* file, SessionWriter* session, int flush_interval_ms, const DiagnosticsSettings* diagnostics) {
+    if (!InitializeSpscRing(&logger->ring, sizeof(TrialRecord), TRIAL_LOG_RING_CAPACITY)) {
+        return false;
+    }
+    if (!InitializeEvent(&logger->wake)) {
+        FreeSpscRing(&logger->ring);
+        return false;
+    }
+
+    logger->file = file;
+    logger->session = session;
+    logger->diagnostics_enabled = diagnostics != NULL;
+    if (diagnostics) logger->diagnostics = *diagnostics;
+    atomic_init(&logger->flush_interval_ms, flush_interval_ms);
+    logger->buffer_used = 0;
+    atomic_init(&logger->dropped, 0);
+    atomic_init(&logger->running, true);
+
+    if (!StartThread(&logger->thread, LoggerThread, logger)) {
+        DestroyEvent(&logger->wake);
+        FreeSpscRing(&logger->ring);
+        return false;
+    }
+    return true;
+}
+
+bool LogTrial(TrialLogger* logger, const TrialRecord* record) {
+    if (!SpscPush(&logger->ring, record)) {
+        atomic_fetch_add(&logger->dropped, 1);
+        return false;
+    }
+    return true;
+}
+
+void SetTrialLogFlushInterval(TrialLogger* logger, int flush_interval_ms) {
+    atomic_store(&logger->flush_interval_ms, flush_interval_ms);
+}
+
+void StopTrialLogger(TrialLogger* logger) {
+    if (!atomic_exchange(&logger->running, false)) {
+        return; // Already stopped (or never started)
+    }
+    SignalEvent(&logger->wake);
+    JoinThread(&logger->thread);
+
+    if (logger->file) fclose(logger->file);
+    if (logger->session) CloseSessionWriter(logger->session);
+    DestroyEvent(&logger->wake);
+    FreeSpscRing(&logger->ring);
+}
@@ -0,0 +1,35 @@
+// Asynchronous trial logger: the game thread pushes fixed-size records into a lock-free ring,
+// a background thread formats them and writes to disk in batches (text log and/or binary session file)
+#pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "latency_diagnostics.h"
+#include "platform.h"
+#include "reaction_engine.h"
+#include "session_file.h"
+#include "spsc_ring.h"
+
+#define TRIAL_LOG_RING_CAPACITY 4096
+#define TRIAL_LOG_BUFFER_SIZE (64 * 1024)
+
+typedef struct {
+    SpscRing ring;                  // TrialRecord
+    PlatformThread thread;
+    PlatformEvent wake;             // Only signaled on shutdown, the producer never makes a syscall
+    FILE* file;                     // Text log, may be NULL
+    SessionWriter* session;         // Binary session file, may be NULL
+    bool diagnostics_enabled;       // Pipeline measures appended to each text line
+    DiagnosticsSettings diagnostics;
+    atomic_int flush_interval_ms;
+    atomic_bool running;
+    atomic_uint dropped;            // Records lost because the ring was full
+    size_t buffer_used;
+    char buffer[TRIAL_LOG_BUFFER_SIZE];
+} TrialLogger;
+
+// Takes ownership of both outputs. With diagnostics, text lines read "Trial N: value | input .. onset .. handoff .. paint .. ms [FLAGGED]".
+bool StartTrialLogger(TrialLogger* logger, FILE* file, SessionWriter* session, int flush_interval_ms, const DiagnosticsSettings* diagnostics);
+bool LogTrial(TrialLogger* logger, const TrialRecord* record);                   // Never blocks, single producer
+void SetTrialLogFlushInterval(TrialLogger* logger, int flush_interval_ms);        // Applies after the current wait
+void StopTrialLogger(TrialLogger* logger);                                       // Drains, flushes and closes the outputs
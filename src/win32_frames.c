@@ -0,0 +1,84 @@
+#define UNICODE
+#define _UNICODE
+#include "win32_frames.h"
+
+static void FreeFrame(FrameCache* cache, int frame) {
+    if (cache->dc[frame]) {
+        SelectObject(cache->dc[frame], cache->original_bitmap[frame]);
+        DeleteDC(cache->dc[frame]);
+        cache->dc[frame] = NULL;
+    }
+    if (cache->bitmap[frame]) {
+        DeleteObject(cache->bitmap[frame]);
+        cache->bitmap[frame] = NULL;
+    }
+}
+
+void FreeFrameCache(FrameCache* cache) {
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        FreeFrame(cache, i);
+    }
+    cache->width = 0;
+    cache->height = 0;
+}
+
+bool ResizeFrameCache(FrameCache* cache, HDC reference, int width, int height) {
+    if (width < 1) width = 1; // Minimized windows report 0x0
+    if (height < 1) height = 1;
+    InvalidateFrames(cache);
+    if (width == cache->width && height == cache->height && cache->dc[0]) {
+        return true;
+    }
+    FreeFrameCache(cache);
+
+    BITMAPINFO info = {0};
+    info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    info.bmiHeader.biWidth = width;
+    info.bmiHeader.biHeight = -height; // Top-down, same row order as the window
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;    // Matches any desktop the compositor runs, so BitBlt is a plain copy
+    info.bmiHeader.biCompression = BI_RGB;
+
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        void* bits;
+        cache->dc[i] = CreateCompatibleDC(reference);
+        cache->bitmap[i] = cache->dc[i] ? CreateDIBSection(reference, &info, DIB_RGB_COLORS, &bits, NULL, 0) : NULL;
+        if (!cache->bitmap[i]) {
+            FreeFrameCache(cache);
+            return false;
+        }
+        cache->original_bitmap[i] = SelectObject(cache->dc[i], cache->bitmap[i]);
+    }
+    cache->width = width;
+    cache->height = height;
+    return true;
+}
+
+void InvalidateFrame(FrameCache* cache, GameState state) {
+    cache->stale[state] = true;
+}
+
+void InvalidateFrames(FrameCache* cache) {
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        cache->stale[i] = true;
+    }
+}
+
+void PrepareFrame(FrameCache* cache, GameState state) {
+    if (!cache->stale[state] || !cache->dc[state]) {
+        return;
+    }
+    RECT rect = {0, 0, cache->width, cache->height};
+    cache->render(cache->dc[state], &rect, state, cache->context);
+    GdiFlush(); // GDI batches calls per thread, make sure the pixels are in the DIB before the next blit
+    cache->stale[state] = false;
+}
+
+void PresentFrame(FrameCache* cache, GameState state, HDC hdc, const RECT* area) {
+    PrepareFrame(cache, state);
+    if (!cache->dc[state]) {
+        return;
+    }
+    BitBlt(hdc, area->left, area->top, area->right - area->left, area->bottom - area->top, cache->dc[state],
+        area->left - cache->origin.x, area->top - cache->origin.y, SRCCOPY);
+}
@@ -0,0 +1,32 @@
+// Pre-rendered state frames: one offscreen DIB section per game state, so WM_PAINT is a single BitBlt.
+// A frame is drawn through the render callback only when it is stale (resize, config change, new text on
+// the result screens) and the react frame, which has no text, is drawn ahead of time. Showing the stimulus
+// costs one blit with no erase pass and no text layout.
+#pragma once
+#include <windows.h>
+#include <stdbool.h>
+#include "reaction_engine.h"
+
+#define FRAME_COUNT STATE_COUNT
+
+typedef void (*FrameRenderer)(HDC hdc, const RECT* rect, GameState state, void* context);
+
+typedef struct {
+    HDC dc[FRAME_COUNT];                // Memory DCs, each keeps its bitmap selected for its whole life
+    HBITMAP bitmap[FRAME_COUNT];
+    HGDIOBJ original_bitmap[FRAME_COUNT];
+    bool stale[FRAME_COUNT];
+    int width;
+    int height;
+    POINT origin;                       // Window position of the frame's top left corner, set for frames smaller than the window
+    FrameRenderer render;
+    void* context;
+} FrameCache;
+
+// Set render (and context) in the initializer, there are no surfaces until the first resize
+void FreeFrameCache(FrameCache* cache);
+bool ResizeFrameCache(FrameCache* cache, HDC reference, int width, int height);     // Marks every frame stale
+void InvalidateFrame(FrameCache* cache, GameState state);
+void InvalidateFrames(FrameCache* cache);
+void PrepareFrame(FrameCache* cache, GameState state);  // Renders it now if stale, e.g. the react frame while READY
+void PresentFrame(FrameCache* cache, GameState state, HDC hdc, const RECT* area); // Blits area (window coordinates), renders first if stale
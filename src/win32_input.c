@@ -0,0 +1,188 @@
+#define UNICODE
+#define _UNICODE
+#include "win32_input.h"
+#include "trace.h"
+
+#define INPUT_THREAD_CLASS_NAME L"ReactionTimeTesterInput"
+
+static void PublishBatch(InputThread* input) {
+    InputEventBatch* batch = &input->batch;
+    if (!batch->count) {
+        return;
+    }
+
+    size_t pushed = SpscPushBatch(&input->ring, batch->events, batch->count);
+    if (pushed < batch->count) {
+        atomic_fetch_add(&input->dropped, (unsigned)(batch->count - pushed));
+    }
+    batch->count = 0;
+    if (pushed && !atomic_exchange(&input->notify_pending, true)) { // Only wake the UI thread once per drain
+        PostMessageW(input->notify_hwnd, input->notify_message, 0, 0);
+    }
+}
+
+static void AddRawInput(InputThread* input, const RAWINPUT* raw, int64_t arrival_tick, uint32_t message_delay_ms) {
+    InputEventBatch* batch = &input->batch;
+    if (batch->count == INPUT_BATCH_CAPACITY) {
+        PublishBatch(input);
+    }
+    if (RawInputToEvent(raw, arrival_tick, message_delay_ms, &batch->events[batch->count])) {
+        batch->count++;
+    }
+}
+
+static void DrainRawInputBuffer(InputThread* input) { // Reads every queued raw input in as few calls as possible
+    UINT events = 0;
+
+    for (;;) {
+        UINT size = RAW_INPUT_BUFFER_SIZE;
+        UINT count = GetRawInputBuffer((PRAWINPUT)input->raw_buffer, &size, sizeof(RAWINPUTHEADER));
+        if (count == 0 || count == (UINT)-1) {
+            break;
+        }
+        int64_t arrival_tick = ClockNow(); // Per read, later reads can pick up input that arrived while we were busy
+        events += count;
+
+        PRAWINPUT raw = (PRAWINPUT)input->raw_buffer;
+        for (UINT i = 0; i < count; i++, raw = NEXTRAWINPUTBLOCK(raw)) {
+            AddRawInput(input, raw, arrival_tick, 0); // No per-message time is available for buffered reads
+        }
+    }
+    if (events) TRACE_INSTANT(TRACE_INPUT_CAPTURED, events, 0);
+    PublishBatch(input);
+}
+
+static LRESULT CALLBACK InputWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
+    if (uMsg == WM_INPUT) { // Only input that raced in between a buffer drain and PeekMessage ends up here
+        int64_t arrival_tick = ClockNow();
+        uint32_t message_delay_ms = GetTickCount() - (DWORD)GetMessageTime();
+        InputThread* input = (InputThread*)GetWindowLongPtrW(hwnd, GWLP_USERDATA);
+
+        UINT size = RAW_INPUT_BUFFER_SIZE;
+        if (input && GetRawInputData((HRAWINPUT)lParam, RID_INPUT, input->raw_buffer, &size, sizeof(RAWINPUTHEADER)) != (UINT)-1) {
+            AddRawInput(input, (RAWINPUT*)input->raw_buffer, arrival_tick, message_delay_ms);
+            TRACE_INSTANT(TRACE_INPUT_CAPTURED, 1, 0);
+            PublishBatch(input);
+        }
+    }
+    return DefWindowProcW(hwnd, uMsg, wParam, lParam);
+}
+
+static bool RegisterInputSink(HWND hwnd, USHORT usage) {
+    RAWINPUTDEVICE rid = {0};
+    rid.usUsagePage = 0x01;
+    rid.usUsage = usage;
+    rid.dwFlags = RIDEV_INPUTSINK; // A message-only window is never in the foreground, so receive input regardless of focus
+    rid.hwndTarget = hwnd;
+    return RegisterRawInputDevices(&rid, 1, sizeof(rid));
+}
+
+static void InputThreadMain(void* arg) {
+    InputThread* input = arg;
+    RaiseThreadPriority();
+    TraceThread("Input capture");
+    input->thread_id = GetCurrentThreadId();
+
+    WNDCLASSW wc = {0};
+    wc.lpfnWndProc = InputWindowProc;
+    wc.hInstance = GetModuleHandleW(NULL);
+    wc.lpszClassName = INPUT_THREAD_CLASS_NAME;
+    RegisterClassW(&wc);
+
+    input->message_hwnd = CreateWindowExW(0, INPUT_THREAD_CLASS_NAME, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, NULL, wc.hInstance, NULL);
+    input->registered = input->message_hwnd != NULL;
+    if (input->registered) {
+        SetWindowLongPtrW(input->message_hwnd, GWLP_USERDATA, (LONG_PTR)input);
+        if (input->keyboard) input->registered &= RegisterInputSink(input->message_hwnd, 0x06);
+        if (input->mouse) input->registered &= RegisterInputSink(input->message_hwnd, 0x02);
+    }
+    SetEvent(input->ready_event);
+    if (!input->registered) {
+        TraceThreadExit();
+        return;
+    }
+
+    MSG msg;
+    for (;;) {
+        MsgWaitForMultipleObjects(0, NULL, FALSE, INFINITE, QS_RAWINPUT | QS_POSTMESSAGE);
+        DrainRawInputBuffer(input);
+        while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT) {
+                DestroyWindow(input->message_hwnd);
+                TraceThreadExit();
+                return;
+            }
+            DispatchMessage(&msg);
+        }
+    }
+}
+
+bool StartInputThread(InputThread* input, HWND notify_hwnd, UINT notify_message, bool keyboard, bool mouse) {
+    if (!InitializeSpscRing(&input->ring, sizeof(InputEvent), INPUT_RING_CAPACITY)) {
+        return false;
+    }
+    input->notify_hwnd = notify_hwnd;
+    input->notify_message = notify_message;
+    input->keyboard = keyboard;
+    input->mouse = mouse;
+    input->registered = false;
+    input->batch.count = 0;
+    atomic_init(&input->notify_pending, false);
+    atomic_init(&input->dropped, 0);
+
+    input->ready_event = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!input->ready_event || !StartThread(&input->thread, InputThreadMain, input)) {
+        return false;
+    }
+    WaitForSingleObject(input->ready_event, INFINITE); // Wait until the window exists and raw input is registered
+    CloseHandle(input->ready_event);
+    return input->registered;
+}
+
+void StopInputThread(InputThread* input) {
+    PostThreadMessageW(input->thread_id, WM_QUIT, 0, 0);
+    JoinThread(&input->thread);
+    FreeSpscRing(&input->ring);
+}
+
+uint32_t PopInputBatch(InputThread* input, InputEventBatch* batch) {
+    batch->count = (uint32_t)SpscPopBatch(&input->ring, batch->events, INPUT_BATCH_CAPACITY);
+    return batch->count;
+}
+
+void AcknowledgeInputNotification(InputThread* input) {
+    atomic_store(&input->notify_pending, false);
+}
+
+bool RawInputToEvent(const RAWINPUT* raw, int64_t arrival_tick, uint32_t message_delay_ms, InputEvent* event) {
+    event->arrival_tick = arrival_tick;
+    event->message_delay_ms = message_delay_ms;
+    event->device = (uint64_t)(uintptr_t)raw->header.hDevice;
+
+    if (raw->header.dwType == RIM_TYPEKEYBOARD) {
+        event->source = INPUT_SOURCE_KEYBOARD;
+        event->key = raw->data.keyboard.VKey;
+        if (raw->data.keyboard.Flags == RI_KEY_MAKE) {
+            event->pressed = 1;
+        } else if (raw->data.keyboard.Flags == RI_KEY_BREAK) {
+            event->pressed = 0;
+        } else {
+            return false; // E0/E1 prefixed keys are never alphanumeric
+        }
+        return true;
+    }
+
+    if (raw->header.dwType == RIM_TYPEMOUSE) {
+        event->source = INPUT_SOURCE_MOUSE;
+        event->key = 0;
+        if (raw->data.mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_DOWN) {
+            event->pressed = 1;
+        } else if (raw->data.mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_UP) {
+            event->pressed = 0;
+        } else {
+            return false; // Movement and other buttons
+        }
+        return true;
+    }
+    return false;
+}
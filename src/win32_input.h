@@ -0,0 +1,35 @@
+// Raw input capture thread: a message-only window on its own high priority thread that
+// timestamps every event on arrival and hands it to the UI thread through an SPSC ring
+#pragma once
+#include <windows.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "input_events.h"
+#include "platform.h"
+#include "spsc_ring.h"
+
+#define INPUT_RING_CAPACITY 4096
+#define RAW_INPUT_BUFFER_SIZE (16 * 1024)
+
+typedef struct {
+    _Alignas(16) unsigned char raw_buffer[RAW_INPUT_BUFFER_SIZE]; // Reused for every GetRawInputBuffer/GetRawInputData call
+    InputEventBatch batch;
+    PlatformThread thread;
+    SpscRing ring;
+    HWND notify_hwnd;           // Receives WM_APP_INPUT when the ring goes from drained to non-empty
+    UINT notify_message;
+    HWND message_hwnd;          // Message-only window owned by the capture thread
+    DWORD thread_id;
+    HANDLE ready_event;
+    bool keyboard;
+    bool mouse;
+    bool registered;
+    atomic_bool notify_pending;
+    atomic_uint dropped;        // Events lost because the ring was full
+} InputThread;
+
+bool StartInputThread(InputThread* input, HWND notify_hwnd, UINT notify_message, bool keyboard, bool mouse);
+void StopInputThread(InputThread* input);
+uint32_t PopInputBatch(InputThread* input, InputEventBatch* batch);  // UI thread only
+void AcknowledgeInputNotification(InputThread* input);      // Call before draining on WM_APP_INPUT
+bool RawInputToEvent(const RAWINPUT* raw, int64_t arrival_tick, uint32_t message_delay_ms, InputEvent* event);
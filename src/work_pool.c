@@ -0,0 +1,123 @@
+#include <stdatomic.h>
+#include "platform.h"
+#include "work_pool.h"
+
+// A worker's remaining chunks, [front, back) packed in one word so owner and thieves agree with a single CAS
+typedef struct {
+    _Alignas(64) atomic_uint_fast64_t range;   // front in the low 32 bits, back in the high 32
+} WorkRange;
+
+typedef struct WorkPool WorkPool;
+
+typedef struct {
+    WorkPool* pool;
+    int index;
+    uint64_t steals;
+    PlatformThread thread;
+} WorkPoolWorker;
+
+struct WorkPool {
+    WorkRange ranges[WORK_POOL_MAX_THREADS];
+    WorkPoolWorker workers[WORK_POOL_MAX_THREADS];
+    int worker_count;
+    uint64_t items;
+    uint32_t chunk_size;
+    WorkChunkFunction function;
+    void* context;
+};
+
+static uint64_t PackRange(uint32_t front, uint32_t back) {
+    return (uint64_t)back << 32 | front;
+}
+
+static bool TakeFront(WorkRange* range, uint32_t* chunk) { // The owner, walks its share in order
+    uint64_t packed = atomic_load_explicit(&range->range, memory_order_relaxed);
+    for (;;) {
+        uint32_t front = (uint32_t)packed;
+        uint32_t back = (uint32_t)(packed >> 32);
+        if (front >= back) return false;
+        if (atomic_compare_exchange_weak(&range->range, &packed, PackRange(front + 1, back))) {
+            *chunk = front;
+            return true;
+        }
+    }
+}
+
+static bool TakeBack(WorkRange* range, uint32_t* chunk) { // A thief, from the far end so it rarely meets the owner
+    uint64_t packed = atomic_load_explicit(&range->range, memory_order_relaxed);
+    for (;;) {
+        uint32_t front = (uint32_t)packed;
+        uint32_t back = (uint32_t)(packed >> 32);
+        if (front >= back) return false;
+        if (atomic_compare_exchange_weak(&range->range, &packed, PackRange(front, back - 1))) {
+            *chunk = back - 1;
+            return true;
+        }
+    }
+}
+
+static void RunChunk(WorkPool* pool, int worker, uint32_t chunk) {
+    uint64_t begin = (uint64_t)chunk * pool->chunk_size;
+    uint64_t end = begin + pool->chunk_size;
+    pool->function(pool->context, worker, begin, end < pool->items ? end : pool->items);
+}
+
+static void WorkPoolThread(void* arg) {
+    WorkPoolWorker* worker = arg;
+    WorkPool* pool = worker->pool;
+    uint32_t chunk;
+    while (TakeFront(&pool->ranges[worker->index], &chunk)) {
+        RunChunk(pool, worker->index, chunk);
+    }
+
+    // Own share done, go round the others until a full pass finds nothing. Ranges only shrink, so that's final.
+    for (bool found = true; found;) {
+        found = false;
+        for (int i = 1; i < pool->worker_count; i++) {
+            int victim = (worker->index + i) % pool->worker_count;
+            while (TakeBack(&pool->ranges[victim], &chunk)) {
+                RunChunk(pool, worker->index, chunk);
+                worker->steals++;
+                found = true;
+            }
+        }
+    }
+}
+
+bool RunWorkPool(uint64_t items, uint32_t chunk_size, int threads, WorkChunkFunction function, void* context, WorkPoolStats* stats) {
+    if (chunk_size == 0) chunk_size = 1;
+    uint64_t chunks = (items + chunk_size - 1) / chunk_size;
+    if (chunks > UINT32_MAX) {
+        return false;
+    }
+    if (threads <= 0) threads = ProcessorCount();
+    if (threads > WORK_POOL_MAX_THREADS) threads = WORK_POOL_MAX_THREADS;
+    if ((uint64_t)threads > chunks) threads = chunks ? (int)chunks : 1;
+
+    WorkPool pool; // About 26 KB, the callers are main threads
+    pool.worker_count = threads;
+    pool.items = items;
+    pool.chunk_size = chunk_size;
+    pool.function = function;
+    pool.context = context;
+    for (int i = 0; i < threads; i++) { // Even contiguous shares, neighbouring chunks stay on one core
+        atomic_init(&pool.ranges[i].range, PackRange((uint32_t)(chunks * (uint64_t)i / (uint64_t)threads), (uint32_t)(chunks * (uint64_t)(i + 1) / (uint64_t)threads)));
+        pool.workers[i] = (WorkPoolWorker){.pool = &pool, .index = i};
+    }
+
+    int started = 1;
+    while (started < threads && StartThread(&pool.workers[started].thread, WorkPoolThread, &pool.workers[started])) {
+        started++;
+    }
+    WorkPoolThread(&pool.workers[0]); // Also steals the shares of workers that failed to start
+    uint64_t steals = pool.workers[0].steals;
+    for (int i = 1; i < started; i++) {
+        JoinThread(&pool.workers[i].thread);
+        steals += pool.workers[i].steals;
+    }
+    if (stats) {
+        stats->steals = steals;
+        stats->threads = started;
+    }
+    return true;
+}
@@ -0,0 +1,20 @@
+// Work-stealing loop over a range of independent items, e.g. bootstrap resamples. The range is cut into chunks and
+// every worker starts on its own contiguous share; one that runs dry steals chunks from the back of the others.
+// The calling thread is worker 0, the other workers are started for the call and joined before it returns.
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WORK_POOL_MAX_THREADS 256
+
+// Called for [begin, end), always inside one chunk: begin / chunk_size is the chunk index, so per-chunk state
+// (e.g. an RNG seeded from the chunk index) gives the same result whichever worker ends up running it
+typedef void (*WorkChunkFunction)(void* context, int worker, uint64_t begin, uint64_t end);
+
+typedef struct {
+    uint64_t steals;            // Chunks run by a worker that didn't own them
+    int threads;                // Workers actually started, including the caller
+} WorkPoolStats;
+
+// threads = 0 uses every processor. False if the range needs more than 2^32 chunks, otherwise every item ran exactly once.
+bool RunWorkPool(uint64_t items, uint32_t chunk_size, int threads, WorkChunkFunction function, void* context, WorkPoolStats* stats);
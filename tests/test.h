@@ -0,0 +1,62 @@
+// Minimal unit test helpers shared by the programs in tests/
+// A failed check prints where it failed and keeps going, TestResult turns the tally into the exit code for `make test`.
+#pragma once
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static int test_checks;
+static int test_failures;
+
+#define CHECK(condition) \
+    do { \
+        test_checks++; \
+        if (!(condition)) { \
+            test_failures++; \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+#define CHECK_INT(actual, expected) \
+    do { \
+        long long actual_value = (long long)(actual), expected_value = (long long)(expected); \
+        test_checks++; \
+        if (actual_value != expected_value) { \
+            test_failures++; \
+            printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, actual_value, expected_value); \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do { \
+        double actual_value = (actual), expected_value = (expected); \
+        test_checks++; \
+        if (!(fabs(actual_value - expected_value) <= (tolerance))) { \
+            test_failures++; \
+            printf("%s:%d: %s is %.17g, expected %.17g\n", __FILE__, __LINE__, #actual, actual_value, expected_value); \
+        } \
+    } while (0)
+
+#define CHECK_STR(actual, expected) \
+    do { \
+        const char* actual_value = (actual); \
+        const char* expected_value = (expected); \
+        test_checks++; \
+        if (!actual_value || strcmp(actual_value, expected_value) != 0) { \
+            test_failures++; \
+            printf("%s:%d: %s is \"%s\", expected \"%s\"\n", __FILE__, __LINE__, #actual, actual_value ? actual_value : "(null)", expected_value); \
+        } \
+    } while (0)
+
+static inline uint64_t TestRandom(uint64_t* state) { // splitmix64, keeps test data independent of the library's own generator
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline int TestResult(const char* name) { // Exit code for main
+    printf("%s: %d checks, %d failed\n", name, test_checks, test_failures);
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+// INI parsing the way the settings file is written and edited by hand: byte order mark, both comment styles, quoted
+// values, duplicate keys, case, stray lines, and the typed lookups on top.
+#include "test.h"
+#include "config_parser.h"
+
+static bool Parse(ConfigFile* config, const char* text) {
+    return ParseConfig(config, text, strlen(text));
+}
+
+static void TestComments(void) {
+    ConfigFile config;
+    CHECK(Parse(&config,
+        "\xEF\xBB\xBF[Fonts]\n"                     // Byte order mark in front of the first section, as Notepad saves it
+        "; Whole line comment = not a key\n"
+        "# Hash comment = not a key\n"
+        "FontName=Arial\t\t ; Font that will be used; Default=Arial\n"
+        "FontSize = 32;no space before the comment\n"
+        "  FontStyle=Bold/Italic  \r\n"
+        "Note=a # only starts a comment at the start of a line\n"
+        "Empty=   ; Default=\n"));
+    CHECK_STR(ConfigString(&config, "Fonts", "FontName", NULL), "Arial");
+    CHECK_STR(ConfigString(&config, "Fonts", "FontSize", NULL), "32");
+    CHECK_STR(ConfigString(&config, "Fonts", "FontStyle", NULL), "Bold/Italic");
+    CHECK_STR(ConfigString(&config, "Fonts", "Note", NULL), "a # only starts a comment at the start of a line");
+    CHECK_STR(ConfigString(&config, "Fonts", "Empty", "fallback"), "");
+    CHECK(ConfigString(&config, "Fonts", "; Whole line comment", NULL) == NULL);
+    CHECK(ConfigString(&config, "Fonts", "# Hash comment", NULL) == NULL);
+    CHECK_INT(config.count, 5);
+    FreeConfig(&config);
+}
+
+static void TestByteOrderMarkOnly(void) {
+    ConfigFile config;
+    CHECK(Parse(&config, "\xEF\xBB\xBFKey=value")); // Key before any section, no trailing newline
+    CHECK_STR(ConfigString(&config, "", "Key", NULL), "value");
+    FreeConfig(&config);
+
+    CHECK(Parse(&config, "\xEF\xBB"));              // Truncated mark, not skipped but harmless
+    CHECK_INT(config.count, 0);
+    FreeConfig(&config);
+
+    CHECK(Parse(&config, ""));
+    CHECK_INT(config.count, 0);
+    CHECK_STR(ConfigString(&config, "Any", "Key", "fallback"), "fallback");
+    FreeConfig(&config);
+}
+
+static void TestQuotes(void) {
+    ConfigFile config;
+    CHECK(Parse(&config,
+        "[Text]\n"
+        "Double=\"  padded value  \" ; comment\n"
+        "Single='semi;colon' ; comment\n"
+        "Unclosed=\"no end ; comment\n"
+        "Mismatched=\"mixed' ; comment\n"
+        "Inner=say \"hi\" ; comment\n"
+        "Lone=\"\n"));
+    CHECK_STR(ConfigString(&config, "Text", "Double", NULL), "  padded value  ");
+    CHECK_STR(ConfigString(&config, "Text", "Single", NULL), "semi;colon");
+    CHECK_STR(ConfigString(&config, "Text", "Unclosed", NULL), "\"no end");
+    CHECK_STR(ConfigString(&config, "Text", "Mismatched", NULL), "\"mixed'");
+    CHECK_STR(ConfigString(&config, "Text", "Inner", NULL), "say \"hi\"");
+    CHECK_STR(ConfigString(&config, "Text", "Lone", NULL), "\"");
+    FreeConfig(&config);
+}
+
+static void TestSectionsAndDuplicates(void) {
+    ConfigFile config;
+    CHECK(Parse(&config,
+        "[Delays]\n"
+        "MinDelay=1000\n"
+        "mindelay=5\n"                              // Same key in another case, the first one wins
+        "MinDelay=7\n"
+        "not a key\n"
+        "=no key\n"
+        "[ Trial ]\n"
+        "MinDelay=2000\n"                           // Same key in another section is a different entry
+        "[Broken\n"                                 // No closing bracket, stays in [Trial]
+        "TotalTrials=10\n"
+        "[delays]\n"
+        "MaxDelay=3000\n"));                        // Reopened section in another case
+    CHECK_STR(ConfigString(&config, "Delays", "MinDelay", NULL), "1000");
+    CHECK_STR(ConfigString(&config, "DELAYS", "mindelay", NULL), "1000");
+    CHECK_STR(ConfigString(&config, "Trial", "MinDelay", NULL), "2000");
+    CHECK_STR(ConfigString(&config, "trial", "TotalTrials", NULL), "10");
+    CHECK_STR(ConfigString(&config, "Delays", "MaxDelay", NULL), "3000");
+    CHECK(ConfigString(&config, "Delays", "not a key", NULL) == NULL);
+    CHECK(ConfigString(&config, "Delays", "", NULL) == NULL);
+    CHECK(ConfigString(&config, "Broken", "TotalTrials", NULL) == NULL);
+    CHECK_INT(config.count, 4);
+    FreeConfig(&config);
+}
+
+static void TestManyKeys(void) { // Enough entries to push the hash index past its first size
+    char text[64 * 1024];
+    size_t length = 0;
+    for (int section = 0; section < 20; section++) {
+        length += (size_t)snprintf(text + length, sizeof(text) - length, "[Section%d]\n", section);
+        for (int key = 0; key < 50; key++) {
+            length += (size_t)snprintf(text + length, sizeof(text) - length, "Key%d=%d\n", key, section * 1000 + key);
+        }
+    }
+    ConfigFile config;
+    CHECK(ParseConfig(&config, text, length));
+    CHECK_INT(config.count, 1000);
+    for (int section = 0; section < 20; section++) {
+        for (int key = 0; key < 50; key++) {
+            char section_name[32], key_name[32];
+            snprintf(section_name, sizeof(section_name), "SECTION%d", section);
+            snprintf(key_name, sizeof(key_name), "key%d", key);
+            int value;
+            CHECK(ConfigInt(&config, section_name, key_name, -1, 0, 100000, &value));
+            CHECK_INT(value, section * 1000 + key);
+        }
+    }
+    FreeConfig(&config);
+}
+
+static void TestTypedLookups(void) {
+    ConfigFile config;
+    CHECK(Parse(&config,
+        "[Values]\n"
+        "Plain=42\n"
+        "Negative=-7\n"
+        "Signed=+15\n"
+        "TooBig=99999999999999999999\n"
+        "Trailing=12ms\n"
+        "Word=many\n"
+        "Color=255,128,0\n"
+        "SpacedColor= 1 , 2 ,3 \n"
+        "ShortColor=1,2\n"
+        "LongColor=1,2,3,4\n"
+        "BrightColor=256,0,0\n"));
+    int value = 0;
+    CHECK(ConfigInt(&config, "Values", "Plain", 5, 0, 100, &value));
+    CHECK_INT(value, 42);
+    CHECK(ConfigInt(&config, "Values", "Negative", 5, -10, 100, &value));
+    CHECK_INT(value, -7);
+    CHECK(ConfigInt(&config, "Values", "Signed", 5, 0, 100, &value));
+    CHECK_INT(value, 15);
+    CHECK(ConfigInt(&config, "Values", "Missing", 5, 0, 100, &value)); // Missing is fine, it takes the fallback
+    CHECK_INT(value, 5);
+
+    CHECK(!ConfigInt(&config, "Values", "Plain", 5, 0, 41, &value)); // Present but invalid also takes the fallback
+    CHECK_INT(value, 5);
+    value = 0;
+    CHECK(!ConfigInt(&config, "Values", "Negative", 5, 0, 100, &value));
+    CHECK_INT(value, 5);
+    CHECK(!ConfigInt(&config, "Values", "TooBig", 5, 0, 2147483647, &value));
+    CHECK(!ConfigInt(&config, "Values", "Trailing", 5, 0, 100, &value));
+    CHECK(!ConfigInt(&config, "Values", "Word", 5, 0, 100, &value));
+
+    uint8_t color[3] = {0};
+    CHECK(ConfigColor(&config, "Values", "Color", color));
+    CHECK(color[0] == 255 && color[1] == 128 && color[2] == 0);
+    CHECK(ConfigColor(&config, "Values", "SpacedColor", color));
+    CHECK(color[0] == 1 && color[1] == 2 && color[2] == 3);
+    CHECK(!ConfigColor(&config, "Values", "ShortColor", color));
+    CHECK(!ConfigColor(&config, "Values", "LongColor", color));
+    CHECK(!ConfigColor(&config, "Values", "BrightColor", color));
+    CHECK(!ConfigColor(&config, "Values", "Missing", color)); // Colors are required
+    FreeConfig(&config);
+}
+
+static void TestLoadFile(void) {
+    FILE* file = tmpfile();
+    CHECK(file != NULL);
+    if (!file) {
+        return;
+    }
+    const char text[] = "\xEF\xBB\xBF[Trial]\r\nAveragingTrials=5 ; Default=5\r\n";
+    fwrite(text, 1, sizeof(text) - 1, file);
+
+    ConfigFile config;
+    CHECK(LoadConfigFile(&config, file));
+    fclose(file);
+    int value = 0;
+    CHECK(ConfigInt(&config, "Trial", "AveragingTrials", 1, 1, 100, &value));
+    CHECK_INT(value, 5);
+    FreeConfig(&config);
+}
+
+int main(void) {
+    TestComments();
+    TestByteOrderMarkOnly();
+    TestQuotes();
+    TestSectionsAndDuplicates();
+    TestManyKeys();
+    TestTypedLookups();
+    TestLoadFile();
+    return TestResult("test_config_parser");
+}
@@ -0,0 +1,306 @@
+// Reaction engine state machine driven through a fake platform: every transition, early presses with and without
+// the automatic reset, debounce gating, mouse input outside the active area and onsets of cancelled trials.
+#include "test.h"
+#include "platform.h"
+#include "reaction_engine.h"
+
+#define TEST_FREQUENCY 1000000 // Microsecond ticks
+
+typedef struct {
+    int64_t clock;
+    int64_t deadline;           // Last schedule_stimulus, 0 after cancel_stimulus
+    int scheduled;
+    int cancelled;
+    int repaints;
+    int timer_delay[3];         // Armed delay per timer id, 0 when not armed
+    int trials;
+    TrialRecord last;
+} FakePlatform;
+
+static int64_t FakeNow(void* context) { return ((FakePlatform*)context)->clock; }
+static void FakeSetTimer(void* context, int timer_id, int delay_ms) { ((FakePlatform*)context)->timer_delay[timer_id] = delay_ms; }
+static void FakeKillTimer(void* context, int timer_id) { ((FakePlatform*)context)->timer_delay[timer_id] = 0; }
+static void FakeRepaint(void* context) { ((FakePlatform*)context)->repaints++; }
+
+static void FakeSchedule(void* context, int64_t deadline_tick) {
+    FakePlatform* fake = context;
+    fake->deadline = deadline_tick;
+    fake->scheduled++;
+}
+
+static void FakeCancel(void* context) {
+    FakePlatform* fake = context;
+    fake->deadline = 0;
+    fake->cancelled++;
+}
+
+static void FakeTrialComplete(void* context, const TrialRecord* record) {
+    FakePlatform* fake = context;
+    fake->last = *record;
+    fake->trials++;
+}
+
+static void StartEngine(ReactionEngine* engine, FakePlatform* fake, int early_reset_delay, int virtual_debounce) {
+    *fake = (FakePlatform){.clock = 1000000};
+    EngineConfig config = {.averaging_trials = 3, .total_trials = 100, .early_reset_delay = early_reset_delay, .virtual_debounce = virtual_debounce, .histogram_precision = 7};
+    EnginePlatform platform = {.context = fake, .now = FakeNow, .set_timer = FakeSetTimer, .kill_timer = FakeKillTimer, .request_repaint = FakeRepaint,
+        .schedule_stimulus = FakeSchedule, .cancel_stimulus = FakeCancel, .trial_complete = FakeTrialComplete};
+    ForeperiodDistribution foreperiods;
+    CHECK(BuildUniformForeperiods(&foreperiods, 1000, 3000));
+    CHECK(InitializeEngine(engine, &config, &platform, TEST_FREQUENCY, &foreperiods, 7));
+    engine->state.mouse_active = true;
+}
+
+static void TestValidTrial(void) {
+    ReactionEngine engine;
+    FakePlatform fake;
+    StartEngine(&engine, &fake, 1500, 0);
+    CHECK_INT(engine.state.game_state, STATE_INITIAL);
+
+    HandleInput(&engine, false, fake.clock);
+    CHECK_INT(engine.state.game_state, STATE_READY);
+    CHECK_INT(fake.scheduled, 1);
+    CHECK(engine.data.foreperiod_ms >= 1000 && engine.data.foreperiod_ms <= 3000);
+    CHECK_INT(fake.deadline, fake.clock + MillisecondsToTicks(engine.data.foreperiod_ms, TEST_FREQUENCY));
+    CHECK_INT(engine.data.scheduled_onset, fake.deadline);
+
+    int64_t scheduled = fake.deadline;
+    int64_t onset = scheduled + 250; // The scheduler may report a little late, timing starts at the actual onset
+    fake.clock = onset + 40;
+    StimulusOnset(&engine, scheduled, onset);
+    CHECK_INT(engine.state.game_state, STATE_REACT);
+    CHECK_INT(engine.data.start_time, onset);
+    CHECK_INT(engine.data.stimulus_dispatch, onset + 40);
+
+    StimulusPresented(&engine, onset + 8000);
+    StimulusPresented(&engine, onset + 16000); // Only the first paint counts
+    CHECK_INT(engine.data.presented, onset + 8000);
+
+    int64_t response = onset + 215500;
+    fake.clock = response + 100; // Reaction time ends at the arrival of the input, not when it is handled
+    HandleInput(&engine, true, response);
+    CHECK_INT(engine.state.game_state, STATE_RESULT);
+    CHECK_INT(engine.state.trial_iteration, 1);
+    CHECK_NEAR(engine.data.reaction_time_value, 215.5, 1e-9);
+    CHECK_INT(engine.data.end_time, response);
+    CHECK_INT(engine.data.input_dispatch, response + 100);
+    CHECK_INT(engine.data.session_histogram.total, 1);
+
+    CHECK_INT(fake.trials, 1);
+    CHECK_INT(fake.last.outcome, TRIAL_VALID);
+    CHECK_INT(fake.last.trial, 1);
+    CHECK_INT(fake.last.scheduled_onset, scheduled);
+    CHECK_INT(fake.last.onset, onset);
+    CHECK_INT(fake.last.response, response);
+    CHECK_INT(fake.last.dispatch, response + 100);
+    CHECK_INT(fake.last.stimulus_dispatch, onset + 40);
+    CHECK_INT(fake.last.presented, onset + 8000);
+    CHECK_INT(fake.last.is_mouse, 1);
+    CHECK_NEAR(fake.last.reaction_time_ms, 215.5, 1e-9);
+    CHECK(!AverageAvailable(&engine));
+
+    // Any input on the result screen arms the next trial
+    int cancelled = fake.cancelled;
+    HandleInput(&engine, false, fake.clock);
+    CHECK_INT(engine.state.game_state, STATE_READY);
+    CHECK_INT(fake.scheduled, 2);
+    CHECK_INT(fake.cancelled, cancelled + 1);
+    CHECK_INT(fake.trials, 1);
+    FreeEngine(&engine);
+}
+
+static void TestAverage(void) {
+    ReactionEngine engine;
+    FakePlatform fake;
+    StartEngine(&engine, &fake, 1500, 0);
+    HandleInput(&engine, false, fake.clock);
+
+    double times[] = {200, 250, 300, 180};
+    double means[] = {200, 225, 250, (250.0 + 300 + 180) / 3};
+    for (int i = 0; i < 4; i++) {
+        fake.clock = fake.deadline;
+        StimulusOnset(&engine, fake.deadline, fake.clock);
+        fake.clock += (int64_t)(times[i] * 1000);
+        HandleInput(&engine, false, fake.clock);
+        CHECK_NEAR(engine.data.reaction_time_value, times[i], 1e-9);
+        CHECK_INT(AverageAvailable(&engine), i >= 2); // Rolls on once the window has filled up
+        CHECK_NEAR(engine.data.rolling.summary.mean, means[i], 1e-9);
+        HandleInput(&engine, false, fake.clock); // Next trial
+    }
+    CHECK_INT(engine.state.trial_iteration, 4);
+    FreeEngine(&engine);
+}
+
+static void TestEarlyPress(void) {
+    ReactionEngine engine;
+    FakePlatform fake;
+    StartEngine(&engine, &fake, 1500, 0);
+    HandleInput(&engine, false, fake.clock);
+
+    fake.clock += 400000;
+    HandleInput(&engine, false, fake.clock);
+    CHECK_INT(engine.state.game_state, STATE_EARLY);
+    CHECK_INT(fake.deadline, 0); // The pending stimulus was cancelled
+    CHECK_INT(fake.timer_delay[TIMER_EARLY], 1500);
+    CHECK_INT(fake.trials, 1);
+    CHECK_INT(fake.last.outcome, TRIAL_EARLY);
+    CHECK_INT(fake.last.onset, 0);
+    CHECK_INT(fake.last.reaction_time_ms, 0);
+    CHECK_INT(fake.last.trial, 0);
+    CHECK_INT(engine.state.trial_iteration, 0); // Early presses are not counted as trials
+
+    // The reset timer takes the participant back to a fresh foreperiod
+    TimerStateLogic(&engine, TIMER_EARLY);
+    CHECK_INT(engine.state.game_state, STATE_READY);
+    CHECK_INT(fake.scheduled, 2);
+    CHECK(fake.deadline > 0);
+    CHECK_INT(fake.timer_delay[TIMER_EARLY], 0);
+
+    // Pressing through the early screen restarts as well, and kills the pending reset
+    HandleInput(&engine, false, fake.clock);
+    CHECK_INT(engine.state.game_state, STATE_EARLY);
+    CHECK_INT(fake.timer_delay[TIMER_EARLY], 1500);
+    HandleInput(&engine, false, fake.clock);
+    CHECK_INT(engine.state.game_state, STATE_READY);
+    CHECK_INT(fake.timer_delay[TIMER_EARLY], 0);
+    CHECK_INT(fake.scheduled, 3);
+    FreeEngine(&engine);
+}
+
+static void TestEarlyPressWithoutReset(void) {
+    ReactionEngine engine;
+    FakePlatform fake;
+    StartEngine(&engine, &fake, 0, 0);
+    HandleInput(&engine, false, fake.clock);
+    HandleInput(&engine, false, fake.clock);
+    CHECK_INT(engine.state.game_state, STATE_EARLY);
+    CHECK_INT(fake.timer_delay[TIMER_EARLY], 0); // Stays on the early screen until the next press
+    HandleInput(&engine, false, fake.clock);
+    CHECK_INT(engine.state.game_state, STATE_READY);
+    FreeEngine(&engine);
+}
+
+static void TestDebounce(void) {
+    ReactionEngine engine;
+    FakePlatform fake;
+    StartEngine(&engine, &fake, 1500, 30);
+
+    HandleInput(&engine, false, fake.clock);
+    CHECK_INT(engine.state.game_state, STATE_READY);
+    CHECK(engine.state.debounce_active);
+    CHECK_INT(fake.timer_delay[TIMER_DEBOUNCE], 30);
+
+    HandleInput(&engine, false, fake.clock); // Key bounce, would otherwise be an early press
+    CHECK_INT(engine.state.game_state, STATE_READY);
+
+    TimerStateLogic(&engine, TIMER_DEBOUNCE);
+    CHECK(!engine.state.debounce_active);
+    CHECK_INT(engine.state.game_state, STATE_READY); // Not a state change
+    HandleInput(&engine, false, fake.clock);
+    CHECK_INT(engine.state.game_state, STATE_EARLY);
+    CHECK(engine.state.debounce_active);
+    FreeEngine(&engine);
+}
+
+static void TestInactiveMouse(void) {
+    ReactionEngine engine;
+    FakePlatform fake;
+    StartEngine(&engine, &fake, 1500, 30);
+    engine.state.mouse_active = false;
+
+    HandleInput(&engine, true, fake.clock);
+    CHECK_INT(engine.state.game_state, STATE_INITIAL);
+    CHECK(!engine.state.debounce_active); // An ignored click does not start a debounce either
+    HandleInput(&engine, false, fake.clock);
+    CHECK_INT(engine.state.game_state, STATE_READY);
+    FreeEngine(&engine);
+}
+
+static void TestStaleOnset(void) {
+    ReactionEngine engine;
+    FakePlatform fake;
+    StartEngine(&engine, &fake, 1500, 0);
+    HandleInput(&engine, false, fake.clock);
+    int64_t first = fake.deadline;
+
+    fake.clock += 100000;
+    HandleInput(&engine, false, fake.clock); // Early, cancels the first deadline
+    fake.clock += 100000;
+    HandleInput(&engine, false, fake.clock); // Restart, arms a second one
+    int64_t second = fake.deadline;
+    CHECK(second != first);
+    CHECK_INT(engine.state.game_state, STATE_READY);
+
+    // The scheduler thread had already fired the first deadline before the cancel reached it
+    StimulusOnset(&engine, first, first + 10);
+    CHECK_INT(engine.state.game_state, STATE_READY);
+    CHECK_INT(engine.data.start_time, 0);
+
+    StimulusOnset(&engine, second, second + 10);
+    CHECK_INT(engine.state.game_state, STATE_REACT);
+    CHECK_INT(engine.data.start_time, second + 10);
+
+    // A second onset for the same trial changes nothing
+    StimulusOnset(&engine, second, second + 5000);
+    CHECK_INT(engine.state.game_state, STATE_REACT);
+    CHECK_INT(engine.data.start_time, second + 10);
+    FreeEngine(&engine);
+}
+
+static void TestIgnoredEvents(void) { // Every (state, event) pair without a row in the transition table
+    ReactionEngine engine;
+    FakePlatform fake;
+    StartEngine(&engine, &fake, 1500, 0);
+
+    StimulusOnset(&engine, 0, fake.clock); // No trial armed yet
+    TimerStateLogic(&engine, TIMER_EARLY);
+    CHECK_INT(engine.state.game_state, STATE_INITIAL);
+    CHECK_INT(fake.scheduled, 0);
+    CHECK_INT(fake.repaints, 0);
+
+    HandleInput(&engine, false, fake.clock);
+    TimerStateLogic(&engine, TIMER_EARLY); // Stray reset timer while waiting for the stimulus
+    CHECK_INT(engine.state.game_state, STATE_READY);
+    CHECK_INT(fake.scheduled, 1);
+
+    StimulusOnset(&engine, fake.deadline, fake.deadline);
+    TimerStateLogic(&engine, TIMER_EARLY);
+    CHECK_INT(engine.state.game_state, STATE_REACT);
+    fake.clock = fake.deadline + 200000;
+    HandleInput(&engine, false, fake.clock);
+    StimulusOnset(&engine, engine.data.scheduled_onset, fake.clock); // Late duplicate on the result screen
+    TimerStateLogic(&engine, TIMER_EARLY);
+    CHECK_INT(engine.state.game_state, STATE_RESULT);
+    CHECK_INT(engine.state.trial_iteration, 1);
+    CHECK_INT(fake.trials, 1);
+    FreeEngine(&engine);
+}
+
+static void TestReset(void) {
+    ReactionEngine engine;
+    FakePlatform fake;
+    StartEngine(&engine, &fake, 1500, 0);
+    HandleInput(&engine, false, fake.clock);
+    StimulusOnset(&engine, fake.deadline, fake.deadline);
+    CHECK_INT(engine.state.game_state, STATE_REACT);
+
+    ResetLogic(&engine);
+    CHECK_INT(engine.state.game_state, STATE_READY);
+    CHECK_INT(fake.cancelled, 1);
+    CHECK_INT(fake.scheduled, 2);
+    CHECK_INT(fake.trials, 0);
+    FreeEngine(&engine);
+}
+
+int main(void) {
+    TestValidTrial();
+    TestAverage();
+    TestEarlyPress();
+    TestEarlyPressWithoutReset();
+    TestDebounce();
+    TestInactiveMouse();
+    TestStaleOnset();
+    TestIgnoredEvents();
+    TestReset();
+    return TestResult("test_engine");
+}
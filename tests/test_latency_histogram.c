@@ -0,0 +1,146 @@
+// Session histogram percentiles against the exact percentile of the recorded values: every reported value has to be
+// within the documented relative error and inside [min, max], for every supported precision.
+#include <stdlib.h>
+#include "test.h"
+#include "latency_histogram.h"
+
+#define TEST_FREQUENCY 10000000 // 100 ns ticks, like QueryPerformanceCounter
+#define TEST_HIGHEST (60LL * TEST_FREQUENCY)
+#define TEST_VALUES 5000
+
+static int CompareTicks(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int64_t ExactPercentile(const int64_t* sorted, int count, double percentile) { // Same rank as LatencyPercentile
+    if (percentile <= 0) return sorted[0];
+    if (percentile >= 100) return sorted[count - 1];
+    uint64_t rank = (uint64_t)(percentile / 100.0 * count + 0.5);
+    return sorted[rank ? rank - 1 : 0];
+}
+
+static void CheckPercentiles(const LatencyHistogram* histogram, int64_t* values, int count) {
+    qsort(values, (size_t)count, sizeof(int64_t), CompareTicks);
+    double error = 1.0 / (1 << (histogram->significant_bits - 1));
+    double percentiles[] = {0, 0.1, 1, 10, 25, 50, 75, 90, 95, 99, 99.9, 100};
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+        int64_t reported = LatencyPercentile(histogram, percentiles[i]);
+        int64_t exact = ExactPercentile(values, count, percentiles[i]);
+        CHECK(reported >= values[0] && reported <= values[count - 1]);
+        if (exact <= histogram->highest_trackable) { // Above it only the exact maximum is kept
+            CHECK_NEAR((double)reported, (double)exact, (double)exact * error);
+        }
+    }
+}
+
+static void TestEmpty(void) {
+    LatencyHistogram histogram;
+    CHECK(InitializeLatencyHistogram(&histogram, TEST_HIGHEST, 7, TEST_FREQUENCY));
+    CHECK_INT(histogram.total, 0);
+    CHECK_INT(LatencyPercentile(&histogram, 0), 0);
+    CHECK_INT(LatencyPercentile(&histogram, 50), 0);
+    CHECK_INT(LatencyPercentile(&histogram, 100), 0);
+    FreeLatencyHistogram(&histogram);
+
+    CHECK(!InitializeLatencyHistogram(&histogram, TEST_HIGHEST, HISTOGRAM_MIN_SIGNIFICANT_BITS - 1, TEST_FREQUENCY));
+    CHECK(!InitializeLatencyHistogram(&histogram, TEST_HIGHEST, HISTOGRAM_MAX_SIGNIFICANT_BITS + 1, TEST_FREQUENCY));
+    CHECK(!InitializeLatencyHistogram(&histogram, TEST_HIGHEST, 7, 0));
+}
+
+static void TestSingleValue(void) {
+    LatencyHistogram histogram;
+    CHECK(InitializeLatencyHistogram(&histogram, TEST_HIGHEST, 3, TEST_FREQUENCY));
+    RecordLatency(&histogram, 2345678);
+    for (int percentile = 0; percentile <= 100; percentile += 10) {
+        CHECK_INT(LatencyPercentile(&histogram, percentile), 2345678); // Clamped to [min, max], so exact
+    }
+    FreeLatencyHistogram(&histogram);
+}
+
+static void TestRandomValues(void) {
+    static int64_t values[TEST_VALUES];
+    uint64_t random = 42;
+    for (int bits = HISTOGRAM_MIN_SIGNIFICANT_BITS; bits <= HISTOGRAM_MAX_SIGNIFICANT_BITS; bits++) {
+        LatencyHistogram histogram;
+        CHECK(InitializeLatencyHistogram(&histogram, TEST_HIGHEST, bits, TEST_FREQUENCY));
+        for (int i = 0; i < TEST_VALUES; i++) {
+            // Mostly reaction times (100 ms to 1 s), some down in the exact range and a few stalls past the last bucket
+            uint64_t kind = TestRandom(&random) % 100;
+            if (kind < 5) values[i] = (int64_t)(TestRandom(&random) % 64);
+            else if (kind < 98) values[i] = TEST_FREQUENCY / 10 + (int64_t)(TestRandom(&random) % (TEST_FREQUENCY - TEST_FREQUENCY / 10 + 1));
+            else values[i] = TEST_HIGHEST + (int64_t)(TestRandom(&random) % TEST_FREQUENCY);
+            RecordLatency(&histogram, values[i]);
+        }
+        CHECK_INT(histogram.total, TEST_VALUES);
+
+        int failures = test_failures;
+        CheckPercentiles(&histogram, values, TEST_VALUES);
+        CHECK_INT(LatencyPercentile(&histogram, 0), values[0]);
+        CHECK_INT(LatencyPercentile(&histogram, 100), values[TEST_VALUES - 1]); // The real maximum, not the clamped bucket
+        if (test_failures != failures) {
+            printf("  %d significant bits\n", bits);
+        }
+        FreeLatencyHistogram(&histogram);
+    }
+}
+
+static void TestMerge(void) {
+    static int64_t values[TEST_VALUES];
+    LatencyHistogram odd, even, merged;
+    CHECK(InitializeLatencyHistogram(&odd, TEST_HIGHEST, 10, TEST_FREQUENCY));
+    CHECK(InitializeLatencyHistogram(&even, TEST_HIGHEST, 10, TEST_FREQUENCY));
+    CHECK(InitializeLatencyHistogram(&merged, TEST_HIGHEST, 10, TEST_FREQUENCY));
+    uint64_t random = 7;
+    for (int i = 0; i < TEST_VALUES; i++) {
+        values[i] = TEST_FREQUENCY / 10 + (int64_t)(TestRandom(&random) % (TEST_FREQUENCY / 2 - TEST_FREQUENCY / 10 + 1));
+        RecordLatency(i & 1 ? &odd : &even, values[i]);
+    }
+
+    MergeLatencyHistogram(&merged, &odd); // Same layout, plain bucket sums
+    MergeLatencyHistogram(&merged, &even);
+    CHECK_INT(merged.total, TEST_VALUES);
+    CheckPercentiles(&merged, values, TEST_VALUES);
+    CHECK_INT(merged.min, values[0]);
+    CHECK_INT(merged.max, values[TEST_VALUES - 1]);
+    FreeLatencyHistogram(&odd);
+    FreeLatencyHistogram(&even);
+    FreeLatencyHistogram(&merged);
+}
+
+static void TestSaveLoad(void) {
+    LatencyHistogram histogram, loaded;
+    CHECK(InitializeLatencyHistogram(&histogram, TEST_HIGHEST, 7, TEST_FREQUENCY));
+    for (int i = 1; i <= 1000; i++) {
+        RecordLatency(&histogram, (int64_t)i * 3001);
+    }
+
+    FILE* file = tmpfile();
+    CHECK(file != NULL);
+    if (!file) {
+        FreeLatencyHistogram(&histogram);
+        return;
+    }
+    CHECK(SaveLatencyHistogram(&histogram, file));
+    rewind(file);
+    CHECK(LoadLatencyHistogram(&loaded, file));
+    fclose(file);
+
+    CHECK_INT(loaded.total, histogram.total);
+    CHECK_INT(loaded.min, histogram.min);
+    CHECK_INT(loaded.max, histogram.max);
+    for (int percentile = 0; percentile <= 100; percentile += 5) {
+        CHECK_INT(LatencyPercentile(&loaded, percentile), LatencyPercentile(&histogram, percentile));
+    }
+    FreeLatencyHistogram(&loaded);
+    FreeLatencyHistogram(&histogram);
+}
+
+int main(void) {
+    TestEmpty();
+    TestSingleValue();
+    TestRandomValues();
+    TestMerge();
+    TestSaveLoad();
+    return TestResult("test_latency_histogram");
+}
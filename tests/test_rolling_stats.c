@@ -0,0 +1,107 @@
+// Rolling window statistics against a naive recompute of the same window after every push, for window sizes from
+// one value up to more than the test pushes, with ties, and across a resize.
+#include <stdlib.h>
+#include "test.h"
+#include "rolling_stats.h"
+
+#define TEST_PUSHES 2000
+
+static int CompareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double NaivePercentile(const double* sorted, int count, double percentile) { // Same interpolation as RollingPercentile
+    double position = (percentile / 100) * (count - 1);
+    int lower = (int)position;
+    if (lower >= count - 1) {
+        return sorted[count - 1];
+    }
+    return sorted[lower] + (sorted[lower + 1] - sorted[lower]) * (position - lower);
+}
+
+static void CheckWindow(const RollingStats* stats, const double* history, int pushed, int window) { // history holds every value pushed so far
+    int count = pushed < window ? pushed : window;
+    const double* values = history + pushed - count;
+    double sorted[TEST_PUSHES];
+    double sum = 0;
+    for (int i = 0; i < count; i++) {
+        sorted[i] = values[i];
+        sum += values[i];
+    }
+    qsort(sorted, (size_t)count, sizeof(double), CompareDoubles);
+    double mean = sum / count;
+    double squares = 0;
+    for (int i = 0; i < count; i++) {
+        squares += (values[i] - mean) * (values[i] - mean);
+    }
+    double sd = count > 1 ? sqrt(squares / (count - 1)) : 0;
+
+    const RollingSummary* summary = &stats->summary;
+    CHECK_INT(summary->count, count);
+    CHECK_NEAR(summary->mean, mean, 1e-9 * fabs(mean) + 1e-9);
+    CHECK_NEAR(summary->sd, sd, 1e-7 * sd + 1e-7);
+    CHECK_NEAR(summary->min, sorted[0], 0);
+    CHECK_NEAR(summary->max, sorted[count - 1], 0);
+    CHECK_NEAR(summary->median, NaivePercentile(sorted, count, 50), 1e-9);
+    CHECK_NEAR(summary->p90, NaivePercentile(sorted, count, 90), 1e-9);
+    for (int percentile = 0; percentile <= 100; percentile += 25) {
+        CHECK_NEAR(RollingPercentile(stats, percentile), NaivePercentile(sorted, count, percentile), 1e-9);
+    }
+}
+
+static void TestWindow(int window, bool coarse) {
+    static double history[TEST_PUSHES];
+    RollingStats stats;
+    uint64_t random = (uint64_t)window * 2 + coarse;
+    CHECK(InitializeRollingStats(&stats, window));
+    CHECK_INT(stats.summary.count, 0);
+    CHECK_NEAR(RollingPercentile(&stats, 50), 0, 0);
+
+    int failures = test_failures;
+    for (int i = 0; i < TEST_PUSHES && test_failures == failures; i++) { // Stop at the first push that disagrees
+        // Coarse values repeat a lot, so the window is full of ties; the others span typical reaction times
+        history[i] = coarse ? (double)(TestRandom(&random) % 8) * 10 : 120 + (double)(TestRandom(&random) >> 11) / (1ull << 53) * 400;
+        PushRollingStats(&stats, history[i]);
+        CheckWindow(&stats, history, i + 1, window);
+    }
+    if (test_failures != failures) {
+        printf("  window %d%s\n", window, coarse ? ", coarse values" : "");
+    }
+    FreeRollingStats(&stats);
+}
+
+static void TestResize(void) {
+    double history[TEST_PUSHES];
+    RollingStats stats;
+    CHECK(InitializeRollingStats(&stats, 10));
+    for (int i = 0; i < 25; i++) {
+        history[i] = 200 + (i * 37) % 50;
+        PushRollingStats(&stats, history[i]);
+    }
+
+    CHECK(ResizeRollingStats(&stats, 4)); // Keeps the newest four
+    CheckWindow(&stats, history, 25, 4);
+    history[25] = 500;
+    PushRollingStats(&stats, history[25]);
+    CheckWindow(&stats, history, 26, 4);
+
+    CHECK(ResizeRollingStats(&stats, 8)); // Growing keeps everything, the window fills up from there
+    CheckWindow(&stats, history, 26, 4);
+    for (int i = 26; i < 40; i++) {
+        history[i] = 150 + i;
+        PushRollingStats(&stats, history[i]);
+        CheckWindow(&stats, history, i + 1, i - 21 < 8 ? i - 21 : 8);
+    }
+    FreeRollingStats(&stats);
+}
+
+int main(void) {
+    int windows[] = {1, 2, 5, 16, 100, TEST_PUSHES + 1};
+    for (size_t i = 0; i < sizeof(windows) / sizeof(windows[0]); i++) {
+        TestWindow(windows[i], false);
+        TestWindow(windows[i], true);
+    }
+    TestResize();
+    return TestResult("test_rolling_stats");
+}
@@ -0,0 +1,104 @@
+// Compares two `make bench` result files (BENCH_OUTPUT JSON lines), e.g. the last release against the current tree.
+// Fails when a benchmark got slower than the threshold or allocates more per operation than before.
+// Usage: bench_compare [--threshold PERCENT] <baseline.jsonl> <current.jsonl>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_THRESHOLD 10.0  // Percent, single runs on a quiet machine stay well inside this
+#define MAX_RESULTS 1024
+
+typedef struct {
+    char program[64];
+    char name[128];
+    unsigned long long ops;
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_per_op;
+} BenchResult;
+
+static int ReadResults(const char* path, BenchResult* results) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return -1;
+    }
+    char line[512];
+    int count = 0;
+    while (count < MAX_RESULTS && fgets(line, sizeof(line), file)) {
+        BenchResult* result = &results[count];
+        if (sscanf(line, "{\"program\": \"%63[^\"]\", \"name\": \"%127[^\"]\", \"ops\": %llu, \"ns_per_op\": %lf, \"allocs_per_op\": %lf, \"bytes_per_op\": %lf}",
+                result->program, result->name, &result->ops, &result->ns_per_op, &result->allocs_per_op, &result->bytes_per_op) == 6) {
+            count++;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+static const BenchResult* FindResult(const BenchResult* results, int count, const BenchResult* key) {
+    for (int i = 0; i < count; i++) {
+        if (!strcmp(results[i].program, key->program) && !strcmp(results[i].name, key->name)) {
+            return &results[i];
+        }
+    }
+    return NULL;
+}
+
+static void Usage(void) {
+    fprintf(stderr, "Usage: bench_compare [--threshold PERCENT] <baseline.jsonl> <current.jsonl>\n"
+                    "Exits with 1 if any benchmark is slower than the threshold (default %.0f%%) or allocates more.\n", DEFAULT_THRESHOLD);
+}
+
+int main(int argc, char** argv) {
+    double threshold = DEFAULT_THRESHOLD;
+    const char* paths[2] = {NULL, NULL};
+    int path_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--threshold") && i + 1 < argc) {
+            threshold = strtod(argv[++i], NULL);
+        } else if (argv[i][0] == '-' || path_count == 2) {
+            Usage();
+            return 1;
+        } else {
+            paths[path_count++] = argv[i];
+        }
+    }
+    if (path_count != 2) {
+        Usage();
+        return 1;
+    }
+
+    static BenchResult baseline[MAX_RESULTS], current[MAX_RESULTS];
+    int baseline_count = ReadResults(paths[0], baseline);
+    int current_count = ReadResults(paths[1], current);
+    if (baseline_count < 0 || current_count < 0) {
+        return 1;
+    }
+
+    int regressions = 0;
+    printf("%-18s %-32s %12s %12s %9s %12s\n", "program", "name", "base ns/op", "ns/op", "change", "allocs/op");
+    for (int i = 0; i < current_count; i++) {
+        const BenchResult* now = &current[i];
+        const BenchResult* before = FindResult(baseline, baseline_count, now);
+        if (!before) {
+            printf("%-18s %-32s %12s %12.2f %9s %12.3f\n", now->program, now->name, "-", now->ns_per_op, "new", now->allocs_per_op);
+            continue;
+        }
+        double change = before->ns_per_op > 0 ? (now->ns_per_op / before->ns_per_op - 1) * 100 : 0;
+        bool slower = change > threshold;
+        bool allocates = now->allocs_per_op > before->allocs_per_op + 1e-9;
+        regressions += slower || allocates;
+        printf("%-18s %-32s %12.2f %12.2f %+8.1f%% %12.3f%s%s\n", now->program, now->name, before->ns_per_op, now->ns_per_op, change,
+            now->allocs_per_op, slower ? "  SLOWER" : "", allocates ? "  MORE ALLOCATIONS" : "");
+    }
+    for (int i = 0; i < baseline_count; i++) {
+        if (!FindResult(current, current_count, &baseline[i])) {
+            printf("%-18s %-32s %12.2f %12s %9s\n", baseline[i].program, baseline[i].name, baseline[i].ns_per_op, "-", "missing");
+        }
+    }
+
+    printf("%d regression%s over %.1f%%\n", regressions, regressions == 1 ? "" : "s", threshold);
+    return regressions ? 1 : 0;
+}
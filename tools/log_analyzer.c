@@ -0,0 +1,384 @@
+// Summarizes trial text logs (Log_*.log, "Trial N: value" lines with ERROR: lines mixed in).
+// Every file is memory-mapped and parsed by a pool of worker threads, largest files first.
+// Usage: log_analyzer [--json] [--threads N] <log directory | files...>
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "latency_histogram.h"
+#include "platform.h"
+
+#define HISTOGRAM_FREQUENCY 1000000         // Reaction times are bucketed in microseconds
+#define HISTOGRAM_HIGHEST_US 60000000
+#define HISTOGRAM_BITS 10                  // 0.2% worst case percentile error
+#define MAX_THREADS 256
+
+typedef struct {
+    uint64_t count;
+    double mean;
+    double m2;
+    double min;
+    double max;
+} Moments;
+
+typedef struct {
+    char* path;
+    const char* name;
+    uint64_t size;
+    Moments moments;
+    uint64_t errors;        // ERROR: lines written by HandleError
+    uint64_t skipped;       // Anything else that is not a trial line
+    double p50;
+    double p90;
+    double p99;
+    bool failed;
+} SessionResult;
+
+typedef struct {
+    SessionResult* sessions;
+    size_t count;
+    size_t capacity;
+    atomic_size_t next;
+} WorkQueue;
+
+typedef struct {
+    WorkQueue* queue;
+    PlatformThread thread;
+    LatencyHistogram session;   // Reused for every file this worker parses
+    LatencyHistogram total;
+    Moments moments;
+} Worker;
+
+static const double NEGATIVE_POWERS[19] = {1e0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9,
+    1e-10, 1e-11, 1e-12, 1e-13, 1e-14, 1e-15, 1e-16, 1e-17, 1e-18};
+
+// Moments helpers (Welford per value, Chan et al. to combine)
+static void AddMoment(Moments* moments, double value) {
+    moments->count++;
+    double delta = value - moments->mean;
+    moments->mean += delta / (double)moments->count;
+    moments->m2 += delta * (value - moments->mean);
+    if (moments->count == 1 || value < moments->min) moments->min = value;
+    if (moments->count == 1 || value > moments->max) moments->max = value;
+}
+
+static void MergeMoments(Moments* into, const Moments* from) {
+    if (!from->count) return;
+    if (!into->count) {
+        *into = *from;
+        return;
+    }
+    double total = (double)(into->count + from->count);
+    double delta = from->mean - into->mean;
+    into->mean += delta * (double)from->count / total;
+    into->m2 += from->m2 + delta * delta * (double)into->count * (double)from->count / total;
+    if (from->min < into->min) into->min = from->min;
+    if (from->max > into->max) into->max = from->max;
+    into->count += from->count;
+}
+
+static double StandardDeviation(const Moments* moments) {
+    return moments->count > 1 ? sqrt(moments->m2 / (double)(moments->count - 1)) : 0;
+}
+
+// Parsing
+static const char* ParseDecimal(const char* p, const char* end, double* value) { // Plain %f output, no exponent
+    bool negative = p < end && *p == '-';
+    p += negative;
+
+    const char* digits_start = p;
+    uint64_t integer = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (integer > UINT64_MAX / 10 - 9) return NULL;
+        integer = integer * 10 + (uint64_t)(*p++ - '0');
+    }
+
+    double result = (double)integer;
+    if (p < end && *p == '.') {
+        p++;
+        uint64_t fraction = 0;
+        int fraction_digits = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (fraction_digits < 18) { // Further digits are below double precision anyway
+                fraction = fraction * 10 + (uint64_t)(*p - '0');
+                fraction_digits++;
+            }
+            p++;
+        }
+        result += (double)fraction * NEGATIVE_POWERS[fraction_digits];
+    }
+    if (p == digits_start) {
+        return NULL;
+    }
+
+    *value = negative ? -result : result;
+    return p;
+}
+
+static bool ParseTrialLine(const char* p, const char* end, double* value) { // "Trial <n>: <value>[ | diagnostics]"
+    if (end - p < 6 || memcmp(p, "Trial ", 6) != 0) return false;
+    p += 6;
+
+    const char* number_start = p;
+    while (p < end && *p >= '0' && *p <= '9') p++;
+    if (p == number_start || p == end || *p != ':') return false;
+    p++;
+
+    while (p < end && *p == ' ') p++;
+    p = ParseDecimal(p, end, value);
+    if (!p) return false;
+
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p == end || *p == '|';
+}
+
+static void ParseLog(Worker* worker, SessionResult* result, const char* data, size_t size) {
+    const char* p = data;
+    const char* end = data + size;
+
+    while (p < end) {
+        const char* line_end = memchr(p, '\n', (size_t)(end - p));
+        const char* next = line_end ? line_end + 1 : end;
+        if (!line_end) line_end = end;
+        if (line_end > p && line_end[-1] == '\r') line_end--; // Logs are written in text mode on Windows
+
+        double value;
+        if (ParseTrialLine(p, line_end, &value)) {
+            AddMoment(&result->moments, value);
+            RecordLatency(&worker->session, llround(value * 1000.0));
+        } else if (line_end - p >= 6 && memcmp(p, "ERROR:", 6) == 0) {
+            result->errors++;
+        } else if ((line_end - p >= 5 && memcmp(p, "Seed:", 5) == 0) || (line_end - p >= 11 && memcmp(p, "Diagnostics", 11) == 0)) {
+            // Session header and diagnostics summary, nothing to summarize
+        } else if (line_end > p) {
+            result->skipped++;
+        }
+        p = next;
+    }
+}
+
+static void AnalyzeSession(Worker* worker, SessionResult* result) {
+    PlatformMapping mapping;
+    if (!MapFile(&mapping, result->path)) {
+        result->failed = true;
+        return;
+    }
+
+    ResetLatencyHistogram(&worker->session);
+    ParseLog(worker, result, mapping.data, mapping.size);
+    UnmapFile(&mapping);
+
+    result->p50 = LatencyPercentile(&worker->session, 50) / 1000.0;
+    result->p90 = LatencyPercentile(&worker->session, 90) / 1000.0;
+    result->p99 = LatencyPercentile(&worker->session, 99) / 1000.0;
+    MergeLatencyHistogram(&worker->total, &worker->session);
+    MergeMoments(&worker->moments, &result->moments);
+}
+
+static void WorkerThread(void* arg) {
+    Worker* worker = arg;
+    WorkQueue* queue = worker->queue;
+
+    size_t index;
+    while ((index = atomic_fetch_add(&queue->next, 1)) < queue->count) {
+        AnalyzeSession(worker, &queue->sessions[index]);
+    }
+}
+
+// File discovery
+static void AddSession(WorkQueue* queue, const char* path, uint64_t size) {
+    if (queue->count == queue->capacity) {
+        queue->capacity = queue->capacity ? queue->capacity * 2 : 256;
+        queue->sessions = realloc(queue->sessions, queue->capacity * sizeof(SessionResult));
+        if (!queue->sessions) {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+    }
+
+    SessionResult* result = &queue->sessions[queue->count++];
+    memset(result, 0, sizeof(*result));
+    result->path = strdup(path);
+    const char* slash = strrchr(result->path, '/');
+    result->name = slash ? slash + 1 : result->path;
+    result->size = size;
+}
+
+static bool IsTrialLogName(const char* name) { // Log_<timestamp>.log, DEBUG_Log_* files are skipped
+    size_t length = strlen(name);
+    return length > 8 && strncmp(name, "Log_", 4) == 0 && strcmp(name + length - 4, ".log") == 0;
+}
+
+static void CollectSessions(WorkQueue* queue, const char* path) {
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return;
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        AddSession(queue, path, (uint64_t)info.st_size);
+        return;
+    }
+
+    DIR* directory = opendir(path);
+    if (!directory) {
+        fprintf(stderr, "Cannot read directory %s\n", path);
+        return;
+    }
+    struct dirent* entry;
+    char file_path[4096];
+    while ((entry = readdir(directory))) {
+        if (!IsTrialLogName(entry->d_name)) continue;
+        snprintf(file_path, sizeof(file_path), "%s/%s", path, entry->d_name);
+        if (stat(file_path, &info) == 0 && S_ISREG(info.st_mode)) {
+            AddSession(queue, file_path, (uint64_t)info.st_size);
+        }
+    }
+    closedir(directory);
+}
+
+static int CompareSize(const void* a, const void* b) { // Largest first keeps the tail of the schedule short
+    uint64_t x = ((const SessionResult*)a)->size;
+    uint64_t y = ((const SessionResult*)b)->size;
+    return (x < y) - (x > y);
+}
+
+static int CompareName(const void* a, const void* b) {
+    return strcmp(((const SessionResult*)a)->name, ((const SessionResult*)b)->name);
+}
+
+// Output
+static void PrintJsonString(const char* text) {
+    putchar('"');
+    for (; *text; text++) {
+        if (*text == '"' || *text == '\\') putchar('\\');
+        if ((unsigned char)*text >= 0x20) putchar(*text);
+    }
+    putchar('"');
+}
+
+static void PrintCsvRow(const char* name, const Moments* moments, uint64_t errors, uint64_t skipped, double p50, double p90, double p99) {
+    printf("%s,%llu,%llu,%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", name, (unsigned long long)moments->count,
+        (unsigned long long)errors, (unsigned long long)skipped, moments->mean, StandardDeviation(moments),
+        moments->min, moments->max, p50, p90, p99);
+}
+
+static void PrintJsonObject(const char* name, const Moments* moments, uint64_t errors, uint64_t skipped, double p50, double p90, double p99) {
+    printf("{\"session\": ");
+    PrintJsonString(name);
+    printf(", \"trials\": %llu, \"errors\": %llu, \"skipped\": %llu, \"mean_ms\": %.3f, \"sd_ms\": %.3f, \"min_ms\": %.3f, "
+        "\"max_ms\": %.3f, \"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f}", (unsigned long long)moments->count,
+        (unsigned long long)errors, (unsigned long long)skipped, moments->mean, StandardDeviation(moments),
+        moments->min, moments->max, p50, p90, p99);
+}
+
+static void Usage(void) {
+    fprintf(stderr, "Usage: log_analyzer [--json] [--threads N] <log directory | files...>\n"
+                    "Prints per-session and aggregate statistics as CSV (default) or JSON.\n");
+}
+
+int main(int argc, char** argv) {
+    bool json = false;
+    long thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    WorkQueue queue = {0};
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--json")) {
+            json = true;
+        } else if (!strcmp(argv[i], "--csv")) {
+            json = false;
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            thread_count = strtol(argv[++i], NULL, 10);
+        } else if (argv[i][0] == '-') {
+            Usage();
+            return 1;
+        } else {
+            CollectSessions(&queue, argv[i]);
+        }
+    }
+    if (queue.count == 0) {
+        Usage();
+        return 1;
+    }
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > MAX_THREADS) thread_count = MAX_THREADS;
+    if ((size_t)thread_count > queue.count) thread_count = (long)queue.count;
+
+    qsort(queue.sessions, queue.count, sizeof(SessionResult), CompareSize);
+    atomic_init(&queue.next, 0);
+
+    static Worker workers[MAX_THREADS];
+    int64_t start = ClockNow();
+    for (long i = 0; i < thread_count; i++) {
+        workers[i].queue = &queue;
+        if (!InitializeLatencyHistogram(&workers[i].session, HISTOGRAM_HIGHEST_US, HISTOGRAM_BITS, HISTOGRAM_FREQUENCY) ||
+            !InitializeLatencyHistogram(&workers[i].total, HISTOGRAM_HIGHEST_US, HISTOGRAM_BITS, HISTOGRAM_FREQUENCY) ||
+            !StartThread(&workers[i].thread, WorkerThread, &workers[i])) {
+            fprintf(stderr, "Failed to start worker %ld\n", i);
+            return 1;
+        }
+    }
+
+    // Combine the per-worker aggregates
+    LatencyHistogram total;
+    Moments moments = {0};
+    uint64_t errors = 0, skipped = 0, bytes = 0;
+    InitializeLatencyHistogram(&total, HISTOGRAM_HIGHEST_US, HISTOGRAM_BITS, HISTOGRAM_FREQUENCY);
+    for (long i = 0; i < thread_count; i++) {
+        JoinThread(&workers[i].thread);
+        MergeLatencyHistogram(&total, &workers[i].total);
+        MergeMoments(&moments, &workers[i].moments);
+        FreeLatencyHistogram(&workers[i].session);
+        FreeLatencyHistogram(&workers[i].total);
+    }
+    double seconds = TicksToMilliseconds(ClockNow() - start, ClockFrequency()) / 1000.0;
+
+    qsort(queue.sessions, queue.count, sizeof(SessionResult), CompareName);
+    if (json) printf("{\"sessions\": [\n");
+    else printf("session,trials,errors,skipped,mean_ms,sd_ms,min_ms,max_ms,p50_ms,p90_ms,p99_ms\n");
+
+    bool first = true;
+    for (size_t i = 0; i < queue.count; i++) {
+        SessionResult* result = &queue.sessions[i];
+        errors += result->errors;
+        skipped += result->skipped;
+        bytes += result->size;
+        if (result->failed) {
+            fprintf(stderr, "Failed to map %s\n", result->path);
+            continue;
+        }
+        if (json) {
+            printf(first ? "  " : ",\n  ");
+            PrintJsonObject(result->name, &result->moments, result->errors, result->skipped, result->p50, result->p90, result->p99);
+        } else {
+            PrintCsvRow(result->name, &result->moments, result->errors, result->skipped, result->p50, result->p90, result->p99);
+        }
+        first = false;
+    }
+
+    double p50 = LatencyPercentile(&total, 50) / 1000.0;
+    double p90 = LatencyPercentile(&total, 90) / 1000.0;
+    double p99 = LatencyPercentile(&total, 99) / 1000.0;
+    if (json) {
+        printf("\n], \"aggregate\": ");
+        PrintJsonObject("ALL", &moments, errors, skipped, p50, p90, p99);
+        printf("}\n");
+    } else {
+        PrintCsvRow("ALL", &moments, errors, skipped, p50, p90, p99);
+    }
+
+    fprintf(stderr, "%zu files, %.1f MB in %.3fs with %ld threads (%.1f MB/s)\n", queue.count, bytes / 1e6, seconds, thread_count,
+        seconds > 0 ? bytes / 1e6 / seconds : 0);
+
+    for (size_t i = 0; i < queue.count; i++) {
+        free(queue.sessions[i].path);
+    }
+    free(queue.sessions);
+    FreeLatencyHistogram(&total);
+    return 0;
+}
@@ -0,0 +1,173 @@
+// Replays input recordings (Input_*.rec) through a fresh engine and checks every trial against the recorded digest.
+// Runs flat out by default; --real-time keeps the recorded pace. --log writes the trials in the text log format,
+// so the output can be compared byte for byte with the session's Log_*.log. --threads replays T recordings at a
+// time, each through its own engine; results and log lines still come out in command line order.
+// Usage: replay [--real-time] [--log FILE] [--threads T] <recordings...>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "event_recorder.h"
+#include "platform.h"
+
+static const char* const STATUS_NAMES[] = {"ok", "MISMATCH", "DIVERGED", "TRUNCATED", "INVALID"};
+
+typedef struct {
+    const char* path;
+    bool opened;
+    ReplayResult result;
+    double ms;
+    FILE* log;                  // This recording's trial lines, copied into the --log file once every replay is done
+} ReplayJob;
+
+typedef struct {
+    ReplayJob* jobs;
+    int count;
+    bool real_time;
+    bool log;
+    atomic_int next;            // Next job nobody has picked up yet
+} ReplayQueue;
+
+static void WriteTrial(void* context, const TrialRecord* record) { // Same lines as the trial logger
+    if (record->outcome == TRIAL_VALID) {
+        fprintf(context, "Trial %d: %f\n", record->trial, record->reaction_time_ms);
+    }
+}
+
+static void RunJob(ReplayJob* job, const ReplayQueue* queue) {
+    PlatformMapping mapping;
+    if (!MapFile(&mapping, job->path)) {
+        return;
+    }
+    ReplayOptions options = {.real_time = queue->real_time};
+    if (queue->log && !(job->log = tmpfile())) {
+        UnmapFile(&mapping);
+        return; // Reported as failed to open, a replay missing from the log would look like a clean one
+    }
+    job->opened = true;
+    if (job->log) {
+        options.trial_complete = WriteTrial;
+        options.context = job->log;
+        if (mapping.size >= sizeof(EventRecordingHeader)) {
+            const EventRecordingHeader* header = mapping.data;
+            fprintf(job->log, "Seed: %llu\n", (unsigned long long)header->seed);
+        }
+    }
+
+    int64_t start = ClockNow();
+    ReplayEventRecording(mapping.data, mapping.size, &options, &job->result);
+    job->ms = TicksToMilliseconds(ClockNow() - start, ClockFrequency());
+    UnmapFile(&mapping);
+}
+
+static void ReplayWorker(void* arg) {
+    ReplayQueue* queue = arg;
+    for (int index; (index = atomic_fetch_add(&queue->next, 1)) < queue->count;) {
+        RunJob(&queue->jobs[index], queue);
+    }
+}
+
+static void CopyLog(FILE* from, FILE* to) {
+    char buffer[4096];
+    size_t size;
+    rewind(from);
+    while ((size = fread(buffer, 1, sizeof(buffer), from)) > 0) {
+        fwrite(buffer, 1, size, to);
+    }
+}
+
+static void Usage(void) {
+    fprintf(stderr, "Usage: replay [--real-time] [--log FILE] [--threads T] <recordings...>\n");
+}
+
+int main(int argc, char** argv) {
+    ReplayQueue queue = {.real_time = false};
+    const char* log_path = NULL;
+    int threads = 1;
+    int first = 1;
+    for (; first < argc && !strncmp(argv[first], "--", 2); first++) {
+        if (!strcmp(argv[first], "--real-time")) {
+            queue.real_time = true;
+        } else if (!strcmp(argv[first], "--log") && first + 1 < argc) {
+            log_path = argv[++first];
+        } else if (!strcmp(argv[first], "--threads") && first + 1 < argc) {
+            threads = atoi(argv[++first]);
+        } else {
+            Usage();
+            return 1;
+        }
+    }
+    queue.count = argc - first;
+    if (queue.count < 1 || threads < 0) {
+        Usage();
+        return 1;
+    }
+
+    FILE* log = NULL;
+    if (log_path) {
+        log = fopen(log_path, "w");
+        if (!log) {
+            fprintf(stderr, "Failed to open %s\n", log_path);
+            return 1;
+        }
+        queue.log = true;
+    }
+
+    queue.jobs = calloc((size_t)queue.count, sizeof(ReplayJob));
+    if (!threads) threads = ProcessorCount();
+    if (threads > queue.count) threads = queue.count;
+    PlatformThread* workers = calloc((size_t)queue.count, sizeof(PlatformThread)); // Never more threads than recordings
+    if (!queue.jobs || !workers) {
+        fprintf(stderr, "Failed to allocate %d replays\n", queue.count);
+        return 1;
+    }
+    for (int i = 0; i < queue.count; i++) {
+        queue.jobs[i].path = argv[first + i];
+    }
+
+    atomic_init(&queue.next, 0);
+    int64_t start = ClockNow();
+    int started = 1;
+    while (started < threads && StartThread(&workers[started], ReplayWorker, &queue)) {
+        started++;
+    }
+    ReplayWorker(&queue); // The main thread is worker 0
+    for (int i = 1; i < started; i++) {
+        JoinThread(&workers[i]);
+    }
+    double seconds = TicksToMilliseconds(ClockNow() - start, ClockFrequency()) / 1000.0;
+
+    int failures = 0;
+    uint64_t total_events = 0;
+    uint64_t total_trials = 0;
+    double recorded_hours = 0;
+    for (int i = 0; i < queue.count; i++) {
+        ReplayJob* job = &queue.jobs[i];
+        if (!job->opened) {
+            printf("%s: failed to open\n", job->path);
+            failures++;
+            continue;
+        }
+        if (log && job->log) {
+            CopyLog(job->log, log);
+        }
+        if (job->log) fclose(job->log);
+
+        const ReplayResult* result = &job->result;
+        double hours = result->status == REPLAY_INVALID ? 0 :
+            (double)(result->last_tick - result->header.first_tick) / (double)result->header.frequency / 3600;
+        printf("%s: %s, %u trials (recorded %u), %llu events, %.2f h recorded, replayed in %.1f ms\n", job->path, STATUS_NAMES[result->status],
+            result->trials, result->recorded_trials, (unsigned long long)result->events, hours, job->ms);
+        failures += result->status != REPLAY_MATCH;
+        total_events += result->events;
+        total_trials += result->trials;
+        recorded_hours += hours;
+    }
+
+    printf("%d of %d recordings reproduced, %llu trials, %.1f h recorded in %.2f s on %d threads (%.0f events/s)\n", queue.count - failures, queue.count,
+        (unsigned long long)total_trials, recorded_hours, seconds, started, seconds > 0 ? (double)total_events / seconds : 0);
+    if (log) fclose(log);
+    free(workers);
+    free(queue.jobs);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+// Bootstrap confidence intervals for the trials of one or more logs (Log_*.log, "Trial N: value" lines), and with
+// --vs a permutation test of those trials against a second set, e.g. before/after a settings change or two devices.
+// Usage: session_compare [--resamples N] [--confidence C] [--seed S] [--threads T] <logs...> [--vs <logs...>]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bootstrap.h"
+#include "platform.h"
+
+#define DEFAULT_RESAMPLES 100000
+#define DEFAULT_CONFIDENCE 0.95
+#define DEFAULT_SEED 0x5EED
+
+typedef struct {
+    double* values;
+    uint32_t count;
+    uint32_t capacity;
+    int files;
+} TrialSet;
+
+static bool AddTrial(TrialSet* set, double value) {
+    if (set->count == set->capacity) {
+        uint32_t capacity = set->capacity ? set->capacity * 2 : 1024;
+        double* values = realloc(set->values, (size_t)capacity * sizeof(double));
+        if (!values) return false;
+        set->values = values;
+        set->capacity = capacity;
+    }
+    set->values[set->count++] = value;
+    return true;
+}
+
+static bool ReadTrials(TrialSet* set, const char* path) { // Anything that isn't a trial line (header, ERROR:, diagnostics) is skipped
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    char line[512];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        if (strncmp(line, "Trial ", 6) != 0) continue;
+        char* colon = strchr(line + 6, ':');
+        if (!colon) continue;
+        char* end;
+        double value = strtod(colon + 1, &end);
+        if (end != colon + 1) ok = AddTrial(set, value);
+    }
+    fclose(file);
+    set->files++;
+    return ok;
+}
+
+static void PrintIntervals(const char* label, const TrialSet* set, const BootstrapResult* result, double confidence) {
+    printf("%s: %u trials from %d file%s\n", label, set->count, set->files, set->files == 1 ? "" : "s");
+    for (int i = 0; i < SUMMARY_COUNT; i++) {
+        const ConfidenceInterval* interval = &result->intervals[i];
+        printf("  %-6s %10.3f ms  %.0f%% CI [%.3f, %.3f]\n", SUMMARY_NAMES[i], interval->estimate, confidence * 100,
+            interval->lower, interval->upper);
+    }
+}
+
+static void Usage(void) {
+    fprintf(stderr, "Usage: session_compare [--resamples N] [--confidence C] [--seed S] [--threads T] <logs...> [--vs <logs...>]\n"
+                    "Bootstrap confidence intervals of mean, median, p90 and p99, and permutation p-values for --vs.\n");
+}
+
+int main(int argc, char** argv) {
+    ResampleOptions options = {.resamples = DEFAULT_RESAMPLES, .confidence = DEFAULT_CONFIDENCE, .seed = DEFAULT_SEED, .threads = 0};
+    TrialSet sets[2] = {0};
+    int current = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--resamples") && i + 1 < argc) {
+            options.resamples = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--confidence") && i + 1 < argc) {
+            options.confidence = strtod(argv[++i], NULL);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            options.seed = strtoull(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            options.threads = (int)strtol(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--vs")) {
+            current = 1;
+        } else if (argv[i][0] == '-') {
+            Usage();
+            return 1;
+        } else if (!ReadTrials(&sets[current], argv[i])) {
+            return 1;
+        }
+    }
+    bool compare = current == 1;
+    if (!sets[0].count || (compare && !sets[1].count)) {
+        Usage();
+        return 1;
+    }
+    if (!options.resamples || !(options.confidence > 0 && options.confidence < 1)) {
+        fprintf(stderr, "--resamples must be positive and --confidence between 0 and 1\n");
+        return 1;
+    }
+
+    int64_t start = ClockNow();
+    BootstrapResult bootstrap[2];
+    PermutationResult permutation;
+    uint64_t steals = 0;
+    int threads = 0;
+    for (int i = 0; i <= (int)compare; i++) {
+        if (!BootstrapSummary(sets[i].values, sets[i].count, &options, &bootstrap[i])) {
+            fprintf(stderr, "Bootstrap failed\n");
+            return 1;
+        }
+        steals += bootstrap[i].pool.steals;
+        threads = bootstrap[i].pool.threads;
+    }
+    if (compare) {
+        if (!PermutationCompare(sets[0].values, sets[0].count, sets[1].values, sets[1].count, &options, &permutation)) {
+            fprintf(stderr, "Permutation test failed\n");
+            return 1;
+        }
+        steals += permutation.pool.steals;
+    }
+    double seconds = TicksToMilliseconds(ClockNow() - start, ClockFrequency()) / 1000.0;
+
+    PrintIntervals(compare ? "A" : "Sessions", &sets[0], &bootstrap[0], options.confidence);
+    if (compare) {
+        PrintIntervals("B", &sets[1], &bootstrap[1], options.confidence);
+        printf("B - A (permutation test, two-sided)\n");
+        for (int i = 0; i < SUMMARY_COUNT; i++) {
+            printf("  %-6s %+10.3f ms  p = %.5f\n", SUMMARY_NAMES[i], permutation.difference[i], permutation.p_value[i]);
+        }
+    }
+    fprintf(stderr, "%u resamples in %.3fs with %d threads, %llu chunks stolen\n", options.resamples, seconds, threads,
+        (unsigned long long)steals);
+
+    free(sets[0].values);
+    free(sets[1].values);
+    return 0;
+}
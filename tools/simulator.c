@@ -0,0 +1,543 @@
+// Headless session simulator: drives the reaction engine from a virtual clock with a synthetic responder,
+// checks every statistic against the responder's ground truth and reports the engine's CPU cost per trial.
+// Usage: simulator [--trials N] [--seed S] [--rt MU SIGMA TAU] [--anticipation P] [--bounce P] [--intertrial MS]
+//                  [--onset-jitter US] [--foreperiod MIN MAX] [--debounce MS] [--early-reset MS] [--averaging N] [--precision BITS]
+//                  [--record FILE] [--sessions N] [--threads T]
+// --record writes the session as an input recording, a quick way to build a replay corpus of any length.
+// --sessions runs N independent sessions (seeds S, S+1, ...) on T threads in one process, each with its own engine,
+// and checks every one against its own ground truth. With --record, session i writes FILE.i.
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "event_recorder.h"
+#include "platform.h"
+#include "prng.h"
+#include "reaction_engine.h"
+
+#define FREQUENCY 1000000000    // Virtual ticks are nanoseconds
+#define NEVER INT64_MAX
+#define MAX_PRESSES 2           // A press and its bounce
+#define TWO_PI 6.283185307179586
+
+typedef struct {
+    int64_t trials;
+    uint64_t seed;
+    double mu_ms;               // Ex-Gaussian reaction times: normal(mu, sigma) + exponential(tau)
+    double sigma_ms;
+    double tau_ms;
+    double anticipation;        // Chance of pressing during the foreperiod
+    double bounce;              // Chance of a second contact inside the debounce window
+    int intertrial_ms;          // Time between a result (or an early screen) and the next press
+    int onset_jitter_us;        // Scheduler lateness, uniform
+    int min_delay;
+    int max_delay;
+    EngineConfig engine;
+    const char* record_path;    // NULL = no recording
+    int sessions;
+    int threads;
+} SimulatorOptions;
+
+typedef enum {
+    EVENT_NONE,
+    EVENT_STIMULUS,
+    EVENT_TIMER,
+    EVENT_PRESS
+} EventKind;
+
+typedef struct {
+    const SimulatorOptions* options;
+    ReactionEngine* engine;
+    EventRecorder* recorder;    // Idle unless --record was given
+    RandomState random;
+
+    // Virtual platform
+    int64_t now;
+    int64_t stimulus_deadline;  // As armed by the engine
+    int64_t stimulus_fire;      // When the virtual scheduler delivers it, NEVER if nothing is armed
+    int64_t timers[3];          // Indexed by timer id
+    int64_t presses[MAX_PRESSES];
+
+    // Responder, plans once per (state, trial)
+    GameState planned_state;
+    int64_t planned_onset;
+    int64_t onset;              // Last stimulus onset, as the responder saw it
+
+    // Ground truth
+    double* truth;              // Reaction time of every valid trial, ms
+    int64_t reactions;
+    int64_t anticipations;
+    int64_t bounces;
+
+    // What the engine reported
+    int64_t valid_records;
+    int64_t early_records;
+    int64_t foreperiod_errors;
+    double max_rt_error;
+
+    // Engine cost
+    int64_t engine_ticks;
+    int64_t engine_calls;
+} Simulation;
+
+typedef struct {
+    SimulatorOptions options;   // Copy with this session's seed and recording
+    Simulation sim;
+    ReactionEngine engine;
+    EventRecorder recorder;
+    char record_path[4096];
+    bool completed;
+    int64_t wall_ticks;
+} SimulatorSession;
+
+typedef struct {
+    SimulatorSession* sessions;
+    int count;
+    atomic_int next;            // Next session nobody has picked up yet
+} SessionQueue;
+
+// Virtual platform callbacks (context is the simulation)
+static int64_t VirtualNow(void* context) {
+    return ((Simulation*)context)->now;
+}
+
+static void VirtualSetTimer(void* context, int timer_id, int delay_ms) {
+    Simulation* sim = context;
+    sim->timers[timer_id] = sim->now + MillisecondsToTicks(delay_ms, FREQUENCY);
+}
+
+static void VirtualKillTimer(void* context, int timer_id) {
+    ((Simulation*)context)->timers[timer_id] = NEVER;
+}
+
+static void VirtualRepaint(void* context) {
+    (void)context;
+}
+
+static void VirtualScheduleStimulus(void* context, int64_t deadline_tick) {
+    Simulation* sim = context;
+    int64_t jitter = sim->options->onset_jitter_us > 0 ? RandomBelow(&sim->random, (uint32_t)sim->options->onset_jitter_us * 1000 + 1) : 0;
+    sim->stimulus_deadline = deadline_tick;
+    sim->stimulus_fire = deadline_tick + jitter;
+}
+
+static void VirtualCancelStimulus(void* context) {
+    ((Simulation*)context)->stimulus_fire = NEVER;
+}
+
+static void VirtualTrialComplete(void* context, const TrialRecord* record) {
+    Simulation* sim = context;
+    if (record->outcome == TRIAL_VALID) {
+        double truth = sim->valid_records < sim->reactions ? sim->truth[sim->valid_records] : NAN;
+        double error = fabs(record->reaction_time_ms - truth);
+        if (!(error <= sim->max_rt_error)) sim->max_rt_error = isnan(error) ? INFINITY : error;
+        sim->valid_records++;
+    } else {
+        sim->early_records++;
+    }
+
+    int64_t armed = record->scheduled_onset - MillisecondsToTicks(record->foreperiod_ms, FREQUENCY);
+    if (record->foreperiod_ms < sim->options->min_delay || record->foreperiod_ms > sim->options->max_delay || armed < 0) {
+        sim->foreperiod_errors++;
+    }
+}
+
+// Responder
+static double ExGaussian(RandomState* random, double mu, double sigma, double tau) {
+    double normal = sqrt(-2.0 * log(1.0 - RandomUnit(random))) * cos(TWO_PI * RandomUnit(random));
+    return mu + sigma * normal - tau * log(1.0 - RandomUnit(random));
+}
+
+static void PlanPress(Simulation* sim, int64_t tick) {
+    for (int i = 0; i < MAX_PRESSES; i++) {
+        if (sim->presses[i] == NEVER) {
+            sim->presses[i] = tick;
+            return;
+        }
+    }
+}
+
+static int64_t DebounceEnd(const Simulation* sim) { // A press before this is ignored by design, the responder waits it out
+    return sim->engine->state.debounce_active ? sim->timers[TIMER_DEBOUNCE] + 1 : sim->now;
+}
+
+static void PlanResponder(Simulation* sim) {
+    const ReactionEngine* engine = sim->engine;
+    const SimulatorOptions* options = sim->options;
+    GameState state = engine->state.game_state;
+    if (state == sim->planned_state && engine->data.scheduled_onset == sim->planned_onset) {
+        return; // Already planned for this screen
+    }
+    sim->planned_state = state;
+    sim->planned_onset = engine->data.scheduled_onset;
+
+    int64_t intertrial = sim->now + MillisecondsToTicks(options->intertrial_ms, FREQUENCY);
+    int64_t earliest = DebounceEnd(sim);
+    switch (state) {
+    case STATE_INITIAL:
+    case STATE_RESULT:
+        PlanPress(sim, intertrial > earliest ? intertrial : earliest);
+        break;
+
+    case STATE_EARLY:
+        if (engine->config.early_reset_delay == 0) {
+            PlanPress(sim, intertrial > earliest ? intertrial : earliest);
+        }
+        break;
+
+    case STATE_READY:
+        if (earliest < sim->stimulus_deadline && RandomUnit(&sim->random) < options->anticipation) {
+            sim->anticipations++;
+            PlanPress(sim, earliest + (int64_t)(RandomUnit(&sim->random) * (double)(sim->stimulus_deadline - earliest)));
+        }
+        break;
+
+    case STATE_REACT: {
+        double rt_ms = ExGaussian(&sim->random, options->mu_ms, options->sigma_ms, options->tau_ms);
+        int64_t press = sim->onset + (rt_ms > 1 ? (int64_t)(rt_ms * 1e6) : 1000000);
+        if (press < earliest) press = earliest;
+        sim->truth[sim->reactions++] = (double)(press - sim->onset) / 1e6;
+        PlanPress(sim, press);
+
+        int debounce = engine->config.virtual_debounce;
+        if (debounce > 1 && RandomUnit(&sim->random) < options->bounce) { // Lands inside the debounce window the press opens
+            sim->bounces++;
+            PlanPress(sim, press + MillisecondsToTicks(1 + RandomBelow(&sim->random, (uint32_t)debounce - 1), FREQUENCY) - 1);
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+// Event loop
+static EventKind NextEvent(const Simulation* sim, int64_t* tick, int* index) {
+    EventKind kind = EVENT_NONE;
+    *tick = NEVER;
+    if (sim->stimulus_fire < *tick) {
+        *tick = sim->stimulus_fire;
+        kind = EVENT_STIMULUS;
+    }
+    for (int i = TIMER_EARLY; i <= TIMER_DEBOUNCE; i++) {
+        if (sim->timers[i] < *tick) {
+            *tick = sim->timers[i];
+            *index = i;
+            kind = EVENT_TIMER;
+        }
+    }
+    for (int i = 0; i < MAX_PRESSES; i++) {
+        if (sim->presses[i] < *tick) {
+            *tick = sim->presses[i];
+            *index = i;
+            kind = EVENT_PRESS;
+        }
+    }
+    return kind;
+}
+
+static bool RunSimulation(Simulation* sim) {
+    ReactionEngine* engine = sim->engine;
+    while (engine->state.trial_iteration < sim->options->trials) {
+        PlanResponder(sim);
+
+        int64_t tick;
+        int index = 0;
+        EventKind kind = NextEvent(sim, &tick, &index);
+        if (kind == EVENT_NONE) {
+            fprintf(stderr, "Simulation stalled in state %d after %d trials\n", engine->state.game_state, engine->state.trial_iteration);
+            return false;
+        }
+        sim->now = tick;
+
+        int64_t start = ClockNow();
+        switch (kind) {
+        case EVENT_STIMULUS:
+            sim->stimulus_fire = NEVER;
+            sim->onset = tick;
+            RecordStimulus(sim->recorder, sim->stimulus_deadline, tick);
+            StimulusOnset(engine, sim->stimulus_deadline, tick);
+            RecordPresented(sim->recorder, tick); // No display, the react frame counts as shown at once
+            StimulusPresented(engine, tick);
+            break;
+        case EVENT_TIMER:
+            sim->timers[index] = NEVER;
+            RecordTimer(sim->recorder, index);
+            TimerStateLogic(engine, index);
+            break;
+        case EVENT_PRESS:
+            sim->presses[index] = NEVER;
+            engine->data.input_key = 'A';
+            RecordInput(sim->recorder, false, tick);
+            HandleInput(engine, false, tick);
+            break;
+        default:
+            break;
+        }
+        sim->engine_ticks += ClockNow() - start;
+        sim->engine_calls++;
+    }
+    return true;
+}
+
+// Ground truth checks
+static int CompareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static bool Close(double value, double expected, double tolerance) {
+    return fabs(value - expected) <= tolerance * fmax(1.0, fabs(expected));
+}
+
+static bool CheckRollingWindow(const Simulation* sim) { // Last averaging_trials reactions, recomputed from scratch
+    int window = sim->engine->config.averaging_trials;
+    if (sim->reactions < window) window = (int)sim->reactions;
+    const double* last = sim->truth + sim->reactions - window;
+    double* sorted = malloc(window * sizeof(double));
+    if (!sorted) return false;
+    memcpy(sorted, last, window * sizeof(double));
+    qsort(sorted, window, sizeof(double), CompareDoubles);
+
+    double mean = 0;
+    for (int i = 0; i < window; i++) mean += last[i];
+    mean /= window;
+    double m2 = 0;
+    for (int i = 0; i < window; i++) m2 += (last[i] - mean) * (last[i] - mean);
+    double sd = window > 1 ? sqrt(m2 / (window - 1)) : 0;
+    double median = window % 2 ? sorted[window / 2] : (sorted[window / 2 - 1] + sorted[window / 2]) / 2;
+
+    const RollingSummary* summary = &sim->engine->data.rolling.summary;
+    bool ok = summary->count == window && Close(summary->mean, mean, 1e-9) && Close(summary->sd, sd, 1e-6) &&
+        Close(summary->min, sorted[0], 1e-12) && Close(summary->max, sorted[window - 1], 1e-12) && Close(summary->median, median, 1e-12);
+    if (!ok) {
+        printf("rolling window: engine mean %.6f sd %.6f median %.6f, truth mean %.6f sd %.6f median %.6f\n",
+            summary->mean, summary->sd, summary->median, mean, sd, median);
+    }
+    free(sorted);
+    return ok;
+}
+
+static bool CheckPercentiles(const Simulation* sim) { // Whole session histogram against exact nearest-rank percentiles
+    double* sorted = malloc(sim->reactions * sizeof(double));
+    if (!sorted) return false;
+    memcpy(sorted, sim->truth, sim->reactions * sizeof(double));
+    qsort(sorted, sim->reactions, sizeof(double), CompareDoubles);
+
+    const double percentiles[] = {50, 90, 99};
+    double bound = ldexp(1.0, 1 - sim->engine->data.session_histogram.significant_bits);
+    bool ok = true;
+    printf("percentiles:");
+    for (int i = 0; i < 3; i++) {
+        int64_t rank = (int64_t)(percentiles[i] / 100.0 * (double)sim->reactions + 0.5);
+        double exact = sorted[(rank > 0 ? rank : 1) - 1];
+        double histogram = TicksToMilliseconds(LatencyPercentile(&sim->engine->data.session_histogram, percentiles[i]), FREQUENCY);
+        double error = fabs(histogram - exact) / exact;
+        ok &= error <= bound;
+        printf(" p%g %.3fms (exact %.3fms, error %.3f%%)", percentiles[i], histogram, exact, 100 * error);
+    }
+    printf(", bound %.3f%%\n", 100 * bound);
+    free(sorted);
+    return ok;
+}
+
+static double ClockOverhead(void) { // Cost of one ClockNow pair, subtracted from every timed engine call
+    const int samples = 1000000;
+    int64_t total = 0;
+    for (int i = 0; i < samples; i++) {
+        int64_t start = ClockNow();
+        total += ClockNow() - start;
+    }
+    return (double)total / samples;
+}
+
+static bool StartSession(SimulatorSession* session, const SimulatorOptions* options, int index) { // Everything a session touches is its own
+    session->options = *options;
+    session->options.seed = options->seed + (uint64_t)index;
+    if (options->record_path && options->sessions > 1) {
+        snprintf(session->record_path, sizeof(session->record_path), "%s.%d", options->record_path, index);
+        session->options.record_path = session->record_path;
+    }
+
+    Simulation* sim = &session->sim;
+    *sim = (Simulation){.options = &session->options, .engine = &session->engine, .recorder = &session->recorder, .stimulus_fire = NEVER,
+        .planned_state = STATE_INITIAL, .planned_onset = -1};
+    for (int i = 0; i < 3; i++) sim->timers[i] = NEVER;
+    for (int i = 0; i < MAX_PRESSES; i++) sim->presses[i] = NEVER;
+    SeedRandom(&sim->random, session->options.seed ^ 0x5DEECE66Dull); // Independent of the foreperiod stream
+    sim->truth = malloc(options->trials * sizeof(double));
+
+    EnginePlatform platform = {
+        .context = sim,
+        .now = VirtualNow,
+        .set_timer = VirtualSetTimer,
+        .kill_timer = VirtualKillTimer,
+        .request_repaint = VirtualRepaint,
+        .schedule_stimulus = VirtualScheduleStimulus,
+        .cancel_stimulus = VirtualCancelStimulus,
+        .trial_complete = VirtualTrialComplete
+    };
+    ForeperiodDistribution foreperiods;
+    BuildUniformForeperiods(&foreperiods, options->min_delay, options->max_delay);
+    if (!sim->truth || !InitializeEngine(&session->engine, &options->engine, &platform, FREQUENCY, &foreperiods, session->options.seed)) {
+        fprintf(stderr, "Failed to initialize the engine\n");
+        return false;
+    }
+    session->engine.state.mouse_active = true;
+    const char* record_path = session->options.record_path;
+    if (record_path && !StartEventRecorder(&session->recorder, fopen(record_path, "wb"), &session->engine, session->options.seed, 0)) {
+        fprintf(stderr, "Failed to open %s\n", record_path);
+        return false;
+    }
+    return true;
+}
+
+static void SessionWorker(void* arg) { // Takes sessions until none are left, so uneven sessions still keep every thread busy
+    SessionQueue* queue = arg;
+    for (int index; (index = atomic_fetch_add(&queue->next, 1)) < queue->count;) {
+        SimulatorSession* session = &queue->sessions[index];
+        int64_t start = ClockNow();
+        session->completed = RunSimulation(&session->sim);
+        if (session->options.record_path && !StopEventRecorder(&session->recorder)) {
+            fprintf(stderr, "Failed to write %s\n", session->options.record_path);
+            session->completed = false;
+        }
+        session->wall_ticks = ClockNow() - start;
+    }
+}
+
+static bool ReportSession(const SimulatorSession* session, double overhead) {
+    if (!session->completed) {
+        return false;
+    }
+    const SimulatorOptions* options = &session->options;
+    const Simulation* sim = &session->sim;
+    double wall_seconds = TicksToMilliseconds(session->wall_ticks, ClockFrequency()) / 1000.0;
+    double engine_ns = ((double)sim->engine_ticks - overhead * (double)sim->engine_calls) * 1e9 / (double)ClockFrequency();
+    printf("trials: %lld valid, %lld early, %lld bounces, %.1f virtual hours\n", (long long)sim->valid_records,
+        (long long)sim->early_records, (long long)sim->bounces, (double)sim->now / FREQUENCY / 3600);
+    printf("engine: %.1f ns/trial over %.2f calls/trial, simulation: %.0f trials/s wall\n", engine_ns / (double)options->trials,
+        (double)sim->engine_calls / (double)options->trials, (double)options->trials / wall_seconds);
+
+    // Every trial the responder produced has to come back out of the engine, unchanged
+    bool counts = sim->valid_records == sim->reactions && sim->early_records == sim->anticipations && sim->foreperiod_errors == 0;
+    bool reaction_times = sim->max_rt_error <= 1e-6;
+    printf("reaction times: max error %.9fms, foreperiod errors %lld\n", sim->max_rt_error, (long long)sim->foreperiod_errors);
+    bool rolling = CheckRollingWindow(sim);
+    bool percentiles = CheckPercentiles(sim);
+
+    bool passed = counts && reaction_times && rolling && percentiles;
+    printf("%s (counts %s, reaction times %s, rolling window %s, percentiles %s)\n", passed ? "PASS" : "FAIL",
+        counts ? "ok" : "FAIL", reaction_times ? "ok" : "FAIL", rolling ? "ok" : "FAIL", percentiles ? "ok" : "FAIL");
+    return passed;
+}
+
+static void Usage(void) {
+    fprintf(stderr, "Usage: simulator [--trials N] [--seed S] [--rt MU SIGMA TAU] [--anticipation P] [--bounce P] [--intertrial MS]\n"
+        "                 [--onset-jitter US] [--foreperiod MIN MAX] [--debounce MS] [--early-reset MS] [--averaging N] [--precision BITS]\n"
+        "                 [--record FILE] [--sessions N] [--threads T]\n");
+}
+
+int main(int argc, char** argv) {
+    SimulatorOptions options = {
+        .trials = 1000000, .seed = 1, .mu_ms = 250, .sigma_ms = 30, .tau_ms = 60, .anticipation = 0.05, .bounce = 0.1,
+        .intertrial_ms = 300, .onset_jitter_us = 0, .min_delay = 1000, .max_delay = 3000, .sessions = 1, .threads = 0,
+        .engine = {.averaging_trials = 5, .total_trials = 1000, .early_reset_delay = 1500, .virtual_debounce = 50, .histogram_precision = 7}
+    };
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--trials") && i + 1 < argc) {
+            options.trials = strtoll(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            options.seed = strtoull(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--rt") && i + 3 < argc) {
+            options.mu_ms = strtod(argv[++i], NULL);
+            options.sigma_ms = strtod(argv[++i], NULL);
+            options.tau_ms = strtod(argv[++i], NULL);
+        } else if (!strcmp(argv[i], "--anticipation") && i + 1 < argc) {
+            options.anticipation = strtod(argv[++i], NULL);
+        } else if (!strcmp(argv[i], "--bounce") && i + 1 < argc) {
+            options.bounce = strtod(argv[++i], NULL);
+        } else if (!strcmp(argv[i], "--intertrial") && i + 1 < argc) {
+            options.intertrial_ms = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--onset-jitter") && i + 1 < argc) {
+            options.onset_jitter_us = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--foreperiod") && i + 2 < argc) {
+            options.min_delay = atoi(argv[++i]);
+            options.max_delay = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--debounce") && i + 1 < argc) {
+            options.engine.virtual_debounce = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--early-reset") && i + 1 < argc) {
+            options.engine.early_reset_delay = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--averaging") && i + 1 < argc) {
+            options.engine.averaging_trials = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--precision") && i + 1 < argc) {
+            options.engine.histogram_precision = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--record") && i + 1 < argc) {
+            options.record_path = argv[++i];
+        } else if (!strcmp(argv[i], "--sessions") && i + 1 < argc) {
+            options.sessions = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            options.threads = atoi(argv[++i]);
+        } else {
+            Usage();
+            return 1;
+        }
+    }
+    if (options.trials < 1 || options.trials > INT32_MAX || options.engine.averaging_trials < 1 || options.min_delay < 0 ||
+        options.max_delay < options.min_delay || options.intertrial_ms < 0 || options.onset_jitter_us < 0 || options.sessions < 1 || options.threads < 0) {
+        Usage();
+        return 1;
+    }
+    options.engine.total_trials = (int)options.trials;
+
+    if (!options.threads) options.threads = ProcessorCount();
+    if (options.threads > options.sessions) options.threads = options.sessions;
+
+    SessionQueue queue = {.sessions = calloc(options.sessions, sizeof(SimulatorSession)), .count = options.sessions};
+    PlatformThread* workers = calloc(options.threads, sizeof(PlatformThread));
+    if (!queue.sessions || !workers) {
+        fprintf(stderr, "Failed to allocate %d sessions\n", options.sessions);
+        return 1;
+    }
+    for (int i = 0; i < options.sessions; i++) {
+        if (!StartSession(&queue.sessions[i], &options, i)) {
+            return 1;
+        }
+    }
+
+    double overhead = ClockOverhead();
+    atomic_init(&queue.next, 0);
+    int64_t wall_start = ClockNow();
+    for (int i = 1; i < options.threads; i++) {
+        if (!StartThread(&workers[i], SessionWorker, &queue)) {
+            fprintf(stderr, "Failed to start worker thread %d\n", i);
+            return 1;
+        }
+    }
+    SessionWorker(&queue); // The main thread is worker 0
+    for (int i = 1; i < options.threads; i++) {
+        JoinThread(&workers[i]);
+    }
+    double wall_seconds = TicksToMilliseconds(ClockNow() - wall_start, ClockFrequency()) / 1000.0;
+
+    int passed = 0;
+    for (int i = 0; i < options.sessions; i++) {
+        SimulatorSession* session = &queue.sessions[i];
+        if (options.sessions > 1) {
+            printf("session %d, seed %llu:\n", i, (unsigned long long)session->options.seed);
+        }
+        passed += ReportSession(session, overhead);
+        FreeEngine(&session->engine);
+        free(session->sim.truth);
+    }
+    if (options.sessions > 1) {
+        printf("%d of %d sessions passed, %lld trials on %d threads in %.2f s (%.0f trials/s wall)\n", passed, options.sessions,
+            (long long)options.trials * options.sessions, options.threads, wall_seconds, (double)options.trials * options.sessions / wall_seconds);
+    }
+    free(workers);
+    free(queue.sessions);
+    return passed == options.sessions ? 0 : 1;
+}
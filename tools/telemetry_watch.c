@@ -0,0 +1,132 @@
+// Follows a running tester through its shared memory telemetry (TelemetryEnabled=1): one line per finished trial
+// as it happens, with the pipeline measures, and every participant's live state each interval. Waits for a tester
+// to start and picks up the next session when one ends. Only reads the block, the tester never notices it.
+// Usage: telemetry_watch [--name NAME] [--interval MS] [--once]
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "config_defaults.h"
+#include "telemetry.h"
+
+#define DEFAULT_INTERVAL_MS 1000
+#define POLL_MS 10              // Trials show up within this
+
+static const char* const STATE_NAMES[STATE_COUNT] = {"initial", "ready", "react", "early", "result"};
+
+static void SleepMilliseconds(int ms) {
+    struct timespec duration = {ms / 1000, (long)(ms % 1000) * 1000000};
+    nanosleep(&duration, NULL);
+}
+
+static void PrintTrial(const TelemetryReader* reader, const TelemetryTrial* trial) {
+    const TrialRecord* record = &trial->record;
+    if (record->outcome != TRIAL_VALID) {
+        printf("P%u early press (trial %d)\n", trial->participant + 1, record->trial);
+        return;
+    }
+    DiagnosticsSettings settings = {reader->block->frequency, reader->block->flag_ticks};
+    int64_t measures[TRIAL_MEASURE_COUNT];
+    bool flagged = MeasureTrial(record, &settings, measures);
+    printf("P%u trial %d: %.3f ms |", trial->participant + 1, record->trial, record->reaction_time_ms);
+    for (int i = 0; i < TRIAL_MEASURE_COUNT; i++) {
+        if (measures[i] < 0) printf(" %s -", PIPELINE_MEASURE_NAMES[i]);
+        else printf(" %s %.3f", PIPELINE_MEASURE_NAMES[i], TicksToMilliseconds(measures[i], settings.frequency));
+    }
+    printf(" ms%s\n", flagged ? " [FLAGGED]" : "");
+}
+
+static void PrintStatus(const TelemetryReader* reader) {
+    for (uint32_t i = 0; i < reader->block->participant_count; i++) {
+        TelemetryParticipant participant;
+        if (!ReadTelemetryParticipant(reader, (int)i, &participant)) {
+            printf("P%u busy\n", i + 1); // The tester was mid-update every time, next interval
+            continue;
+        }
+        const char* state = participant.state < STATE_COUNT ? STATE_NAMES[participant.state] : "?";
+        printf("P%u %-7s trials %d, early %u, last %.2f ms", i + 1, state, participant.trials, participant.early_presses, participant.last_ms);
+        if (participant.rolling_count) {
+            printf(", last %u: mean %.2f sd %.2f median %.2f best %.2f", participant.rolling_count, participant.rolling_mean_ms,
+                participant.rolling_sd_ms, participant.rolling_median_ms, participant.rolling_min_ms);
+        }
+        printf(", session p50/p90/p99 %.1f/%.1f/%.1f ms\n", participant.session_p50_ms, participant.session_p90_ms, participant.session_p99_ms);
+    }
+
+    TelemetryDiagnostics diagnostics;
+    if (ReadTelemetryDiagnostics(reader, &diagnostics)) {
+        printf("Pipeline last (ms):");
+        for (int i = 0; i < MEASURE_COUNT; i++) {
+            if (diagnostics.last[i] < 0) printf(" %s -", PIPELINE_MEASURE_NAMES[i]);
+            else printf(" %s %.3f", PIPELINE_MEASURE_NAMES[i], TicksToMilliseconds(diagnostics.last[i], reader->block->frequency));
+        }
+        printf(", flagged %llu of %llu\n", (unsigned long long)diagnostics.flagged, (unsigned long long)diagnostics.trials);
+    }
+}
+
+static void DrainTrials(TelemetryReader* reader) {
+    TelemetryTrial trials[64];
+    uint32_t count;
+    uint64_t lost;
+    do {
+        count = ReadTelemetryTrials(reader, trials, 64, &lost);
+        if (lost) printf("(%llu trials missed)\n", (unsigned long long)lost);
+        for (uint32_t i = 0; i < count; i++) {
+            PrintTrial(reader, &trials[i]);
+        }
+    } while (count == 64);
+}
+
+int main(int argc, char** argv) {
+    const char* name = DEFAULT_TELEMETRY_NAME;
+    int interval_ms = DEFAULT_INTERVAL_MS;
+    bool once = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--name") && i + 1 < argc) {
+            name = argv[++i];
+        } else if (!strcmp(argv[i], "--interval") && i + 1 < argc) {
+            interval_ms = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--once")) {
+            once = true;
+        } else {
+            fprintf(stderr, "Usage: telemetry_watch [--name NAME] [--interval MS] [--once]\n");
+            return 1;
+        }
+    }
+    if (interval_ms < POLL_MS) interval_ms = POLL_MS;
+
+    TelemetryReader reader;
+    bool waiting = false;
+    for (;;) {
+        if (!OpenTelemetryReader(&reader, name)) {
+            if (once) {
+                fprintf(stderr, "No tester publishes telemetry as %s\n", name);
+                return 1;
+            }
+            if (!waiting) fprintf(stderr, "Waiting for a tester publishing as %s\n", name);
+            waiting = true;
+            SleepMilliseconds(interval_ms);
+            continue;
+        }
+        waiting = false;
+        printf("Session %016llx, seed %llu, %u participant%s\n", (unsigned long long)reader.block->session_id,
+            (unsigned long long)reader.block->seed, reader.block->participant_count, reader.block->participant_count == 1 ? "" : "s");
+
+        int64_t next_status = ClockNow();
+        for (;;) {
+            bool closed = TelemetryClosed(&reader); // Checked first, so the trials below are the last ones
+            DrainTrials(&reader);
+            if (closed || once || ClockNow() >= next_status) {
+                PrintStatus(&reader);
+                next_status = ClockNow() + MillisecondsToTicks(interval_ms, ClockFrequency());
+            }
+            fflush(stdout);
+            if (closed || once) break;
+            SleepMilliseconds(POLL_MS);
+        }
+        CloseTelemetryReader(&reader);
+        if (once) return 0;
+        printf("Session ended\n");
+        fflush(stdout);
+    }
+}
@@ -0,0 +1,135 @@
+// Scripted responder for the Linux frontend: a uinput virtual keyboard that presses a key at a fixed interval
+// (plus jitter), so a whole session can run unattended, e.g. under Xvfb. The kernel stamps uinput events like
+// those of a real keyboard, and the press times printed here are on the same clock as the trial log ticks.
+// Usage: uinput_keyboard [--presses N] [--interval MS] [--jitter MS] [--hold MS] [--key A-Z|0-9] [--seed S] [--output FILE]
+// --output writes the same events as raw struct input_event to FILE (e.g. a FIFO given to ReactionTimeTester --device)
+// instead of creating a device, for machines without /dev/uinput access.
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <linux/uinput.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+#include "platform.h"
+#include "prng.h"
+
+typedef struct {
+    int presses;
+    int interval_ms;
+    int jitter_ms;
+    int hold_ms;
+    uint16_t key;               // evdev code
+    uint64_t seed;
+    const char* output_path;    // NULL = uinput device
+} ResponderOptions;
+
+static uint16_t KeyCode(char key) {
+    static const uint16_t LETTERS[26] = {
+        KEY_A, KEY_B, KEY_C, KEY_D, KEY_E, KEY_F, KEY_G, KEY_H, KEY_I, KEY_J, KEY_K, KEY_L, KEY_M,
+        KEY_N, KEY_O, KEY_P, KEY_Q, KEY_R, KEY_S, KEY_T, KEY_U, KEY_V, KEY_W, KEY_X, KEY_Y, KEY_Z
+    };
+    if (key >= 'a' && key <= 'z') key -= 32;
+    if (key >= 'A' && key <= 'Z') return LETTERS[key - 'A'];
+    if (key == '0') return KEY_0;
+    if (key >= '1' && key <= '9') return (uint16_t)(KEY_1 + key - '1');
+    return 0;
+}
+
+static void SleepUntil(int64_t tick) {
+    struct timespec deadline = {.tv_sec = tick / 1000000000, .tv_nsec = tick % 1000000000}; // ClockNow is CLOCK_MONOTONIC in ns
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
+
+static bool Emit(int fd, bool stamped, uint16_t type, uint16_t code, int32_t value) {
+    struct input_event event = {.type = type, .code = code, .value = value};
+    if (stamped) { // uinput stamps events itself, a canned stream has to carry its own stamps
+        int64_t now = ClockNow();
+        event.input_event_sec = now / 1000000000;
+        event.input_event_usec = (now % 1000000000) / 1000;
+    }
+    return write(fd, &event, sizeof(event)) == sizeof(event);
+}
+
+static int CreateDevice(uint16_t key) {
+    int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "/dev/uinput: %s\n", strerror(errno));
+        return -1;
+    }
+    struct uinput_setup setup = {.id = {.bustype = BUS_VIRTUAL, .vendor = 0x1209, .product = 0x0001}};
+    snprintf(setup.name, sizeof(setup.name), "Reaction Time Tester responder");
+    if (ioctl(fd, UI_SET_EVBIT, EV_KEY) < 0 || ioctl(fd, UI_SET_KEYBIT, KEY_A) < 0 || ioctl(fd, UI_SET_KEYBIT, KEY_Z) < 0 || // Looks like a keyboard to the frontend's scan
+        ioctl(fd, UI_SET_KEYBIT, key) < 0 || ioctl(fd, UI_DEV_SETUP, &setup) < 0 || ioctl(fd, UI_DEV_CREATE) < 0) {
+        fprintf(stderr, "uinput setup failed: %s\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool ParseOptions(int argc, char** argv, ResponderOptions* options) {
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value) return false;
+        if (!strcmp(argv[i], "--presses")) options->presses = atoi(value);
+        else if (!strcmp(argv[i], "--interval")) options->interval_ms = atoi(value);
+        else if (!strcmp(argv[i], "--jitter")) options->jitter_ms = atoi(value);
+        else if (!strcmp(argv[i], "--hold")) options->hold_ms = atoi(value);
+        else if (!strcmp(argv[i], "--key")) options->key = KeyCode(value[0]);
+        else if (!strcmp(argv[i], "--seed")) options->seed = strtoull(value, NULL, 0);
+        else if (!strcmp(argv[i], "--output")) options->output_path = value;
+        else return false;
+        i++;
+    }
+    return options->presses > 0 && options->interval_ms > options->hold_ms && options->jitter_ms >= 0 && options->key;
+}
+
+int main(int argc, char** argv) {
+    ResponderOptions options = {.presses = 100, .interval_ms = 700, .jitter_ms = 300, .hold_ms = 60, .key = KEY_A, .seed = 1};
+    if (!ParseOptions(argc, argv, &options)) {
+        fprintf(stderr, "Usage: %s [--presses N] [--interval MS] [--jitter MS] [--hold MS] [--key A-Z|0-9] [--seed S] [--output FILE]\n", argv[0]);
+        return 2;
+    }
+
+    bool stamped = options.output_path != NULL;
+    int fd = stamped ? open(options.output_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) : CreateDevice(options.key);
+    if (fd < 0) {
+        if (stamped) fprintf(stderr, "%s: %s\n", options.output_path, strerror(errno));
+        return 1;
+    }
+    if (!stamped) {
+        sleep(1); // Give udev and the frontend's device scan a moment to see the new device
+    }
+
+    RandomState random;
+    SeedRandom(&random, options.seed);
+    int64_t frequency = ClockFrequency();
+    int64_t next = ClockNow() + MillisecondsToTicks(options.interval_ms, frequency);
+    for (int i = 0; i < options.presses; i++) {
+        SleepUntil(next);
+        int64_t pressed = ClockNow();
+        if (!Emit(fd, stamped, EV_KEY, options.key, 1) || !Emit(fd, stamped, EV_SYN, SYN_REPORT, 0)) {
+            fprintf(stderr, "write failed: %s\n", strerror(errno));
+            return 1;
+        }
+        printf("%d %lld\n", i + 1, (long long)pressed);
+        SleepUntil(pressed + MillisecondsToTicks(options.hold_ms, frequency));
+        if (!Emit(fd, stamped, EV_KEY, options.key, 0) || !Emit(fd, stamped, EV_SYN, SYN_REPORT, 0)) {
+            return 1;
+        }
+        int jitter = RandomInRange(&random, 0, options.jitter_ms);
+        next = pressed + MillisecondsToTicks(options.interval_ms + jitter, frequency);
+    }
+
+    if (!stamped) {
+        ioctl(fd, UI_DEV_DESTROY);
+    }
+    close(fd);
+    return 0;
+}